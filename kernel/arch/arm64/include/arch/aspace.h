@@ -8,6 +8,7 @@
 #pragma once
 
 #include <arch/arm64/mmu.h>
+#include <fbl/auto_lock.h>
 #include <fbl/canary.h>
 #include <fbl/mutex.h>
 #include <vm/arch_vm_aspace.h>
@@ -40,6 +41,10 @@ public:
                      vaddr_t align, size_t size, uint mmu_flags) override;
 
     paddr_t arch_table_phys() const override { return tt_phys_; }
+    size_t pt_pages() const override {
+        fbl::AutoLock a(&lock_);
+        return pt_pages_;
+    }
     uint16_t arch_asid() const { return asid_; }
     void arch_set_asid(uint16_t asid) { asid_ = asid; }
 
@@ -92,7 +97,7 @@ private:
 
     fbl::Canary<fbl::magic("VAAS")> canary_;
 
-    fbl::Mutex lock_;
+    mutable fbl::Mutex lock_;
 
     uint16_t asid_ = MMU_ARM64_UNUSED_ASID;
 
@@ -629,8 +629,25 @@ ssize_t ArmArchVmAspace::MapPageTable(vaddr_t vaddr_in, vaddr_t vaddr_rel_in,
             ret = MapPageTable(vaddr, vaddr_rem, paddr, chunk_size, attrs,
                                index_shift - (page_size_shift - 3),
                                page_size_shift, next_page_table);
-            if (ret < 0)
+            if (ret < 0) {
+                // The unmap below only covers the chunks that were mapped
+                // before this one, so don't leave behind a table that nothing
+                // ended up in, such as one GetPageTable just created.
+                if (page_table_is_clear(next_page_table, page_size_shift)) {
+                    paddr_t page_table_paddr = page_table[index] & MMU_PTE_OUTPUT_ADDR_MASK;
+                    page_table[index] = MMU_PTE_DESCRIPTOR_INVALID;
+
+                    // ensure that the update is observable from hardware page table walkers
+                    DMB_ISHST;
+
+                    // flush the non terminal TLB entry
+                    FlushTLBEntry(vaddr, false);
+
+                    FreePageTable(const_cast<pte_t*>(next_page_table), page_table_paddr,
+                                  page_size_shift);
+                }
                 goto err;
+            }
         } else {
             pte = page_table[index];
             if (pte) {
@@ -92,7 +92,7 @@ public:
 
     paddr_t arch_table_phys() const override { return pt_->phys(); }
     paddr_t pt_phys() const { return pt_->phys(); }
-    size_t pt_pages() const { return pt_->pages(); }
+    size_t pt_pages() const override { return pt_->pages(); }
 
     int active_cpus() { return active_cpus_.load(); }
 
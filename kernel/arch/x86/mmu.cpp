@@ -516,6 +516,9 @@ zx_status_t X86PageTableBase::Init(void* ctx) TA_NO_THREAD_SAFETY_ANALYSIS {
     virt_ = reinterpret_cast<pt_entry_t*>(paddr_to_physmap(pa));
     phys_ = pa;
     p->state = VM_PAGE_STATE_MMU;
+    // Only counts the entries mapped through UpdateEntry(), not the kernel
+    // ones aliased in; the top level table is never checked for emptiness.
+    p->mmu.num_present = 0;
 
     // TODO(abdulla): Remove when PMM returns pre-zeroed pages.
     arch_zero_page(virt_);
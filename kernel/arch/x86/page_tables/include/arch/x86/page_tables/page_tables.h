@@ -181,6 +181,10 @@ private:
     void UnmapEntry(ConsistencyManager* cm, PageTableLevel level, vaddr_t vaddr,
                     volatile pt_entry_t* pte, bool was_terminal) TA_REQ(lock_);
 
+    static bool IsTableEmpty(volatile pt_entry_t* table);
+    void FreeTable(PageTableLevel level, vaddr_t vaddr, volatile pt_entry_t* pte,
+                   volatile pt_entry_t* table, ConsistencyManager* cm) TA_REQ(lock_);
+
     fbl::Canary<fbl::magic("X86P")> canary_;
 
     // low lock to protect the mmu code
@@ -254,6 +254,15 @@ public:
     size_t size;
 };
 
+// Returns the page backing |table| if it keeps a count of its present
+// entries. Tables that weren't allocated by _map_alloc_page(), such as the
+// ones built at boot, don't.
+static vm_page_t* counted_table_page(volatile pt_entry_t* table) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(table) & ~static_cast<uintptr_t>(PAGE_MASK);
+    vm_page_t* page = paddr_to_vm_page(X86_VIRT_TO_PHYS(base));
+    return (page && page->state == VM_PAGE_STATE_MMU) ? page : nullptr;
+}
+
 void X86PageTableBase::UpdateEntry(ConsistencyManager* cm, PageTableLevel level, vaddr_t vaddr,
                                    volatile pt_entry_t* pte, paddr_t paddr, PtFlags flags,
                                    bool was_terminal) {
@@ -266,6 +275,14 @@ void X86PageTableBase::UpdateEntry(ConsistencyManager* cm, PageTableLevel level,
     *pte = paddr | flags | X86_MMU_PG_P;
     cm->cache_line_flusher()->FlushPtEntry(pte);
 
+    if (!IS_PAGE_PRESENT(olde)) {
+        vm_page_t* page = counted_table_page(pte);
+        if (page) {
+            DEBUG_ASSERT(page->mmu.num_present < NO_OF_PT_ENTRIES);
+            page->mmu.num_present++;
+        }
+    }
+
     /* attempt to invalidate the page */
     if (IS_PAGE_PRESENT(olde)) {
         // TODO(teisenbe): the is_kernel_address should be a check for the
@@ -283,6 +300,14 @@ void X86PageTableBase::UnmapEntry(ConsistencyManager* cm, PageTableLevel level,
     *pte = 0;
     cm->cache_line_flusher()->FlushPtEntry(pte);
 
+    if (IS_PAGE_PRESENT(olde)) {
+        vm_page_t* page = counted_table_page(pte);
+        if (page) {
+            DEBUG_ASSERT(page->mmu.num_present > 0);
+            page->mmu.num_present--;
+        }
+    }
+
     /* attempt to invalidate the page */
     if (IS_PAGE_PRESENT(olde)) {
         // TODO(teisenbe): the is_kernel_address should be a check for the
@@ -301,6 +326,7 @@ static volatile pt_entry_t* _map_alloc_page(void) {
         return nullptr;
     }
     p->state = VM_PAGE_STATE_MMU;
+    p->mmu.num_present = 0;
 
     pt_entry_t* page_ptr = static_cast<pt_entry_t*>(paddr_to_physmap(pa));
     DEBUG_ASSERT(page_ptr);
@@ -484,41 +510,20 @@ bool X86PageTableBase::RemoveMapping(volatile pt_entry_t* table, PageTableLevel
 
         MappingCursor cursor;
         volatile pt_entry_t* next_table = get_next_table_from_entry(pt_val);
-        bool lower_unmapped = RemoveMapping(next_table, lower_level(level),
-                                            *new_cursor, &cursor, cm);
+        RemoveMapping(next_table, lower_level(level), *new_cursor, &cursor, cm);
 
         // If we were requesting to unmap everything in the lower page table,
-        // we know we can unmap the lower level page table.  Otherwise, if
-        // we unmapped anything in the lower level, check to see if that
-        // level is now empty.
+        // we know we can unmap the lower level page table.  Otherwise, check
+        // to see if that level is now empty.  This is done even if nothing
+        // was unmapped below, so that tables left empty by an earlier
+        // operation (such as a failed map) are reclaimed as well.
         bool unmap_page_table =
             page_aligned(level, new_cursor->vaddr) && new_cursor->size >= ps;
-        if (!unmap_page_table && lower_unmapped) {
-            uint lower_idx;
-            for (lower_idx = 0; lower_idx < NO_OF_PT_ENTRIES; ++lower_idx) {
-                if (IS_PAGE_PRESENT(next_table[lower_idx])) {
-                    break;
-                }
-            }
-            if (lower_idx == NO_OF_PT_ENTRIES) {
-                unmap_page_table = true;
-            }
+        if (!unmap_page_table) {
+            unmap_page_table = IsTableEmpty(next_table);
         }
         if (unmap_page_table) {
-            paddr_t ptable_phys = X86_VIRT_TO_PHYS(next_table);
-            LTRACEF("L: %d free pt v %#" PRIxPTR " phys %#" PRIxPTR "\n",
-                    level, (uintptr_t)next_table, ptable_phys);
-
-            UnmapEntry(cm, level, new_cursor->vaddr, e, false /* was_terminal */);
-            vm_page_t* page = paddr_to_vm_page(ptable_phys);
-
-            DEBUG_ASSERT(page);
-            DEBUG_ASSERT_MSG(page->state == VM_PAGE_STATE_MMU,
-                             "page %p state %u, paddr %#" PRIxPTR "\n", page, page->state,
-                             X86_VIRT_TO_PHYS(next_table));
-            DEBUG_ASSERT(!list_in_list(&page->queue_node));
-
-            cm->queue_free(page);
+            FreeTable(level, new_cursor->vaddr, e, next_table, cm);
             unmapped = true;
         }
         *new_cursor = cursor;
@@ -530,6 +535,40 @@ bool X86PageTableBase::RemoveMapping(volatile pt_entry_t* table, PageTableLevel
     return unmapped;
 }
 
+// Returns true if none of the entries in |table| are present.
+bool X86PageTableBase::IsTableEmpty(volatile pt_entry_t* table) {
+    vm_page_t* page = counted_table_page(table);
+    if (page) {
+        return page->mmu.num_present == 0;
+    }
+    for (uint i = 0; i < NO_OF_PT_ENTRIES; ++i) {
+        if (IS_PAGE_PRESENT(table[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Unlinks the lower level |table| referenced by the entry |e| at |level| and
+// queues it to be freed once the TLB invalidation has completed.
+void X86PageTableBase::FreeTable(PageTableLevel level, vaddr_t vaddr, volatile pt_entry_t* e,
+                                 volatile pt_entry_t* table, ConsistencyManager* cm) {
+    paddr_t ptable_phys = X86_VIRT_TO_PHYS(table);
+    LTRACEF("L: %d free pt v %#" PRIxPTR " phys %#" PRIxPTR "\n",
+            level, (uintptr_t)table, ptable_phys);
+
+    UnmapEntry(cm, level, vaddr, e, false /* was_terminal */);
+    vm_page_t* page = paddr_to_vm_page(ptable_phys);
+
+    DEBUG_ASSERT(page);
+    DEBUG_ASSERT_MSG(page->state == VM_PAGE_STATE_MMU,
+                     "page %p state %u, paddr %#" PRIxPTR "\n", page, page->state,
+                     ptable_phys);
+    DEBUG_ASSERT(!list_in_list(&page->queue_node));
+
+    cm->queue_free(page);
+}
+
 // Base case of RemoveMapping for smallest page size.
 bool X86PageTableBase::RemoveMappingL0(volatile pt_entry_t* table,
                                        const MappingCursor& start_cursor, MappingCursor* new_cursor,
@@ -628,6 +667,7 @@ zx_status_t X86PageTableBase::AddMapping(volatile pt_entry_t* table, uint mmu_fl
             DEBUG_ASSERT(new_cursor->size <= start_cursor.size);
         } else {
             // See if we need to create a new table
+            bool allocated_table = false;
             if (!IS_PAGE_PRESENT(pt_val)) {
                 volatile pt_entry_t* m = _map_alloc_page();
                 if (m == nullptr) {
@@ -640,16 +680,24 @@ zx_status_t X86PageTableBase::AddMapping(volatile pt_entry_t* table, uint mmu_fl
                             X86_VIRT_TO_PHYS(m), interm_flags, false /* was_terminal */);
                 pt_val = *e;
                 pages_++;
+                allocated_table = true;
             }
 
             MappingCursor cursor;
-            ret = AddMapping(get_next_table_from_entry(pt_val), mmu_flags,
-                             lower_level(level), *new_cursor, &cursor, cm);
-            *new_cursor = cursor;
-            DEBUG_ASSERT(new_cursor->size <= start_cursor.size);
+            volatile pt_entry_t* next_table = get_next_table_from_entry(pt_val);
+            ret = AddMapping(next_table, mmu_flags, lower_level(level), *new_cursor, &cursor, cm);
             if (ret != ZX_OK) {
+                // The abort handler only unmaps what was mapped before this
+                // entry, so don't leave behind a table we just created for
+                // it if nothing ended up in it.
+                if (allocated_table && IsTableEmpty(next_table)) {
+                    FreeTable(level, new_cursor->vaddr, e, next_table, cm);
+                }
+                *new_cursor = cursor;
                 return ret;
             }
+            *new_cursor = cursor;
+            DEBUG_ASSERT(new_cursor->size <= start_cursor.size);
         }
     }
     abort.cancel();
@@ -0,0 +1,78 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <zircon/types.h>
+#include <fbl/canary.h>
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/ref_ptr.h>
+#include <list.h>
+#include <object/dispatcher.h>
+#include <object/port_dispatcher.h>
+#include <vm/page_source.h>
+#include <vm/vm_object.h>
+
+class PagerDispatcher;
+
+// The page source of a VMO created by a pager. Requests for pages are sent as
+// ZX_PKT_TYPE_PAGE_REQUEST packets to the port the VMO was created with.
+class PagerSource final : public PageSource,
+                          public fbl::WAVLTreeContainable<fbl::RefPtr<PagerSource>> {
+public:
+    PagerSource(fbl::RefPtr<PagerDispatcher> pager, fbl::RefPtr<PortDispatcher> port,
+                uint64_t key);
+    ~PagerSource() final;
+
+    uintptr_t GetKey() const { return reinterpret_cast<uintptr_t>(this); }
+
+private:
+    zx_status_t SendRequest(uint64_t offset, uint64_t len) final;
+    void OnClose() final;
+
+    // Keeps the pager alive until every VMO it created is gone, so that
+    // closing the source can always unregister it.
+    const fbl::RefPtr<PagerDispatcher> pager_;
+    const fbl::RefPtr<PortDispatcher> port_;
+    const uint64_t key_;
+};
+
+class PagerDispatcher final : public SoloDispatcher<PagerDispatcher> {
+public:
+    static zx_status_t Create(fbl::RefPtr<Dispatcher>* dispatcher, zx_rights_t* rights);
+
+    ~PagerDispatcher() final;
+    zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_PAGER; }
+    bool has_state_tracker() const final { return false; }
+    void on_zero_handles() final;
+
+    // Creates a source whose page requests are queued on |port| with |key|.
+    zx_status_t CreateSource(fbl::RefPtr<PortDispatcher> port, uint64_t key,
+                             fbl::RefPtr<PageSource>* source);
+
+    // Closes the source of |vmo|, failing any outstanding and future
+    // requests for its pages.
+    zx_status_t DetachSource(VmObject* vmo);
+
+    // Moves |pages| into |vmo| at [offset, offset + len).
+    zx_status_t SupplyPages(VmObject* vmo, uint64_t offset, uint64_t len, list_node* pages);
+
+private:
+    friend PagerSource;
+
+    PagerDispatcher();
+
+    // Drops |source| from the set of sources created by this pager.
+    void RemoveSource(PagerSource* source);
+
+    // Returns true if |source| was created by this pager and is still open.
+    bool OwnsSource(PageSource* source);
+
+    fbl::Canary<fbl::magic("PGRD")> canary_;
+
+    bool closed_ TA_GUARDED(get_lock()) = false;
+    fbl::WAVLTree<uintptr_t, fbl::RefPtr<PagerSource>> sources_ TA_GUARDED(get_lock());
+};
@@ -0,0 +1,154 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <object/pager_dispatcher.h>
+
+#include <err.h>
+#include <inttypes.h>
+#include <trace.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/ref_ptr.h>
+
+#include <zircon/rights.h>
+#include <zircon/syscalls/port.h>
+
+#define LOCAL_TRACE 0
+
+PagerSource::PagerSource(fbl::RefPtr<PagerDispatcher> pager, fbl::RefPtr<PortDispatcher> port,
+                         uint64_t key)
+    : pager_(fbl::move(pager)), port_(fbl::move(port)), key_(key) {}
+
+PagerSource::~PagerSource() {
+    DEBUG_ASSERT(!InContainer());
+}
+
+zx_status_t PagerSource::SendRequest(uint64_t offset, uint64_t len) {
+    LTRACEF("key %#" PRIx64 " offset %#" PRIx64 " len %#" PRIx64 "\n", key_, offset, len);
+
+    auto port_packet = PortDispatcher::DefaultPortAllocator()->Alloc();
+    if (!port_packet) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    port_packet->packet.key = key_;
+    port_packet->packet.type = ZX_PKT_TYPE_PAGE_REQUEST;
+    port_packet->packet.status = ZX_OK;
+    port_packet->packet.page_request.command = ZX_PAGER_VMO_READ;
+    port_packet->packet.page_request.flags = 0;
+    port_packet->packet.page_request.reserved0 = 0;
+    port_packet->packet.page_request.offset = offset;
+    port_packet->packet.page_request.length = len;
+    port_packet->packet.page_request.reserved1 = 0;
+
+    zx_status_t status = port_->Queue(port_packet, 0, 0);
+    if (status != ZX_OK) {
+        port_packet->Free();
+        // A full port mustn't look like a queued request to the VMO.
+        return status == ZX_ERR_SHOULD_WAIT ? ZX_ERR_NO_RESOURCES : status;
+    }
+    return ZX_OK;
+}
+
+void PagerSource::OnClose() {
+    pager_->RemoveSource(this);
+}
+
+zx_status_t PagerDispatcher::Create(fbl::RefPtr<Dispatcher>* dispatcher, zx_rights_t* rights) {
+    fbl::AllocChecker ac;
+    auto disp = new (&ac) PagerDispatcher();
+    if (!ac.check())
+        return ZX_ERR_NO_MEMORY;
+
+    *rights = ZX_DEFAULT_PAGER_RIGHTS;
+    *dispatcher = fbl::AdoptRef<Dispatcher>(disp);
+    return ZX_OK;
+}
+
+PagerDispatcher::PagerDispatcher() {}
+
+PagerDispatcher::~PagerDispatcher() {
+    DEBUG_ASSERT(sources_.is_empty());
+}
+
+zx_status_t PagerDispatcher::CreateSource(fbl::RefPtr<PortDispatcher> port, uint64_t key,
+                                          fbl::RefPtr<PageSource>* source) {
+    canary_.Assert();
+
+    fbl::AllocChecker ac;
+    auto src = fbl::AdoptRef(new (&ac) PagerSource(fbl::WrapRefPtr(this), fbl::move(port), key));
+    if (!ac.check())
+        return ZX_ERR_NO_MEMORY;
+
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        if (closed_) {
+            return ZX_ERR_BAD_STATE;
+        }
+        sources_.insert(src);
+    }
+
+    *source = fbl::move(src);
+    return ZX_OK;
+}
+
+void PagerDispatcher::RemoveSource(PagerSource* source) {
+    fbl::RefPtr<PagerSource> removed;
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        if (source->InContainer()) {
+            removed = sources_.erase(*source);
+        }
+    }
+    // |removed| may hold the last reference to the source, and through it to
+    // us, so it is dropped here with our lock released.
+}
+
+bool PagerDispatcher::OwnsSource(PageSource* source) {
+    Guard<fbl::Mutex> guard{get_lock()};
+    return source && sources_.find(reinterpret_cast<uintptr_t>(source)).IsValid();
+}
+
+zx_status_t PagerDispatcher::DetachSource(VmObject* vmo) {
+    canary_.Assert();
+
+    PageSource* source = vmo->page_source();
+    if (!OwnsSource(source)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    // the vmo holds a reference to its source, so it can't go away under us
+    source->Close();
+    return ZX_OK;
+}
+
+zx_status_t PagerDispatcher::SupplyPages(VmObject* vmo, uint64_t offset, uint64_t len,
+                                         list_node* pages) {
+    canary_.Assert();
+
+    if (!OwnsSource(vmo->page_source())) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    return vmo->SupplyPages(offset, len, pages);
+}
+
+void PagerDispatcher::on_zero_handles() {
+    canary_.Assert();
+
+    fbl::WAVLTree<uintptr_t, fbl::RefPtr<PagerSource>> sources;
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        closed_ = true;
+        sources = fbl::move(sources_);
+    }
+
+    // Nothing will supply the pages of our vmos anymore, so fail any reads.
+    while (!sources.is_empty()) {
+        fbl::RefPtr<PagerSource> source = sources.pop_front();
+        source->Close();
+    }
+}
@@ -557,6 +557,22 @@ zx_status_t ProcessDispatcher::GetStats(zx_info_task_stats_t* stats) {
     return ZX_OK;
 }
 
+zx_status_t ProcessDispatcher::GetVmStats(zx_info_task_vm_stats_t* stats) {
+    DEBUG_ASSERT(stats != nullptr);
+    Guard<fbl::Mutex> guard{get_lock()};
+    if (state_ != State::RUNNING) {
+        return ZX_ERR_BAD_STATE;
+    }
+    VmAspace::vm_usage_t usage;
+    zx_status_t s = aspace_->GetMemoryUsage(&usage);
+    if (s != ZX_OK) {
+        return s;
+    }
+    stats->mem_zero_reclaimed_bytes = usage.zero_reclaimed_pages * PAGE_SIZE;
+    stats->mem_page_table_bytes = aspace_->arch_aspace().pt_pages() * PAGE_SIZE;
+    return ZX_OK;
+}
+
 zx_status_t ProcessDispatcher::GetAspaceMaps(
     user_out_ptr<zx_info_maps_t> maps, size_t max,
     size_t* actual, size_t* available) {
@@ -327,6 +327,22 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         return single_record_result(
             _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
     }
+    case ZX_INFO_TASK_VM_STATS: {
+        fbl::RefPtr<ProcessDispatcher> process;
+        auto error = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT,
+                                                 &process);
+        if (error < 0)
+            return error;
+
+        zx_info_task_vm_stats_t info = {};
+
+        auto err = process->GetVmStats(&info);
+        if (err != ZX_OK)
+            return err;
+
+        return single_record_result(
+            _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
+    }
     case ZX_INFO_PROCESS_MAPS: {
         fbl::RefPtr<ProcessDispatcher> process;
         zx_status_t status =
@@ -0,0 +1,167 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <err.h>
+#include <inttypes.h>
+#include <trace.h>
+
+#include <lib/counters.h>
+
+#include <vm/pmm.h>
+#include <vm/vm_object.h>
+#include <vm/vm_object_paged.h>
+
+#include <object/handle.h>
+#include <object/pager_dispatcher.h>
+#include <object/port_dispatcher.h>
+#include <object/process_dispatcher.h>
+#include <object/vm_object_dispatcher.h>
+
+#include <fbl/ref_ptr.h>
+
+#include "priv.h"
+
+#define LOCAL_TRACE 0
+
+KCOUNTER(pager_supply_pages, "kernel.pager.supply_pages");
+
+zx_status_t sys_pager_create(uint32_t options, user_out_handle* out) {
+    if (options) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    fbl::RefPtr<Dispatcher> dispatcher;
+    zx_rights_t rights;
+    zx_status_t status = PagerDispatcher::Create(&dispatcher, &rights);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    return out->make(fbl::move(dispatcher), rights);
+}
+
+zx_status_t sys_pager_create_vmo(zx_handle_t pager, zx_handle_t port, uint64_t key,
+                                 uint64_t size, uint32_t options, user_out_handle* out) {
+    LTRACEF("pager %x port %x key %#" PRIx64 " size %#" PRIx64 "\n", pager, port, key, size);
+
+    if (options) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    auto up = ProcessDispatcher::GetCurrent();
+    zx_status_t status = up->QueryPolicy(ZX_POL_NEW_VMO);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<PagerDispatcher> pager_dispatcher;
+    status = up->GetDispatcherWithRights(pager, ZX_RIGHT_WRITE, &pager_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<PortDispatcher> port_dispatcher;
+    status = up->GetDispatcherWithRights(port, ZX_RIGHT_WRITE, &port_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<PageSource> src;
+    status = pager_dispatcher->CreateSource(fbl::move(port_dispatcher), key, &src);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<VmObject> vmo;
+    status = VmObjectPaged::CreateWithSource(PMM_ALLOC_FLAG_ANY, size, src, &vmo);
+    if (status != ZX_OK) {
+        // the vmo never took ownership of the source, so unregister it here
+        src->Close();
+        return status;
+    }
+
+    fbl::RefPtr<Dispatcher> dispatcher;
+    zx_rights_t rights;
+    status = VmObjectDispatcher::Create(fbl::move(vmo), &dispatcher, &rights);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    return out->make(fbl::move(dispatcher), rights);
+}
+
+zx_status_t sys_pager_detach_vmo(zx_handle_t pager, zx_handle_t vmo) {
+    LTRACEF("pager %x vmo %x\n", pager, vmo);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<PagerDispatcher> pager_dispatcher;
+    zx_status_t status = up->GetDispatcherWithRights(pager, ZX_RIGHT_WRITE, &pager_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<VmObjectDispatcher> vmo_dispatcher;
+    status = up->GetDispatcherWithRights(vmo, ZX_RIGHT_WRITE, &vmo_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    return pager_dispatcher->DetachSource(vmo_dispatcher->vmo().get());
+}
+
+zx_status_t sys_pager_supply_pages(zx_handle_t pager, zx_handle_t pager_vmo,
+                                   uint64_t offset, uint64_t length,
+                                   zx_handle_t aux_vmo, uint64_t aux_offset) {
+    LTRACEF("pager %x pager_vmo %x offset %#" PRIx64 " length %#" PRIx64
+            " aux_vmo %x aux_offset %#" PRIx64 "\n",
+            pager, pager_vmo, offset, length, aux_vmo, aux_offset);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<PagerDispatcher> pager_dispatcher;
+    zx_status_t status = up->GetDispatcherWithRights(pager, ZX_RIGHT_WRITE, &pager_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<VmObjectDispatcher> pager_vmo_dispatcher;
+    status = up->GetDispatcherWithRights(pager_vmo, ZX_RIGHT_WRITE, &pager_vmo_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<VmObjectDispatcher> aux_vmo_dispatcher;
+    status = up->GetDispatcherWithRights(aux_vmo, ZX_RIGHT_READ | ZX_RIGHT_WRITE,
+                                         &aux_vmo_dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(length) || !IS_PAGE_ALIGNED(aux_offset)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (aux_vmo_dispatcher->vmo() == pager_vmo_dispatcher->vmo()) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    // Move the pages out of the aux vmo, then into the pager's vmo. Nothing is
+    // copied; on failure the pages that were taken are simply freed.
+    list_node pages;
+    list_initialize(&pages);
+    status = aux_vmo_dispatcher->vmo()->TakePages(aux_offset, length, &pages);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    status = pager_dispatcher->SupplyPages(pager_vmo_dispatcher->vmo().get(), offset, length,
+                                           &pages);
+    pmm_free(&pages);
+    if (status == ZX_OK) {
+        kcounter_add(pager_supply_pages, 1);
+    }
+    return status;
+}
@@ -21,6 +21,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <trace.h>
+#include <vm/vm_object_paged.h>
 
 const size_t BUFSIZE = (3 * 1024 * 1024); // must be smaller than max allowed heap allocation
 const size_t ITER = (1UL * 1024 * 1024 * 1024 / BUFSIZE); // enough iterations to have to copy/set 1GB of memory
@@ -270,6 +271,44 @@ __NO_INLINE static void bench_mutex() {
     printf("%" PRIu64 " cycles to acquire/release uncontended mutex %u times (%" PRIu64 " cycles per)\n", c, count, c / count);
 }
 
+// Measures commit and decommit throughput for a range of VMO sizes.
+__NO_INLINE static void bench_vmo_commit_decommit() {
+    static const size_t kSizes[] = {1 * MB, 4 * MB, 16 * MB, 64 * MB};
+    for (size_t size : kSizes) {
+        fbl::RefPtr<VmObject> vmo;
+        zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, size, &vmo);
+        if (status != ZX_OK) {
+            TRACEF("error: vmo creation failed: %d\n", status);
+            return;
+        }
+
+        uint64_t n;
+        zx_time_t start = current_time();
+        status = vmo->CommitRange(0, size, &n);
+        zx_duration_t commit_time = current_time() - start;
+        if (status != ZX_OK) {
+            TRACEF("error: commit of %zu bytes failed: %d\n", size, status);
+            return;
+        }
+
+        start = current_time();
+        status = vmo->DecommitRange(0, size, &n);
+        zx_duration_t decommit_time = current_time() - start;
+        if (status != ZX_OK) {
+            TRACEF("error: decommit of %zu bytes failed: %d\n", size, status);
+            return;
+        }
+
+        printf("%3zuMB: commit %6" PRIi64 "us (%5" PRIu64 " MB/s), "
+               "decommit %6" PRIi64 "us (%5" PRIu64 " MB/s)\n",
+               size / MB,
+               commit_time / ZX_USEC(1),
+               size * ZX_SEC(1) / MB / MAX(commit_time, 1),
+               decommit_time / ZX_USEC(1),
+               size * ZX_SEC(1) / MB / MAX(decommit_time, 1));
+    }
+}
+
 int benchmarks(int, const cmd_args*, uint32_t) {
     bench_set_overhead();
     bench_memcpy();
@@ -287,5 +326,7 @@ int benchmarks(int, const cmd_args*, uint32_t) {
     bench_spinlock();
     bench_mutex();
 
+    bench_vmo_commit_decommit();
+
     return 0;
 }
@@ -0,0 +1,131 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <vm/compressed_page.h>
+
+#include <assert.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/atomic.h>
+#include <fbl/mutex.h>
+#include <inttypes.h>
+#include <kernel/cmdline.h>
+#include <kernel/mutex.h>
+#include <lib/counters.h>
+#include <lk/init.h>
+#include <lz4/lz4.h>
+#include <platform.h>
+#include <string.h>
+#include <trace.h>
+#include <vm/vm.h>
+
+#include "vm_priv.h"
+
+#define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
+
+KCOUNTER(compressed_pages, "kernel.vm.compression.pages_compressed");
+KCOUNTER(incompressible_pages, "kernel.vm.compression.pages_incompressible");
+KCOUNTER(compressed_bytes_in, "kernel.vm.compression.bytes_in");
+KCOUNTER(compressed_bytes_out, "kernel.vm.compression.bytes_out");
+KCOUNTER(decompressed_pages, "kernel.vm.compression.pages_decompressed");
+KCOUNTER(decompress_ns, "kernel.vm.compression.decompress_ns");
+
+namespace {
+
+// Pages that don't shrink to at most this size are left uncompressed; the
+// savings wouldn't pay for the faults needed to bring them back.
+constexpr size_t kMaxCompressedSize = PAGE_SIZE * 3 / 4;
+
+// Set once at init time.
+size_t store_budget;
+
+fbl::atomic<size_t> store_bytes;
+
+// The LZ4 compression state is too large for a kernel stack, so a single
+// static copy is shared, along with the scratch output buffer.
+DECLARE_SINGLETON_MUTEX(CompressLock);
+LZ4_stream_t compress_state TA_GUARDED(CompressLock::Get());
+char compress_buf[kMaxCompressedSize] TA_GUARDED(CompressLock::Get());
+
+void compressed_page_init(uint level) {
+    // Be sure to update kernel_cmdline.md if this default changes.
+    store_budget = cmdline_get_uint64("kernel.page-compressor.budget-mb", 64) * MB;
+}
+
+} // namespace
+
+LK_INIT_HOOK(compressed_page, compressed_page_init, LK_INIT_LEVEL_VM);
+
+VmCompressedPage::VmCompressedPage(uint64_t offset, fbl::unique_ptr<uint8_t[]> data, size_t size)
+    : offset_(offset), data_(fbl::move(data)), size_(size) {
+    LTRACEF("%p offset %#" PRIx64 " size %zu\n", this, offset_, size_);
+}
+
+VmCompressedPage::~VmCompressedPage() {
+    canary_.Assert();
+    LTRACEF("%p offset %#" PRIx64 "\n", this, offset_);
+
+    store_bytes.fetch_sub(size_);
+}
+
+zx_status_t VmCompressedPage::Create(uint64_t offset, const void* src,
+                                     fbl::unique_ptr<VmCompressedPage>* out) {
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(offset));
+
+    Guard<fbl::Mutex> guard{CompressLock::Get()};
+
+    int size = LZ4_compress_fast_extState(&compress_state, static_cast<const char*>(src),
+                                          compress_buf, PAGE_SIZE, sizeof(compress_buf), 1);
+    if (size <= 0) {
+        kcounter_add(incompressible_pages, 1);
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    // Reserve space in the store before allocating anything.
+    if (store_bytes.fetch_add(size) + size > store_budget) {
+        store_bytes.fetch_sub(size);
+        return ZX_ERR_NO_SPACE;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[size]);
+    if (!ac.check()) {
+        store_bytes.fetch_sub(size);
+        return ZX_ERR_NO_MEMORY;
+    }
+    memcpy(data.get(), compress_buf, size);
+
+    out->reset(new (&ac) VmCompressedPage(offset, fbl::move(data), size));
+    if (!ac.check()) {
+        store_bytes.fetch_sub(size);
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    kcounter_add(compressed_pages, 1);
+    kcounter_add(compressed_bytes_in, PAGE_SIZE);
+    kcounter_add(compressed_bytes_out, size);
+    return ZX_OK;
+}
+
+void VmCompressedPage::Decompress(void* dst) const {
+    canary_.Assert();
+
+    const zx_time_t start = current_time();
+    __UNUSED int size = LZ4_decompress_safe(reinterpret_cast<const char*>(data_.get()),
+                                            static_cast<char*>(dst), static_cast<int>(size_),
+                                            PAGE_SIZE);
+    ASSERT_MSG(size == PAGE_SIZE, "corrupt compressed page %p: %d\n", this, size);
+
+    kcounter_add(decompressed_pages, 1);
+    kcounter_add(decompress_ns, current_time() - start);
+}
+
+size_t VmCompressedPage::StoreBytes() {
+    return store_bytes.load();
+}
+
+size_t VmCompressedPage::StoreBudget() {
+    return store_budget;
+}
@@ -67,4 +67,7 @@ public:
     // This should be treated as an opaque value outside of
     // architecture-specific components.
     virtual paddr_t arch_table_phys() const = 0;
+
+    // Number of pages currently allocated for the translation tables.
+    virtual size_t pt_pages() const = 0;
 };
@@ -0,0 +1,55 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <fbl/canary.h>
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <stdint.h>
+#include <zircon/types.h>
+
+// An LZ4-compressed copy of one page of a VmObjectPaged, keyed by the page's
+// offset within the object. All compressed pages share a single system-wide
+// budget, set with kernel.page-compressor.budget-mb.
+class VmCompressedPage final
+    : public fbl::WAVLTreeContainable<fbl::unique_ptr<VmCompressedPage>> {
+public:
+    // Compresses the page at |src| on behalf of the object offset |offset|.
+    // Returns ZX_ERR_NO_SPACE if the store's budget is exhausted, and
+    // ZX_ERR_OUT_OF_RANGE if the page doesn't compress well enough to be
+    // worth keeping in compressed form.
+    static zx_status_t Create(uint64_t offset, const void* src,
+                              fbl::unique_ptr<VmCompressedPage>* out);
+
+    ~VmCompressedPage();
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(VmCompressedPage);
+
+    // accessors
+    uint64_t offset() const { return offset_; }
+    uint64_t GetKey() const { return offset_; }
+    size_t compressed_size() const { return size_; }
+
+    // Decompresses the page into the page-sized buffer at |dst|.
+    void Decompress(void* dst) const;
+
+    // Returns the number of bytes currently held by all compressed pages.
+    static size_t StoreBytes();
+
+    // Returns the maximum number of bytes all compressed pages may hold.
+    static size_t StoreBudget();
+
+private:
+    VmCompressedPage(uint64_t offset, fbl::unique_ptr<uint8_t[]> data, size_t size);
+
+    fbl::Canary<fbl::magic("VMCP")> canary_;
+
+    const uint64_t offset_;
+    const fbl::unique_ptr<uint8_t[]> data_;
+    const size_t size_;
+};
@@ -47,7 +47,16 @@ typedef struct vm_page {
 #define VM_PAGE_OBJECT_MAX_PIN_COUNT ((1ul << VM_PAGE_OBJECT_PIN_COUNT_BITS) - 1)
 
             uint8_t pin_count : VM_PAGE_OBJECT_PIN_COUNT_BITS;
+
+            // Set whenever a fault finds the page, and cleared by the page
+            // compressor, which only compresses pages it finds clear.
+            uint8_t referenced : 1;
         } object; // attached to a vm object
+
+        struct {
+            // Number of present entries, for page tables that keep count.
+            uint16_t num_present;
+        } mmu; // allocated for the mmu
     };
 
     // helper routines
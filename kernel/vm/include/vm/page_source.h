@@ -0,0 +1,103 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <fbl/canary.h>
+#include <fbl/intrusive_double_list.h>
+#include <fbl/macros.h>
+#include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
+#include <kernel/event.h>
+#include <kernel/lockdep.h>
+#include <kernel/mutex.h>
+#include <stdint.h>
+#include <zircon/thread_annotations.h>
+#include <zircon/types.h>
+
+class PageSource;
+
+// A thread's request for a page that a VmObjectPaged doesn't have yet and has
+// to get from its PageSource. Requests live on the stack of the waiting
+// thread, which queues one with the VMO's lock held and then waits on it
+// after dropping every lock.
+class PageRequest : public fbl::DoublyLinkedListable<PageRequest*> {
+public:
+    PageRequest();
+    ~PageRequest();
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(PageRequest);
+
+    // Waits for the requested page to be supplied. Returns ZX_OK once it has
+    // been, ZX_ERR_BAD_STATE if the source was closed first, or an error if
+    // the wait was interrupted. In every case the request is finished and may
+    // be queued again.
+    zx_status_t Wait();
+
+private:
+    friend PageSource;
+
+    fbl::RefPtr<PageSource> source_;
+    uint64_t offset_ = 0;
+    zx_status_t status_ = ZX_OK;
+    // Set, under the source's lock, once the source has taken the request off
+    // its queue to signal it.
+    bool completing_ = false;
+    event_t event_;
+};
+
+// Provides the contents of the pages of a VmObjectPaged that are not yet
+// resident. When a thread needs such a page, the VMO queues a PageRequest
+// with its source, which passes it on to the provider with SendRequest().
+// The provider answers by supplying the pages to the VMO, which then calls
+// OnPagesSupplied() to wake the waiting threads.
+//
+// Methods other than Close() are called with the VMO's lock held.
+class PageSource : public fbl::RefCounted<PageSource> {
+public:
+    PageSource() = default;
+    virtual ~PageSource();
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(PageSource);
+
+    // Queues |request| for the page at |offset|, asking the provider for it
+    // unless another request for the same page is already outstanding.
+    // Returns ZX_ERR_SHOULD_WAIT if the request was queued.
+    zx_status_t GetPage(uint64_t offset, PageRequest* request);
+
+    // Completes all queued requests for pages in [offset, offset + len).
+    void OnPagesSupplied(uint64_t offset, uint64_t len);
+
+    // Fails all queued requests, and any made from now on, with
+    // ZX_ERR_BAD_STATE.
+    void Close();
+
+    bool is_closed() const;
+
+protected:
+    // Asks the provider for the pages in [offset, offset + len).
+    virtual zx_status_t SendRequest(uint64_t offset, uint64_t len) = 0;
+
+    // Called once, without any locks held, when the source is first closed.
+    virtual void OnClose() {}
+
+private:
+    friend PageRequest;
+
+    // Drops |request| if it is still queued. Returns false if the request
+    // is already being completed, in which case it will still be signaled.
+    bool CancelRequest(PageRequest* request);
+
+    // Signals each of |requests|, which have been taken off the queue, with
+    // no locks held.
+    static void SignalRequests(fbl::DoublyLinkedList<PageRequest*>* requests, bool reschedule);
+
+    fbl::Canary<fbl::magic("VMPS")> canary_;
+
+    mutable DECLARE_MUTEX(PageSource) lock_;
+    bool closed_ TA_GUARDED(lock_) = false;
+    fbl::DoublyLinkedList<PageRequest*> pending_requests_ TA_GUARDED(lock_);
+};
@@ -116,8 +116,16 @@ public:
     fbl::RefPtr<VmMapping> as_vm_mapping();
 
     // Page fault in an address within the region.  Recursively traverses
-    // the regions to find the target mapping, if it exists.
-    virtual zx_status_t PageFault(vaddr_t va, uint pf_flags) = 0;
+    // the regions to find the target mapping, if it exists.  Must be called
+    // with the aspace lock held through |aspace_guard|; the mapping releases
+    // it once it holds its VMO's lock, so that the rest of the fault doesn't
+    // serialize with other faults and mapping changes in the address space.
+    //
+    // If the page has to come from a pager, |page_request| is queued for it
+    // and ZX_ERR_SHOULD_WAIT is returned, with all locks dropped; the caller
+    // waits on the request and then retries the fault.
+    virtual zx_status_t PageFault(vaddr_t va, uint pf_flags, Guard<fbl::Mutex>* aspace_guard,
+                                  PageRequest* page_request) = 0;
 
     // WAVL tree key function
     vaddr_t GetKey() const { return base(); }
@@ -243,7 +251,8 @@ public:
     bool has_parent() const;
 
     void Dump(uint depth, bool verbose) const override;
-    zx_status_t PageFault(vaddr_t va, uint pf_flags) override;
+    zx_status_t PageFault(vaddr_t va, uint pf_flags, Guard<fbl::Mutex>* aspace_guard,
+                          PageRequest* page_request) override;
 
 protected:
     // constructor for use in creating a VmAddressRegionDummy
@@ -384,7 +393,8 @@ public:
         return;
     }
 
-    zx_status_t PageFault(vaddr_t va, uint pf_flags) override {
+    zx_status_t PageFault(vaddr_t va, uint pf_flags, Guard<fbl::Mutex>* aspace_guard,
+                          PageRequest* page_request) override {
         // We should never be trying to page fault on this...
         ASSERT(false);
         return ZX_ERR_BAD_STATE;
@@ -448,7 +458,8 @@ public:
     bool is_mapping() const override { return true; }
 
     void Dump(uint depth, bool verbose) const override;
-    zx_status_t PageFault(vaddr_t va, uint pf_flags) override;
+    zx_status_t PageFault(vaddr_t va, uint pf_flags, Guard<fbl::Mutex>* aspace_guard,
+                          PageRequest* page_request) override;
 
 protected:
     ~VmMapping() override;
@@ -494,6 +505,10 @@ private:
     void ActivateLocked();
 
     // pointer and region of the object we are mapping
+    //
+    // object_offset_, arch_mmu_flags_ and the base_ and size_ of the mapping
+    // are only changed while holding both the aspace lock and the object's
+    // lock, so PageFault can rely on them with just the latter held.
     fbl::RefPtr<VmObject> object_;
     uint64_t object_offset_ = 0;
 
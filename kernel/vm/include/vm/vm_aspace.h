@@ -113,6 +113,10 @@ public:
         //
         // This number is strictly smaller than shared_pages * PAGE_SIZE.
         size_t scaled_shared_bytes;
+
+        // A count of pages freed by the zero page scanner from VmObjects
+        // mapped into this address space.
+        size_t zero_reclaimed_pages;
     };
 
     // Counts memory usage under the VmAspace.
@@ -196,6 +200,8 @@ private:
     bool aspace_destroyed_ = false;
     bool aslr_enabled_ = false;
 
+    // Serializes changes to the region tree. Page faults only hold it while
+    // looking up their mapping; see VmMapping::PageFault.
     mutable DECLARE_MUTEX(VmAspace) lock_;
 
     // root of virtual address space
@@ -26,6 +26,8 @@
 #include <zircon/types.h>
 
 class VmMapping;
+class PageRequest;
+class PageSource;
 
 typedef zx_status_t (*vmo_lookup_fn_t)(void* context, size_t offset, size_t index, paddr_t pa);
 
@@ -56,6 +58,12 @@ public:
     virtual bool is_contiguous() const { return false; }
     // Returns true if the object size can be changed.
     virtual bool is_resizable() const { return false; }
+    // Returns true if missing pages of the object, or of an object it was
+    // cloned from, are supplied by a PageSource rather than zero filled.
+    virtual bool is_pager_backed() const { return false; }
+
+    // Returns the source that supplies the object's missing pages, if any.
+    virtual PageSource* page_source() const { return nullptr; }
 
     // Returns the number of physical pages currently allocated to the
     // object where (offset <= page_offset < offset+len).
@@ -68,6 +76,28 @@ public:
         return AllocatedPagesInRange(0, size());
     }
 
+    // Returns the number of committed pages that have been returned to the
+    // shared zero page by ScanForZeroPages().
+    virtual size_t ReclaimedZeroPages() const { return 0; }
+
+    // Examines up to |max_pages| committed pages, resuming where the previous
+    // call left off, and frees any page that contains only zeroes so that
+    // later reads are satisfied by the shared zero page. Returns the number of
+    // pages freed; the number of pages examined is returned in |scanned|.
+    virtual size_t ScanForZeroPages(size_t max_pages, size_t* scanned) {
+        *scanned = 0;
+        return 0;
+    }
+
+    // Examines up to |max_pages| committed pages, resuming where the previous
+    // call left off, and moves pages that have not been faulted on since the
+    // previous call into the compressed page store. Returns the number of
+    // pages compressed; the number examined is returned in |scanned|.
+    virtual size_t CompressPages(size_t max_pages, size_t* scanned) {
+        *scanned = 0;
+        return 0;
+    }
+
     // find physical pages to back the range of the object
     virtual zx_status_t CommitRange(uint64_t offset, uint64_t len, uint64_t* committed) {
         return ZX_ERR_NOT_SUPPORTED;
@@ -84,6 +114,21 @@ public:
         return ZX_ERR_NOT_SUPPORTED;
     }
 
+    // Move the committed pages in the page aligned range [offset, offset + len)
+    // out of the object, appending them to |pages| in offset order. Every page
+    // in the range must be committed and unpinned.
+    virtual zx_status_t TakePages(uint64_t offset, uint64_t len, list_node* pages) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Hand the pages in |pages|, in offset order, to the page aligned range
+    // [offset, offset + len) of an object created with a PageSource, waking
+    // any threads waiting for them. Pages for offsets that are already
+    // resident are freed instead. |pages| is empty on return.
+    virtual zx_status_t SupplyPages(uint64_t offset, uint64_t len, list_node* pages) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
     // Unpin the given range of the vmo.  This asserts if it tries to unpin a
     // page that is already not pinned (do not expose this function to
     // usermode).
@@ -180,7 +225,12 @@ public:
 
     // get a pointer to the page structure and/or physical address at the specified offset.
     // valid flags are VMM_PF_FLAG_*
+    //
+    // If the page has to come from a PageSource and |page_request| is not null,
+    // the request is queued and ZX_ERR_SHOULD_WAIT is returned; the caller
+    // must drop the lock, wait on the request and try again.
     virtual zx_status_t GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
+                                      PageRequest* page_request,
                                       vm_page_t** page, paddr_t* pa) TA_REQ(lock_) {
         return ZX_ERR_NOT_SUPPORTED;
     }
@@ -219,6 +269,15 @@ public:
         return ZX_OK;
     }
 
+    // Runs ScanForZeroPages() over every VMO in the system, examining at most
+    // |max_pages| pages in total. Successive calls pick up with the VMO after
+    // the last one examined. Returns the number of pages freed.
+    static size_t ScanAllForZeroPages(size_t max_pages);
+
+    // Runs CompressPages() over every VMO in the system in the same manner as
+    // ScanAllForZeroPages(). Returns the number of pages compressed.
+    static size_t CompressAllPages(size_t max_pages);
+
 protected:
     // private constructor (use Create())
     explicit VmObject(fbl::RefPtr<VmObject> parent);
@@ -288,4 +347,16 @@ private:
     using GlobalList = fbl::DoublyLinkedList<VmObject*, GlobalListTraits>;
     DECLARE_SINGLETON_MUTEX(AllVmosLock);
     static GlobalList all_vmos_ TA_GUARDED(AllVmosLock::Get());
+
+    // Walks |all_vmos_| from |*cursor| calling |scan_func| on each VMO until
+    // |max_pages| pages have been examined or the end of the list is reached.
+    template <typename F>
+    static size_t ScanAll(size_t* cursor, size_t max_pages, F scan_func);
+
+    // Serializes the system-wide scans below.
+    DECLARE_SINGLETON_MUTEX(ScanLock);
+
+    // Indices into |all_vmos_| where the next system-wide scans start.
+    static size_t zero_scan_cursor_ TA_GUARDED(ScanLock::Get());
+    static size_t compress_cursor_ TA_GUARDED(ScanLock::Get());
 };
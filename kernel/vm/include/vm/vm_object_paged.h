@@ -17,6 +17,8 @@
 #include <lib/user_copy/user_ptr.h>
 #include <list.h>
 #include <stdint.h>
+#include <vm/compressed_page.h>
+#include <vm/page_source.h>
 #include <vm/pmm.h>
 #include <vm/vm.h>
 #include <vm/vm_aspace.h>
@@ -44,6 +46,12 @@ public:
 
     static zx_status_t CreateFromROData(const void* data, size_t size, fbl::RefPtr<VmObject>* vmo);
 
+    // Create a non-resizable VMO whose pages are supplied by |src| as they
+    // are first needed, rather than zero filled. The VMO closes |src| when it
+    // is destroyed.
+    static zx_status_t CreateWithSource(uint32_t pmm_alloc_flags, uint64_t size,
+                                        fbl::RefPtr<PageSource> src, fbl::RefPtr<VmObject>* vmo);
+
     zx_status_t Resize(uint64_t size) override;
     zx_status_t ResizeLocked(uint64_t size) override TA_REQ(lock_);
     uint32_t create_options() const override { return options_; }
@@ -54,12 +62,25 @@ public:
     bool is_paged() const override { return true; }
     bool is_contiguous() const override {return (options_ & kContiguous); }
     bool is_resizable() const override { return (options_ & kResizable); }
+    bool is_pager_backed() const override {
+        return page_source_ || (parent_ && parent_->is_pager_backed());
+    }
+    PageSource* page_source() const override { return page_source_.get(); }
 
     size_t AllocatedPagesInRange(uint64_t offset, uint64_t len) const override;
 
+    size_t ReclaimedZeroPages() const override;
+    size_t ScanForZeroPages(size_t max_pages, size_t* scanned) override
+        // Calls a Locked method of the parent, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+    size_t CompressPages(size_t max_pages, size_t* scanned) override;
+
     zx_status_t CommitRange(uint64_t offset, uint64_t len, uint64_t* committed) override;
     zx_status_t DecommitRange(uint64_t offset, uint64_t len, uint64_t* decommitted) override;
 
+    zx_status_t TakePages(uint64_t offset, uint64_t len, list_node* pages) override;
+    zx_status_t SupplyPages(uint64_t offset, uint64_t len, list_node* pages) override;
+
     zx_status_t Pin(uint64_t offset, uint64_t len) override;
     void Unpin(uint64_t offset, uint64_t len) override;
 
@@ -82,7 +103,7 @@ public:
     zx_status_t SyncCache(const uint64_t offset, const uint64_t len) override;
 
     zx_status_t GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
-                              vm_page_t**, paddr_t*) override
+                              PageRequest* page_request, vm_page_t**, paddr_t*) override
         // Calls a Locked method of the parent, which confuses analysis.
         TA_NO_THREAD_SAFETY_ANALYSIS;
 
@@ -103,8 +124,8 @@ public:
 
 private:
     // private constructor (use Create())
-    VmObjectPaged(
-        uint32_t options, uint32_t pmm_alloc_flags, uint64_t size, fbl::RefPtr<VmObject> parent);
+    VmObjectPaged(uint32_t options, uint32_t pmm_alloc_flags, uint64_t size,
+                  fbl::RefPtr<VmObject> parent, fbl::RefPtr<PageSource> page_source);
 
     // private destructor, only called from refptr
     ~VmObjectPaged() override;
@@ -132,6 +153,25 @@ private:
     // internal check if any pages in a range are pinned
     bool AnyPagesPinnedLocked(uint64_t offset, size_t len) TA_REQ(lock_);
 
+    // whether the page scanners may free or compress this object's pages
+    bool CanReclaimPagesLocked() const TA_REQ(lock_);
+
+    // whether a read at |offset| would see data held by this object or an
+    // ancestor, resident or compressed, rather than zeroes. Unlike
+    // GetPageLocked() it never allocates or faults anything in.
+    bool HasPageLocked(uint64_t offset) TA_REQ(lock_)
+        // Calls a Locked method of the parent, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // bring the compressed page at |offset| back into the page list, taking
+    // the new page from |free_list| if possible. Returns ZX_ERR_NOT_FOUND if
+    // there is no compressed page at |offset|.
+    zx_status_t DecompressPageLocked(uint64_t offset, list_node* free_list,
+                                     vm_page_t** page_out) TA_REQ(lock_);
+
+    // drop compressed pages in the range [start, end), returning how many
+    size_t FreeCompressedPagesLocked(uint64_t start, uint64_t end) TA_REQ(lock_);
+
     // internal read/write routine that takes a templated copy function to help share some code
     template <typename T>
     zx_status_t ReadWriteInternal(uint64_t offset, size_t len, bool write, T copyfunc);
@@ -146,6 +186,21 @@ private:
     uint32_t pmm_alloc_flags_ TA_GUARDED(lock_) = PMM_ALLOC_FLAG_ANY;
     uint32_t cache_policy_ TA_GUARDED(lock_) = ARCH_MMU_FLAG_CACHED;
 
+    // offset at which the next ScanForZeroPages() call resumes
+    uint64_t zero_scan_offset_ TA_GUARDED(lock_) = 0;
+
+    // number of pages freed by ScanForZeroPages() over the object's lifetime
+    size_t zero_pages_reclaimed_ TA_GUARDED(lock_) = 0;
+
+    // offset at which the next CompressPages() call resumes
+    uint64_t compress_offset_ TA_GUARDED(lock_) = 0;
+
+    // pages that have been moved out of page_list_ into the compressed store
+    fbl::WAVLTree<uint64_t, fbl::unique_ptr<VmCompressedPage>> compressed_pages_ TA_GUARDED(lock_);
+
+    // supplies pages that aren't in page_list_, instead of zero filling them
+    const fbl::RefPtr<PageSource> page_source_;
+
     // a tree of pages
     VmPageList page_list_ TA_GUARDED(lock_);
 };
@@ -193,6 +193,17 @@ public:
     size_t FreeAllPages();
     bool IsEmpty();
 
+    // Fill every empty slot in the page aligned range [start_offset, end_offset)
+    // with pages taken from the head of |pages|, visiting each tree node once.
+    // Stops early if |pages| runs out. On failure, slots filled before the
+    // failure keep their pages.
+    zx_status_t FillRange(uint64_t start_offset, uint64_t end_offset, list_node* pages);
+
+    // Remove every page in the page aligned range [start_offset, end_offset),
+    // appending them to |removed| so the caller can free them in one batch.
+    // Returns the number of pages removed.
+    size_t RemoveRange(uint64_t start_offset, uint64_t end_offset, list_node* removed);
+
 private:
     fbl::WAVLTree<uint64_t, fbl::unique_ptr<VmPageListNode>> list_;
 };
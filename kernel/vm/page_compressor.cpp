@@ -0,0 +1,112 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// The page compressor is a kernel thread that, while free memory is below a
+// watermark, moves pages of paged VMOs that have not been faulted on recently
+// into the compressed page store (see VmCompressedPage). A later fault on a
+// compressed page decompresses it back into a freshly allocated page.
+
+#include <inttypes.h>
+#include <kernel/cmdline.h>
+#include <kernel/thread.h>
+#include <lib/console.h>
+#include <lk/init.h>
+#include <pretty/sizes.h>
+#include <string.h>
+#include <trace.h>
+#include <vm/compressed_page.h>
+#include <vm/pmm.h>
+#include <vm/vm_object.h>
+#include <zircon/time.h>
+
+#include "vm_priv.h"
+
+#define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
+
+namespace {
+
+// Set once at init time, before the thread is started.
+zx_duration_t compress_interval;
+size_t compress_pages_per_pass;
+size_t compress_watermark_bytes;
+
+thread_t* compress_thread;
+
+size_t CompressPass() {
+    size_t compressed = VmObject::CompressAllPages(compress_pages_per_pass);
+    LTRACEF("compressed %zu pages, store now %zu bytes\n",
+            compressed, VmCompressedPage::StoreBytes());
+    return compressed;
+}
+
+int CompressLoop(void* arg) {
+    while (true) {
+        thread_sleep_relative(compress_interval);
+        if (pmm_count_free_pages() * PAGE_SIZE >= compress_watermark_bytes) {
+            continue;
+        }
+        CompressPass();
+    }
+    return 0;
+}
+
+void page_compressor_init(uint level) {
+    // Be sure to update kernel_cmdline.md if any of these defaults change.
+    compress_interval = ZX_SEC(cmdline_get_uint64("kernel.page-compressor.sleep-sec", 1));
+    compress_pages_per_pass = cmdline_get_uint64("kernel.page-compressor.pages-per-pass", 4096);
+    compress_watermark_bytes =
+        cmdline_get_uint64("kernel.page-compressor.free-watermark-mb", 128) * MB;
+
+    if (!cmdline_get_bool("kernel.page-compressor.enable", false)) {
+        return;
+    }
+
+    compress_thread = thread_create("page-compressor", CompressLoop, nullptr, LOW_PRIORITY);
+    if (compress_thread == nullptr) {
+        printf("VM: failed to create page compressor thread\n");
+        return;
+    }
+    thread_resume(compress_thread);
+}
+
+} // namespace
+
+LK_INIT_HOOK(page_compressor, page_compressor_init, LK_INIT_LEVEL_USER);
+
+static int cmd_page_compressor(int argc, const cmd_args* argv, uint32_t flags) {
+    if (argc < 2) {
+        printf("not enough arguments\n");
+    usage:
+        printf("usage:\n");
+        printf("%s info : dump compressor params/state\n", argv[0].str);
+        printf("%s run  : run one compressor pass now\n", argv[0].str);
+        return ZX_ERR_INTERNAL;
+    }
+
+    if (!strcmp(argv[1].str, "info")) {
+        char buf[MAX_FORMAT_SIZE_LEN];
+        printf("running: %s\n", compress_thread ? "true" : "false");
+        printf("interval: %" PRIi64 "ms\n", compress_interval / ZX_MSEC(1));
+        printf("pages per pass: %zu\n", compress_pages_per_pass);
+        printf("free watermark: %s\n",
+               format_size(buf, sizeof(buf), compress_watermark_bytes));
+        printf("store: %s", format_size(buf, sizeof(buf), VmCompressedPage::StoreBytes()));
+        printf(" / %s\n", format_size(buf, sizeof(buf), VmCompressedPage::StoreBudget()));
+    } else if (!strcmp(argv[1].str, "run")) {
+        printf("compressed %zu pages\n", CompressPass());
+    } else {
+        printf("unknown command\n");
+        goto usage;
+    }
+
+    return ZX_OK;
+}
+
+STATIC_COMMAND_START
+#if LK_DEBUGLEVEL > 0
+STATIC_COMMAND("pgc", "page compressor", &cmd_page_compressor)
+#endif
+STATIC_COMMAND_END(pgc);
@@ -0,0 +1,164 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <vm/page_source.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <lib/counters.h>
+#include <trace.h>
+#include <vm/vm.h>
+#include <zircon/time.h>
+
+#include "vm_priv.h"
+
+#define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
+
+KCOUNTER(page_requests_sent, "kernel.vm.page_source.requests_sent");
+KCOUNTER(page_requests_coalesced, "kernel.vm.page_source.requests_coalesced");
+
+PageRequest::PageRequest() {
+    event_init(&event_, false, 0);
+}
+
+PageRequest::~PageRequest() {
+    DEBUG_ASSERT(!InContainer());
+    DEBUG_ASSERT(!source_);
+    event_destroy(&event_);
+}
+
+zx_status_t PageRequest::Wait() {
+    DEBUG_ASSERT(source_);
+
+    zx_status_t status = event_wait_deadline(&event_, ZX_TIME_INFINITE, true);
+    if (status == ZX_OK) {
+        status = status_;
+    } else if (!source_->CancelRequest(this)) {
+        // Interrupted, but the source has already taken the request off its
+        // queue and is about to signal it. It still points into our stack
+        // until it has, so wait that out.
+        event_wait(&event_);
+    }
+    source_.reset();
+    return status;
+}
+
+PageSource::~PageSource() {
+    canary_.Assert();
+    DEBUG_ASSERT(pending_requests_.is_empty());
+}
+
+zx_status_t PageSource::GetPage(uint64_t offset, PageRequest* request) {
+    canary_.Assert();
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(offset));
+    DEBUG_ASSERT(!request->source_);
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (closed_) {
+        return ZX_ERR_BAD_STATE;
+    }
+
+    bool outstanding = false;
+    for (const auto& r : pending_requests_) {
+        if (r.offset_ == offset) {
+            outstanding = true;
+            break;
+        }
+    }
+
+    if (!outstanding) {
+        zx_status_t status = SendRequest(offset, PAGE_SIZE);
+        if (status != ZX_OK) {
+            return status;
+        }
+        kcounter_add(page_requests_sent, 1);
+    } else {
+        kcounter_add(page_requests_coalesced, 1);
+    }
+
+    LTRACEF("%p offset %#" PRIx64 "%s\n", this, offset, outstanding ? " (coalesced)" : "");
+
+    request->source_ = fbl::WrapRefPtr(this);
+    request->offset_ = offset;
+    request->completing_ = false;
+    event_unsignal(&request->event_);
+    pending_requests_.push_back(request);
+    return ZX_ERR_SHOULD_WAIT;
+}
+
+void PageSource::OnPagesSupplied(uint64_t offset, uint64_t len) {
+    canary_.Assert();
+
+    fbl::DoublyLinkedList<PageRequest*> completed;
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+
+        for (auto iter = pending_requests_.begin(); iter != pending_requests_.end();) {
+            auto cur = iter++;
+            if (cur->offset_ >= offset && cur->offset_ - offset < len) {
+                PageRequest* request = pending_requests_.erase(cur);
+                request->status_ = ZX_OK;
+                request->completing_ = true;
+                completed.push_back(request);
+            }
+        }
+    }
+
+    // Our caller holds the VMO's lock, which every woken thread is about to
+    // take again, so don't reschedule to them here.
+    SignalRequests(&completed, false);
+}
+
+void PageSource::Close() {
+    canary_.Assert();
+    LTRACEF("%p\n", this);
+
+    fbl::DoublyLinkedList<PageRequest*> completed;
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        while (!pending_requests_.is_empty()) {
+            PageRequest* request = pending_requests_.pop_front();
+            request->status_ = ZX_ERR_BAD_STATE;
+            request->completing_ = true;
+            completed.push_back(request);
+        }
+    }
+
+    SignalRequests(&completed, true);
+    OnClose();
+}
+
+bool PageSource::is_closed() const {
+    Guard<fbl::Mutex> guard{&lock_};
+    return closed_;
+}
+
+bool PageSource::CancelRequest(PageRequest* request) {
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (request->completing_) {
+        return false;
+    }
+    if (request->InContainer()) {
+        pending_requests_.erase(*request);
+    }
+    return true;
+}
+
+void PageSource::SignalRequests(fbl::DoublyLinkedList<PageRequest*>* requests, bool reschedule) {
+    while (!requests->is_empty()) {
+        // The waiter may return and free the request as soon as it is
+        // signaled, so it has to be off our list by then.
+        PageRequest* request = requests->pop_front();
+        event_signal_etc(&request->event_, reschedule, ZX_OK);
+    }
+}
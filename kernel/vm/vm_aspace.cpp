@@ -527,12 +527,33 @@ zx_status_t VmAspace::PageFault(vaddr_t va, uint flags) {
         flags |= VMM_PF_FLAG_GUEST;
     }
 
-    // for now, hold the aspace lock across the page fault operation,
-    // which stops any other operations on the address space from moving
-    // the region out from underneath it
-    Guard<fbl::Mutex> guard{&lock_};
+    // The aspace lock is only held while looking up the mapping; the mapping
+    // hands it off for the lock of the vmo it maps before resolving the fault.
+    // If the page has to come from a pager, wait for it with no locks held and
+    // then fault again, since the mapping may have changed in the meantime.
+    PageRequest page_request;
+    while (true) {
+        zx_status_t status;
+        {
+            Guard<fbl::Mutex> guard{&lock_};
+            status = root_vmar_->PageFault(va, flags, &guard, &page_request);
+        }
+        if (status != ZX_ERR_SHOULD_WAIT) {
+            return status;
+        }
 
-    return root_vmar_->PageFault(va, flags);
+        status = page_request.Wait();
+        if (status == ZX_ERR_INTERNAL_INTR_RETRY || status == ZX_ERR_INTERNAL_INTR_KILLED) {
+            // Let a user thread take the signal; the faulting instruction will
+            // simply fault again once it is resumed.
+            if (flags & VMM_PF_FLAG_USER) {
+                return ZX_OK;
+            }
+        }
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
 }
 
 void VmAspace::Dump(bool verbose) const {
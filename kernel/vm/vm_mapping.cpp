@@ -502,7 +502,7 @@ zx_status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
 
         zx_status_t status;
         paddr_t pa;
-        status = object_->GetPageLocked(vmo_offset, pf_flags, nullptr, nullptr, &pa);
+        status = object_->GetPageLocked(vmo_offset, pf_flags, nullptr, nullptr, nullptr, &pa);
         if (status != ZX_OK) {
             // no page to map
             if (commit) {
@@ -591,9 +591,12 @@ zx_status_t VmMapping::DestroyLocked() {
     return ZX_OK;
 }
 
-zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
+zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags,
+                                 Guard<fbl::Mutex>* aspace_guard,
+                                 PageRequest* page_request) {
     canary_.Assert();
     DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
+    DEBUG_ASSERT(state_ == LifeCycleState::ALIVE);
 
     DEBUG_ASSERT(va >= base_ && va <= base_ + size_ - 1);
 
@@ -627,8 +630,15 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
         return ZX_ERR_ACCESS_DENIED;
     }
 
-    // grab the lock for the vmo
-    Guard<fbl::Mutex> guard{object_->lock()};
+    // Grab the lock for the vmo, then drop the aspace lock. Every change to
+    // this mapping's range, permissions or lifetime also takes the vmo lock,
+    // so the mapping stays valid for the rest of the fault, while other
+    // threads are free to fault on other vmos or change other parts of the
+    // address space. Our caller holds a reference that keeps |this| alive,
+    // and |object| keeps the vmo alive should we be destroyed afterwards.
+    fbl::RefPtr<VmObject> object = object_;
+    Guard<fbl::Mutex> guard{object->lock()};
+    aspace_guard->Release();
 
     // set the currently faulting flag for any recursive calls the vmo may make back into us
     // The specific path we're avoiding is if the VMO calls back into us during vmo->GetPageLocked()
@@ -641,7 +651,12 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
     // fault in or grab an existing page
     paddr_t new_pa;
     vm_page_t* page;
-    zx_status_t status = object_->GetPageLocked(vmo_offset, pf_flags, nullptr, &page, &new_pa);
+    zx_status_t status = object->GetPageLocked(vmo_offset, pf_flags, nullptr, page_request,
+                                               &page, &new_pa);
+    if (status == ZX_ERR_SHOULD_WAIT) {
+        // the caller waits for the page once we've dropped the vmo lock
+        return status;
+    }
     if (status != ZX_OK) {
         // TODO(cpu): This trace was originally TRACEF() always on, but it fires if the
         // VMO was resized, rather than just when the system is running out of memory.
@@ -27,6 +27,8 @@
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
 VmObject::GlobalList VmObject::all_vmos_ = {};
+size_t VmObject::zero_scan_cursor_ = 0;
+size_t VmObject::compress_cursor_ = 0;
 
 VmObject::VmObject(fbl::RefPtr<VmObject> parent)
     : lock_(parent ? parent->lock_ref() : local_lock_),
@@ -248,6 +250,74 @@ void VmObject::RangeChangeUpdateLocked(uint64_t offset, uint64_t len) {
     }
 }
 
+template <typename F>
+size_t VmObject::ScanAll(size_t* cursor, size_t max_pages, F scan_func) {
+    // VMOs are scanned in small batches: references to the batch are taken
+    // under the global list lock, and the scan itself (and the release of the
+    // references, which may destroy a VMO) happens with that lock dropped.
+    static constexpr size_t kBatchSize = 16;
+
+    size_t processed = 0;
+    while (max_pages > 0) {
+        fbl::RefPtr<VmObject> batch[kBatchSize];
+        size_t count = 0;
+        bool wrapped = false;
+        {
+            Guard<fbl::Mutex> guard{AllVmosLock::Get()};
+            size_t index = 0;
+            for (auto& vmo : all_vmos_) {
+                if (index++ < *cursor) {
+                    continue;
+                }
+                if (count == kBatchSize) {
+                    break;
+                }
+                // Skip objects that are already on their way to destruction.
+                batch[count] = fbl::internal::MakeRefPtrUpgradeFromRaw(
+                    &vmo, AllVmosLock::Get()->lock());
+                if (batch[count]) {
+                    count++;
+                }
+                (*cursor)++;
+            }
+            if (index <= *cursor) {
+                *cursor = 0;
+                wrapped = true;
+            }
+        }
+
+        for (size_t i = 0; i < count && max_pages > 0; i++) {
+            size_t scanned;
+            processed += scan_func(batch[i].get(), max_pages, &scanned);
+            max_pages -= scanned;
+        }
+
+        // Stop at the end of the list so that a nearly idle system doesn't
+        // spin over the same handful of VMOs.
+        if (wrapped) {
+            break;
+        }
+    }
+
+    return processed;
+}
+
+size_t VmObject::ScanAllForZeroPages(size_t max_pages) {
+    Guard<fbl::Mutex> guard{ScanLock::Get()};
+    return ScanAll(&zero_scan_cursor_, max_pages,
+                   [](VmObject* vmo, size_t max_pages, size_t* scanned) {
+                       return vmo->ScanForZeroPages(max_pages, scanned);
+                   });
+}
+
+size_t VmObject::CompressAllPages(size_t max_pages) {
+    Guard<fbl::Mutex> guard{ScanLock::Get()};
+    return ScanAll(&compress_cursor_, max_pages,
+                   [](VmObject* vmo, size_t max_pages, size_t* scanned) {
+                       return vmo->CompressPages(max_pages, scanned);
+                   });
+}
+
 static int cmd_vm_object(int argc, const cmd_args* argv, uint32_t flags) {
     if (argc < 2) {
     notenoughargs:
@@ -40,10 +40,23 @@ void ZeroPage(vm_page_t* p) {
     ZeroPage(pa);
 }
 
+bool IsZeroPage(vm_page_t* p) {
+    const uint64_t* word = static_cast<const uint64_t*>(paddr_to_physmap(p->paddr()));
+    DEBUG_ASSERT(word);
+
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(*word); i++) {
+        if (word[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void InitializeVmPage(vm_page_t* p) {
     DEBUG_ASSERT(p->state == VM_PAGE_STATE_ALLOC);
     p->state = VM_PAGE_STATE_OBJECT;
     p->object.pin_count = 0;
+    p->object.referenced = 1;
 }
 
 // round up the size to the next page size boundary and make sure we dont wrap
@@ -61,12 +74,13 @@ zx_status_t RoundSize(uint64_t size, uint64_t* out_size) {
 
 } // namespace
 
-VmObjectPaged::VmObjectPaged(
-    uint32_t options, uint32_t pmm_alloc_flags, uint64_t size, fbl::RefPtr<VmObject> parent)
+VmObjectPaged::VmObjectPaged(uint32_t options, uint32_t pmm_alloc_flags, uint64_t size,
+                             fbl::RefPtr<VmObject> parent, fbl::RefPtr<PageSource> page_source)
         : VmObject(fbl::move(parent)),
           options_(options),
           size_(size),
-          pmm_alloc_flags_(pmm_alloc_flags) {
+          pmm_alloc_flags_(pmm_alloc_flags),
+          page_source_(fbl::move(page_source)) {
     LTRACEF("%p\n", this);
 
     DEBUG_ASSERT(IS_PAGE_ALIGNED(size_));
@@ -88,6 +102,12 @@ VmObjectPaged::~VmObjectPaged() {
 
     // free all of the pages attached to us
     page_list_.FreeAllPages();
+    compressed_pages_.clear();
+
+    // fail anyone still waiting on pages that will never be supplied
+    if (page_source_) {
+        page_source_->Close();
+    }
 }
 
 zx_status_t VmObjectPaged::Create(uint32_t pmm_alloc_flags,
@@ -106,7 +126,28 @@ zx_status_t VmObjectPaged::Create(uint32_t pmm_alloc_flags,
 
     fbl::AllocChecker ac;
     auto vmo = fbl::AdoptRef<VmObject>(
-        new (&ac) VmObjectPaged(options, pmm_alloc_flags, size, nullptr));
+        new (&ac) VmObjectPaged(options, pmm_alloc_flags, size, nullptr, nullptr));
+    if (!ac.check())
+        return ZX_ERR_NO_MEMORY;
+
+    *obj = fbl::move(vmo);
+
+    return ZX_OK;
+}
+
+zx_status_t VmObjectPaged::CreateWithSource(uint32_t pmm_alloc_flags, uint64_t size,
+                                            fbl::RefPtr<PageSource> src,
+                                            fbl::RefPtr<VmObject>* obj) {
+    DEBUG_ASSERT(src);
+
+    zx_status_t status = RoundSize(size, &size);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::AllocChecker ac;
+    auto vmo = fbl::AdoptRef<VmObject>(
+        new (&ac) VmObjectPaged(0, pmm_alloc_flags, size, nullptr, fbl::move(src)));
     if (!ac.check())
         return ZX_ERR_NO_MEMORY;
 
@@ -126,7 +167,7 @@ zx_status_t VmObjectPaged::CreateContiguous(uint32_t pmm_alloc_flags, uint64_t s
 
     fbl::AllocChecker ac;
     auto vmo = fbl::AdoptRef<VmObject>(
-        new (&ac) VmObjectPaged(kContiguous, pmm_alloc_flags, size, nullptr));
+        new (&ac) VmObjectPaged(kContiguous, pmm_alloc_flags, size, nullptr, nullptr));
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
@@ -248,7 +289,8 @@ zx_status_t VmObjectPaged::CloneCOW(bool resizable, uint64_t offset, uint64_t si
     // allocate the clone up front outside of our lock
     fbl::AllocChecker ac;
     auto vmo = fbl::AdoptRef<VmObjectPaged>(
-        new (&ac) VmObjectPaged(options, pmm_alloc_flags_, size, fbl::WrapRefPtr(this)));
+        new (&ac) VmObjectPaged(options, pmm_alloc_flags_, size, fbl::WrapRefPtr(this),
+                                nullptr));
     if (!ac.check())
         return ZX_ERR_NO_MEMORY;
 
@@ -294,8 +336,8 @@ void VmObjectPaged::Dump(uint depth, bool verbose) {
         printf("  ");
     }
     printf("vmo %p/k%" PRIu64 " size %#" PRIx64
-           " pages %zu ref %d parent k%" PRIu64 "\n",
-           this, user_id_, size_, count, ref_count_debug(), parent_id);
+           " pages %zu compressed %zu ref %d parent k%" PRIu64 "\n",
+           this, user_id_, size_, count, compressed_pages_.size(), ref_count_debug(), parent_id);
 
     if (verbose) {
         auto f = [depth](const auto p, uint64_t offset) {
@@ -329,6 +371,285 @@ size_t VmObjectPaged::AllocatedPagesInRange(uint64_t offset, uint64_t len) const
     return count;
 }
 
+bool VmObjectPaged::CanReclaimPagesLocked() const {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    // Contiguous and uncached objects are used for device memory, whose
+    // physical pages must not move. Kernel mappings are expected not to fault
+    // once committed, so skip any object the kernel has mapped.
+    if (is_contiguous() || cache_policy_ != ARCH_MMU_FLAG_CACHED) {
+        return false;
+    }
+    // Pages of pager-backed objects (and their clones) can't be told apart
+    // from pages the pager hasn't supplied yet once they are dropped.
+    if (is_pager_backed()) {
+        return false;
+    }
+    for (const auto& m : mapping_list_) {
+        if (!m.aspace()->is_user()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VmObjectPaged::HasPageLocked(uint64_t offset) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    if (offset >= size_) {
+        return false;
+    }
+    if (page_list_.GetPage(offset) || compressed_pages_.find(offset).IsValid()) {
+        return true;
+    }
+    if (page_source_) {
+        return true;
+    }
+    if (!parent_) {
+        return false;
+    }
+    uint64_t parent_offset;
+    if (add_overflow(parent_offset_, offset, &parent_offset) || !parent_->is_paged()) {
+        return true;
+    }
+    return static_cast<VmObjectPaged*>(parent_.get())->HasPageLocked(parent_offset);
+}
+
+size_t VmObjectPaged::ReclaimedZeroPages() const {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{&lock_};
+    return zero_pages_reclaimed_;
+}
+
+size_t VmObjectPaged::ScanForZeroPages(size_t max_pages, size_t* scanned) {
+    canary_.Assert();
+
+    // Number of candidate pages collected per walk of the page list, since
+    // pages can't be freed while the list is being iterated.
+    static constexpr size_t kMaxCandidates = 16;
+
+    *scanned = 0;
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!CanReclaimPagesLocked()) {
+        return 0;
+    }
+
+    if (zero_scan_offset_ >= size_) {
+        zero_scan_offset_ = 0;
+    }
+
+    size_t freed = 0;
+    while (*scanned < max_pages) {
+        uint64_t candidates[kMaxCandidates];
+        size_t num_candidates = 0;
+        uint64_t next_offset = size_;
+        page_list_.ForEveryPageInRange(
+            [&](const auto p, uint64_t off) {
+                if (*scanned == max_pages || num_candidates == kMaxCandidates) {
+                    next_offset = off;
+                    return ZX_ERR_STOP;
+                }
+                (*scanned)++;
+                // Pinned pages may be in use by a device; wired pages belong
+                // to the kernel image.
+                if (p->state == VM_PAGE_STATE_OBJECT && p->object.pin_count == 0 &&
+                    IsZeroPage(p)) {
+                    candidates[num_candidates++] = off;
+                }
+                return ZX_ERR_NEXT;
+            },
+            zero_scan_offset_, size_);
+
+        for (size_t i = 0; i < num_candidates; i++) {
+            const uint64_t off = candidates[i];
+
+            // A clone's missing page reads from the parent, so the page can
+            // only go if the parent doesn't have one at that offset either.
+            if (parent_) {
+                uint64_t parent_offset;
+                bool overflowed = add_overflow(parent_offset_, off, &parent_offset);
+                ASSERT(!overflowed);
+                // Only a paged parent can be asked without faulting anything
+                // in; keep the page if there's any doubt.
+                if (!parent_->is_paged() ||
+                    static_cast<VmObjectPaged*>(parent_.get())->HasPageLocked(parent_offset)) {
+                    continue;
+                }
+            }
+
+            // Remove all mappings of the page before the final check, so that
+            // nothing can write to it between the check and the free. Any
+            // access after this point faults and blocks on our lock.
+            RangeChangeUpdateLocked(off, PAGE_SIZE);
+
+            vm_page_t* p = page_list_.GetPage(off);
+            DEBUG_ASSERT(p);
+            if (!IsZeroPage(p)) {
+                continue;
+            }
+
+            LTRACEF("vmo %p freeing zero page %p at offset %#" PRIx64 "\n", this, p, off);
+
+            zx_status_t status = page_list_.FreePage(off);
+            DEBUG_ASSERT(status == ZX_OK);
+            freed++;
+        }
+
+        zero_scan_offset_ = next_offset;
+        if (next_offset == size_) {
+            // Reached the end of the object; the next call starts over.
+            zero_scan_offset_ = 0;
+            break;
+        }
+    }
+
+    zero_pages_reclaimed_ += freed;
+    return freed;
+}
+
+size_t VmObjectPaged::CompressPages(size_t max_pages, size_t* scanned) {
+    canary_.Assert();
+
+    // Number of candidate pages collected per walk of the page list, since
+    // pages can't be freed while the list is being iterated.
+    static constexpr size_t kMaxCandidates = 16;
+
+    *scanned = 0;
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!CanReclaimPagesLocked()) {
+        return 0;
+    }
+
+    if (compress_offset_ >= size_) {
+        compress_offset_ = 0;
+    }
+
+    size_t compressed = 0;
+    bool store_full = false;
+    while (*scanned < max_pages && !store_full) {
+        uint64_t candidates[kMaxCandidates];
+        size_t num_candidates = 0;
+        uint64_t next_offset = size_;
+        page_list_.ForEveryPageInRange(
+            [&](const auto p, uint64_t off) {
+                if (*scanned == max_pages || num_candidates == kMaxCandidates) {
+                    next_offset = off;
+                    return ZX_ERR_STOP;
+                }
+                (*scanned)++;
+                if (p->state != VM_PAGE_STATE_OBJECT || p->object.pin_count > 0) {
+                    return ZX_ERR_NEXT;
+                }
+                // Pages faulted on since the last pass get a second chance.
+                if (p->object.referenced) {
+                    p->object.referenced = 0;
+                    return ZX_ERR_NEXT;
+                }
+                candidates[num_candidates++] = off;
+                return ZX_ERR_NEXT;
+            },
+            compress_offset_, size_);
+
+        for (size_t i = 0; i < num_candidates; i++) {
+            const uint64_t off = candidates[i];
+
+            // Remove all mappings of the page first, so that nothing can write
+            // to it while it is being compressed.
+            RangeChangeUpdateLocked(off, PAGE_SIZE);
+
+            vm_page_t* p = page_list_.GetPage(off);
+            DEBUG_ASSERT(p);
+
+            fbl::unique_ptr<VmCompressedPage> cp;
+            zx_status_t status = VmCompressedPage::Create(off, paddr_to_physmap(p->paddr()), &cp);
+            if (status == ZX_ERR_NO_SPACE) {
+                // Resume from this page once the store has room again.
+                next_offset = off;
+                store_full = true;
+                break;
+            }
+            if (status != ZX_OK) {
+                // Don't retry an incompressible page on the very next pass.
+                p->object.referenced = 1;
+                continue;
+            }
+
+            LTRACEF("vmo %p compressed page %p at offset %#" PRIx64 " to %zu bytes\n",
+                    this, p, off, cp->compressed_size());
+
+            compressed_pages_.insert(fbl::move(cp));
+            status = page_list_.FreePage(off);
+            DEBUG_ASSERT(status == ZX_OK);
+            compressed++;
+        }
+
+        compress_offset_ = next_offset;
+        if (next_offset == size_) {
+            // Reached the end of the object; the next call starts over.
+            compress_offset_ = 0;
+            break;
+        }
+    }
+
+    return compressed;
+}
+
+zx_status_t VmObjectPaged::DecompressPageLocked(uint64_t offset, list_node* free_list,
+                                                vm_page_t** page_out) {
+    canary_.Assert();
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    auto compressed = compressed_pages_.find(offset);
+    if (!compressed.IsValid()) {
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    vm_page_t* p = nullptr;
+    paddr_t pa;
+    if (free_list) {
+        p = list_remove_head_type(free_list, vm_page, queue_node);
+        if (p) {
+            pa = p->paddr();
+        }
+    }
+    if (!p) {
+        p = pmm_alloc_page(pmm_alloc_flags_, &pa);
+    }
+    if (!p) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    InitializeVmPage(p);
+
+    compressed->Decompress(paddr_to_physmap(pa));
+    compressed_pages_.erase(compressed);
+
+    zx_status_t status = AddPageLocked(p, offset);
+    DEBUG_ASSERT(status == ZX_OK);
+
+    LTRACEF("decompressed page %p, pa %#" PRIxPTR " at offset %#" PRIx64 "\n", p, pa, offset);
+
+    *page_out = p;
+    return ZX_OK;
+}
+
+size_t VmObjectPaged::FreeCompressedPagesLocked(uint64_t start, uint64_t end) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    size_t count = 0;
+    auto iter = compressed_pages_.lower_bound(start);
+    while (iter.IsValid() && iter->offset() < end) {
+        auto cur = iter++;
+        compressed_pages_.erase(cur);
+        count++;
+    }
+    return count;
+}
+
 zx_status_t VmObjectPaged::AddPage(vm_page_t* p, uint64_t offset) {
     Guard<fbl::Mutex> guard{&lock_};
 
@@ -363,7 +684,12 @@ zx_status_t VmObjectPaged::AddPageLocked(vm_page_t* p, uint64_t offset) {
 // this function may allocate from.  This function will need at most one entry,
 // and will not fail if |free_list| is a non-empty list, faulting in was requested,
 // and offset is in range.
+//
+// If the page has to come from a page source, |page_request| is queued with it
+// and ZX_ERR_SHOULD_WAIT is returned; with no |page_request| the page is
+// reported as not found.
 zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
+                                         PageRequest* page_request,
                                          vm_page_t** const page_out, paddr_t* const pa_out) {
     canary_.Assert();
     DEBUG_ASSERT(lock_.lock().IsHeld());
@@ -377,6 +703,9 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
     // see if we already have a page at that offset
     p = page_list_.GetPage(offset);
     if (p) {
+        if (pf_flags & VMM_PF_FLAG_FAULT_MASK) {
+            p->object.referenced = 1;
+        }
         if (page_out)
             *page_out = p;
         if (pa_out)
@@ -384,6 +713,23 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
         return ZX_OK;
     }
 
+    // see if the page was moved to the compressed page store; only faults
+    // bring it back, lookups of present pages must not allocate
+    if ((pf_flags & (VMM_PF_FLAG_FAULT_MASK | VMM_PF_FLAG_DECOMPRESS)) &&
+        !compressed_pages_.is_empty()) {
+        zx_status_t status = DecompressPageLocked(offset, free_list, &p);
+        if (status == ZX_OK) {
+            if (page_out)
+                *page_out = p;
+            if (pa_out)
+                *pa_out = p->paddr();
+            return ZX_OK;
+        }
+        if (status != ZX_ERR_NOT_FOUND) {
+            return status;
+        }
+    }
+
     __UNUSED char pf_string[5];
     LTRACEF("vmo %p, offset %#" PRIx64 ", pf_flags %#x (%s)\n", this, offset, pf_flags,
             vmm_pf_flags_to_string(pf_flags, pf_string));
@@ -396,9 +742,16 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
 
         // make sure we don't cause the parent to fault in new pages, just ask for any that already exist
         uint parent_pf_flags = pf_flags & ~(VMM_PF_FLAG_FAULT_MASK);
+        // a page the parent compressed still exists, and a fault needs it back
+        if (pf_flags & VMM_PF_FLAG_FAULT_MASK) {
+            parent_pf_flags |= VMM_PF_FLAG_DECOMPRESS;
+        }
 
         zx_status_t status = parent_->GetPageLocked(parent_offset, parent_pf_flags,
-                                                    nullptr, &p, &pa);
+                                                    nullptr, page_request, &p, &pa);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            return status;
+        }
         if (status == ZX_OK) {
             // we have a page from them. if we're read-only faulting, return that page so they can map
             // or read from it directly
@@ -455,6 +808,15 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
         }
     }
 
+    // pages we don't have come from the page source rather than being zero filled,
+    // even for lookups that don't fault, since a clone's faults look like that
+    if (page_source_) {
+        if (!page_request) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        return page_source_->GetPage(offset, page_request);
+    }
+
     // if we're not being asked to sw or hw fault in the page, return not found
     if ((pf_flags & VMM_PF_FLAG_FAULT_MASK) == 0)
         return ZX_ERR_NOT_FOUND;
@@ -521,6 +883,10 @@ zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t*
 
     Guard<fbl::Mutex> guard{&lock_};
 
+    // pages of pager-backed objects can only be filled in by the pager
+    if (is_pager_backed())
+        return ZX_ERR_NOT_SUPPORTED;
+
     // trim the size
     uint64_t new_len;
     if (!TrimRange(offset, len, size_, &new_len))
@@ -568,6 +934,36 @@ zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t*
     // unmap all of the pages in this range on all the mapping regions
     RangeChangeUpdateLocked(offset, end - offset);
 
+    // Without a parent to copy from or compressed pages to bring back, every
+    // missing page is a fresh zero page, so they can be added in bulk.
+    if (!parent_ && compressed_pages_.is_empty()) {
+        vm_page_t* p;
+        list_for_every_entry (&page_list, p, vm_page_t, queue_node) {
+            InitializeVmPage(p);
+
+            // TODO: remove once pmm returns zeroed pages
+            ZeroPage(p);
+
+// if ARM and not fully cached, clean/invalidate the page after zeroing it
+#if ARCH_ARM64
+            if (cache_policy_ != ARCH_MMU_FLAG_CACHED) {
+                arch_clean_invalidate_cache_range((addr_t)paddr_to_physmap(p->paddr()), PAGE_SIZE);
+            }
+#endif
+        }
+
+        zx_status_t status = page_list_.FillRange(offset, end, &page_list);
+        if (committed)
+            *committed = (count - list_length(&page_list)) * PAGE_SIZE;
+        if (status != ZX_OK) {
+            pmm_free(&page_list);
+            return status;
+        }
+
+        DEBUG_ASSERT(list_is_empty(&page_list));
+        return ZX_OK;
+    }
+
     // add them to the appropriate range of the object
     for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
         // Don't commit if we already have this page
@@ -581,7 +977,7 @@ zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t*
         const uint flags = VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE;
         // Should not be able to fail, since we're providing it memory and the
         // range should be valid.
-        zx_status_t status = GetPageLocked(o, flags, &page_list, &p, &pa);
+        zx_status_t status = GetPageLocked(o, flags, &page_list, nullptr, &p, &pa);
         ASSERT(status == ZX_OK);
 
         if (committed)
@@ -638,15 +1034,114 @@ zx_status_t VmObjectPaged::DecommitRange(uint64_t offset, uint64_t len, uint64_t
     // unmap all of the pages in this range on all the mapping regions
     RangeChangeUpdateLocked(start, page_aligned_len);
 
-    // iterate through the pages, freeing them
-    // TODO: use page_list iterator, move pages to list, free at once
-    while (start < end) {
-        auto status = page_list_.FreePage(start);
-        if (status == ZX_OK && decommitted) {
-            *decommitted += PAGE_SIZE;
+    // drop any compressed copies in the range
+    size_t compressed_freed = FreeCompressedPagesLocked(start, end);
+    if (decommitted) {
+        *decommitted += compressed_freed * PAGE_SIZE;
+    }
+
+    // pull the pages out of the tree and return them to the pmm at once
+    list_node list;
+    list_initialize(&list);
+    size_t freed = page_list_.RemoveRange(start, end, &list);
+    pmm_free(&list);
+    if (decommitted) {
+        *decommitted += freed * PAGE_SIZE;
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t VmObjectPaged::TakePages(uint64_t offset, uint64_t len, list_node* pages) {
+    canary_.Assert();
+    LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
+
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(len)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    if (options_ & kContiguous) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!InRange(offset, len, size_)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    const uint64_t end = offset + len;
+
+    // bring back anything in the range that was compressed
+    for (uint64_t off = offset; off < end && !compressed_pages_.is_empty(); off += PAGE_SIZE) {
+        vm_page_t* p;
+        zx_status_t status = DecompressPageLocked(off, nullptr, &p);
+        if (status != ZX_OK && status != ZX_ERR_NOT_FOUND) {
+            return status;
+        }
+    }
+
+    // every page has to be present, so that pages[i] always belongs at offset + i * PAGE_SIZE
+    size_t present = 0;
+    page_list_.ForEveryPageInRange(
+        [&present](const auto p, uint64_t off) {
+            present++;
+            return ZX_ERR_NEXT;
+        },
+        offset, end);
+    if (present != len / PAGE_SIZE) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    if (AnyPagesPinnedLocked(offset, len)) {
+        return ZX_ERR_BAD_STATE;
+    }
+
+    // unmap all of the pages in this range on all the mapping regions
+    RangeChangeUpdateLocked(offset, len);
+
+    __UNUSED size_t taken = page_list_.RemoveRange(offset, end, pages);
+    DEBUG_ASSERT(taken == len / PAGE_SIZE);
+
+    return ZX_OK;
+}
+
+zx_status_t VmObjectPaged::SupplyPages(uint64_t offset, uint64_t len, list_node* pages) {
+    canary_.Assert();
+    LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
+
+    if (!page_source_) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(len)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!InRange(offset, len, size_)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    list_node unused;
+    list_initialize(&unused);
+    for (uint64_t off = offset; off < offset + len; off += PAGE_SIZE) {
+        vm_page_t* p = list_remove_head_type(pages, vm_page, queue_node);
+        DEBUG_ASSERT(p);
+
+        // keep whatever is already here; the supplier can't have newer contents
+        if (page_list_.GetPage(off)) {
+            list_add_tail(&unused, &p->queue_node);
+            continue;
         }
-        start += PAGE_SIZE;
+
+        p->object.pin_count = 0;
+        p->object.referenced = 1;
+        zx_status_t status = AddPageLocked(p, off);
+        DEBUG_ASSERT(status == ZX_OK);
     }
+    pmm_free(&unused);
+
+    page_source_->OnPagesSupplied(offset, len);
 
     return ZX_OK;
 }
@@ -671,6 +1166,17 @@ zx_status_t VmObjectPaged::PinLocked(uint64_t offset, uint64_t len) {
     const uint64_t start_page_offset = ROUNDDOWN(offset, PAGE_SIZE);
     const uint64_t end_page_offset = ROUNDUP(offset + len, PAGE_SIZE);
 
+    // committed pages may have been compressed; pinned pages must be resident
+    auto compressed = compressed_pages_.lower_bound(start_page_offset);
+    while (compressed.IsValid() && compressed->offset() < end_page_offset) {
+        const uint64_t off = (compressed++)->offset();
+        vm_page_t* p;
+        zx_status_t status = DecompressPageLocked(off, nullptr, &p);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+
     uint64_t expected_next_off = start_page_offset;
     zx_status_t status = page_list_.ForEveryPageInRange(
         [&expected_next_off](const auto p, uint64_t off) {
@@ -795,12 +1301,13 @@ zx_status_t VmObjectPaged::ResizeLocked(uint64_t s) {
         // unmap all of the pages in this range on all the mapping regions
         RangeChangeUpdateLocked(start, len);
 
-        // iterate through the pages, freeing them
-        // TODO: use page_list iterator, move pages to list, free at once
-        while (start < end) {
-            page_list_.FreePage(start);
-            start += PAGE_SIZE;
-        }
+        FreeCompressedPagesLocked(start, end);
+
+        // pull the pages out of the tree and return them to the pmm at once
+        list_node list;
+        list_initialize(&list);
+        page_list_.RemoveRange(start, end, &list);
+        pmm_free(&list);
     } else if (s > size_) {
         // expanding
         // figure the starting and ending page offset that is affected
@@ -865,6 +1372,7 @@ zx_status_t VmObjectPaged::ReadWriteInternal(uint64_t offset, size_t len, bool w
     // walk the list of pages and do the write
     uint64_t src_offset = offset;
     size_t dest_offset = 0;
+    PageRequest page_request;
     while (len > 0) {
         size_t page_offset = src_offset % PAGE_SIZE;
         size_t tocopy = MIN(PAGE_SIZE - page_offset, len);
@@ -873,7 +1381,17 @@ zx_status_t VmObjectPaged::ReadWriteInternal(uint64_t offset, size_t len, bool w
         paddr_t pa;
         auto status = GetPageLocked(src_offset,
                                     VMM_PF_FLAG_SW_FAULT | (write ? VMM_PF_FLAG_WRITE : 0),
-                                    nullptr, nullptr, &pa);
+                                    nullptr, &page_request, nullptr, &pa);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            // wait for the page source without holding the lock, then retry
+            guard.CallUnlocked([&page_request, &status]() { status = page_request.Wait(); });
+            if (status != ZX_OK)
+                return status;
+            // a clone may have been resized while we were waiting
+            if (end_offset > size_)
+                return ZX_ERR_OUT_OF_RANGE;
+            continue;
+        }
         if (status != ZX_OK)
             return status;
 
@@ -944,6 +1462,22 @@ zx_status_t VmObjectPaged::Lookup(uint64_t offset, uint64_t len, uint pf_flags,
     const uint64_t start_page_offset = ROUNDDOWN(offset, PAGE_SIZE);
     const uint64_t end_page_offset = ROUNDUP(offset + len, PAGE_SIZE);
 
+    if (pf_flags & VMM_PF_FLAG_FAULT_MASK) {
+        // Faulting can add pages to the list, by decompressing or committing
+        // them, which can't happen while the list is walked below. Fault the
+        // missing pages in first, so that the gaps left are only ones read
+        // from the parent or the zero page.
+        for (uint64_t off = start_page_offset; off < end_page_offset; off += PAGE_SIZE) {
+            if (page_list_.GetPage(off)) {
+                continue;
+            }
+            zx_status_t status = GetPageLocked(off, pf_flags, nullptr, nullptr, nullptr, nullptr);
+            if (status != ZX_OK) {
+                return ZX_ERR_NO_MEMORY;
+            }
+        }
+    }
+
     uint64_t expected_next_off = start_page_offset;
     zx_status_t status = page_list_.ForEveryPageInRange(
         [&expected_next_off, this, pf_flags, lookup_fn, context,
@@ -956,7 +1490,7 @@ zx_status_t VmObjectPaged::Lookup(uint64_t offset, uint64_t len, uint pf_flags,
 
                 paddr_t pa;
                 zx_status_t status = this->GetPageLocked(missing_off, pf_flags, nullptr,
-                                                         nullptr, &pa);
+                                                         nullptr, nullptr, &pa);
                 if (status != ZX_OK) {
                     return ZX_ERR_NO_MEMORY;
                 }
@@ -991,7 +1525,7 @@ zx_status_t VmObjectPaged::Lookup(uint64_t offset, uint64_t len, uint pf_flags,
     // If expected_next_off isn't at the end, there's a gap to process
     for (uint64_t off = expected_next_off; off < end_page_offset; off += PAGE_SIZE) {
         paddr_t pa;
-        zx_status_t status = GetPageLocked(off, pf_flags, nullptr, nullptr, &pa);
+        zx_status_t status = GetPageLocked(off, pf_flags, nullptr, nullptr, nullptr, &pa);
         if (status != ZX_OK) {
             return ZX_ERR_NO_MEMORY;
         }
@@ -1091,7 +1625,7 @@ zx_status_t VmObjectPaged::CacheOp(const uint64_t start_offset, const uint64_t l
 
         // lookup the physical address of the page, careful not to fault in a new one
         paddr_t pa;
-        auto status = GetPageLocked(op_start_offset, 0, nullptr, nullptr, &pa);
+        auto status = GetPageLocked(op_start_offset, 0, nullptr, nullptr, nullptr, &pa);
 
         if (likely(status == ZX_OK)) {
             // Convert the page address to a Kernel virtual address.
@@ -1144,7 +1678,7 @@ zx_status_t VmObjectPaged::SetMappingCachePolicy(const uint32_t cache_policy) {
     // 2) vmo has no mappings
     // 3) vmo has no clones
     // 4) vmo is not a clone
-    if (!page_list_.IsEmpty()) {
+    if (!page_list_.IsEmpty() || !compressed_pages_.is_empty()) {
         return ZX_ERR_BAD_STATE;
     }
     if (!mapping_list_.is_empty()) {
@@ -141,6 +141,87 @@ zx_status_t VmPageList::FreePage(uint64_t offset) {
     return ZX_OK;
 }
 
+zx_status_t VmPageList::FillRange(uint64_t start_offset, uint64_t end_offset, list_node* pages) {
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(start_offset) && IS_PAGE_ALIGNED(end_offset));
+
+    const uint64_t node_span = PAGE_SIZE * VmPageListNode::kPageFanOut;
+
+    LTRACEF_LEVEL(2, "%p start %#" PRIx64 " end %#" PRIx64 "\n", this, start_offset, end_offset);
+
+    // |next| tracks the first existing node at or after |node_offset|, so the
+    // tree is searched once for the whole range rather than once per page.
+    uint64_t node_offset = ROUNDDOWN(start_offset, node_span);
+    auto next = list_.lower_bound(node_offset);
+    for (; node_offset < end_offset; node_offset += node_span) {
+        VmPageListNode* node;
+        if (next.IsValid() && next->offset() == node_offset) {
+            node = &*next;
+            ++next;
+        } else {
+            fbl::AllocChecker ac;
+            fbl::unique_ptr<VmPageListNode> pl =
+                fbl::unique_ptr<VmPageListNode>(new (&ac) VmPageListNode(node_offset));
+            if (!ac.check())
+                return ZX_ERR_NO_MEMORY;
+
+            LTRACEF("allocating new inner node %p\n", pl.get());
+            node = pl.get();
+            list_.insert(fbl::move(pl));
+        }
+
+        const uint64_t first = MAX(start_offset, node_offset);
+        const uint64_t last = MIN(end_offset, node_offset + node_span);
+        for (uint64_t o = first; o < last; o += PAGE_SIZE) {
+            size_t index = (o - node_offset) / PAGE_SIZE;
+            if (node->GetPage(index)) {
+                continue;
+            }
+            vm_page* p = list_remove_head_type(pages, vm_page, queue_node);
+            if (!p) {
+                // Don't leave behind a node we just created for nothing.
+                if (node->IsEmpty()) {
+                    list_.erase(*node);
+                }
+                return ZX_OK;
+            }
+            __UNUSED auto status = node->AddPage(p, index);
+            DEBUG_ASSERT(status == ZX_OK);
+        }
+    }
+
+    return ZX_OK;
+}
+
+size_t VmPageList::RemoveRange(uint64_t start_offset, uint64_t end_offset, list_node* removed) {
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(start_offset) && IS_PAGE_ALIGNED(end_offset));
+
+    const uint64_t node_span = PAGE_SIZE * VmPageListNode::kPageFanOut;
+
+    LTRACEF_LEVEL(2, "%p start %#" PRIx64 " end %#" PRIx64 "\n", this, start_offset, end_offset);
+
+    size_t count = 0;
+    auto itr = list_.lower_bound(ROUNDDOWN(start_offset, node_span));
+    while (itr.IsValid() && itr->offset() < end_offset) {
+        auto cur = itr++;
+        cur->ForEveryPage(
+            [removed, &count](vm_page*& p, uint64_t offset) {
+                list_add_tail(removed, &p->queue_node);
+                p = nullptr;
+                count++;
+                return ZX_ERR_NEXT;
+            },
+            start_offset, end_offset);
+
+        // if that emptied the node, remove it from the tree
+        if (cur->IsEmpty()) {
+            LTRACEF_LEVEL(2, "%p freeing the list node\n", this);
+            list_.erase(cur);
+        }
+    }
+
+    return count;
+}
+
 size_t VmPageList::FreeAllPages() {
     LTRACEF("%p\n", this);
 
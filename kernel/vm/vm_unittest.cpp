@@ -8,7 +8,10 @@
 #include <err.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/array.h>
+#include <inttypes.h>
 #include <lib/unittest/unittest.h>
+#include <platform.h>
+#include <vm/page_source.h>
 #include <vm/physmap.h>
 #include <vm/vm.h>
 #include <vm/vm_address_region.h>
@@ -492,6 +495,258 @@ static bool vmo_odd_size_commit_test() {
     END_TEST;
 }
 
+// Creates a vm object, commits memory, and has the zero page scanner free the
+// pages that were never written.
+static bool vmo_zero_scan_test() {
+    BEGIN_TEST;
+    static const size_t alloc_size = PAGE_SIZE * 16;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+    ASSERT_TRUE(vmo, "vmobject creation\n");
+
+    uint64_t n;
+    status = vmo->CommitRange(0, alloc_size, &n);
+    ASSERT_EQ(ZX_OK, status, "committing range\n");
+
+    // Dirty one page and pin another; neither may be reclaimed.
+    const uint8_t data = 0x5a;
+    status = vmo->Write(&data, 2 * PAGE_SIZE + 7, sizeof(data));
+    ASSERT_EQ(ZX_OK, status, "writing to vmo\n");
+    status = vmo->Pin(5 * PAGE_SIZE, PAGE_SIZE);
+    ASSERT_EQ(ZX_OK, status, "pinning page\n");
+
+    // A limited scan examines no more than it was asked to.
+    size_t scanned;
+    size_t freed = vmo->ScanForZeroPages(4, &scanned);
+    EXPECT_EQ(4u, scanned, "limited scan\n");
+    EXPECT_EQ(3u, freed, "limited scan\n");
+
+    // The next scan picks up where the last one stopped.
+    freed += vmo->ScanForZeroPages(alloc_size / PAGE_SIZE, &scanned);
+    EXPECT_EQ(12u, scanned, "resumed scan\n");
+    EXPECT_EQ(14u, freed, "resumed scan\n");
+    EXPECT_EQ(14u, vmo->ReclaimedZeroPages(), "reclaimed count\n");
+    EXPECT_EQ(2u, vmo->AllocatedPages(), "pages left after scan\n");
+
+    // The dirty page survives and reclaimed pages still read as zero.
+    uint8_t buf[2] = {0xff, 0xff};
+    status = vmo->Read(&buf[0], 2 * PAGE_SIZE + 7, sizeof(buf[0]));
+    EXPECT_EQ(ZX_OK, status, "reading vmo\n");
+    EXPECT_EQ(data, buf[0], "dirty page contents\n");
+    status = vmo->Read(&buf[1], 3 * PAGE_SIZE, sizeof(buf[1]));
+    EXPECT_EQ(ZX_OK, status, "reading vmo\n");
+    EXPECT_EQ(0u, buf[1], "reclaimed page contents\n");
+    EXPECT_EQ(2u, vmo->AllocatedPages(), "reads don't commit pages\n");
+
+    vmo->Unpin(5 * PAGE_SIZE, PAGE_SIZE);
+    END_TEST;
+}
+
+// Creates a clone whose zeroed page hides a page its parent has compressed;
+// the scanner must keep the clone's page.
+static bool vmo_zero_scan_clone_test() {
+    BEGIN_TEST;
+    static const size_t alloc_size = PAGE_SIZE * 2;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+    ASSERT_TRUE(vmo, "vmobject creation\n");
+
+    const uint8_t data = 0x5a;
+    status = vmo->Write(&data, 7, sizeof(data));
+    ASSERT_EQ(ZX_OK, status, "writing to vmo\n");
+
+    fbl::RefPtr<VmObject> clone;
+    status = vmo->CloneCOW(false, 0, alloc_size, false, &clone);
+    ASSERT_EQ(ZX_OK, status, "cloning vmo\n");
+
+    // Overwrite the clone's copy of the page with zeroes.
+    const uint8_t zeroes[64] = {};
+    for (size_t off = 0; off < PAGE_SIZE; off += sizeof(zeroes)) {
+        status = clone->Write(zeroes, off, sizeof(zeroes));
+        ASSERT_EQ(ZX_OK, status, "writing to clone\n");
+    }
+
+    size_t scanned;
+    vmo->CompressPages(alloc_size / PAGE_SIZE, &scanned);
+    size_t compressed = vmo->CompressPages(alloc_size / PAGE_SIZE, &scanned);
+    EXPECT_EQ(1u, compressed, "compressing parent\n");
+
+    size_t freed = clone->ScanForZeroPages(alloc_size / PAGE_SIZE, &scanned);
+    EXPECT_EQ(0u, freed, "scanning clone\n");
+    EXPECT_EQ(0u, vmo->AllocatedPages(), "scan decompressed the parent\n");
+
+    uint8_t val = 0xff;
+    status = clone->Read(&val, 7, sizeof(val));
+    EXPECT_EQ(ZX_OK, status, "reading clone\n");
+    EXPECT_EQ(0u, val, "clone contents\n");
+    END_TEST;
+}
+
+// Creates a vm object, moves its pages into the compressed page store, and
+// faults them back in.
+static bool vmo_compress_test() {
+    BEGIN_TEST;
+    static const size_t alloc_size = PAGE_SIZE * 16;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+    ASSERT_TRUE(vmo, "vmobject creation\n");
+
+    for (size_t i = 0; i < alloc_size / PAGE_SIZE; i++) {
+        const uint8_t val = static_cast<uint8_t>(i + 1);
+        status = vmo->Write(&val, i * PAGE_SIZE + i, sizeof(val));
+        ASSERT_EQ(ZX_OK, status, "writing to vmo\n");
+    }
+
+    // Freshly faulted pages are given a second chance.
+    size_t scanned;
+    size_t compressed = vmo->CompressPages(alloc_size / PAGE_SIZE, &scanned);
+    EXPECT_EQ(16u, scanned, "first pass\n");
+    EXPECT_EQ(0u, compressed, "first pass\n");
+
+    compressed = vmo->CompressPages(alloc_size / PAGE_SIZE, &scanned);
+    EXPECT_EQ(16u, compressed, "second pass\n");
+    EXPECT_EQ(0u, vmo->AllocatedPages(), "pages left after compression\n");
+
+    // Reading a page brings it, and only it, back.
+    for (size_t i = 0; i < alloc_size / PAGE_SIZE; i++) {
+        uint8_t val = 0;
+        status = vmo->Read(&val, i * PAGE_SIZE + i, sizeof(val));
+        EXPECT_EQ(ZX_OK, status, "reading vmo\n");
+        EXPECT_EQ(i + 1, val, "decompressed contents\n");
+        EXPECT_EQ(i + 1, vmo->AllocatedPages(), "decompressed page count\n");
+    }
+
+    // Lookups only see present pages, so they don't bring compressed ones back.
+    vmo->CompressPages(alloc_size / PAGE_SIZE, &scanned);
+    compressed = vmo->CompressPages(alloc_size / PAGE_SIZE, &scanned);
+    EXPECT_EQ(16u, compressed, "recompressing\n");
+    size_t pages_seen = 0;
+    auto lookup_fn = [](void* context, size_t offset, size_t index, paddr_t pa) {
+        size_t* pages_seen = static_cast<size_t*>(context);
+        (*pages_seen)++;
+        return ZX_OK;
+    };
+    status = vmo->Lookup(0, alloc_size, 0, lookup_fn, &pages_seen);
+    EXPECT_EQ(ZX_ERR_NO_MEMORY, status, "lookup on compressed pages\n");
+    EXPECT_EQ(0u, pages_seen, "lookup on compressed pages\n");
+    EXPECT_EQ(0u, vmo->AllocatedPages(), "lookup decompressed pages\n");
+
+    // Faulting lookups bring the whole range back.
+    status = vmo->Lookup(0, 2 * PAGE_SIZE, VMM_PF_FLAG_SW_FAULT, lookup_fn, &pages_seen);
+    EXPECT_EQ(ZX_OK, status, "faulting lookup on compressed pages\n");
+    EXPECT_EQ(2u, pages_seen, "faulting lookup on compressed pages\n");
+    EXPECT_EQ(2u, vmo->AllocatedPages(), "faulting lookup decompressed pages\n");
+
+    // Pinning requires compressed pages to be resident again.
+    status = vmo->Pin(0, 4 * PAGE_SIZE);
+    EXPECT_EQ(ZX_OK, status, "pinning compressed range\n");
+    EXPECT_EQ(4u, vmo->AllocatedPages(), "pinned pages are resident\n");
+    vmo->Unpin(0, 4 * PAGE_SIZE);
+
+    // Decommit drops compressed pages along with resident ones.
+    uint64_t n;
+    status = vmo->DecommitRange(0, alloc_size, &n);
+    EXPECT_EQ(ZX_OK, status, "decommitting range\n");
+    EXPECT_EQ(alloc_size, n, "decommitted everything\n");
+
+    END_TEST;
+}
+
+namespace {
+
+// Page source that just counts the requests it is sent.
+class TestPageSource : public PageSource {
+public:
+    size_t requests() const { return requests_; }
+
+private:
+    zx_status_t SendRequest(uint64_t offset, uint64_t len) override {
+        requests_++;
+        return ZX_OK;
+    }
+
+    size_t requests_ = 0;
+};
+
+} // namespace
+
+static bool vmo_page_source_test() {
+    BEGIN_TEST;
+    static const size_t alloc_size = PAGE_SIZE * 4;
+
+    fbl::AllocChecker ac;
+    auto src = fbl::AdoptRef(new (&ac) TestPageSource());
+    ASSERT_TRUE(ac.check(), "page source creation\n");
+
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::CreateWithSource(PMM_ALLOC_FLAG_ANY, alloc_size,
+                                                         src, &vmo);
+    ASSERT_EQ(ZX_OK, status, "vmobject creation\n");
+    EXPECT_TRUE(vmo->is_pager_backed(), "pager backed\n");
+
+    // Missing pages are requested from the source, once.
+    PageRequest request1;
+    PageRequest request2;
+    {
+        Guard<fbl::Mutex> guard{vmo->lock()};
+        paddr_t pa;
+        status = vmo->GetPageLocked(0, VMM_PF_FLAG_SW_FAULT, nullptr, &request1, nullptr, &pa);
+        EXPECT_EQ(ZX_ERR_SHOULD_WAIT, status, "first request\n");
+        status = vmo->GetPageLocked(0, VMM_PF_FLAG_SW_FAULT, nullptr, &request2, nullptr, &pa);
+        EXPECT_EQ(ZX_ERR_SHOULD_WAIT, status, "second request\n");
+        status = vmo->GetPageLocked(0, VMM_PF_FLAG_SW_FAULT, nullptr, nullptr, nullptr, &pa);
+        EXPECT_EQ(ZX_ERR_NOT_FOUND, status, "lookup without a request\n");
+    }
+    EXPECT_EQ(1u, src->requests(), "coalesced requests\n");
+
+    uint64_t committed;
+    status = vmo->CommitRange(0, alloc_size, &committed);
+    EXPECT_EQ(ZX_ERR_NOT_SUPPORTED, status, "committing pager-backed vmo\n");
+
+    // Supply the page from another vmo, which gives it up.
+    fbl::RefPtr<VmObject> aux;
+    status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, PAGE_SIZE, &aux);
+    ASSERT_EQ(ZX_OK, status, "aux vmobject creation\n");
+    const uint8_t val = 0x5a;
+    status = aux->Write(&val, 7, sizeof(val));
+    ASSERT_EQ(ZX_OK, status, "writing aux vmo\n");
+
+    list_node pages;
+    list_initialize(&pages);
+    status = aux->TakePages(0, PAGE_SIZE, &pages);
+    ASSERT_EQ(ZX_OK, status, "taking aux pages\n");
+    EXPECT_EQ(0u, aux->AllocatedPages(), "aux pages left\n");
+    status = vmo->SupplyPages(0, PAGE_SIZE, &pages);
+    EXPECT_EQ(ZX_OK, status, "supplying pages\n");
+    EXPECT_TRUE(list_is_empty(&pages), "all pages supplied\n");
+
+    EXPECT_EQ(ZX_OK, request1.Wait(), "first request completed\n");
+    EXPECT_EQ(ZX_OK, request2.Wait(), "second request completed\n");
+
+    uint8_t read_val = 0;
+    status = vmo->Read(&read_val, 7, sizeof(read_val));
+    EXPECT_EQ(ZX_OK, status, "reading supplied page\n");
+    EXPECT_EQ(val, read_val, "supplied contents\n");
+    EXPECT_EQ(1u, src->requests(), "no request for a supplied page\n");
+
+    // Closing the source fails outstanding and later requests.
+    {
+        Guard<fbl::Mutex> guard{vmo->lock()};
+        paddr_t pa;
+        status = vmo->GetPageLocked(PAGE_SIZE, 0, nullptr, &request1, nullptr, &pa);
+        EXPECT_EQ(ZX_ERR_SHOULD_WAIT, status, "request before close\n");
+    }
+    src->Close();
+    EXPECT_EQ(ZX_ERR_BAD_STATE, request1.Wait(), "request failed by close\n");
+    status = vmo->Read(&read_val, PAGE_SIZE, sizeof(read_val));
+    EXPECT_EQ(ZX_ERR_BAD_STATE, status, "reading after close\n");
+
+    END_TEST;
+}
+
 static bool vmo_create_physical_test() {
     BEGIN_TEST;
 
@@ -1031,6 +1286,50 @@ static bool arch_noncontiguous_map() {
     END_TEST;
 }
 
+// Fills and empties ranges of a VmPageList that straddle node boundaries.
+static bool vmpl_range_test() {
+    BEGIN_TEST;
+
+    list_node pages = LIST_INITIAL_VALUE(pages);
+    size_t allocated = pmm_alloc_pages(40, 0, &pages);
+    ASSERT_EQ(40u, allocated, "allocating pages\n");
+
+    VmPageList pl;
+    vm_page_t* existing = list_remove_head_type(&pages, vm_page_t, queue_node);
+    ASSERT_EQ(ZX_OK, pl.AddPage(existing, 5 * PAGE_SIZE), "adding page\n");
+
+    // The existing page is left in place and its slot skipped, so of the 39
+    // remaining pages, 37 fill the range.
+    EXPECT_EQ(ZX_OK, pl.FillRange(2 * PAGE_SIZE, 40 * PAGE_SIZE, &pages), "filling range\n");
+    EXPECT_EQ(2u, list_length(&pages), "pages left over\n");
+    EXPECT_EQ(existing, pl.GetPage(5 * PAGE_SIZE), "existing page\n");
+    for (uint64_t o = 0; o < 48 * PAGE_SIZE; o += PAGE_SIZE) {
+        bool in_range = o >= 2 * PAGE_SIZE && o < 40 * PAGE_SIZE;
+        EXPECT_EQ(in_range, pl.GetPage(o) != nullptr, "filled page\n");
+    }
+
+    // Running out of pages stops the fill without failing it.
+    EXPECT_EQ(ZX_OK, pl.FillRange(40 * PAGE_SIZE, 48 * PAGE_SIZE, &pages), "filling range\n");
+    EXPECT_TRUE(list_is_empty(&pages), "pages left over\n");
+    EXPECT_NONNULL(pl.GetPage(40 * PAGE_SIZE), "partially filled range\n");
+    EXPECT_NONNULL(pl.GetPage(41 * PAGE_SIZE), "partially filled range\n");
+    EXPECT_NULL(pl.GetPage(42 * PAGE_SIZE), "partially filled range\n");
+
+    EXPECT_EQ(10u, pl.RemoveRange(10 * PAGE_SIZE, 20 * PAGE_SIZE, &pages), "removing range\n");
+    EXPECT_EQ(10u, list_length(&pages), "removed pages\n");
+    EXPECT_NONNULL(pl.GetPage(9 * PAGE_SIZE), "page before removed range\n");
+    EXPECT_NULL(pl.GetPage(10 * PAGE_SIZE), "removed range\n");
+    EXPECT_NULL(pl.GetPage(19 * PAGE_SIZE), "removed range\n");
+    EXPECT_NONNULL(pl.GetPage(20 * PAGE_SIZE), "page after removed range\n");
+
+    EXPECT_EQ(30u, pl.RemoveRange(0, 64 * PAGE_SIZE, &pages), "removing everything\n");
+    EXPECT_TRUE(pl.IsEmpty(), "list emptied\n");
+
+    pmm_free(&pages);
+
+    END_TEST;
+}
+
 // Use the function name as the test name
 #define VM_UNITTEST(fname) UNITTEST(#fname, fname)
 
@@ -1054,6 +1353,10 @@ VM_UNITTEST(vmo_pin_test)
 VM_UNITTEST(vmo_multiple_pin_test)
 VM_UNITTEST(vmo_commit_test)
 VM_UNITTEST(vmo_odd_size_commit_test)
+VM_UNITTEST(vmo_zero_scan_test)
+VM_UNITTEST(vmo_zero_scan_clone_test)
+VM_UNITTEST(vmo_compress_test)
+VM_UNITTEST(vmo_page_source_test)
 VM_UNITTEST(vmo_create_physical_test)
 VM_UNITTEST(vmo_create_contiguous_test)
 VM_UNITTEST(vmo_contiguous_decommit_test)
@@ -1066,6 +1369,7 @@ VM_UNITTEST(vmo_read_write_smoke_test)
 VM_UNITTEST(vmo_cache_test)
 VM_UNITTEST(vmo_lookup_test)
 VM_UNITTEST(arch_noncontiguous_map)
+VM_UNITTEST(vmpl_range_test)
 // Uncomment for debugging
 // VM_UNITTEST(dump_all_aspaces)  // Run last
 UNITTEST_END_TESTCASE(vm_tests, "vmtests", "Virtual memory tests");
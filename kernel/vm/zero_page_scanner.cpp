@@ -0,0 +1,103 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// The zero page scanner is a low priority kernel thread that periodically
+// walks the committed pages of every VMO and frees the ones that contain only
+// zeroes. Subsequent reads of those offsets map the shared zero page, and
+// writes fault in a fresh page as they would for never-touched memory.
+
+#include <inttypes.h>
+#include <kernel/cmdline.h>
+#include <kernel/thread.h>
+#include <lib/console.h>
+#include <lib/counters.h>
+#include <lk/init.h>
+#include <string.h>
+#include <trace.h>
+#include <vm/vm_object.h>
+#include <zircon/time.h>
+
+#include "vm_priv.h"
+
+#define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
+
+KCOUNTER(zero_scan_passes, "kernel.vm.zero_scan.passes");
+KCOUNTER(zero_scan_pages_freed, "kernel.vm.zero_scan.pages_freed");
+
+namespace {
+
+// Set once at init time, before the thread is started.
+zx_duration_t scan_interval;
+size_t scan_pages_per_pass;
+
+thread_t* scan_thread;
+
+size_t ScanPass() {
+    size_t freed = VmObject::ScanAllForZeroPages(scan_pages_per_pass);
+    kcounter_add(zero_scan_passes, 1);
+    kcounter_add(zero_scan_pages_freed, freed);
+    LTRACEF("freed %zu zero pages\n", freed);
+    return freed;
+}
+
+int ScanLoop(void* arg) {
+    while (true) {
+        thread_sleep_relative(scan_interval);
+        ScanPass();
+    }
+    return 0;
+}
+
+void zero_page_scanner_init(uint level) {
+    // Be sure to update kernel_cmdline.md if any of these defaults change.
+    scan_interval = ZX_SEC(cmdline_get_uint64("kernel.zero-page-scanner.sleep-sec", 10));
+    scan_pages_per_pass = cmdline_get_uint64("kernel.zero-page-scanner.pages-per-pass", 4096);
+
+    if (!cmdline_get_bool("kernel.zero-page-scanner.enable", false)) {
+        return;
+    }
+
+    scan_thread = thread_create("zero-page-scanner", ScanLoop, nullptr, LOW_PRIORITY);
+    if (scan_thread == nullptr) {
+        printf("VM: failed to create zero page scanner thread\n");
+        return;
+    }
+    thread_resume(scan_thread);
+}
+
+} // namespace
+
+LK_INIT_HOOK(zero_page_scanner, zero_page_scanner_init, LK_INIT_LEVEL_USER);
+
+static int cmd_zero_page_scanner(int argc, const cmd_args* argv, uint32_t flags) {
+    if (argc < 2) {
+        printf("not enough arguments\n");
+    usage:
+        printf("usage:\n");
+        printf("%s info : dump scanner params/state\n", argv[0].str);
+        printf("%s scan : run one scanner pass now\n", argv[0].str);
+        return ZX_ERR_INTERNAL;
+    }
+
+    if (!strcmp(argv[1].str, "info")) {
+        printf("running: %s\n", scan_thread ? "true" : "false");
+        printf("interval: %" PRIi64 "ms\n", scan_interval / ZX_MSEC(1));
+        printf("pages per pass: %zu\n", scan_pages_per_pass);
+    } else if (!strcmp(argv[1].str, "scan")) {
+        printf("freed %zu zero pages\n", ScanPass());
+    } else {
+        printf("unknown command\n");
+        goto usage;
+    }
+
+    return ZX_OK;
+}
+
+STATIC_COMMAND_START
+#if LK_DEBUGLEVEL > 0
+STATIC_COMMAND("zps", "zero page scanner", &cmd_zero_page_scanner)
+#endif
+STATIC_COMMAND_END(zps);
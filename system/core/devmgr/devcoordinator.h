@@ -62,10 +62,22 @@ struct dc_devhost {
 
     // list of all child devhosts of this devhost
     list_node_t children;
+
+    // when the launch of this devhost began, and how long it took
+    zx_time_t launch_start;
+    zx_duration_t launch_time;
+
+    // name of the devhost process
+    char name[ZX_MAX_NAME_LEN];
 };
 
 #define DEV_HOST_DYING 1
 #define DEV_HOST_SUSPEND 2
+// The devhost process is still being launched.  Requests sent to it
+// are queued in its rpc channel until it starts.
+#define DEV_HOST_LAUNCHING 4
+// The devhost is in the pool of spare devhosts, and has no devices yet.
+#define DEV_HOST_POOLED 8
 
 struct dc_device {
     zx_handle_t hrpc;
@@ -107,6 +119,12 @@ struct dc_device {
     // listnode for this device's metadata (list of dc_metadata_t)
     list_node_t metadata;
 
+    // boot timeline: when the device was added, when a driver was last
+    // sent to its devhost to bind, and when that bind completed
+    zx_time_t added_time;
+    zx_time_t bind_time;
+    zx_time_t ready_time;
+
     zx_device_prop_t props[];
 };
 
@@ -151,6 +169,9 @@ struct dc_driver {
     zx_handle_t dso_vmo;
     struct list_node node;
     const char* libname;
+    // position in the all-drivers list, set by dc_bind_index_add();
+    // drivers with lower values are tried first
+    int32_t priority;
 };
 
 #define DRIVER_NAME_LEN_MAX 64
@@ -172,6 +193,45 @@ bool dc_is_bindable(driver_t* drv, uint32_t protocol_id,
                     zx_device_prop_t* props, size_t prop_count,
                     bool autobind);
 
+// The bind index holds every driver in the all-drivers list, keyed on the
+// protocols its bind program can match, so that the drivers which might bind
+// to a new device are found without running every driver's bind program.
+// Drivers whose programs cannot be narrowed down to a few protocols are
+// candidates for every device.
+//
+// Only the protocol is indexed.  Among the drivers for a protocol, matches on
+// other properties such as PCI or USB vendor and device IDs are still found
+// by running each bind program, so a protocol with many drivers (PCI, USB)
+// still costs one program run per driver for each device added.
+
+// Adds |drv| to the index, at the head or tail of the priority order.
+void dc_bind_index_add(driver_t* drv, bool first);
+
+// Most protocols a driver is indexed under.  Bind programs which can match
+// more are indexed as matching any protocol.
+#define DC_BIND_MAX_PROTOCOLS 8
+
+// Finds the protocols a device must have for |drv|'s bind program to match
+// it, by walking the program from the start for as long as every instruction
+// either matches on the protocol or can only abort.  Fills in at most
+// DC_BIND_MAX_PROTOCOLS |protocols|, and returns false if the program might
+// match a device with any protocol.
+bool dc_bind_protocols(const driver_t* drv, uint32_t* protocols, size_t* count);
+
+typedef struct dc_bind_iter {
+    list_node_t* list[2];
+    list_node_t* pos[2];
+} dc_bind_iter_t;
+
+// Starts an iteration over the drivers which might bind to a device with
+// |protocol_id| and |props|, in priority order.  dc_is_bindable() must still
+// be used to check each of them.
+void dc_bind_index_find(dc_bind_iter_t* it, uint32_t protocol_id,
+                        const zx_device_prop_t* props, size_t prop_count);
+
+// Returns the next candidate driver, or nullptr when there are no more.
+driver_t* dc_bind_iter_next(dc_bind_iter_t* it);
+
 #define DC_MAX_DATA 4096
 
 // The first two fields of devcoordinator messages align
@@ -7,6 +7,7 @@
 #include <ddk/binding.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "devcoordinator.h"
 
@@ -154,3 +155,176 @@ bool dc_is_bindable(driver_t* drv, uint32_t protocol_id,
     ctx.autobind = autobind ? 1 : 0;
     return is_bindable(&ctx);
 }
+
+bool dc_bind_protocols(const driver_t* drv, uint32_t* protocols, size_t* count) {
+    const zx_bind_inst_t* ip = drv->binding;
+    const zx_bind_inst_t* end = ip + (drv->binding_size / sizeof(zx_bind_inst_t));
+    size_t n = 0;
+
+    for (; ip < end; ip++) {
+        uint32_t op = BINDINST_OP(ip->op);
+        uint32_t cc = BINDINST_CC(ip->op);
+        bool on_protocol = (cc != COND_AL) && (BINDINST_PB(ip->op) == BIND_PROTOCOL);
+
+        if (op == OP_LABEL || op == OP_SET || op == OP_CLEAR) {
+            continue;
+        }
+        if (op == OP_ABORT && on_protocol && cc == COND_NE) {
+            // every match from here on requires this protocol
+            if (n == DC_BIND_MAX_PROTOCOLS) {
+                return false;
+            }
+            protocols[n++] = ip->arg;
+            break;
+        }
+        if (op == OP_ABORT) {
+            if (cc == COND_AL) {
+                // nothing after this is reachable
+                break;
+            }
+            continue;
+        }
+        if (op == OP_MATCH && on_protocol && cc == COND_EQ) {
+            if (n == DC_BIND_MAX_PROTOCOLS) {
+                return false;
+            }
+            protocols[n++] = ip->arg;
+            continue;
+        }
+        // any other match or jump may be taken whatever the protocol
+        return false;
+    }
+    *count = n;
+    return true;
+}
+
+typedef struct bind_entry {
+    list_node_t node;
+    driver_t* drv;
+} bind_entry_t;
+
+typedef struct bind_bucket {
+    list_node_t node;
+    uint32_t protocol_id;
+    list_node_t drivers; // bind_entry_t, in priority order
+} bind_bucket_t;
+
+#define BIND_INDEX_CHAINS 64
+
+static list_node_t bind_index[BIND_INDEX_CHAINS]; // bind_bucket_t, hashed on protocol
+static list_node_t bind_any = LIST_INITIAL_VALUE(bind_any); // bind_entry_t
+static int32_t bind_priority_first;
+static int32_t bind_priority_last;
+
+static list_node_t* bind_chain(uint32_t protocol_id) {
+    static bool ready;
+    if (!ready) {
+        for (auto& chain : bind_index) {
+            list_initialize(&chain);
+        }
+        ready = true;
+    }
+    // protocol ids are four-character codes, so mix in every byte
+    uint32_t h = protocol_id ^ (protocol_id >> 8) ^ (protocol_id >> 16) ^ (protocol_id >> 24);
+    return &bind_index[h % BIND_INDEX_CHAINS];
+}
+
+static bind_bucket_t* bind_bucket(uint32_t protocol_id, bool create) {
+    list_node_t* chain = bind_chain(protocol_id);
+    bind_bucket_t* bucket;
+    list_for_every_entry(chain, bucket, bind_bucket_t, node) {
+        if (bucket->protocol_id == protocol_id) {
+            return bucket;
+        }
+    }
+    if (!create) {
+        return nullptr;
+    }
+    if ((bucket = static_cast<bind_bucket_t*>(calloc(1, sizeof(bind_bucket_t)))) == nullptr) {
+        return nullptr;
+    }
+    bucket->protocol_id = protocol_id;
+    list_initialize(&bucket->drivers);
+    list_add_tail(chain, &bucket->node);
+    return bucket;
+}
+
+static bool bind_index_insert(list_node_t* list, driver_t* drv, bool first) {
+    auto entry = static_cast<bind_entry_t*>(calloc(1, sizeof(bind_entry_t)));
+    if (entry == nullptr) {
+        return false;
+    }
+    entry->drv = drv;
+    if (first) {
+        list_add_head(list, &entry->node);
+    } else {
+        list_add_tail(list, &entry->node);
+    }
+    return true;
+}
+
+void dc_bind_index_add(driver_t* drv, bool first) {
+    drv->priority = first ? --bind_priority_first : ++bind_priority_last;
+    if (drv->binding_size == 0) {
+        // never bindable
+        return;
+    }
+
+    uint32_t protocols[DC_BIND_MAX_PROTOCOLS];
+    size_t count;
+    if (dc_bind_protocols(drv, protocols, &count)) {
+        for (size_t i = 0; i < count; i++) {
+            bool dup = false;
+            for (size_t j = 0; j < i; j++) {
+                dup |= (protocols[j] == protocols[i]);
+            }
+            if (dup) {
+                continue;
+            }
+            bind_bucket_t* bucket = bind_bucket(protocols[i], true);
+            if (bucket == nullptr || !bind_index_insert(&bucket->drivers, drv, first)) {
+                printf("devmgr: cannot index driver '%s'\n", drv->name);
+            }
+        }
+    } else if (!bind_index_insert(&bind_any, drv, first)) {
+        printf("devmgr: cannot index driver '%s'\n", drv->name);
+    }
+}
+
+void dc_bind_index_find(dc_bind_iter_t* it, uint32_t protocol_id,
+                        const zx_device_prop_t* props, size_t prop_count) {
+    // as for dev_get_prop(), a BIND_PROTOCOL property overrides the protocol id
+    for (size_t i = 0; i < prop_count; i++) {
+        if (props[i].id == BIND_PROTOCOL) {
+            protocol_id = props[i].value;
+            break;
+        }
+    }
+    bind_bucket_t* bucket = bind_bucket(protocol_id, false);
+    it->list[0] = (bucket != nullptr) ? &bucket->drivers : nullptr;
+    it->pos[0] = it->list[0];
+    it->list[1] = &bind_any;
+    it->pos[1] = &bind_any;
+}
+
+driver_t* dc_bind_iter_next(dc_bind_iter_t* it) {
+    bind_entry_t* next[2] = {};
+    for (int i = 0; i < 2; i++) {
+        if (it->list[i] != nullptr) {
+            list_node_t* node = list_next(it->list[i], it->pos[i]);
+            next[i] = (node != nullptr) ? containerof(node, bind_entry_t, node) : nullptr;
+        }
+    }
+    int i;
+    if (next[0] == nullptr && next[1] == nullptr) {
+        return nullptr;
+    } else if (next[0] == nullptr) {
+        i = 1;
+    } else if (next[1] == nullptr) {
+        i = 0;
+    } else {
+        i = (next[0]->drv->priority < next[1]->drv->priority) ? 0 : 1;
+    }
+    it->pos[i] = &next[i]->node;
+    return next[i]->drv;
+}
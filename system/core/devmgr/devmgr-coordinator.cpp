@@ -5,9 +5,11 @@
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <threads.h>
 
@@ -49,6 +51,7 @@ static zx_handle_t bootdata_vmo;
 static void dc_dump_state(void);
 static void dc_dump_devprops(void);
 static void dc_dump_drivers(void);
+static void dc_dump_timeline(void);
 
 typedef struct {
     zx_status_t status;
@@ -153,6 +156,11 @@ static device_t test_device = []() {
 
 static zx_handle_t dmctl_socket;
 
+// Devices which have been matched against the drivers by dc_handle_new_device(),
+// and the time taken to do so.
+static uint32_t bind_match_count;
+static zx_duration_t bind_match_time;
+
 static void dmprintf(const char* fmt, ...) {
     if (dmctl_socket == ZX_HANDLE_INVALID) {
         return;
@@ -188,6 +196,8 @@ static zx_status_t handle_dmctl_write(size_t len, const char* cmd) {
                      "ktraceon          - start kernel tracing\n"
                      "devprops          - dump published devices and their binding properties\n"
                      "drivers           - list discovered drivers and their properties\n"
+                     "timeline          - show when devices were added, bound and ready\n"
+                     "bindstats         - show how many devices were matched against drivers\n"
                      );
             return ZX_OK;
         }
@@ -229,6 +239,15 @@ static zx_status_t handle_dmctl_write(size_t len, const char* cmd) {
             dc_dump_devprops();
             return ZX_OK;
         }
+        if (!memcmp(cmd, "timeline", 8)) {
+            dc_dump_timeline();
+            return ZX_OK;
+        }
+    }
+    if ((len == 9) && !memcmp(cmd, "bindstats", 9)) {
+        dmprintf("devices=%u took=%" PRId64 "us\n", bind_match_count,
+                 bind_match_time / ZX_USEC(1));
+        return ZX_OK;
     }
     if ((len == 9) && (!memcmp(cmd, "ktraceoff", 9))) {
         zx_ktrace_control(get_root_resource(), KTRACE_ACTION_STOP, 0, nullptr);
@@ -276,6 +295,18 @@ static list_node_t list_devices = LIST_INITIAL_VALUE(list_devices);
 // All DevHosts
 static list_node_t list_devhosts = LIST_INITIAL_VALUE(list_devhosts);
 
+// Spare devhosts, which are launched ahead of time so that a new devhost
+// need not wait for its process to be loaded and started, and for it to
+// load libc, libdriver and the rest of its shared libraries.  Set with
+// devmgr.devhost.pool (default 0, since each spare devhost costs memory
+// for as long as it sits idle); the pool is refilled as devhosts are
+// taken from it.  The timeline dmctl command reports what it costs.
+static list_node_t list_devhost_pool = LIST_INITIAL_VALUE(list_devhost_pool);
+static uint32_t devhost_pool_size;
+static uint32_t devhost_pool_count;
+static uint32_t devhost_pool_hits;
+static uint32_t devhost_pool_misses;
+
 static driver_t* libname_to_driver(const char* libname) {
     driver_t* drv;
     list_for_every_entry(&list_drivers, drv, driver_t, node) {
@@ -371,6 +402,87 @@ static void dc_dump_state(void) {
     dc_dump_device(&test_device, 1);
 }
 
+// The first block device to be added, for measuring time to block device.
+static zx_time_t first_block_time;
+static char first_block_name[ZX_DEVICE_NAME_MAX + 1];
+
+// Formats |t|, in nanoseconds since boot, as milliseconds.
+static const char* dc_time_str(zx_time_t t, char* buf, size_t len) {
+    if (t == 0) {
+        snprintf(buf, len, "-");
+    } else {
+        snprintf(buf, len, "%" PRId64 ".%03" PRId64 "ms",
+                 t / ZX_MSEC(1), (t % ZX_MSEC(1)) / ZX_USEC(1));
+    }
+    return buf;
+}
+
+static void dc_dump_device_timeline(device_t* dev, size_t indent) {
+    char added[32], bind[32], ready[32];
+    dmprintf("%*s%c%s%c added=%s bind=%s ready=%s\n",
+             (int) (indent * 3), "",
+             dev->flags & DEV_CTX_PROXY ? '<' : '[',
+             dev->name,
+             dev->flags & DEV_CTX_PROXY ? '>' : ']',
+             dc_time_str(dev->added_time, added, sizeof(added)),
+             dc_time_str(dev->bind_time, bind, sizeof(bind)),
+             dc_time_str(dev->ready_time, ready, sizeof(ready)));
+    device_t* child;
+    if (dev->proxy) {
+        indent++;
+        dc_dump_device_timeline(dev->proxy, indent);
+    }
+    list_for_every_entry(&dev->children, child, device_t, node) {
+        dc_dump_device_timeline(child, indent + 1);
+    }
+}
+
+// Private memory of a devhost's process, which is what a spare devhost
+// costs; shared pages (libc, libdriver) are paid for once whatever the
+// pool size.
+static size_t dc_devhost_mem(devhost_t* dh) {
+    zx_info_task_stats_t info;
+    if ((dh->proc == ZX_HANDLE_INVALID) ||
+        (zx_object_get_info(dh->proc, ZX_INFO_TASK_STATS, &info,
+                            sizeof(info), nullptr, nullptr) != ZX_OK)) {
+        return 0;
+    }
+    return info.mem_private_bytes;
+}
+
+static void dc_dump_timeline(void) {
+    char buf[32];
+    if (first_block_time != 0) {
+        dmprintf("first block device: %s at %s\n", first_block_name,
+                 dc_time_str(first_block_time, buf, sizeof(buf)));
+    } else {
+        dmprintf("first block device: none\n");
+    }
+    devhost_t* dh;
+    size_t spare_mem = 0;
+    list_for_every_entry(&list_devhost_pool, dh, devhost_t, node) {
+        spare_mem += dc_devhost_mem(dh);
+    }
+    dmprintf("devhost pool: size=%u spare=%u hits=%u misses=%u mem=%zuK\n",
+             devhost_pool_size, devhost_pool_count, devhost_pool_hits, devhost_pool_misses,
+             spare_mem / 1024);
+    list_for_every_entry(&list_devhosts, dh, devhost_t, anode) {
+        char took[32];
+        if (dh->flags & DEV_HOST_LAUNCHING) {
+            snprintf(took, sizeof(took), "launching");
+        } else {
+            snprintf(took, sizeof(took), "%" PRId64 "us", dh->launch_time / ZX_USEC(1));
+        }
+        dmprintf("devhost '%s' pid=%zu launched=%s took=%s mem=%zuK\n", dh->name, dh->koid,
+                 dc_time_str(dh->launch_start, buf, sizeof(buf)), took,
+                 dc_devhost_mem(dh) / 1024);
+    }
+    dc_dump_device_timeline(&root_device, 0);
+    dc_dump_device_timeline(&misc_device, 1);
+    dc_dump_device_timeline(&sys_device, 1);
+    dc_dump_device_timeline(&test_device, 1);
+}
+
 static void dc_dump_device_props(device_t* dev) {
     if (dev->host) {
         dmprintf("Name [%s]%s%s%s\n",
@@ -608,21 +720,47 @@ static void dc_watch(zx_handle_t h) {
     }
 }
 
-static zx_status_t dc_launch_devhost(devhost_t* host,
-                                     const char* name, zx_handle_t hrpc) {
-    const char* devhost_bin = get_devhost_bin();
+// Devhosts are launched on threads of their own, since loading and
+// starting a process is slow enough to hold up the rest of boot.  The
+// devhost's rpc channel exists from the start, so the coordinator goes
+// straight on to create devices in the new devhost and bind drivers to
+// them: those requests wait in the channel until the devhost is running,
+// while work for devices in other devhosts carries on meanwhile.
+//
+// The launcher hands its result back by signaling an event which the
+// coordinator began waiting on before the thread was started.  The port
+// packet for an async wait is reserved when the wait is registered, so
+// unlike port_queue() from the launcher thread, the delivery cannot fail
+// and leave the devhost stuck in DEV_HOST_LAUNCHING.
+typedef struct {
+    port_handler_t ph;
+    devhost_t* host;
+    char name[ZX_MAX_NAME_LEN];
+    const char* devhost_bin;
 
-    launchpad_t* lp;
-    launchpad_create_with_jobs(devhost_job, 0, name, &lp);
-    launchpad_load_from_file(lp, devhost_bin);
-    launchpad_set_args(lp, 1, &devhost_bin);
+    // handles for the new process, owned by the launcher thread
+    zx_handle_t hrpc;
+    zx_handle_t resource;
+    zx_handle_t boot;
+    zx_handle_t svc;
+    zx_handle_t job_root;
+
+    // results, filled in by the launcher thread
+    zx_status_t status;
+    zx_handle_t proc;
+    zx_time_t done;
+} devhost_launch_t;
 
-    launchpad_add_handle(lp, hrpc, PA_HND(PA_USER0, 0));
+static int devhost_launcher(void* arg) {
+    auto ctx = static_cast<devhost_launch_t*>(arg);
 
-    zx_handle_t h;
-    //TODO: limit root resource to root devhost only
-    zx_handle_duplicate(get_root_resource(), ZX_RIGHT_SAME_RIGHTS, &h);
-    launchpad_add_handle(lp, h, PA_HND(PA_RESOURCE, 0));
+    launchpad_t* lp;
+    launchpad_create_with_jobs(devhost_job, 0, ctx->name, &lp);
+    launchpad_load_from_file(lp, ctx->devhost_bin);
+    launchpad_set_args(lp, 1, &ctx->devhost_bin);
+
+    launchpad_add_handle(lp, ctx->hrpc, PA_HND(PA_USER0, 0));
+    launchpad_add_handle(lp, ctx->resource, PA_HND(PA_RESOURCE, 0));
 
     // Inherit devmgr's environment (including kernel cmdline)
     launchpad_clone(lp, LP_CLONE_ENVIRON);
@@ -630,43 +768,141 @@ static zx_status_t dc_launch_devhost(devhost_t* host,
     const char* nametable[2] = { "/boot", "/svc", };
     uint32_t name_count = 0;
 
-    //TODO: eventually devhosts should not have vfs access
-    launchpad_add_handle(lp, fs_clone("boot"),
-                         PA_HND(PA_NS_DIR, name_count++));
-
-    //TODO: constrain to /svc/device
-    if ((h = fs_clone("svc")) != ZX_HANDLE_INVALID) {
-        launchpad_add_handle(lp, h, PA_HND(PA_NS_DIR, name_count++));
+    launchpad_add_handle(lp, ctx->boot, PA_HND(PA_NS_DIR, name_count++));
+    if (ctx->svc != ZX_HANDLE_INVALID) {
+        launchpad_add_handle(lp, ctx->svc, PA_HND(PA_NS_DIR, name_count++));
     }
 
     launchpad_set_nametable(lp, name_count, nametable);
 
-    //TODO: limit root job access to root devhost only
-    launchpad_add_handle(lp, get_sysinfo_job_root(),
-                         PA_HND(PA_USER0, ID_HJOBROOT));
+    launchpad_add_handle(lp, ctx->job_root, PA_HND(PA_USER0, ID_HJOBROOT));
 
     const char* errmsg;
-    zx_status_t status = launchpad_go(lp, &host->proc, &errmsg);
-    if (status < 0) {
+    ctx->status = launchpad_go(lp, &ctx->proc, &errmsg);
+    ctx->done = zx_clock_get_monotonic();
+    if (ctx->status < 0) {
         log(ERROR, "devcoord: launch devhost '%s': failed: %d: %s\n",
-            name, status, errmsg);
-        return status;
+            ctx->name, ctx->status, errmsg);
+    }
+
+    zx_status_t r = zx_object_signal(ctx->ph.handle, 0, ZX_EVENT_SIGNALED);
+    if (r != ZX_OK) {
+        // Only a bad event handle gets here.  Don't leave an orphaned
+        // process running that the coordinator will never learn about.
+        log(ERROR, "devcoord: launch devhost '%s': cannot signal: %d\n", ctx->name, r);
+        if (ctx->status == ZX_OK) {
+            zx_task_kill(ctx->proc);
+            zx_handle_close(ctx->proc);
+        }
+    }
+    return 0;
+}
+
+static void dc_release_devhost(devhost_t* dh);
+
+static zx_status_t dc_handle_devhost_launched(port_handler_t* ph, zx_signals_t signals,
+                                              uint32_t evt) {
+    devhost_launch_t* ctx = containerof(ph, devhost_launch_t, ph);
+    devhost_t* host = ctx->host;
+
+    zx_handle_close(ctx->ph.handle);
+    host->flags &= ~DEV_HOST_LAUNCHING;
+    host->launch_time = ctx->done - host->launch_start;
+    if (host->launch_time < 0) {
+        // A pooled devhost handed out after its launch finished was not
+        // waited for at all.
+        host->launch_time = 0;
+    }
+    if (ctx->status == ZX_OK) {
+        host->proc = ctx->proc;
+        zx_info_handle_basic_t info;
+        if (zx_object_get_info(host->proc, ZX_INFO_HANDLE_BASIC, &info,
+                               sizeof(info), nullptr, nullptr) == ZX_OK) {
+            host->koid = info.koid;
+        }
+        // A pooled devhost may have been handed out, and renamed, while
+        // it was launching.
+        if (strcmp(ctx->name, host->name)) {
+            zx_object_set_property(host->proc, ZX_PROP_NAME, host->name, strlen(host->name));
+        }
+        log(INFO, "devcoord: launch devhost '%s': pid=%zu (%" PRId64 "us)\n",
+            host->name, host->koid, host->launch_time / ZX_USEC(1));
+    } else if (host->flags & DEV_HOST_POOLED) {
+        // Drop the pool's reference to a devhost which will never start.
+        host->flags &= ~DEV_HOST_POOLED;
+        list_delete(&host->node);
+        devhost_pool_count--;
+        host->refcount--;
+    }
+    // If the launch failed, the devhost's end of the rpc channel has been
+    // closed, and so its devices are removed as their channels close.
+
+    // Drop the reference taken for the launch, which kept the devhost
+    // around to receive its process handle.
+    dc_release_devhost(host);
+    free(ctx);
+    // The wait was one-shot, and its context is gone.
+    return ZX_ERR_STOP;
+}
+
+static zx_status_t dc_launch_devhost(devhost_t* host,
+                                     const char* name, zx_handle_t hrpc) {
+    devhost_launch_t* ctx = static_cast<devhost_launch_t*>(calloc(1, sizeof(devhost_launch_t)));
+    if (ctx == nullptr) {
+        zx_handle_close(hrpc);
+        return ZX_ERR_NO_MEMORY;
     }
-    zx_info_handle_basic_t info;
-    if (zx_object_get_info(host->proc, ZX_INFO_HANDLE_BASIC, &info,
-                           sizeof(info), nullptr, nullptr) == ZX_OK) {
-        host->koid = info.koid;
+    zx_status_t r;
+    if ((r = zx_event_create(0, &ctx->ph.handle)) != ZX_OK) {
+        free(ctx);
+        zx_handle_close(hrpc);
+        return r;
     }
-    log(INFO, "devcoord: launch devhost '%s': pid=%zu\n",
-        name, host->koid);
+    ctx->ph.waitfor = ZX_EVENT_SIGNALED;
+    ctx->ph.func = dc_handle_devhost_launched;
+    if ((r = port_wait(&dc_port, &ctx->ph)) != ZX_OK) {
+        zx_handle_close(ctx->ph.handle);
+        free(ctx);
+        zx_handle_close(hrpc);
+        return r;
+    }
+    ctx->host = host;
+    strlcpy(ctx->name, name, sizeof(ctx->name));
+    ctx->devhost_bin = get_devhost_bin();
+    ctx->hrpc = hrpc;
+
+    //TODO: limit root resource to root devhost only
+    zx_handle_duplicate(get_root_resource(), ZX_RIGHT_SAME_RIGHTS, &ctx->resource);
+
+    //TODO: eventually devhosts should not have vfs access
+    ctx->boot = fs_clone("boot");
+
+    //TODO: constrain to /svc/device
+    ctx->svc = fs_clone("svc");
 
+    //TODO: limit root job access to root devhost only
+    ctx->job_root = get_sysinfo_job_root();
+
+    host->flags |= DEV_HOST_LAUNCHING;
+    host->launch_start = zx_clock_get_monotonic();
+    host->refcount++;
+
+    thrd_t t;
+    if (thrd_create_with_name(&t, devhost_launcher, ctx, "devhost-launcher") == thrd_success) {
+        thrd_detach(t);
+    } else {
+        log(ERROR, "devcoord: can't create devhost launcher thread\n");
+        devhost_launcher(ctx);
+    }
+
+    // The choice of devhost binary is made now, whether or not the process
+    // has started yet.
     dc_launched_first_devhost = true;
 
     return ZX_OK;
 }
 
-static zx_status_t dc_new_devhost(const char* name, devhost_t* parent,
-                                  devhost_t** out) {
+static zx_status_t dc_alloc_devhost(const char* name, devhost_t** out) {
     devhost_t* dh = static_cast<devhost_t*>(calloc(1, sizeof(devhost_t)));
     if (dh == nullptr) {
         return ZX_ERR_NO_MEMORY;
@@ -679,14 +915,75 @@ static zx_status_t dc_new_devhost(const char* name, devhost_t* parent,
         return r;
     }
 
+    list_initialize(&dh->devices);
+    list_initialize(&dh->children);
+    list_initialize(&dh->anode);
+    strlcpy(dh->name, name, sizeof(dh->name));
+
     if ((r = dc_launch_devhost(dh, name, hrpc)) < 0) {
         zx_handle_close(dh->hrpc);
         free(dh);
         return r;
     }
 
-    list_initialize(&dh->devices);
-    list_initialize(&dh->children);
+    *out = dh;
+    return ZX_OK;
+}
+
+static void dc_fill_devhost_pool(void) {
+    while (devhost_pool_count < devhost_pool_size) {
+        devhost_t* dh;
+        if (dc_alloc_devhost("devhost:pool", &dh) < 0) {
+            log(ERROR, "devcoord: cannot launch pooled devhost\n");
+            return;
+        }
+        // The pool holds a reference to each of its devhosts.
+        dh->flags |= DEV_HOST_POOLED;
+        dh->refcount++;
+        list_add_tail(&list_devhost_pool, &dh->node);
+        devhost_pool_count++;
+    }
+}
+
+// Takes a devhost from the pool and renames it to |name|, or returns
+// nullptr if the pool is empty.
+static devhost_t* dc_take_pooled_devhost(const char* name) {
+    devhost_t* dh = list_remove_head_type(&list_devhost_pool, devhost_t, node);
+    if (dh == nullptr) {
+        return nullptr;
+    }
+    devhost_pool_count--;
+    dh->flags &= ~DEV_HOST_POOLED;
+    strlcpy(dh->name, name, sizeof(dh->name));
+    if (dh->proc != ZX_HANDLE_INVALID) {
+        zx_object_set_property(dh->proc, ZX_PROP_NAME, dh->name, strlen(dh->name));
+    }
+    // From here on, the time taken to launch the devhost is the time it is
+    // waited for after being handed out.
+    dh->launch_start = zx_clock_get_monotonic();
+    dh->launch_time = 0;
+
+    // The pool's reference is handed over to the devices which are about to
+    // be created in the devhost, as for a newly allocated one.
+    dh->refcount--;
+    return dh;
+}
+
+static zx_status_t dc_new_devhost(const char* name, devhost_t* parent,
+                                  devhost_t** out) {
+    devhost_t* dh = dc_take_pooled_devhost(name);
+    if (dh != nullptr) {
+        devhost_pool_hits++;
+        dc_fill_devhost_pool();
+    } else {
+        if (devhost_pool_size) {
+            devhost_pool_misses++;
+        }
+        zx_status_t r;
+        if ((r = dc_alloc_devhost(name, &dh)) < 0) {
+            return r;
+        }
+    }
 
     if (parent) {
         dh->parent = parent;
@@ -785,6 +1082,7 @@ static zx_status_t dc_add_device(device_t* parent, zx_handle_t hrpc,
     dev->hrpc = hrpc;
     dev->prop_count = static_cast<uint32_t>(msg->datalen / sizeof(zx_device_prop_t));
     dev->protocol_id = msg->protocol_id;
+    dev->added_time = zx_clock_get_monotonic();
 
     char* text = (char*) (dev->props + dev->prop_count);
     memcpy(text, args, msg->argslen + 1);
@@ -859,6 +1157,11 @@ static zx_status_t dc_add_device(device_t* parent, zx_handle_t hrpc,
 
     list_add_tail(&list_devices, &dev->anode);
 
+    if ((dev->protocol_id == ZX_PROTOCOL_BLOCK) && (first_block_time == 0)) {
+        first_block_time = dev->added_time;
+        strlcpy(first_block_name, dev->name, sizeof(first_block_name));
+    }
+
     log(DEVLC, "devcoord: dev %p name='%s' ++ref=%d (child)\n",
         parent, parent->name, parent->refcount);
 
@@ -1031,22 +1334,35 @@ static zx_status_t dc_bind_device(device_t* dev, const char* drvlibname) {
 
     //TODO: disallow if we're in the middle of enumeration, etc
     driver_t* drv;
-    list_for_every_entry(&list_drivers, drv, driver_t, node) {
-        if (autobind || !strcmp(drv->libname, drvlibname)) {
+    if (autobind) {
+        dc_bind_iter_t it;
+        dc_bind_index_find(&it, dev->protocol_id, dev->props, dev->prop_count);
+        while ((drv = dc_bind_iter_next(&it)) != nullptr) {
             if (dc_is_bindable(drv, dev->protocol_id,
-                               dev->props, dev->prop_count, autobind)) {
+                               dev->props, dev->prop_count, true)) {
                 log(SPEW, "devcoord: drv='%s' bindable to dev='%s'\n",
                     drv->name, dev->name);
                 dc_attempt_bind(drv, dev);
                 return ZX_OK;
             }
         }
-    }
 
-    // Notify observers that this device is available again
-    // Needed for non-auto-binding drivers like GPT against block, etc
-    if (autobind) {
+        // Notify observers that this device is available again
+        // Needed for non-auto-binding drivers like GPT against block, etc
         devfs_advertise_modified(dev);
+        return ZX_OK;
+    }
+
+    list_for_every_entry(&list_drivers, drv, driver_t, node) {
+        if (!strcmp(drv->libname, drvlibname)) {
+            if (dc_is_bindable(drv, dev->protocol_id,
+                               dev->props, dev->prop_count, false)) {
+                log(SPEW, "devcoord: drv='%s' bindable to dev='%s'\n",
+                    drv->name, dev->name);
+                dc_attempt_bind(drv, dev);
+                return ZX_OK;
+            }
+        }
     }
 
     return ZX_OK;
@@ -1373,6 +1689,7 @@ static zx_status_t dc_handle_device_read(device_t* dev) {
                 log(ERROR, "devcoord: rpc: bind-driver '%s' status %d\n",
                     dev->name, msg.status);
             } else {
+                dev->ready_time = zx_clock_get_monotonic();
                 dc_notify(dev, DEVMGR_OP_DEVICE_CHANGED);
             }
             //TODO: try next driver, clear BOUND flag
@@ -1572,6 +1889,7 @@ static zx_status_t dc_create_proxy(device_t* parent) {
     list_initialize(&dev->metadata);
     dev->flags = DEV_CTX_PROXY;
     dev->protocol_id = parent->protocol_id;
+    dev->added_time = zx_clock_get_monotonic();
     dev->parent = parent;
     dev->refcount = 1;
     parent->proxy = dev;
@@ -1612,6 +1930,8 @@ static zx_status_t dh_bind_driver(device_t* dev, const char* libname) {
     }
 
     dev->flags |= DEV_CTX_BOUND;
+    dev->bind_time = zx_clock_get_monotonic();
+    dev->ready_time = 0;
     pending->op = PENDING_BIND;
     pending->ctx = nullptr;
     list_add_tail(&dev->pending, &pending->node);
@@ -1722,9 +2042,14 @@ static zx_status_t dc_attempt_bind(driver_t* drv, device_t* dev) {
 }
 
 static void dc_handle_new_device(device_t* dev) {
+    zx_time_t start = zx_clock_get_monotonic();
     driver_t* drv;
 
-    list_for_every_entry(&list_drivers, drv, driver_t, node) {
+    // Only drivers whose bind programs might match the device's protocol
+    // need to be tried.
+    dc_bind_iter_t it;
+    dc_bind_index_find(&it, dev->protocol_id, dev->props, dev->prop_count);
+    while ((drv = dc_bind_iter_next(&it)) != nullptr) {
         if (dc_is_bindable(drv, dev->protocol_id,
                            dev->props, dev->prop_count, true)) {
             log(SPEW, "devcoord: drv='%s' bindable to dev='%s'\n",
@@ -1736,6 +2061,9 @@ static void dc_handle_new_device(device_t* dev) {
             }
         }
     }
+
+    bind_match_count++;
+    bind_match_time += zx_clock_get_monotonic() - start;
 }
 
 static void dc_suspend_fallback(uint32_t flags) {
@@ -2015,6 +2343,18 @@ static bool is_root_driver(driver_t* drv) {
         (memcmp(&root_device_binding, drv->binding, sizeof(root_device_binding)) == 0);
 }
 
+// Adds |drv| to the all-drivers list and the bind index, ahead of or
+// after the drivers already there.  Every driver on list_drivers must
+// come through here, or devices will never be offered to it.
+static void dc_add_driver(driver_t* drv, bool first) {
+    if (first) {
+        list_add_head(&list_drivers, &drv->node);
+    } else {
+        list_add_tail(&list_drivers, &drv->node);
+    }
+    dc_bind_index_add(drv, first);
+}
+
 // dc_driver_added_init is called from driver enumeration during
 // startup and before the devcoordinator starts running.  Enumerated
 // drivers are added directly to the all-drivers or fallback list.
@@ -2027,9 +2367,9 @@ static void dc_driver_added_init(driver_t* drv, const char* version) {
     } else if (version[0] == '!') {
         // debugging / development hack
         // prioritize drivers with version "!..." over others
-        list_add_head(&list_drivers, &drv->node);
+        dc_add_driver(drv, true);
     } else {
-        list_add_tail(&list_drivers, &drv->node);
+        dc_add_driver(drv, false);
     }
 }
 
@@ -2102,7 +2442,7 @@ void dc_bind_driver(driver_t* drv) {
 void dc_handle_new_driver(void) {
     driver_t* drv;
     while ((drv = list_remove_head_type(&list_drivers_new, driver_t, node)) != nullptr) {
-        list_add_tail(&list_drivers, &drv->node);
+        dc_add_driver(drv, false);
         dc_bind_driver(drv);
     }
 }
@@ -2132,7 +2472,8 @@ static zx_status_t dc_control_event(port_handler_t* ph, zx_signals_t signals, ui
         break;
     case CTL_ADD_SYSTEM: {
         driver_t* drv;
-        // Add system drivers to the new list
+        // Add system drivers to the new list; dc_handle_new_driver() moves
+        // them to the all-drivers list and the bind index, then binds them
         while ((drv = list_remove_head_type(&list_drivers_system, driver_t, node)) != nullptr) {
             list_add_tail(&list_drivers_new, &drv->node);
         }
@@ -2200,6 +2541,9 @@ void coordinator(void) {
 
     dc_asan_drivers = getenv_bool("devmgr.devhost.asan", false);
 
+    const char* pool = getenv("devmgr.devhost.pool");
+    devhost_pool_size = (pool != nullptr) ? static_cast<uint32_t>(strtoul(pool, nullptr, 0)) : 0;
+
     devfs_publish(&root_device, &misc_device);
     devfs_publish(&root_device, &sys_device);
     devfs_publish(&root_device, &test_device);
@@ -2227,12 +2571,15 @@ void coordinator(void) {
     dc_prepare_proxy(&sys_device);
     dc_prepare_proxy(&test_device);
 
+    // Start spare devhosts once the first ones are on their way.
+    dc_fill_devhost_pool();
+
     if (require_system && !system_loaded) {
         printf("devcoord: full system required, ignoring fallback drivers until /system is loaded\n");
     } else {
         driver_t* drv;
         while ((drv = list_remove_tail_type(&list_drivers_fallback, driver_t, node)) != nullptr) {
-            list_add_tail(&list_drivers, &drv->node);
+            dc_add_driver(drv, false);
         }
     }
 
@@ -160,3 +160,39 @@ MODULE_STATIC_LIBS := system/ulib/ddk system/ulib/port
 MODULE_LIBS := system/ulib/driver system/ulib/zircon system/ulib/c
 
 include make/module.mk
+
+
+# Unit tests.
+
+MODULE := $(LOCAL_DIR).test
+
+MODULE_TYPE := usertest
+
+MODULE_NAME := devmgr-binding-test
+
+TEST_DIR := $(LOCAL_DIR)/test
+
+MODULE_SRCS := \
+    $(LOCAL_DIR)/devmgr-binding.cpp \
+    $(TEST_DIR)/binding-test.cpp \
+    $(TEST_DIR)/main.cpp \
+
+MODULE_COMPILEFLAGS := \
+    -I$(LOCAL_DIR) \
+
+# ddk and port are needed only for devcoordinator.h
+MODULE_HEADER_DEPS := \
+    system/ulib/ddk \
+    system/ulib/port \
+
+MODULE_STATIC_LIBS := \
+    system/ulib/fbl \
+    system/ulib/zxcpp \
+
+MODULE_LIBS := \
+    system/ulib/c \
+    system/ulib/fdio \
+    system/ulib/unittest \
+    system/ulib/zircon \
+
+include make/module.mk
@@ -0,0 +1,247 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "devcoordinator.h"
+
+#include <ddk/binding.h>
+#include <fbl/algorithm.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+// The bind index is global, so each test uses its own protocol ids and only
+// looks at the drivers it added.
+constexpr uint32_t kProtoA = 0x74657341; // 'tesA'
+constexpr uint32_t kProtoB = 0x74657342;
+constexpr uint32_t kProtoC = 0x74657343;
+constexpr uint32_t kProtoD = 0x74657344;
+constexpr uint32_t kProtoE = 0x74657345;
+constexpr uint32_t kProtoUnknown = 0x7465735a;
+
+template <size_t N>
+driver_t MakeDriver(const char* name, const zx_bind_inst_t (&binding)[N]) {
+    driver_t drv = {};
+    drv.name = name;
+    drv.binding = binding;
+    drv.binding_size = static_cast<uint32_t>(sizeof(binding));
+    return drv;
+}
+
+// Finds the candidates for a device, skipping drivers not in |drivers|, and
+// checks that they are |expected|, in order.
+bool CheckCandidates(uint32_t protocol_id, const zx_device_prop_t* props, size_t prop_count,
+                     driver_t* const* drivers, size_t driver_count,
+                     driver_t* const* expected, size_t expected_count) {
+    BEGIN_HELPER;
+    dc_bind_iter_t it;
+    dc_bind_index_find(&it, protocol_id, props, prop_count);
+    size_t n = 0;
+    driver_t* drv;
+    while ((drv = dc_bind_iter_next(&it)) != nullptr) {
+        bool ours = false;
+        for (size_t i = 0; i < driver_count; i++) {
+            ours |= (drivers[i] == drv);
+        }
+        if (!ours) {
+            continue;
+        }
+        ASSERT_LT(n, expected_count, "unexpected candidate");
+        EXPECT_STR_EQ(expected[n]->name, drv->name);
+        n++;
+    }
+    EXPECT_EQ(expected_count, n);
+    END_HELPER;
+}
+
+bool MatchIfTest() {
+    BEGIN_TEST;
+    const zx_bind_inst_t binding[] = {
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kProtoA),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kProtoB),
+    };
+    driver_t drv = MakeDriver("match-if", binding);
+    uint32_t protocols[DC_BIND_MAX_PROTOCOLS];
+    size_t count;
+    ASSERT_TRUE(dc_bind_protocols(&drv, protocols, &count));
+    ASSERT_EQ(2u, count);
+    EXPECT_EQ(kProtoA, protocols[0]);
+    EXPECT_EQ(kProtoB, protocols[1]);
+    END_TEST;
+}
+
+bool AbortIfTest() {
+    BEGIN_TEST;
+    // Aborts on other variables are skipped; the first abort on a different
+    // protocol ends the walk, whatever follows it.
+    const zx_bind_inst_t binding[] = {
+        BI_ABORT_IF_AUTOBIND,
+        BI_ABORT_IF(EQ, BIND_PROTOCOL, kProtoB),
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kProtoA),
+        BI_MATCH_IF(EQ, BIND_PCI_VID, 0x8086),
+        BI_GOTO(1),
+    };
+    driver_t drv = MakeDriver("abort-if", binding);
+    uint32_t protocols[DC_BIND_MAX_PROTOCOLS];
+    size_t count;
+    ASSERT_TRUE(dc_bind_protocols(&drv, protocols, &count));
+    ASSERT_EQ(1u, count);
+    EXPECT_EQ(kProtoA, protocols[0]);
+    END_TEST;
+}
+
+bool MatchThenAbortIfTest() {
+    BEGIN_TEST;
+    const zx_bind_inst_t binding[] = {
+        BI_SET(1),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kProtoA),
+        BI_LABEL(1),
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kProtoB),
+        BI_MATCH(),
+    };
+    driver_t drv = MakeDriver("match-then-abort-if", binding);
+    uint32_t protocols[DC_BIND_MAX_PROTOCOLS];
+    size_t count;
+    ASSERT_TRUE(dc_bind_protocols(&drv, protocols, &count));
+    ASSERT_EQ(2u, count);
+    EXPECT_EQ(kProtoA, protocols[0]);
+    EXPECT_EQ(kProtoB, protocols[1]);
+    END_TEST;
+}
+
+bool AbortTest() {
+    BEGIN_TEST;
+    const zx_bind_inst_t binding[] = {
+        BI_ABORT(),
+        BI_MATCH(),
+    };
+    driver_t drv = MakeDriver("abort", binding);
+    uint32_t protocols[DC_BIND_MAX_PROTOCOLS];
+    size_t count;
+    ASSERT_TRUE(dc_bind_protocols(&drv, protocols, &count));
+    EXPECT_EQ(0u, count);
+    END_TEST;
+}
+
+bool AnyProtocolTest() {
+    BEGIN_TEST;
+    uint32_t protocols[DC_BIND_MAX_PROTOCOLS];
+    size_t count;
+
+    const zx_bind_inst_t match[] = {
+        BI_ABORT_IF_AUTOBIND,
+        BI_MATCH(),
+    };
+    driver_t drv = MakeDriver("match", match);
+    EXPECT_FALSE(dc_bind_protocols(&drv, protocols, &count));
+
+    const zx_bind_inst_t jump[] = {
+        BI_GOTO_IF(EQ, BIND_PCI_VID, 0x8086, 1),
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kProtoA),
+        BI_LABEL(1),
+        BI_MATCH(),
+    };
+    drv = MakeDriver("goto", jump);
+    EXPECT_FALSE(dc_bind_protocols(&drv, protocols, &count));
+
+    const zx_bind_inst_t other[] = {
+        BI_MATCH_IF(EQ, BIND_PCI_VID, 0x8086),
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kProtoA),
+    };
+    drv = MakeDriver("other-variable", other);
+    EXPECT_FALSE(dc_bind_protocols(&drv, protocols, &count));
+
+    const zx_bind_inst_t not_protocol[] = {
+        BI_MATCH_IF(NE, BIND_PROTOCOL, kProtoA),
+    };
+    drv = MakeDriver("match-if-ne", not_protocol);
+    EXPECT_FALSE(dc_bind_protocols(&drv, protocols, &count));
+    END_TEST;
+}
+
+bool TooManyProtocolsTest() {
+    BEGIN_TEST;
+    zx_bind_inst_t binding[DC_BIND_MAX_PROTOCOLS + 1];
+    for (uint32_t i = 0; i < fbl::count_of(binding); i++) {
+        binding[i] = BI_MATCH_IF(EQ, BIND_PROTOCOL, kProtoA + i);
+    }
+    driver_t drv = MakeDriver("too-many", binding);
+    uint32_t protocols[DC_BIND_MAX_PROTOCOLS];
+    size_t count;
+    EXPECT_FALSE(dc_bind_protocols(&drv, protocols, &count));
+
+    drv.binding_size -= static_cast<uint32_t>(sizeof(binding[0]));
+    ASSERT_TRUE(dc_bind_protocols(&drv, protocols, &count));
+    EXPECT_EQ(DC_BIND_MAX_PROTOCOLS, count);
+    END_TEST;
+}
+
+bool IndexTest() {
+    BEGIN_TEST;
+    const zx_bind_inst_t on_c[] = {
+        BI_ABORT_IF(NE, BIND_PROTOCOL, kProtoC),
+        BI_MATCH(),
+    };
+    const zx_bind_inst_t on_c_or_d[] = {
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kProtoC),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kProtoD),
+        BI_MATCH_IF(EQ, BIND_PROTOCOL, kProtoC),
+    };
+    const zx_bind_inst_t on_any[] = {
+        BI_MATCH_IF(EQ, BIND_PCI_VID, 0x8086),
+    };
+    driver_t c1 = MakeDriver("c1", on_c);
+    driver_t any1 = MakeDriver("any1", on_any);
+    driver_t cd = MakeDriver("cd", on_c_or_d);
+    driver_t any2 = MakeDriver("any2", on_any);
+    driver_t c0 = MakeDriver("c0", on_c);
+    driver_t unbindable = {};
+    unbindable.name = "unbindable";
+
+    dc_bind_index_add(&c1, false);
+    dc_bind_index_add(&any1, false);
+    dc_bind_index_add(&cd, false);
+    dc_bind_index_add(&any2, false);
+    dc_bind_index_add(&unbindable, false);
+    // goes ahead of everything already added
+    dc_bind_index_add(&c0, true);
+
+    driver_t* const drivers[] = {&c1, &any1, &cd, &any2, &c0, &unbindable};
+
+    // The protocol's drivers and the catch-all list, merged in priority
+    // order.  |cd| names kProtoC twice but is only listed once.
+    driver_t* const on_c_expected[] = {&c0, &c1, &any1, &cd, &any2};
+    EXPECT_TRUE(CheckCandidates(kProtoC, nullptr, 0, drivers, fbl::count_of(drivers),
+                                on_c_expected, fbl::count_of(on_c_expected)));
+
+    driver_t* const on_d_expected[] = {&any1, &cd, &any2};
+    EXPECT_TRUE(CheckCandidates(kProtoD, nullptr, 0, drivers, fbl::count_of(drivers),
+                                on_d_expected, fbl::count_of(on_d_expected)));
+
+    // Only the catch-all list for protocols nobody asked for.
+    driver_t* const on_unknown_expected[] = {&any1, &any2};
+    EXPECT_TRUE(CheckCandidates(kProtoUnknown, nullptr, 0, drivers, fbl::count_of(drivers),
+                                on_unknown_expected, fbl::count_of(on_unknown_expected)));
+
+    // A BIND_PROTOCOL property overrides the device's protocol id.
+    const zx_device_prop_t props[] = {
+        {BIND_PCI_VID, 0, 0x8086},
+        {BIND_PROTOCOL, 0, kProtoD},
+    };
+    EXPECT_TRUE(CheckCandidates(kProtoE, props, fbl::count_of(props),
+                                drivers, fbl::count_of(drivers),
+                                on_d_expected, fbl::count_of(on_d_expected)));
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(BindIndexTests)
+RUN_TEST(MatchIfTest)
+RUN_TEST(AbortIfTest)
+RUN_TEST(MatchThenAbortIfTest)
+RUN_TEST(AbortTest)
+RUN_TEST(AnyProtocolTest)
+RUN_TEST(TooManyProtocolsTest)
+RUN_TEST(IndexTest)
+END_TEST_CASE(BindIndexTests);
@@ -0,0 +1,23 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <ddk/binding.h>
+#include <ddk/device.h>
+#include <ddk/driver.h>
+#include <zircon/types.h>
+
+// Callback for devmgr to instantiate the block_cache::Device when ioctl_device_bind is called on a
+// block device.
+extern zx_status_t block_cache_bind(void* ctx, zx_device_t* parent);
+
+static zx_driver_ops_t block_cache_driver_ops = {
+    .version = DRIVER_OPS_VERSION,
+    .bind = block_cache_bind,
+};
+
+// clang-format off
+ZIRCON_DRIVER_BEGIN(block_cache, block_cache_driver_ops, "zircon", "0.1", 2)
+    BI_ABORT_IF_AUTOBIND,
+    BI_MATCH_IF(EQ, BIND_PROTOCOL, ZX_PROTOCOL_BLOCK),
+ZIRCON_DRIVER_END(block_cache)
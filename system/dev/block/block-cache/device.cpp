@@ -0,0 +1,572 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include <ddk/debug.h>
+#include <ddk/device.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/atomic.h>
+#include <fbl/auto_lock.h>
+#include <fbl/unique_ptr.h>
+#include <lib/sync/completion.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
+#include <zircon/compiler.h>
+#include <zircon/device/block.h>
+#include <zircon/listnode.h>
+#include <zircon/status.h>
+#include <zircon/syscalls.h>
+#include <zircon/types.h>
+
+#include "device.h"
+
+namespace block_cache {
+namespace {
+
+// Preferred size of a cache line.  Reads which miss fetch the whole line from the device.
+const uint32_t kLineSize = 4 * PAGE_SIZE;
+
+// Size of the cache when "block-cache.size" is not set on the kernel command line.
+const size_t kDefaultCacheMiB = 16;
+
+// How long the device must be idle before dirty lines are written back without a flush.
+const zx_duration_t kWritebackDelay = ZX_SEC(5);
+
+// Tracks a batch of I/O requests sent to the parent device.
+struct IoBatch {
+    fbl::atomic<size_t> pending;
+    fbl::atomic<zx_status_t> status;
+    sync_completion_t done;
+};
+
+void IoCallback(block_op_t* block, zx_status_t status) {
+    IoBatch* batch = static_cast<IoBatch*>(block->cookie);
+    zx_status_t expected = ZX_OK;
+    if (status != ZX_OK) {
+        batch->status.compare_exchange_strong(&expected, status);
+    }
+    if (batch->pending.fetch_sub(1) == 1) {
+        sync_completion_signal(&batch->done);
+    }
+}
+
+// Tracks a flush sent to the worker by |IOCTL_DEVICE_SYNC|.
+struct SyncRequest {
+    zx_status_t status;
+    sync_completion_t done;
+};
+
+void SyncCallback(block_op_t* block, zx_status_t status) {
+    SyncRequest* sync = static_cast<SyncRequest*>(block->cookie);
+    sync->status = status;
+    sync_completion_signal(&sync->done);
+}
+
+int WorkerThread(void* arg) {
+    return static_cast<Device*>(arg)->Worker();
+}
+
+} // namespace
+
+Device::Device(zx_device_t* parent)
+    : DeviceType(parent), parent_op_size_(0), line_blocks_(0), line_count_(0), base_(0),
+      worker_started_(false), dead_(false) {
+    list_initialize(&queue_);
+    sync_completion_reset(&signal_);
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+Device::~Device() {
+    zx_status_t rc;
+    map_.clear();
+    lru_.clear();
+    if (base_ != 0 &&
+        (rc = zx::vmar::root_self()->unmap(base_, line_count_ * line_blocks_ * info_.block_size)) !=
+            ZX_OK) {
+        zxlogf(WARN, "block-cache: failed to unmap cache: %s\n", zx_status_get_string(rc));
+    }
+}
+
+zx_status_t Device::Bind() {
+    zx_status_t rc;
+
+    if ((rc = device_get_protocol(parent(), ZX_PROTOCOL_BLOCK, &proto_)) != ZX_OK) {
+        zxlogf(ERROR, "block-cache: failed to get block protocol: %s\n", zx_status_get_string(rc));
+        return rc;
+    }
+    proto_.ops->query(proto_.ctx, &info_, &parent_op_size_);
+    if (info_.block_size == 0 || info_.block_count == 0) {
+        zxlogf(ERROR, "block-cache: parent device is empty\n");
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Cover whole pages with each line where possible, but keep it within a single transfer.
+    uint32_t line_size = fbl::max(kLineSize, info_.block_size);
+    if (info_.max_transfer_size != BLOCK_MAX_TRANSFER_UNBOUNDED &&
+        info_.max_transfer_size < line_size) {
+        line_size = info_.max_transfer_size;
+    }
+    line_blocks_ = fbl::max(line_size / info_.block_size, 1U);
+    line_size = line_blocks_ * info_.block_size;
+
+    size_t cache_mib = kDefaultCacheMiB;
+    const char* option = getenv("block-cache.size");
+    if (option) {
+        cache_mib = strtoul(option, nullptr, 0);
+    }
+    line_count_ = (cache_mib << 20) / line_size;
+    // A batch must never be able to evict one of its own lines.
+    if (line_count_ < 2 * kMaxBatch) {
+        line_count_ = 2 * kMaxBatch;
+    }
+    // There's no use in caching more lines than the device has.
+    uint64_t device_lines = (info_.block_count + line_blocks_ - 1) / line_blocks_;
+    if (line_count_ > device_lines && device_lines >= 2 * kMaxBatch) {
+        line_count_ = device_lines;
+    }
+
+    // Set up the cache memory
+    const size_t cache_size = line_count_ * line_size;
+    if ((rc = zx::vmo::create(cache_size, 0, &vmo_)) != ZX_OK) {
+        zxlogf(ERROR, "block-cache: zx::vmo::create failed: %s\n", zx_status_get_string(rc));
+        return rc;
+    }
+    constexpr uint32_t flags = ZX_VM_PERM_READ | ZX_VM_PERM_WRITE;
+    if ((rc = zx::vmar::root_self()->map(0, vmo_, 0, cache_size, flags, &base_)) != ZX_OK) {
+        zxlogf(ERROR, "block-cache: zx::vmar::map failed: %s\n", zx_status_get_string(rc));
+        return rc;
+    }
+
+    fbl::AllocChecker ac;
+    lines_.reset(new (&ac) Line[line_count_]);
+    if (!ac.check()) {
+        zxlogf(ERROR, "block-cache: failed to allocate %zu lines\n", line_count_);
+        return ZX_ERR_NO_MEMORY;
+    }
+    for (size_t i = 0; i < line_count_; ++i) {
+        lines_[i].slot = i;
+        lru_.push_back(&lines_[i]);
+    }
+    ops_.reset(new (&ac) uint8_t[parent_op_size_ * kMaxBatch], parent_op_size_ * kMaxBatch);
+    if (!ac.check()) {
+        zxlogf(ERROR, "block-cache: failed to allocate block ops\n");
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    {
+        fbl::AutoLock lock(&mtx_);
+        stats_.line_size = line_size;
+        stats_.line_count = line_count_;
+    }
+
+    if (thrd_create_with_name(&worker_, WorkerThread, this, "block-cache") != thrd_success) {
+        zxlogf(ERROR, "block-cache: failed to start worker\n");
+        return ZX_ERR_NO_RESOURCES;
+    }
+    worker_started_ = true;
+
+    if ((rc = DdkAdd("block-cache")) != ZX_OK) {
+        zxlogf(ERROR, "block-cache: DdkAdd failed: %s\n", zx_status_get_string(rc));
+        StopWorker();
+        return rc;
+    }
+    zxlogf(TRACE, "block-cache: caching %zu lines of %" PRIu32 " bytes\n", line_count_, line_size);
+    return ZX_OK;
+}
+
+int Device::Worker() {
+    for (;;) {
+        Request* request;
+        bool dead;
+        bool dirty;
+        {
+            fbl::AutoLock lock(&mtx_);
+            request = list_remove_head_type(&queue_, Request, node);
+            dead = dead_;
+            dirty = stats_.dirty_count != 0;
+            if (!request) {
+                sync_completion_reset(&signal_);
+            }
+        }
+        if (request) {
+            Serve(&request->op);
+            continue;
+        }
+        if (dead) {
+            break;
+        }
+        // Wait for more work, writing back dirty lines if none comes for a while.
+        zx_time_t deadline = dirty ? zx_deadline_after(kWritebackDelay) : ZX_TIME_INFINITE;
+        if (sync_completion_wait_deadline(&signal_, deadline) == ZX_ERR_TIMED_OUT) {
+            WriteBackAll();
+        }
+    }
+
+    // Nothing more will be queued; make a last attempt to save any unwritten data.
+    zx_status_t rc;
+    if ((rc = WriteBackAll()) != ZX_OK) {
+        zxlogf(ERROR, "block-cache: lost dirty lines on unbind: %s\n", zx_status_get_string(rc));
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////
+// ddk::Device methods
+
+zx_status_t Device::DdkIoctl(uint32_t op, const void* in, size_t in_len, void* out,
+                             size_t out_len, size_t* actual) {
+    switch (op) {
+    case IOCTL_BLOCK_GET_CACHE_STATS: {
+        if (out_len < sizeof(block_cache_stats_t)) {
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        }
+        fbl::AutoLock lock(&mtx_);
+        memcpy(out, &stats_, sizeof(stats_));
+        *actual = sizeof(stats_);
+        return ZX_OK;
+    }
+    case IOCTL_DEVICE_SYNC: {
+        // Send a flush through the queue, so that every write accepted before the sync is
+        // written back.
+        Request request;
+        memset(&request, 0, sizeof(request));
+        SyncRequest sync;
+        sync.status = ZX_OK;
+        sync_completion_reset(&sync.done);
+        request.op.command = BLOCK_OP_FLUSH;
+        request.op.completion_cb = SyncCallback;
+        request.op.cookie = &sync;
+        BlockQueue(&request.op);
+        sync_completion_wait(&sync.done, ZX_TIME_INFINITE);
+        return sync.status;
+    }
+    default:
+        return device_ioctl(parent(), op, in, in_len, out, out_len, actual);
+    }
+}
+
+zx_off_t Device::DdkGetSize() {
+    return device_get_size(parent());
+}
+
+void Device::DdkUnbind() {
+    {
+        fbl::AutoLock lock(&mtx_);
+        dead_ = true;
+    }
+    sync_completion_signal(&signal_);
+    DdkRemove();
+}
+
+void Device::DdkRelease() {
+    StopWorker();
+    delete this;
+}
+
+////////////////////////////////////////////////////////////////
+// ddk::BlockProtocol methods
+
+void Device::BlockQuery(block_info_t* out_info, size_t* out_op_size) {
+    memcpy(out_info, &info_, sizeof(info_));
+    *out_op_size = sizeof(Request);
+}
+
+void Device::BlockQueue(block_op_t* block) {
+    Request* request = containerof(block, Request, op);
+    bool dead;
+    {
+        fbl::AutoLock lock(&mtx_);
+        if (!(dead = dead_)) {
+            list_add_tail(&queue_, &request->node);
+        }
+    }
+    if (dead) {
+        block->completion_cb(block, ZX_ERR_BAD_STATE);
+        return;
+    }
+    sync_completion_signal(&signal_);
+}
+
+////////////////////////////////////////////////////////////////
+// Private methods
+
+void Device::StopWorker() {
+    if (!worker_started_) {
+        return;
+    }
+    {
+        fbl::AutoLock lock(&mtx_);
+        dead_ = true;
+    }
+    sync_completion_signal(&signal_);
+    thrd_join(worker_, nullptr);
+    worker_started_ = false;
+}
+
+void Device::Serve(block_op_t* block) {
+    zx_status_t rc = ZX_OK;
+    switch (block->command & BLOCK_OP_MASK) {
+    case BLOCK_OP_READ:
+    case BLOCK_OP_WRITE: {
+        uint64_t start = block->rw.offset_dev;
+        if (block->rw.length == 0) {
+            rc = ZX_ERR_INVALID_ARGS;
+            break;
+        }
+        if (start >= info_.block_count || info_.block_count - start < block->rw.length) {
+            rc = ZX_ERR_OUT_OF_RANGE;
+            break;
+        }
+        // Work through the request a batch of lines at a time.
+        const uint64_t end = start + block->rw.length;
+        while (start < end && rc == ZX_OK) {
+            uint64_t next = fbl::min(end, (start / line_blocks_ + kMaxBatch) * line_blocks_);
+            rc = Transfer(block, start, next);
+            start = next;
+        }
+        break;
+    }
+    case BLOCK_OP_FLUSH:
+        rc = Flush();
+        break;
+    default:
+        rc = ZX_ERR_NOT_SUPPORTED;
+        break;
+    }
+    block->completion_cb(block, rc);
+}
+
+zx_status_t Device::Transfer(block_op_t* block, uint64_t start, uint64_t end) {
+    zx_status_t rc;
+    const bool write = (block->command & BLOCK_OP_MASK) == BLOCK_OP_WRITE;
+    const uint64_t first = start / line_blocks_;
+    const size_t count = static_cast<size_t>((end - 1) / line_blocks_ - first + 1);
+    ZX_DEBUG_ASSERT(count <= kMaxBatch);
+
+    // Find each line in the cache, or claim the least recently used line for it.  Touched lines
+    // move to the front of the LRU list, and there are at least twice as many lines as a batch
+    // may touch, so no line of this batch can be claimed for another.  Claimed lines leave the
+    // map straight away, so that they can't be found again under their old index.
+    Line* lines[kMaxBatch];
+    bool fresh[kMaxBatch];
+    Line* victims[kMaxBatch];
+    size_t num_victims = 0;
+    for (size_t i = 0; i < count; ++i) {
+        auto iter = map_.find(first + i);
+        Line* line;
+        if (iter.IsValid()) {
+            line = &*iter;
+            lru_.erase(*line);
+        } else {
+            line = lru_.pop_back();
+            if (line->cached) {
+                map_.erase(*line);
+                line->cached = false;
+            }
+            if (line->dirty) {
+                victims[num_victims++] = line;
+            }
+        }
+        lru_.push_front(line);
+        lines[i] = line;
+        fresh[i] = !iter.IsValid();
+    }
+
+    // Save any dirty data being evicted.  If this fails, put the dirty lines back in the map.
+    if ((rc = WriteBack(victims, num_victims)) != ZX_OK) {
+        for (size_t i = 0; i < num_victims; ++i) {
+            victims[i]->cached = true;
+            map_.insert(victims[i]);
+        }
+        return rc;
+    }
+
+    // Move the claimed lines to their new positions, and fill them from the device unless they
+    // are about to be completely overwritten.
+    Line* fills[kMaxBatch];
+    size_t num_fills = 0;
+    uint64_t misses = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!fresh[i]) {
+            continue;
+        }
+        Line* line = lines[i];
+        line->index = first + i;
+        const uint64_t line_start = line->index * line_blocks_;
+        if (!write || start > line_start || end < line_start + LineBlocks(line->index)) {
+            fills[num_fills++] = line;
+        }
+        ++misses;
+    }
+    if ((rc = DoIo(BLOCK_OP_READ, fills, num_fills)) != ZX_OK) {
+        for (size_t i = 0; i < count; ++i) {
+            if (fresh[i]) {
+                lru_.erase(*lines[i]);
+                lru_.push_back(lines[i]);
+            }
+        }
+        return rc;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (fresh[i]) {
+            lines[i]->cached = true;
+            map_.insert(lines[i]);
+        }
+    }
+
+    // Copy the data between the cache and the request's VMO.
+    const size_t block_size = info_.block_size;
+    const uint64_t vmo_start = block->rw.offset_vmo + (start - block->rw.offset_dev);
+    uint64_t dirtied = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Line* line = lines[i];
+        const uint64_t line_start = line->index * line_blocks_;
+        const uint64_t from = fbl::max(start, line_start);
+        const uint64_t to = fbl::min(end, line_start + LineBlocks(line->index));
+        uint8_t* data = LineData(line) + (from - line_start) * block_size;
+        const uint64_t vmo_offset = (vmo_start + (from - start)) * block_size;
+        const size_t len = static_cast<size_t>(to - from) * block_size;
+        if (!write) {
+            rc = zx_vmo_write(block->rw.vmo, data, vmo_offset, len);
+        } else {
+            // The line's contents are changed even if the copy fails partway.
+            if (!line->dirty) {
+                line->dirty = true;
+                ++dirtied;
+            }
+            rc = zx_vmo_read(block->rw.vmo, data, vmo_offset, len);
+        }
+        if (rc != ZX_OK) {
+            break;
+        }
+    }
+
+    fbl::AutoLock lock(&mtx_);
+    stats_.dirty_count += dirtied;
+    if (write) {
+        stats_.write_hits += count - misses;
+        stats_.write_misses += misses;
+    } else {
+        stats_.read_hits += count - misses;
+        stats_.read_misses += misses;
+    }
+    return rc;
+}
+
+zx_status_t Device::Flush() {
+    zx_status_t rc;
+    if ((rc = WriteBackAll()) != ZX_OK) {
+        return rc;
+    }
+    block_op_t* op = reinterpret_cast<block_op_t*>(ops_.get());
+    memset(op, 0, parent_op_size_);
+    op->command = BLOCK_OP_FLUSH;
+    return Submit(1);
+}
+
+zx_status_t Device::WriteBackAll() {
+    zx_status_t rc;
+    Line* lines[kMaxBatch];
+    size_t count = 0;
+    // Lines are visited in device order, which keeps the writes sequential.
+    for (auto& line : map_) {
+        if (!line.dirty) {
+            continue;
+        }
+        lines[count++] = &line;
+        if (count == kMaxBatch) {
+            if ((rc = WriteBack(lines, count)) != ZX_OK) {
+                return rc;
+            }
+            count = 0;
+        }
+    }
+    return WriteBack(lines, count);
+}
+
+zx_status_t Device::WriteBack(Line** lines, size_t count) {
+    zx_status_t rc;
+    if ((rc = DoIo(BLOCK_OP_WRITE, lines, count)) != ZX_OK) {
+        zxlogf(ERROR, "block-cache: write back failed: %s\n", zx_status_get_string(rc));
+        return rc;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        lines[i]->dirty = false;
+    }
+    fbl::AutoLock lock(&mtx_);
+    stats_.dirty_count -= count;
+    stats_.writebacks += count;
+    return ZX_OK;
+}
+
+zx_status_t Device::DoIo(uint32_t command, Line** lines, size_t count) {
+    ZX_DEBUG_ASSERT(count <= kMaxBatch);
+    for (size_t i = 0; i < count; ++i) {
+        block_op_t* op = reinterpret_cast<block_op_t*>(ops_.get() + parent_op_size_ * i);
+        memset(op, 0, parent_op_size_);
+        op->command = command;
+        op->rw.vmo = vmo_.get();
+        op->rw.length = LineBlocks(lines[i]->index);
+        op->rw.offset_dev = lines[i]->index * line_blocks_;
+        op->rw.offset_vmo = lines[i]->slot * line_blocks_;
+    }
+    return Submit(count);
+}
+
+zx_status_t Device::Submit(size_t count) {
+    if (count == 0) {
+        return ZX_OK;
+    }
+    IoBatch batch;
+    batch.pending.store(count);
+    batch.status.store(ZX_OK);
+    sync_completion_reset(&batch.done);
+    for (size_t i = 0; i < count; ++i) {
+        block_op_t* op = reinterpret_cast<block_op_t*>(ops_.get() + parent_op_size_ * i);
+        op->completion_cb = IoCallback;
+        op->cookie = &batch;
+        proto_.ops->queue(proto_.ctx, op);
+    }
+    sync_completion_wait(&batch.done, ZX_TIME_INFINITE);
+    return batch.status.load();
+}
+
+uint32_t Device::LineBlocks(uint64_t index) const {
+    const uint64_t start = index * line_blocks_;
+    ZX_DEBUG_ASSERT(start < info_.block_count);
+    return static_cast<uint32_t>(fbl::min<uint64_t>(line_blocks_, info_.block_count - start));
+}
+
+uint8_t* Device::LineData(const Line* line) const {
+    return reinterpret_cast<uint8_t*>(base_) + line->slot * line_blocks_ * info_.block_size;
+}
+
+} // namespace block_cache
+
+extern "C" zx_status_t block_cache_bind(void* ctx, zx_device_t* parent) {
+    zx_status_t rc;
+
+    fbl::AllocChecker ac;
+    auto dev = fbl::make_unique_checked<block_cache::Device>(&ac, parent);
+    if (!ac.check()) {
+        zxlogf(ERROR, "block-cache: failed to allocate %zu bytes\n", sizeof(block_cache::Device));
+        return ZX_ERR_NO_MEMORY;
+    }
+    if ((rc = dev->Bind()) != ZX_OK) {
+        return rc;
+    }
+    // devmgr is now in charge of the memory for |dev|
+    block_cache::Device* devmgr_owned __attribute__((unused));
+    devmgr_owned = dev.release();
+
+    return ZX_OK;
+}
@@ -0,0 +1,158 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+
+#include <ddk/device.h>
+#include <ddk/protocol/block.h>
+#include <ddktl/device.h>
+#include <ddktl/protocol/block.h>
+#include <fbl/array.h>
+#include <fbl/intrusive_double_list.h>
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/macros.h>
+#include <fbl/mutex.h>
+#include <fbl/unique_ptr.h>
+#include <lib/sync/completion.h>
+#include <lib/zx/vmo.h>
+#include <zircon/device/block.h>
+#include <zircon/listnode.h>
+#include <zircon/thread_annotations.h>
+#include <zircon/types.h>
+
+namespace block_cache {
+
+// A cache line holds a run of device blocks, aligned to the line size, in the cache's VMO.  Lines
+// which hold data are found through the cache's map; every line is also on the LRU list, which is
+// used to pick lines to reuse.
+struct Line : public fbl::WAVLTreeContainable<Line*>, public fbl::DoublyLinkedListable<Line*> {
+    uint64_t GetKey() const { return index; }
+
+    // Position of this line's data on the device, in lines.
+    uint64_t index = 0;
+    // Position of this line's data in the cache VMO, in lines.
+    uint64_t slot = 0;
+    // True if the line holds the data for |index|, and is in the map.
+    bool cached = false;
+    // True if the line has been written since it was read from or written back to the device.
+    bool dirty = false;
+};
+
+// See ddk::Device in ddktl/device.h
+class Device;
+using DeviceType = ddk::Device<Device, ddk::Ioctlable, ddk::GetSizable, ddk::Unbindable>;
+
+// |block_cache::Device| is a block device filter driver which keeps recently used blocks of its
+// parent device in memory.  Reads are served from memory when possible, and writes are held in
+// memory until the line holding them is evicted, the device is flushed with |BLOCK_OP_FLUSH| or
+// |IOCTL_DEVICE_SYNC|, or the device has been idle for a few seconds.
+//
+// Requests are served one at a time, in order, by a single worker thread, so barriers need no
+// special handling.  Hit and miss counters are available through |IOCTL_BLOCK_GET_CACHE_STATS|.
+//
+// The cache is only coherent with I/O which goes through it; the parent device should not be
+// written to directly while the cache is bound.
+class Device final : public DeviceType, public ddk::BlockProtocol<Device> {
+public:
+    explicit Device(zx_device_t* parent);
+    ~Device();
+
+    // Called via ioctl_device_bind.  Sets up the cache memory, starts the worker thread and adds
+    // the device.
+    zx_status_t Bind();
+
+    // The body of the worker thread.
+    int Worker();
+
+    // ddk::Device methods; see ddktl/device.h
+    zx_status_t DdkIoctl(uint32_t op, const void* in, size_t in_len, void* out, size_t out_len,
+                         size_t* actual);
+    zx_off_t DdkGetSize();
+    void DdkUnbind();
+    void DdkRelease();
+
+    // ddk::BlockProtocol methods; see ddktl/protocol/block.h
+    void BlockQuery(block_info_t* out_info, size_t* out_op_size);
+    void BlockQueue(block_op_t* block) __TA_EXCLUDES(mtx_);
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Device);
+
+    // Requests are queued for the worker through a list node following the block_op_t.
+    struct Request {
+        block_op_t op;
+        list_node_t node;
+    };
+
+    // Maximum number of lines touched by a single step of a request, and so the number of
+    // I/O requests which may be outstanding to the parent device at once.
+    static constexpr size_t kMaxBatch = 64;
+
+    // Tells the worker to exit once the queue is empty, and waits for it.
+    void StopWorker();
+
+    // Serves a single request from the queue, and completes it.
+    void Serve(block_op_t* block);
+
+    // Reads or writes the blocks of |block| in [start, end) through the cache.  The range may
+    // span at most |kMaxBatch| lines.
+    zx_status_t Transfer(block_op_t* block, uint64_t start, uint64_t end);
+
+    // Writes every dirty line back to the device, then flushes it.
+    zx_status_t Flush();
+
+    // Writes back every dirty line, or the first |count| |lines|, and marks them clean.
+    zx_status_t WriteBackAll();
+    zx_status_t WriteBack(Line** lines, size_t count);
+
+    // Reads or writes each of the first |count| |lines| from or to the device, and waits for them.
+    zx_status_t DoIo(uint32_t command, Line** lines, size_t count);
+
+    // Queues the first |count| ops in |ops_| to the parent device, and waits for them.
+    zx_status_t Submit(size_t count);
+
+    // Returns the number of device blocks covered by the line at |index|.  This is less than
+    // |line_blocks_| only for the last line of a device whose size is not a multiple of it.
+    uint32_t LineBlocks(uint64_t index) const;
+
+    // Returns the address of the data for |line| in the cache's mapping.
+    uint8_t* LineData(const Line* line) const;
+
+    // The parent device's block protocol, geometry and required block_op_t size.
+    block_protocol_t proto_;
+    block_info_t info_;
+    size_t parent_op_size_;
+
+    // Cache geometry, and memory.
+    uint32_t line_blocks_;
+    size_t line_count_;
+    zx::vmo vmo_;
+    uintptr_t base_;
+    fbl::unique_ptr<Line[]> lines_;
+
+    // Ops used by the worker for I/O to the parent device.
+    fbl::Array<uint8_t> ops_;
+
+    // Cached lines, indexed by their position on the device, and all lines, most recently used
+    // first.  Only touched by the worker.
+    fbl::WAVLTree<uint64_t, Line*> map_;
+    fbl::DoublyLinkedList<Line*> lru_;
+
+    thrd_t worker_;
+    bool worker_started_;
+
+    // Signalled when a request is queued or the device is unbound.
+    sync_completion_t signal_;
+
+    fbl::Mutex mtx_;
+    list_node_t queue_ __TA_GUARDED(mtx_);
+    bool dead_ __TA_GUARDED(mtx_);
+    block_cache_stats_t stats_ __TA_GUARDED(mtx_);
+};
+
+} // namespace block_cache
@@ -10,6 +10,7 @@ MODULE_TYPE := driver
 
 MODULE_SRCS := \
     $(LOCAL_DIR)/block.c \
+    $(LOCAL_DIR)/scheduler.cpp \
     $(LOCAL_DIR)/server.cpp \
     $(LOCAL_DIR)/txn-group.cpp \
 
@@ -24,3 +25,37 @@ MODULE_STATIC_LIBS := \
 MODULE_LIBS := system/ulib/c system/ulib/driver system/ulib/zircon
 
 include make/module.mk
+
+# Unit tests.
+
+MODULE := $(LOCAL_DIR).test
+
+MODULE_TYPE := usertest
+
+MODULE_NAME := block-scheduler-test
+
+TEST_DIR := $(LOCAL_DIR)/test
+
+MODULE_SRCS := \
+    $(LOCAL_DIR)/scheduler.cpp \
+    $(TEST_DIR)/main.cpp \
+    $(TEST_DIR)/scheduler-test.cpp \
+
+MODULE_COMPILEFLAGS := \
+    -I$(LOCAL_DIR) \
+
+MODULE_STATIC_LIBS := \
+    system/ulib/ddk \
+    system/ulib/fbl \
+    system/ulib/fzl \
+    system/ulib/sync \
+    system/ulib/zx \
+    system/ulib/zxcpp \
+
+MODULE_LIBS := \
+    system/ulib/c \
+    system/ulib/fdio \
+    system/ulib/unittest \
+    system/ulib/zircon \
+
+include make/module.mk
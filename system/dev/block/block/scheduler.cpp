@@ -0,0 +1,168 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <fbl/alloc_checker.h>
+#include <zircon/syscalls.h>
+#include <zircon/time.h>
+
+#include "scheduler.h"
+#include "server.h"
+
+namespace {
+
+// How long a message may wait before the deadline scheduler issues it ahead
+// of messages closer to the head.
+constexpr zx_duration_t kReadExpiry = ZX_MSEC(50);
+constexpr zx_duration_t kWriteExpiry = ZX_MSEC(500);
+
+bool IsWrite(const block_msg_t* msg) {
+    return (msg->op.command & BLOCK_OP_MASK) == BLOCK_OP_WRITE;
+}
+
+bool IsReadWrite(const block_msg_t* msg) {
+    uint32_t op = msg->op.command & BLOCK_OP_MASK;
+    return op == BLOCK_OP_READ || op == BLOCK_OP_WRITE;
+}
+
+zx_time_t Deadline(const block_msg_t* msg) {
+    return zx_time_add_duration(msg->extra.enqueued,
+                                IsWrite(msg) ? kWriteExpiry : kReadExpiry);
+}
+
+}  // namespace
+
+bool BlockMsgConflicts(const block_msg_t* a, const block_msg_t* b) {
+    if (!IsWrite(a) && !IsWrite(b)) {
+        return false;
+    }
+    uint64_t a_start = a->op.rw.offset_dev;
+    uint64_t b_start = b->op.rw.offset_dev;
+    return (a_start < b_start + b->op.rw.length) && (b_start < a_start + a->op.rw.length);
+}
+
+bool BlockMsgMayReorder(block_msg_t* const* window, size_t index) {
+    for (size_t i = 0; i < index; i++) {
+        if (BlockMsgConflicts(window[i], window[index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t BlockMsgMerge(block_msg_t* msg, block_msg_t** window, size_t* count,
+                     uint64_t max_length) {
+    if (!IsReadWrite(msg)) {
+        return 0;
+    }
+    const uint32_t op = msg->op.command & BLOCK_OP_MASK;
+
+    block_msg_t** tail = &msg->extra.merged;
+    size_t merged = 0;
+    size_t i = 0;
+    while (i < *count) {
+        block_msg_t* next = window[i];
+        if ((next->op.command & BLOCK_OP_MASK) != op ||
+            next->op.rw.vmo != msg->op.rw.vmo ||
+            next->op.rw.offset_dev != msg->op.rw.offset_dev + msg->op.rw.length ||
+            next->op.rw.offset_vmo != msg->op.rw.offset_vmo + msg->op.rw.length ||
+            static_cast<uint64_t>(msg->op.rw.length) + next->op.rw.length > max_length ||
+            !BlockMsgMayReorder(window, i)) {
+            i++;
+            continue;
+        }
+
+        msg->op.rw.length += next->op.rw.length;
+        *tail = next;
+        tail = &next->extra.merged;
+        memmove(&window[i], &window[i + 1], (*count - i - 1) * sizeof(window[0]));
+        (*count)--;
+        merged++;
+        // A later message may continue the one just merged.
+        i = 0;
+    }
+    return merged;
+}
+
+void BlockMsgCompleteMerged(block_msg_t* msg, zx_status_t status,
+                            void (*complete)(block_msg_t* msg, zx_status_t status)) {
+    while (msg != nullptr) {
+        block_msg_t* next = msg->extra.merged;
+        complete(msg, status);
+        msg = next;
+    }
+}
+
+zx_status_t Scheduler::Create(const char* name, fbl::unique_ptr<Scheduler>* out) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Scheduler> scheduler;
+    if (name == nullptr || !strcmp(name, "fifo")) {
+        scheduler.reset(new (&ac) FifoScheduler());
+    } else if (!strcmp(name, "deadline")) {
+        scheduler.reset(new (&ac) DeadlineScheduler());
+    } else if (!strcmp(name, "read")) {
+        scheduler.reset(new (&ac) ReadPriorityScheduler());
+    } else {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    *out = fbl::move(scheduler);
+    return ZX_OK;
+}
+
+size_t FifoScheduler::Pick(block_msg_t* const* window, size_t count) {
+    return 0;
+}
+
+size_t DeadlineScheduler::Pick(block_msg_t* const* window, size_t count) {
+    // Serve the message which expired first, if any have.
+    zx_time_t now = zx_clock_get_monotonic();
+    size_t pick = count;
+    zx_time_t earliest = ZX_TIME_INFINITE;
+    for (size_t i = 0; i < count; i++) {
+        zx_time_t deadline = Deadline(window[i]);
+        if (deadline <= now && deadline < earliest && BlockMsgMayReorder(window, i)) {
+            earliest = deadline;
+            pick = i;
+        }
+    }
+
+    if (pick == count) {
+        // Otherwise continue the sweep from the end of the last message,
+        // wrapping around to the lowest offset once nothing lies ahead.
+        size_t ahead = count;
+        size_t lowest = count;
+        for (size_t i = 0; i < count; i++) {
+            if (!BlockMsgMayReorder(window, i)) {
+                continue;
+            }
+            uint64_t offset = window[i]->op.rw.offset_dev;
+            if (offset >= head_ &&
+                (ahead == count || offset < window[ahead]->op.rw.offset_dev)) {
+                ahead = i;
+            }
+            if (lowest == count || offset < window[lowest]->op.rw.offset_dev) {
+                lowest = i;
+            }
+        }
+        pick = ahead != count ? ahead : lowest;
+    }
+
+    if (IsReadWrite(window[pick])) {
+        head_ = window[pick]->op.rw.offset_dev + window[pick]->op.rw.length;
+    }
+    return pick;
+}
+
+size_t ReadPriorityScheduler::Pick(block_msg_t* const* window, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (!IsWrite(window[i]) && BlockMsgMayReorder(window, i)) {
+            return i;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <zircon/types.h>
+
+typedef struct block_msg block_msg_t;
+
+// The largest number of queued messages a scheduler may choose between.
+constexpr size_t kSchedulerWindow = 32;
+
+// Returns true if |a| and |b| access overlapping ranges of the device, and at
+// least one of them writes.
+bool BlockMsgConflicts(const block_msg_t* a, const block_msg_t* b);
+
+// Returns true if |window[index]| may be issued ahead of every message queued
+// before it in |window|.
+bool BlockMsgMayReorder(block_msg_t* const* window, size_t index);
+
+// Merges the messages of |window| which continue |msg| on both the device and
+// the VMO into it, as long as it stays within |max_length| blocks. Merged
+// messages are chained from |msg->extra.merged| and removed from |window|.
+// Returns the number of messages merged.
+size_t BlockMsgMerge(block_msg_t* msg, block_msg_t** window, size_t* count, uint64_t max_length);
+
+// Calls |complete| on |msg| and then on each message merged into it, all with
+// the |status| of the combined operation. |complete| may free its message.
+void BlockMsgCompleteMerged(block_msg_t* msg, zx_status_t status,
+                            void (*complete)(block_msg_t* msg, zx_status_t status));
+
+// Chooses the order in which the block server issues queued messages to the
+// driver.
+//
+// The server only offers messages which the fifo protocol lets it reorder:
+// reads and writes, up to the next barrier. Overlapping messages are never
+// issued out of order when one of them writes.
+//
+// Each client fifo is scheduled on its own, and every server issues to the
+// driver's single queue. Spreading clients across multiple hardware queues
+// (such as NVMe submission queues) is not supported.
+class Scheduler {
+public:
+    virtual ~Scheduler() = default;
+
+    virtual const char* Name() const = 0;
+
+    // Returns the index of the message within |window| which should be issued
+    // next. |count| is at least one, and the first message may always be
+    // issued.
+    virtual size_t Pick(block_msg_t* const* window, size_t count) = 0;
+
+    // Creates the scheduler called |name|: "fifo", "deadline" or "read".
+    static zx_status_t Create(const char* name, fbl::unique_ptr<Scheduler>* out);
+};
+
+// Issues messages in the order they arrived.
+class FifoScheduler final : public Scheduler {
+public:
+    const char* Name() const final { return "fifo"; }
+    size_t Pick(block_msg_t* const* window, size_t count) final;
+};
+
+// Issues messages in order of their device offset, sweeping across the device
+// in one direction, unless a message has waited past its deadline. Reads
+// expire sooner than writes.
+class DeadlineScheduler final : public Scheduler {
+public:
+    const char* Name() const final { return "deadline"; }
+    size_t Pick(block_msg_t* const* window, size_t count) final;
+
+private:
+    // The end of the last message issued, in blocks.
+    uint64_t head_ = 0;
+};
+
+// Issues reads ahead of writes, so that readers are not stalled behind
+// bulk writeback.
+class ReadPriorityScheduler final : public Scheduler {
+public:
+    const char* Name() const final { return "read"; }
+    size_t Pick(block_msg_t* const* window, size_t count) final;
+};
@@ -63,10 +63,28 @@ void BlockComplete(BlockMsg* msg, zx_status_t status) {
     extra->server->TxnEnd();
 }
 
+void BlockCompleteOne(block_msg_t* bop, zx_status_t status) {
+    BlockMsg msg(bop);
+    BlockComplete(&msg, status);
+}
+
 void BlockCompleteCb(block_op_t* bop, zx_status_t status) {
     ZX_DEBUG_ASSERT(bop != nullptr);
-    BlockMsg msg(static_cast<block_msg_t*>(bop->cookie));
-    BlockComplete(&msg, status);
+    // Messages merged into this one were issued as part of it.
+    BlockMsgCompleteMerged(static_cast<block_msg_t*>(bop->cookie), status, BlockCompleteOne);
+}
+
+bool IsReadWrite(uint32_t command) {
+    uint32_t op = command & BLOCK_OP_MASK;
+    return op == BLOCK_OP_READ || op == BLOCK_OP_WRITE;
+}
+
+bool EnvOptionEnabled(const char* name, bool default_value) {
+    const char* value = getenv(name);
+    if (value == nullptr) {
+        return default_value;
+    }
+    return strcmp(value, "0") && strcmp(value, "false") && strcmp(value, "off");
 }
 
 uint32_t OpcodeToCommand(uint32_t opcode) {
@@ -91,6 +109,8 @@ void InQueueAdd(zx_handle_t vmo, uint64_t length, uint64_t vmo_offset,
     bop->rw.pages = NULL;
     bop->completion_cb = BlockCompleteCb;
     bop->cookie = msg;
+    msg->extra.enqueued = zx_clock_get_monotonic();
+    msg->extra.merged = nullptr;
     queue->push_back(msg);
 }
 
@@ -98,8 +118,6 @@ void InQueueAdd(zx_handle_t vmo, uint64_t length, uint64_t vmo_offset,
 
 IoBuffer::IoBuffer(zx::vmo vmo, vmoid_t id) : io_vmo_(fbl::move(vmo)), vmoid_(id) {}
 
-IoBuffer::~IoBuffer() {}
-
 zx_status_t IoBuffer::ValidateVmoHack(uint64_t length, uint64_t vmo_offset) {
     uint64_t vmo_size;
     zx_status_t status;
@@ -230,19 +248,55 @@ void BlockServer::TxnEnd() {
     }
 }
 
+size_t BlockServer::FillWindow(block_msg_t** window) {
+    size_t count = 0;
+    for (auto& msg : in_queue_) {
+        uint32_t command = msg.op.command;
+        if (count == 0) {
+            window[count++] = &msg;
+            // Nothing may pass a flush, or the end of a barrier.
+            if (!IsReadWrite(command) || (command & BLOCK_FL_BARRIER_AFTER)) {
+                break;
+            }
+            continue;
+        }
+        if (!IsReadWrite(command) ||
+            (command & (BLOCK_FL_BARRIER_BEFORE | BLOCK_FL_BARRIER_AFTER))) {
+            break;
+        }
+        window[count++] = &msg;
+        if (count == kSchedulerWindow) {
+            break;
+        }
+    }
+    return count;
+}
+
+size_t BlockServer::MergeWindow(block_msg_t* msg, block_msg_t** window, size_t* count) {
+    const uint64_t max_xfer = info_.max_transfer_size / info_.block_size;
+    const uint64_t limit = max_xfer == 0 ? fbl::numeric_limits<uint32_t>::max() :
+            fbl::min<uint64_t>(max_xfer, fbl::numeric_limits<uint32_t>::max());
+    size_t merged = BlockMsgMerge(msg, window, count, limit);
+    for (block_msg_t* next = msg->extra.merged; next != nullptr; next = next->extra.merged) {
+        in_queue_.erase(*next);
+    }
+    return merged;
+}
+
 void BlockServer::InQueueDrainer() {
+    block_msg_t* window[kSchedulerWindow];
     while (true) {
         if (in_queue_.is_empty()) {
             return;
         }
 
-        auto msg = in_queue_.begin();
+        auto first = in_queue_.begin();
         if (deferred_barrier_before_) {
-            msg->op.command |= BLOCK_FL_BARRIER_BEFORE;
+            first->op.command |= BLOCK_FL_BARRIER_BEFORE;
             deferred_barrier_before_ = false;
         }
 
-        if (msg->op.command & BLOCK_FL_BARRIER_BEFORE) {
+        if (first->op.command & BLOCK_FL_BARRIER_BEFORE) {
             barrier_in_progress_.store(true);
             if (pending_count_.load() > 0) {
                 return;
@@ -250,12 +304,23 @@ void BlockServer::InQueueDrainer() {
             // Since we're the only thread that could add to pending
             // count, we reliably know it has terminated.
             barrier_in_progress_.store(false);
+            first->op.command &= ~BLOCK_FL_BARRIER_BEFORE;
         }
+
+        size_t count = FillWindow(window);
+        size_t index = scheduler_->Pick(window, count);
+        ZX_DEBUG_ASSERT(index < count);
+        block_msg_t* msg = window[index];
+        memmove(&window[index], &window[index + 1], (count - index - 1) * sizeof(window[0]));
+        count--;
+
         if (msg->op.command & BLOCK_FL_BARRIER_AFTER) {
             deferred_barrier_before_ = true;
         }
-        pending_count_.fetch_add(1);
-        in_queue_.pop_front();
+        in_queue_.erase(*msg);
+        size_t merged = merge_ ? MergeWindow(msg, window, &count) : 0;
+        // Every merged message still ends with its own call to TxnEnd.
+        pending_count_.fetch_add(1 + merged);
         // Underlying block device drivers should not see block barriers
         // which are already handled by the block midlayer.
         //
@@ -298,6 +363,17 @@ zx_status_t BlockServer::Create(zx_device_t* dev, block_protocol_t* bp,
         bp->ops->query(bp->ctx, &bs->info_, &bs->block_op_size_);
     }
 
+    const char* scheduler = getenv("block.scheduler");
+    if ((status = Scheduler::Create(scheduler, &bs->scheduler_)) == ZX_ERR_NOT_SUPPORTED) {
+        fprintf(stderr, "block: Unknown scheduler '%s', using fifo\n", scheduler);
+        status = Scheduler::Create("fifo", &bs->scheduler_);
+    }
+    if (status != ZX_OK) {
+        delete bs;
+        return status;
+    }
+    bs->merge_ = EnvOptionEnabled("block.merge", true);
+
     // TODO(ZX-1583): Allocate BlockMsg arena based on block_op_size_.
 
     *out = bs;
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 
 #include <zircon/device/block.h>
+#include <ddk/device.h>
 #include <ddk/protocol/block.h>
 #include <zircon/thread_annotations.h>
 #include <zircon/types.h>
@@ -19,6 +20,7 @@
 #include <fbl/intrusive_double_list.h>
 #include <fbl/intrusive_wavl_tree.h>
 #include <fbl/mutex.h>
+#include <fbl/new.h>
 #include <fbl/ref_counted.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
@@ -26,6 +28,7 @@
 #include <lib/zx/vmo.h>
 #include <lib/sync/completion.h>
 
+#include "scheduler.h"
 #include "txn-group.h"
 
 // Represents the mapping of "vmoid --> VMO"
@@ -43,7 +46,7 @@ public:
     zx_handle_t vmo() const { return io_vmo_.get(); }
 
     IoBuffer(zx::vmo vmo, vmoid_t vmoid);
-    ~IoBuffer();
+    ~IoBuffer() = default;
 
 private:
     friend struct TypeWAVLTraits;
@@ -66,6 +69,10 @@ struct block_msg_extra {
     BlockServer* server;
     reqid_t reqid;
     groupid_t group;
+    // When the message was placed on the server's queue.
+    zx_time_t enqueued;
+    // Messages merged into this one, which are issued and completed with it.
+    block_msg_t* merged;
 };
 
 // A single unit of work transmitted to the underlying block layer.
@@ -189,8 +196,20 @@ private:
     // Attempts to enqueue all operations on the |in_queue_|. Stops
     // when either the queue is empty, or a BARRIER_BEFORE is reached and
     // operations are in-flight.
+    //
+    // Within the operations which may be reordered, |scheduler_| picks
+    // which is issued next.
     void InQueueDrainer();
 
+    // Fills |window| with the leading messages of |in_queue_| which may be
+    // issued in any order, and returns how many there are.
+    size_t FillWindow(block_msg_t** window);
+
+    // Merges the messages of |window| which continue |msg| on both the device
+    // and the VMO into it, removing them from |window| and |in_queue_|.
+    // Returns the number of messages merged.
+    size_t MergeWindow(block_msg_t* msg, block_msg_t** window, size_t* count);
+
     zx_status_t FindVmoIDLocked(vmoid_t* out) TA_REQ(server_lock_);
 
     fzl::fifo<block_fifo_response_t, block_fifo_request_t> fifo_;
@@ -203,6 +222,9 @@ private:
     // next operation that arrives.
     bool deferred_barrier_before_ = false;
     BlockMsgQueue in_queue_;
+    fbl::unique_ptr<Scheduler> scheduler_;
+    // Whether adjacent reads and writes are merged before being issued.
+    bool merge_ = true;
     fbl::atomic<size_t> pending_count_;
     fbl::atomic<bool> barrier_in_progress_;
     TransactionGroup groups_[MAX_TXN_GROUP_COUNT];
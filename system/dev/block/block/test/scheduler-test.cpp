@@ -0,0 +1,286 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "scheduler.h"
+#include "server.h"
+
+#include <fbl/algorithm.h>
+#include <unittest/unittest.h>
+#include <zircon/syscalls.h>
+#include <zircon/time.h>
+#include <zircon/types.h>
+
+namespace {
+
+// Stands in for the VMO handle of a client; never dereferenced.
+constexpr zx_handle_t kVmo = 1;
+constexpr zx_handle_t kOtherVmo = 2;
+
+void InitMsg(block_msg_t* msg, uint32_t command, uint64_t dev_offset, uint32_t length,
+             uint64_t vmo_offset, zx_handle_t vmo = kVmo) {
+    msg->op.command = command;
+    msg->op.rw.length = length;
+    msg->op.rw.vmo = vmo;
+    msg->op.rw.offset_dev = dev_offset;
+    msg->op.rw.offset_vmo = vmo_offset;
+    msg->extra.enqueued = zx_clock_get_monotonic();
+    msg->extra.merged = nullptr;
+}
+
+// Initializes a message which reads |length| blocks from |dev_offset| into the
+// same offset of the VMO.
+void InitRead(block_msg_t* msg, uint64_t dev_offset, uint32_t length = 1) {
+    InitMsg(msg, BLOCK_OP_READ, dev_offset, length, dev_offset);
+}
+
+void InitWrite(block_msg_t* msg, uint64_t dev_offset, uint32_t length = 1) {
+    InitMsg(msg, BLOCK_OP_WRITE, dev_offset, length, dev_offset);
+}
+
+// Makes |msg| look as though it was queued |age| ago.
+void Age(block_msg_t* msg, zx_duration_t age) {
+    msg->extra.enqueued = zx_time_sub_duration(zx_clock_get_monotonic(), age);
+}
+
+// Removes |window[index]|, as the block server does once it is issued.
+void Issue(block_msg_t** window, size_t* count, size_t index) {
+    for (size_t i = index + 1; i < *count; i++) {
+        window[i - 1] = window[i];
+    }
+    (*count)--;
+}
+
+bool FifoPicksOldestTest() {
+    BEGIN_TEST;
+    block_msg_t msgs[3] = {};
+    InitWrite(&msgs[0], 100);
+    InitRead(&msgs[1], 10);
+    InitRead(&msgs[2], 50);
+    block_msg_t* window[] = {&msgs[0], &msgs[1], &msgs[2]};
+
+    FifoScheduler scheduler;
+    EXPECT_EQ(scheduler.Pick(window, fbl::count_of(window)), 0u);
+    END_TEST;
+}
+
+bool ReadPriorityTest() {
+    BEGIN_TEST;
+    block_msg_t msgs[3] = {};
+    InitWrite(&msgs[0], 0, 8);
+    InitWrite(&msgs[1], 100);
+    InitRead(&msgs[2], 200);
+    block_msg_t* window[] = {&msgs[0], &msgs[1], &msgs[2]};
+
+    ReadPriorityScheduler scheduler;
+    EXPECT_EQ(scheduler.Pick(window, fbl::count_of(window)), 2u);
+
+    // A read of blocks still being written waits for the write.
+    InitRead(&msgs[2], 4);
+    EXPECT_EQ(scheduler.Pick(window, fbl::count_of(window)), 0u);
+    END_TEST;
+}
+
+bool DeadlineSweepTest() {
+    BEGIN_TEST;
+    block_msg_t msgs[5] = {};
+    InitRead(&msgs[0], 100);
+    InitRead(&msgs[1], 10);
+    InitRead(&msgs[2], 50);
+    block_msg_t* window[] = {&msgs[0], &msgs[1], &msgs[2]};
+    size_t count = fbl::count_of(window);
+
+    // Nothing has expired, so messages are issued in order of offset.
+    DeadlineScheduler scheduler;
+    size_t pick = scheduler.Pick(window, count);
+    EXPECT_EQ(window[pick], &msgs[1]);
+    Issue(window, &count, pick);
+    pick = scheduler.Pick(window, count);
+    EXPECT_EQ(window[pick], &msgs[2]);
+    Issue(window, &count, pick);
+
+    // Once nothing lies ahead of the head, the sweep starts over from the
+    // lowest offset.
+    InitRead(&msgs[3], 5);
+    InitRead(&msgs[4], 20);
+    window[0] = &msgs[0];
+    count = 1;
+    pick = scheduler.Pick(window, count);
+    EXPECT_EQ(window[pick], &msgs[0]);
+    window[0] = &msgs[4];
+    window[1] = &msgs[3];
+    count = 2;
+    pick = scheduler.Pick(window, count);
+    EXPECT_EQ(window[pick], &msgs[3]);
+    END_TEST;
+}
+
+bool DeadlineExpiryTest() {
+    BEGIN_TEST;
+    block_msg_t msgs[3] = {};
+    InitRead(&msgs[0], 10);
+    InitWrite(&msgs[1], 500);
+    block_msg_t* window[] = {&msgs[0], &msgs[1], &msgs[2]};
+
+    // An expired message is issued ahead of those closer to the head.
+    DeadlineScheduler scheduler;
+    Age(&msgs[1], ZX_SEC(1));
+    EXPECT_EQ(scheduler.Pick(window, 2), 1u);
+
+    // Reads expire sooner than writes.
+    DeadlineScheduler fresh;
+    InitWrite(&msgs[0], 10);
+    InitRead(&msgs[1], 500);
+    Age(&msgs[0], ZX_MSEC(100));
+    Age(&msgs[1], ZX_MSEC(100));
+    EXPECT_EQ(fresh.Pick(window, 2), 1u);
+
+    // Among expired messages, the one which expired first is issued first.
+    DeadlineScheduler oldest;
+    InitRead(&msgs[0], 10);
+    InitRead(&msgs[1], 500);
+    InitRead(&msgs[2], 300);
+    Age(&msgs[0], ZX_MSEC(100));
+    Age(&msgs[1], ZX_MSEC(200));
+    Age(&msgs[2], ZX_MSEC(300));
+    EXPECT_EQ(oldest.Pick(window, 3), 2u);
+
+    // An expired read still waits for an earlier write to the same blocks.
+    DeadlineScheduler ordered;
+    InitWrite(&msgs[0], 100, 10);
+    InitRead(&msgs[1], 105);
+    Age(&msgs[1], ZX_SEC(1));
+    EXPECT_EQ(ordered.Pick(window, 2), 0u);
+    END_TEST;
+}
+
+bool MergeContiguousTest() {
+    BEGIN_TEST;
+    block_msg_t msgs[3] = {};
+    InitRead(&msgs[0], 0, 4);
+    // Queued out of order: the second continues only once the third is merged.
+    InitRead(&msgs[1], 8, 4);
+    InitRead(&msgs[2], 4, 4);
+    block_msg_t* window[] = {&msgs[1], &msgs[2]};
+    size_t count = fbl::count_of(window);
+
+    EXPECT_EQ(BlockMsgMerge(&msgs[0], window, &count, 64), 2u);
+    EXPECT_EQ(count, 0u);
+    EXPECT_EQ(msgs[0].op.rw.offset_dev, 0u);
+    EXPECT_EQ(msgs[0].op.rw.length, 12u);
+    // Merged messages are chained in the order they were merged.
+    EXPECT_EQ(msgs[0].extra.merged, &msgs[2]);
+    EXPECT_EQ(msgs[2].extra.merged, &msgs[1]);
+    EXPECT_NULL(msgs[1].extra.merged);
+    END_TEST;
+}
+
+bool MergeBoundariesTest() {
+    BEGIN_TEST;
+    block_msg_t msg = {};
+    block_msg_t msgs[5] = {};
+    InitRead(&msg, 0, 4);
+    // A write, a different VMO, a gap in the VMO, and a gap on the device.
+    InitWrite(&msgs[0], 4, 4);
+    InitMsg(&msgs[1], BLOCK_OP_READ, 4, 4, 4, kOtherVmo);
+    InitMsg(&msgs[2], BLOCK_OP_READ, 4, 4, 5);
+    InitMsg(&msgs[3], BLOCK_OP_READ, 5, 4, 4);
+    block_msg_t* window[] = {&msgs[1], &msgs[2], &msgs[3], &msgs[0]};
+    size_t count = 4;
+    EXPECT_EQ(BlockMsgMerge(&msg, window, &count, 64), 0u);
+    EXPECT_EQ(count, 4u);
+    EXPECT_EQ(msg.op.rw.length, 4u);
+    EXPECT_NULL(msg.extra.merged);
+
+    // The combined message may not exceed the transfer limit.
+    InitRead(&msgs[4], 4, 4);
+    window[0] = &msgs[4];
+    count = 1;
+    EXPECT_EQ(BlockMsgMerge(&msg, window, &count, 7), 0u);
+    EXPECT_EQ(BlockMsgMerge(&msg, window, &count, 8), 1u);
+    EXPECT_EQ(msg.op.rw.length, 8u);
+
+    // Flushes are never merged.
+    block_msg_t flush = {};
+    InitMsg(&flush, BLOCK_OP_FLUSH, 0, 0, 0);
+    InitMsg(&msgs[0], BLOCK_OP_FLUSH, 0, 0, 0);
+    window[0] = &msgs[0];
+    count = 1;
+    EXPECT_EQ(BlockMsgMerge(&flush, window, &count, 64), 0u);
+    END_TEST;
+}
+
+bool MergeRespectsOrderTest() {
+    BEGIN_TEST;
+    block_msg_t msg = {};
+    block_msg_t msgs[2] = {};
+    InitWrite(&msg, 0, 4);
+    // The continuation overlaps a write queued before it, so it cannot be
+    // pulled ahead of that write.
+    InitWrite(&msgs[0], 6, 4);
+    InitWrite(&msgs[1], 4, 4);
+    block_msg_t* window[] = {&msgs[0], &msgs[1]};
+    size_t count = 2;
+    EXPECT_EQ(BlockMsgMerge(&msg, window, &count, 64), 0u);
+    EXPECT_EQ(count, 2u);
+    END_TEST;
+}
+
+struct Completion {
+    block_msg_t* msg;
+    zx_status_t status;
+};
+Completion completions[4];
+size_t completion_count;
+
+void RecordCompletion(block_msg_t* msg, zx_status_t status) {
+    completions[completion_count++] = {msg, status};
+    // Completed messages are freed, so the chain may not be read afterwards.
+    msg->extra.merged = nullptr;
+}
+
+bool CompleteMergedTest() {
+    BEGIN_TEST;
+    block_msg_t msgs[3] = {};
+    InitWrite(&msgs[0], 0, 4);
+    InitWrite(&msgs[1], 4, 4);
+    InitWrite(&msgs[2], 8, 4);
+    block_msg_t* window[] = {&msgs[2], &msgs[1]};
+    size_t count = 2;
+    ASSERT_EQ(BlockMsgMerge(&msgs[0], window, &count, 64), 2u);
+
+    // Every message shares the outcome of the combined operation.
+    completion_count = 0;
+    BlockMsgCompleteMerged(&msgs[0], ZX_ERR_IO, RecordCompletion);
+    ASSERT_EQ(completion_count, 3u);
+    EXPECT_EQ(completions[0].msg, &msgs[0]);
+    EXPECT_EQ(completions[1].msg, &msgs[1]);
+    EXPECT_EQ(completions[2].msg, &msgs[2]);
+    for (size_t i = 0; i < completion_count; i++) {
+        EXPECT_EQ(completions[i].status, ZX_ERR_IO);
+    }
+
+    // A message which was not merged completes alone.
+    InitRead(&msgs[0], 0, 4);
+    completion_count = 0;
+    BlockMsgCompleteMerged(&msgs[0], ZX_OK, RecordCompletion);
+    ASSERT_EQ(completion_count, 1u);
+    EXPECT_EQ(completions[0].status, ZX_OK);
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(BlockSchedulerTests)
+RUN_TEST(FifoPicksOldestTest)
+RUN_TEST(ReadPriorityTest)
+RUN_TEST(DeadlineSweepTest)
+RUN_TEST(DeadlineExpiryTest)
+END_TEST_CASE(BlockSchedulerTests)
+
+BEGIN_TEST_CASE(BlockMergeTests)
+RUN_TEST(MergeContiguousTest)
+RUN_TEST(MergeBoundariesTest)
+RUN_TEST(MergeRespectsOrderTest)
+RUN_TEST(CompleteMergedTest)
+END_TEST_CASE(BlockMergeTests)
@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <threads.h>
 
 #include <ddk/device.h>
 #include <fvm/fvm.h>
@@ -20,6 +21,7 @@
 #include <ddktl/protocol/block.h>
 #include <lib/fzl/mapped-vmo.h>
 #include <fbl/algorithm.h>
+#include <fbl/atomic.h>
 #include <fbl/intrusive_wavl_tree.h>
 #include <fbl/mutex.h>
 #include <fbl/unique_ptr.h>
@@ -33,6 +35,12 @@ using ManagerDeviceType = ddk::Device<VPartitionManager, ddk::Ioctlable, ddk::Un
 class VPartition;
 using PartitionDeviceType = ddk::Device<VPartition, ddk::Ioctlable, ddk::GetSizable, ddk::Unbindable>;
 
+// The slice cache of each VPartition is split into leaves, each of which
+// covers an aligned run of 1 << kSliceCacheShift virtual slices.
+constexpr size_t kSliceCacheShift = 10;
+constexpr size_t kSliceCacheLeafSize = 1 << kSliceCacheShift;
+constexpr size_t kSliceCacheLeaves = 16;
+
 class SliceExtent : public fbl::WAVLTreeContainable<fbl::unique_ptr<SliceExtent>> {
 public:
     size_t GetKey() const { return vslice_start_; }
@@ -224,6 +232,17 @@ public:
     // to it. If no slice is allocated, return PSLICE_UNALLOCATED.
     uint32_t SliceGetLocked(size_t vslice) const TA_REQ(lock_);
 
+    // Given a virtual slice, return the physical slice allocated to it
+    // without acquiring |lock_|. Returns PSLICE_UNALLOCATED if the slice is
+    // unallocated or missing from the slice cache, in which case the caller
+    // should fall back to SliceGetLocked.
+    uint32_t SliceGetCached(size_t vslice) const;
+
+    // Remove |count| slices starting at |vslice_start| from the slice cache,
+    // and wait for any I/O which may have translated one of them without
+    // |lock_| to be queued to the parent device.
+    void SliceCacheInvalidateLocked(size_t vslice_start, size_t count) TA_REQ(lock_);
+
     // Check slices starting from |vslice_start|.
     // Sets |*count| to the number of contiguous allocated or unallocated slices found.
     // Sets |*allocated| to true if the vslice range is allocated, and false otherwise.
@@ -267,6 +286,28 @@ private:
 
     zx_device_t* GetParent() const { return mgr_->parent(); }
 
+    // Record |pslice| as the physical slice backing |vslice| in the slice
+    // cache, allocating a leaf for it if needed.
+    void SliceCacheSetLocked(size_t vslice, uint32_t pslice) TA_REQ(lock_);
+    void SliceCacheClearLocked(size_t vslice_start, size_t count) TA_REQ(lock_);
+
+    // Translate |txn| to physical slices and queue it to the parent device,
+    // splitting it where its slices are not physically contiguous.
+    //
+    // If |cached| is set, slices are looked up with SliceGetCached, and false
+    // is returned without touching |txn| if any of them is missing. Otherwise
+    // the caller must hold |lock_|, and |txn| is always consumed.
+    bool QueueTranslated(block_op_t* txn, bool cached) TA_NO_THREAD_SAFETY_ANALYSIS;
+    uint32_t SliceGet(size_t vslice, bool cached) const TA_NO_THREAD_SAFETY_ANALYSIS {
+        return cached ? SliceGetCached(vslice) : SliceGetLocked(vslice);
+    }
+
+    // A run of physically contiguous slices, found while translating a request.
+    struct SliceRun {
+        size_t vslice_start;
+        uint32_t pslice_start;
+    };
+
     VPartitionManager* mgr_;
     size_t entry_index_;
 
@@ -276,6 +317,32 @@ private:
     // physical slices.
     fbl::WAVLTree<size_t, fbl::unique_ptr<SliceExtent>> slice_map_ TA_GUARDED(lock_);
     block_info_t info_ TA_GUARDED(lock_);
+
+    // A copy of |slice_map_| which BlockQueue reads without |lock_|, so that
+    // I/O to a partition is not serialized on slice lookups.
+    //
+    // Leaves are allocated under |lock_| as slices are mapped, and are never
+    // reassigned: |tag| is published last, and is one more than the index of
+    // the first slice the leaf covers. Entries are only cleared once no
+    // translation can still be using them (see SliceCacheInvalidateLocked).
+    // Slices which do not fit in the cache are translated under |lock_|.
+    struct SliceCacheLeaf {
+        fbl::atomic<size_t> tag{0};
+        fbl::unique_ptr<fbl::atomic<uint32_t>[]> pslices;
+    };
+    SliceCacheLeaf slice_cache_[kSliceCacheLeaves];
+
+    // Number of I/O requests currently being translated through the slice
+    // cache.
+    fbl::atomic<uint32_t> translations_{0};
+
+    // SliceCacheInvalidateLocked waits on |translations_cvar_| for
+    // |translations_| to drop to zero. It sets |translations_waiting_| first,
+    // so that BlockQueue only takes |translations_lock_| to signal it when
+    // someone is waiting.
+    fbl::atomic<bool> translations_waiting_{false};
+    fbl::Mutex translations_lock_;
+    cnd_t translations_cvar_;
 };
 
 } // namespace fvm
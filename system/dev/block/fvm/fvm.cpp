@@ -501,6 +501,9 @@ zx_status_t VPartitionManager::FreeSlicesLocked(VPartition* vp, size_t vslice_st
         if (vp->IsKilledLocked())
             return ZX_ERR_BAD_STATE;
 
+        // Stop translating I/O to these slices without the partition lock.
+        vp->SliceCacheInvalidateLocked(vslice_start, count);
+
         //TODO: use block protocol
         // Sync first, before removing slices, so iotxns in-flight cannot
         // operate on 'unowned' slices.
@@ -679,9 +682,12 @@ VPartition::VPartition(VPartitionManager* vpm, size_t entry_index, size_t block_
 
     memcpy(&info_, &mgr_->info_, sizeof(block_info_t));
     info_.block_count = 0;
+    cnd_init(&translations_cvar_);
 }
 
-VPartition::~VPartition() = default;
+VPartition::~VPartition() {
+    cnd_destroy(&translations_cvar_);
+}
 
 zx_status_t VPartition::Create(VPartitionManager* vpm, size_t entry_index,
                                fbl::unique_ptr<VPartition>* out) {
@@ -770,6 +776,7 @@ zx_status_t VPartition::SliceSetLocked(size_t vslice, uint32_t pslice) {
 
     ZX_DEBUG_ASSERT(SliceGetLocked(vslice) == pslice);
     AddBlocksLocked((mgr_->SliceSize() / info_.block_size));
+    SliceCacheSetLocked(vslice, pslice);
 
     // Merge with the next contiguous extent (if any)
     auto nextExtent = slice_map_.upper_bound(vslice);
@@ -785,6 +792,7 @@ zx_status_t VPartition::SliceSetLocked(size_t vslice, uint32_t pslice) {
 bool VPartition::SliceFreeLocked(size_t vslice) {
     ZX_DEBUG_ASSERT(vslice < mgr_->VSliceMax());
     ZX_DEBUG_ASSERT(SliceCanFree(vslice));
+    SliceCacheClearLocked(vslice, 1);
     auto extent = --slice_map_.upper_bound(vslice);
     if (vslice != extent->end() - 1) {
         // Removing from the middle of an extent; this splits the extent in
@@ -810,10 +818,83 @@ void VPartition::ExtentDestroyLocked(size_t vslice) TA_REQ(lock_) {
     ZX_DEBUG_ASSERT(SliceCanFree(vslice));
     auto extent = --slice_map_.upper_bound(vslice);
     size_t length = extent->size();
+    SliceCacheClearLocked(extent->start(), length);
     slice_map_.erase(*extent);
     AddBlocksLocked(-((length * mgr_->SliceSize()) / info_.block_size));
 }
 
+uint32_t VPartition::SliceGetCached(size_t vslice) const {
+    const size_t tag = (vslice >> kSliceCacheShift) + 1;
+    for (const auto& leaf : slice_cache_) {
+        if (leaf.tag.load(fbl::memory_order_acquire) == tag) {
+            return leaf.pslices[vslice % kSliceCacheLeafSize].load();
+        }
+    }
+    return PSLICE_UNALLOCATED;
+}
+
+void VPartition::SliceCacheSetLocked(size_t vslice, uint32_t pslice) {
+    const size_t tag = (vslice >> kSliceCacheShift) + 1;
+    SliceCacheLeaf* unused = nullptr;
+    for (auto& leaf : slice_cache_) {
+        size_t leaf_tag = leaf.tag.load(fbl::memory_order_relaxed);
+        if (leaf_tag == tag) {
+            leaf.pslices[vslice % kSliceCacheLeafSize].store(pslice);
+            return;
+        } else if (leaf_tag == 0 && unused == nullptr) {
+            unused = &leaf;
+        }
+    }
+    if (unused == nullptr) {
+        // Every leaf is in use; I/O to this slice will be translated under
+        // the partition lock instead.
+        return;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<fbl::atomic<uint32_t>[]> pslices(
+        new (&ac) fbl::atomic<uint32_t>[kSliceCacheLeafSize]);
+    if (!ac.check()) {
+        return;
+    }
+    for (size_t i = 0; i < kSliceCacheLeafSize; i++) {
+        pslices[i].store(PSLICE_UNALLOCATED, fbl::memory_order_relaxed);
+    }
+    pslices[vslice % kSliceCacheLeafSize].store(pslice, fbl::memory_order_relaxed);
+    unused->pslices = fbl::move(pslices);
+    unused->tag.store(tag, fbl::memory_order_release);
+}
+
+void VPartition::SliceCacheClearLocked(size_t vslice_start, size_t count) {
+    const size_t vslice_end = vslice_start + count;
+    for (auto& leaf : slice_cache_) {
+        size_t leaf_tag = leaf.tag.load(fbl::memory_order_relaxed);
+        if (leaf_tag == 0) {
+            continue;
+        }
+        const size_t leaf_start = (leaf_tag - 1) << kSliceCacheShift;
+        const size_t leaf_end = leaf_start + kSliceCacheLeafSize;
+        for (size_t vslice = fbl::max(vslice_start, leaf_start);
+             vslice < fbl::min(vslice_end, leaf_end); vslice++) {
+            leaf.pslices[vslice - leaf_start].store(PSLICE_UNALLOCATED);
+        }
+    }
+}
+
+void VPartition::SliceCacheInvalidateLocked(size_t vslice_start, size_t count) {
+    SliceCacheClearLocked(vslice_start, count);
+
+    // A translation which began before the slices were cleared may still be
+    // about to queue I/O to them. Any translation which begins afterwards
+    // misses the cache, and waits for |lock_|.
+    fbl::AutoLock lock(&translations_lock_);
+    translations_waiting_.store(true);
+    while (translations_.load() != 0) {
+        cnd_wait(&translations_cvar_, translations_lock_.GetInternal());
+    }
+    translations_waiting_.store(false);
+}
+
 static zx_status_t RequestBoundCheck(const extend_request_t* request,
                                      size_t vslice_max) {
     if (request->offset == 0 || request->offset > vslice_max) {
@@ -1009,6 +1090,23 @@ void VPartition::BlockQueue(block_op_t* txn) {
         return;
     }
 
+    // Common case: every slice is in the slice cache, and the partition lock
+    // is not needed.
+    translations_.fetch_add(1);
+    bool queued = QueueTranslated(txn, true);
+    if (translations_.fetch_sub(1) == 1 && translations_waiting_.load()) {
+        // Both atomics are sequentially consistent: either the waiter sees the
+        // count drop to zero, or we see that it is waiting and wake it.
+        fbl::AutoLock lock(&translations_lock_);
+        cnd_broadcast(&translations_cvar_);
+    }
+    if (!queued) {
+        fbl::AutoLock lock(&lock_);
+        QueueTranslated(txn, false);
+    }
+}
+
+bool VPartition::QueueTranslated(block_op_t* txn, bool cached) {
     const size_t disk_size = mgr_->DiskSize();
     const size_t slice_size = mgr_->SliceSize();
     const uint64_t blocks_per_slice = slice_size / BlockSize();
@@ -1016,46 +1114,52 @@ void VPartition::BlockQueue(block_op_t* txn) {
     size_t vslice_start = txn->rw.offset_dev / blocks_per_slice;
     size_t vslice_end = (txn->rw.offset_dev + txn->rw.length - 1) / blocks_per_slice;
 
-    fbl::AutoLock lock(&lock_);
-    if (vslice_start == vslice_end) {
-        // Common case: txn occurs within one slice
-        uint32_t pslice = SliceGetLocked(vslice_start);
-        if (pslice == PSLICE_UNALLOCATED) {
-            txn->completion_cb(txn, ZX_ERR_OUT_OF_RANGE);
-            return;
-        }
-        txn->rw.offset_dev = SliceStart(disk_size, slice_size, pslice) /
-                BlockSize() + (txn->rw.offset_dev % blocks_per_slice);
-        mgr_->Queue(txn);
-        return;
-    }
-
-    // Less common case: txn spans multiple slices
-
     // First, check that all slices are allocated.
     // If any are missing, then this txn will fail.
-    bool contiguous = true;
-    for (size_t vslice = vslice_start; vslice <= vslice_end; vslice++) {
-        if (SliceGetLocked(vslice) == PSLICE_UNALLOCATED) {
+    // Record where each physically contiguous run of slices after the first
+    // begins while we're at it. The cached slice map may change as soon as it
+    // has been read, so the txn is split using only the slices read here.
+    const uint32_t first_pslice = SliceGet(vslice_start, cached);
+    if (first_pslice == PSLICE_UNALLOCATED) {
+        if (cached) {
+            return false;
+        }
+        txn->completion_cb(txn, ZX_ERR_OUT_OF_RANGE);
+        return true;
+    }
+    fbl::Vector<SliceRun> runs;
+    uint32_t prev = first_pslice;
+    for (size_t vslice = vslice_start + 1; vslice <= vslice_end; vslice++) {
+        uint32_t pslice = SliceGet(vslice, cached);
+        if (pslice == PSLICE_UNALLOCATED) {
+            if (cached) {
+                return false;
+            }
             txn->completion_cb(txn, ZX_ERR_OUT_OF_RANGE);
-            return;
+            return true;
         }
-        if (vslice != vslice_start && SliceGetLocked(vslice - 1) + 1 != SliceGetLocked(vslice)) {
-            contiguous = false;
+        if (prev + 1 != pslice) {
+            fbl::AllocChecker ac;
+            runs.push_back({vslice, pslice}, &ac);
+            if (!ac.check()) {
+                txn->completion_cb(txn, ZX_ERR_NO_MEMORY);
+                return true;
+            }
         }
+        prev = pslice;
     }
 
     // Ideal case: slices are contiguous
-    if (contiguous) {
-        uint32_t pslice = SliceGetLocked(vslice_start);
-        txn->rw.offset_dev = SliceStart(disk_size, slice_size, pslice) /
+    if (runs.is_empty()) {
+        txn->rw.offset_dev = SliceStart(disk_size, slice_size, first_pslice) /
                 BlockSize() + (txn->rw.offset_dev % blocks_per_slice);
         mgr_->Queue(txn);
-        return;
+        return true;
     }
 
-    // Harder case: Noncontiguous slices
-    const size_t txn_count = vslice_end - vslice_start + 1;
+    // Harder case: Noncontiguous slices.
+    // Issue one txn per contiguous run.
+    const size_t txn_count = runs.size() + 1;
     fbl::Vector<block_op_t*> txns;
     txns.reserve(txn_count);
 
@@ -1063,27 +1167,18 @@ void VPartition::BlockQueue(block_op_t* txn) {
     fbl::unique_ptr<multi_txn_state_t> state(new (&ac) multi_txn_state_t(txn_count, txn));
     if (!ac.check()) {
         txn->completion_cb(txn, ZX_ERR_NO_MEMORY);
-        return;
+        return true;
     }
 
+    uint64_t offset_dev = txn->rw.offset_dev;
+    uint64_t offset_vmo = txn->rw.offset_vmo;
     uint32_t length_remaining = txn->rw.length;
     for (size_t i = 0; i < txn_count; i++) {
-        size_t vslice = vslice_start + i;
-        uint32_t pslice = SliceGetLocked(vslice);
-
-        uint64_t offset_vmo = txn->rw.offset_vmo;
-        uint64_t length;
-        if (vslice == vslice_start) {
-            length = fbl::round_up(txn->rw.offset_dev + 1, blocks_per_slice) - txn->rw.offset_dev;
-        } else if (vslice == vslice_end) {
-            length = length_remaining;
-            offset_vmo += txn->rw.length - length_remaining;
-        } else {
-            length = blocks_per_slice;
-            offset_vmo += txns[0]->rw.length + blocks_per_slice * (i - 1);
-        }
-        ZX_DEBUG_ASSERT(length <= blocks_per_slice);
-        ZX_DEBUG_ASSERT(length <= length_remaining);
+        // Run |i| ends (exclusive) where the next one starts.
+        uint32_t pslice = (i == 0) ? first_pslice : runs[i - 1].pslice_start;
+        size_t run_end = (i < runs.size()) ? runs[i].vslice_start : vslice_end + 1;
+        uint64_t length = fbl::min<uint64_t>(run_end * blocks_per_slice - offset_dev,
+                                             length_remaining);
 
         txns.push_back(reinterpret_cast<block_op_t*>(new uint8_t[mgr_->BlockOpSize()]));
         if (txns[i] == nullptr) {
@@ -1091,18 +1186,19 @@ void VPartition::BlockQueue(block_op_t* txn) {
                 delete[] txns[i];
             }
             txn->completion_cb(txn, ZX_ERR_NO_MEMORY);
-            return;
+            return true;
         }
         memcpy(txns[i], txn, sizeof(*txn));
         txns[i]->rw.offset_vmo = offset_vmo;
         txns[i]->rw.length = static_cast<uint32_t>(length);
-        txns[i]->rw.offset_dev = SliceStart(disk_size, slice_size, pslice) / BlockSize();
-        if (vslice == vslice_start) {
-            txns[i]->rw.offset_dev += (txn->rw.offset_dev % blocks_per_slice);
-        }
-        length_remaining -= txns[i]->rw.length;
+        txns[i]->rw.offset_dev = SliceStart(disk_size, slice_size, pslice) / BlockSize() +
+                (offset_dev % blocks_per_slice);
         txns[i]->completion_cb = multi_txn_completion;
         txns[i]->cookie = state.get();
+
+        offset_dev += length;
+        offset_vmo += length;
+        length_remaining -= static_cast<uint32_t>(length);
     }
     ZX_DEBUG_ASSERT(length_remaining == 0);
 
@@ -1111,6 +1207,7 @@ void VPartition::BlockQueue(block_op_t* txn) {
     }
     // TODO(johngro): ask smklein why it is OK to release this managed pointer.
     __UNUSED auto ptr = state.release();
+    return true;
 }
 
 zx_off_t VPartition::DdkGetSize() {
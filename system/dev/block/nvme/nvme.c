@@ -964,6 +964,9 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
     FEATURE(ONCS, COMPARE);
 
     // set feature (number of queues) to 1 iosq and 1 iocq
+    // TODO: one queue pair (and interrupt) per CPU would let the block
+    // server's clients submit without sharing io_sq; until then every
+    // operation is funneled through this single queue.
     memset(&cmd, 0, sizeof(cmd));
     cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_SET_FEATURE);
     cmd.u.raw[0] = NVME_FEATURE_NUMBER_OF_QUEUES;
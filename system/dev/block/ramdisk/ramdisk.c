@@ -50,6 +50,7 @@ typedef struct ramdisk_device {
     bool asleep; // true if the ramdisk is "sleeping"
     uint64_t sa_blk_count; // number of blocks to sleep after
     ramdisk_blk_counts_t blk_counts; // current block counts
+    zx_duration_t latency; // delay before each transaction, to simulate a slower device
 
     thrd_t worker;
     char name[NAME_MAX];
@@ -67,6 +68,7 @@ static int worker_thread(void* arg) {
     ramdisk_txn_t* txn = NULL;
     bool dead, asleep, defer;
     size_t blocks = 0;
+    zx_duration_t latency = 0;
 
     for (;;) {
         for (;;) {
@@ -76,6 +78,7 @@ static int worker_thread(void* arg) {
             asleep = dev->asleep;
             defer = (dev->flags & RAMDISK_FLAG_RESUME_ON_WAKE) != 0;
             blocks = dev->sa_blk_count;
+            latency = dev->latency;
 
             if (!asleep) {
                 // If we are awake, try grabbing pending transactions from the deferred list.
@@ -102,6 +105,10 @@ static int worker_thread(void* arg) {
             }
         }
 
+        if (latency > 0) {
+            zx_nanosleep(zx_deadline_after(latency));
+        }
+
         size_t txn_blocks = txn->op.rw.length;
         if (txn->op.command == BLOCK_OP_READ || blocks == 0 || blocks > txn_blocks) {
             // If the ramdisk is not configured to sleep after x blocks, or the number of blocks in
@@ -277,6 +284,15 @@ static zx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd, size_t
         *out_actual = sizeof(ramdisk_blk_counts_t);
         return ZX_OK;
     }
+    case IOCTL_RAMDISK_SET_LATENCY: {
+        if (cmd_len < sizeof(zx_duration_t)) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        mtx_lock(&ramdev->lock);
+        ramdev->latency = *(zx_duration_t*)cmd;
+        mtx_unlock(&ramdev->lock);
+        return ZX_OK;
+    }
     // Block Protocol
     case IOCTL_BLOCK_GET_NAME: {
         char* name = reply;
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <inttypes.h>
+#include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
@@ -23,6 +24,7 @@
 #include <zircon/device/block.h>
 #include <zircon/errors.h>
 #include <zircon/status.h>
+#include <zircon/syscalls.h>
 #include <zircon/thread_annotations.h>
 #include <zircon/types.h>
 #include <zxcrypt/volume.h>
@@ -157,13 +159,16 @@ zx_status_t Device::Init() {
         return rc;
     }
 
-    // Start workers
-    // TODO(aarongreen): Investigate performance implications of adding more workers.
+    // Start workers, one per CPU.
     if ((rc = zx::port::create(0, &port_)) != ZX_OK) {
         zxlogf(ERROR, "zx::port::create failed: %s\n", zx_status_get_string(rc));
         return rc;
     }
-    for (size_t i = 0; i < kNumWorkers; ++i) {
+    size_t num_workers = zx_system_get_num_cpus();
+    if (num_workers > kMaxWorkers) {
+        num_workers = kMaxWorkers;
+    }
+    for (size_t i = 0; i < num_workers; ++i) {
         zx::port port;
         port_.duplicate(ZX_RIGHT_SAME_RIGHTS, &port);
         if ((rc = workers_[i].Start(this, *volume, fbl::move(port))) != ZX_OK) {
@@ -506,13 +511,60 @@ void Device::SendToWorker(block_op_t* block) {
     LOG_ENTRY_ARGS("block=%p", block);
     zx_status_t rc;
 
+    // Share the request between the workers, in pieces of whole pages so that each piece of a read
+    // can be mapped separately.
+    uint32_t length = block->rw.length;
+    uint32_t page_blocks = fbl::max<uint32_t>(PAGE_SIZE / info_->block_size, 1);
+    uint32_t piece = fbl::max<uint32_t>(kMinSplitSize / info_->block_size,
+                                        fbl::round_up(length, info_->num_workers) /
+                                            info_->num_workers);
+    piece = fbl::round_up(piece, page_blocks);
+    uint32_t count = fbl::max<uint32_t>(fbl::round_up(length, piece) / piece, 1);
+
+    extra_op_t* extra = BlockToExtra(block, info_->op_size);
+    extra->pieces.store(count);
+    extra->pieces_status.store(ZX_OK);
+
     zx_port_packet_t packet;
-    Worker::MakeRequest(&packet, Worker::kBlockRequest, block);
-    if ((rc = port_.queue(&packet)) != ZX_OK) {
-        zxlogf(ERROR, "zx::port::queue failed: %s\n", zx_status_get_string(rc));
-        BlockComplete(block, rc);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t offset = i * piece;
+        Worker::MakeRequest(&packet, Worker::kBlockRequest, block, offset,
+                            fbl::min(piece, length - offset));
+        if ((rc = port_.queue(&packet)) != ZX_OK) {
+            zxlogf(ERROR, "zx::port::queue failed: %s\n", zx_status_get_string(rc));
+            // Account for this and the remaining pieces, none of which will reach a worker.
+            for (; i < count; ++i) {
+                TransformComplete(block, rc);
+            }
+            return;
+        }
+    }
+}
+
+void Device::TransformComplete(block_op_t* block, zx_status_t status) {
+    LOG_ENTRY_ARGS("block=%p, status=%s", block, zx_status_get_string(status));
+    ZX_DEBUG_ASSERT(info_);
+
+    extra_op_t* extra = BlockToExtra(block, info_->op_size);
+    if (status != ZX_OK) {
+        zx_status_t expected = ZX_OK;
+        extra->pieces_status.compare_exchange_strong(&expected, status, fbl::memory_order_seq_cst,
+                                                     fbl::memory_order_seq_cst);
+    }
+    if (extra->pieces.fetch_sub(1) != 1) {
         return;
     }
+
+    status = extra->pieces_status.load();
+    switch (block->command & BLOCK_OP_MASK) {
+    case BLOCK_OP_WRITE:
+        BlockForward(block, status);
+        break;
+    case BLOCK_OP_READ:
+    default:
+        BlockComplete(block, status);
+        break;
+    }
 }
 
 void Device::BlockCallback(block_op_t* block, zx_status_t status) {
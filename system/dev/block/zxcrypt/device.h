@@ -76,18 +76,27 @@ public:
     // Returns a completed |block| request to the caller of |BlockQueue|.
     void BlockComplete(block_op_t* block, zx_status_t status) __TA_EXCLUDES(mtx_);
 
+    // Called by a worker when it has finished transforming a piece of |block|.  Once every piece
+    // is done, forwards a write to the parent device or completes a read.
+    void TransformComplete(block_op_t* block, zx_status_t status) __TA_EXCLUDES(mtx_);
+
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(Device);
 
-    // TODO(aarongreen): Investigate performance impact of changing this.
-    // Number of encrypting/decrypting workers
-    static const size_t kNumWorkers = 2;
+    // Maximum number of encrypting/decrypting workers.  One worker is started per CPU, up to this
+    // limit.  Workers share a single port, so idle workers cost nothing while the queue is shallow.
+    static const size_t kMaxWorkers = 16;
+
+    // Requests are split into pieces of at least this many bytes, so that workers can transform a
+    // single large request in parallel.
+    static const uint32_t kMinSplitSize = 64 * 1024;
 
     // Adds |block| to the write queue if not null, and sends to the workers as many write requests
     // as fit in the space available in the write buffer.
     void EnqueueWrite(block_op_t* block = nullptr) __TA_EXCLUDES(mtx_);
 
-    // Sends a block I/O request to a worker to be encrypted or decrypted.
+    // Sends a block I/O request to the workers to be encrypted or decrypted, split into as many
+    // pieces as there are workers to share it.
     void SendToWorker(block_op_t* block) __TA_EXCLUDES(mtx_);
 
     // Callback used for block ops sent to the parent device.  Restores the fields saved by
@@ -146,7 +155,7 @@ private:
     thrd_t init_;
 
     // Threads that performs encryption/decryption.
-    Worker workers_[kNumWorkers];
+    Worker workers_[kMaxWorkers];
 
     // Port used to send write/read operations to be encrypted/decrypted.
     zx::port port_;
@@ -25,6 +25,8 @@ zx_status_t extra_op_t::Init(block_op_t* block, size_t reserved_blocks) {
     data = nullptr;
     completion_cb = block->completion_cb;
     cookie = block->cookie;
+    pieces.store(0);
+    pieces_status.store(ZX_OK);
 
     switch (block->command & BLOCK_OP_MASK) {
     case BLOCK_OP_READ:
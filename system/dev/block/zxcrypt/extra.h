@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include <ddk/protocol/block.h>
+#include <fbl/atomic.h>
 #include <zircon/listnode.h>
 #include <zircon/types.h>
 
@@ -36,6 +37,11 @@ struct extra_op_t {
     void (*completion_cb)(block_op_t* block, zx_status_t status);
     void* cookie;
 
+    // The number of pieces of the request still being transformed by workers, and the first
+    // failure among them.
+    fbl::atomic_uint32_t pieces;
+    fbl::atomic<zx_status_t> pieces_status;
+
     // Resets this structure to an initial state.
     zx_status_t Init(block_op_t* block, size_t reserved_blocks);
 };
@@ -32,7 +32,8 @@ Worker::~Worker() {
     LOG_ENTRY();
 }
 
-void Worker::MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg) {
+void Worker::MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg, uint64_t offset,
+                         uint64_t length) {
     static_assert(sizeof(uintptr_t) <= sizeof(uint64_t), "cannot store pointer as uint64_t");
     ZX_DEBUG_ASSERT(packet);
     packet->key = 0;
@@ -40,6 +41,8 @@ void Worker::MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg) {
     packet->status = ZX_OK;
     packet->user.u64[0] = op;
     packet->user.u64[1] = reinterpret_cast<uint64_t>(arg);
+    packet->user.u64[2] = offset;
+    packet->user.u64[3] = length;
 }
 
 zx_status_t Worker::Start(Device* device, const Volume& volume, zx::port&& port) {
@@ -98,44 +101,48 @@ zx_status_t Worker::Run() {
 
         // Dispatch block request
         block_op_t* block = reinterpret_cast<block_op_t*>(packet.user.u64[1]);
+        uint64_t offset = packet.user.u64[2];
+        uint64_t length = packet.user.u64[3];
         switch (block->command & BLOCK_OP_MASK) {
         case BLOCK_OP_WRITE:
-            device_->BlockForward(block, EncryptWrite(block));
+            rc = EncryptWrite(block, offset, length);
             break;
 
         case BLOCK_OP_READ:
-            device_->BlockComplete(block, DecryptRead(block));
+            rc = DecryptRead(block, offset, length);
             break;
 
         default:
-            device_->BlockComplete(block, ZX_ERR_NOT_SUPPORTED);
+            rc = ZX_ERR_NOT_SUPPORTED;
         }
+        device_->TransformComplete(block, rc);
     }
 }
 
-zx_status_t Worker::EncryptWrite(block_op_t* block) {
-    LOG_ENTRY_ARGS("block=%p", block);
+zx_status_t Worker::EncryptWrite(block_op_t* block, uint64_t offset, uint64_t length) {
+    LOG_ENTRY_ARGS("block=%p, offset=%" PRIu64 ", length=%" PRIu64, block, offset, length);
     zx_status_t rc;
 
     // Convert blocks to bytes
     extra_op_t* extra = BlockToExtra(block, device_->op_size());
-    uint32_t length;
-    uint64_t offset_dev, offset_vmo;
-    if (mul_overflow(block->rw.length, device_->block_size(), &length) ||
-        mul_overflow(block->rw.offset_dev, device_->block_size(), &offset_dev) ||
-        mul_overflow(extra->offset_vmo, device_->block_size(), &offset_vmo)) {
+    uint64_t len, off, offset_dev, offset_vmo;
+    if (mul_overflow(length, device_->block_size(), &len) ||
+        mul_overflow(offset, device_->block_size(), &off) ||
+        mul_overflow(block->rw.offset_dev + offset, device_->block_size(), &offset_dev) ||
+        mul_overflow(extra->offset_vmo + offset, device_->block_size(), &offset_vmo)) {
         zxlogf(ERROR,
-               "overflow; length=%" PRIu32 "; offset_dev=%" PRIu64 "; offset_vmo=%" PRIu64 "\n",
-               block->rw.length, block->rw.offset_dev, extra->offset_vmo);
+               "overflow; length=%" PRIu64 "; offset_dev=%" PRIu64 "; offset_vmo=%" PRIu64 "\n",
+               length, block->rw.offset_dev + offset, extra->offset_vmo + offset);
         return ZX_ERR_OUT_OF_RANGE;
     }
 
     // Copy and encrypt the plaintext
-    if ((rc = zx_vmo_read(extra->vmo, extra->data, offset_vmo, length)) != ZX_OK) {
+    uint8_t* data = extra->data + off;
+    if ((rc = zx_vmo_read(extra->vmo, data, offset_vmo, len)) != ZX_OK) {
         zxlogf(ERROR, "zx_vmo_read() failed: %s\n", zx_status_get_string(rc));
         return rc;
     }
-    if ((rc = encrypt_.Encrypt(extra->data, offset_dev, length, extra->data) != ZX_OK)) {
+    if ((rc = encrypt_.Encrypt(data, offset_dev, len, data)) != ZX_OK) {
         zxlogf(ERROR, "failed to encrypt: %s\n", zx_status_get_string(rc));
         return rc;
     }
@@ -143,19 +150,18 @@ zx_status_t Worker::EncryptWrite(block_op_t* block) {
     return ZX_OK;
 }
 
-zx_status_t Worker::DecryptRead(block_op_t* block) {
-    LOG_ENTRY_ARGS("block=%p", block);
+zx_status_t Worker::DecryptRead(block_op_t* block, uint64_t offset, uint64_t length) {
+    LOG_ENTRY_ARGS("block=%p, offset=%" PRIu64 ", length=%" PRIu64, block, offset, length);
     zx_status_t rc;
 
     // Convert blocks to bytes
-    uint32_t length;
-    uint64_t offset_dev, offset_vmo;
-    if (mul_overflow(block->rw.length, device_->block_size(), &length) ||
-        mul_overflow(block->rw.offset_dev, device_->block_size(), &offset_dev) ||
-        mul_overflow(block->rw.offset_vmo, device_->block_size(), &offset_vmo)) {
+    uint64_t len, offset_dev, offset_vmo;
+    if (mul_overflow(length, device_->block_size(), &len) ||
+        mul_overflow(block->rw.offset_dev + offset, device_->block_size(), &offset_dev) ||
+        mul_overflow(block->rw.offset_vmo + offset, device_->block_size(), &offset_vmo)) {
         zxlogf(ERROR,
-               "overflow; length=%" PRIu32 "; offset_dev=%" PRIu64 "; offset_vmo=%" PRIu64 "\n",
-               block->rw.length, block->rw.offset_dev, block->rw.offset_vmo);
+               "overflow; length=%" PRIu64 "; offset_dev=%" PRIu64 "; offset_vmo=%" PRIu64 "\n",
+               length, block->rw.offset_dev + offset, block->rw.offset_vmo + offset);
         return ZX_ERR_OUT_OF_RANGE;
     }
 
@@ -163,16 +169,16 @@ zx_status_t Worker::DecryptRead(block_op_t* block) {
     zx_handle_t root = zx_vmar_root_self();
     uintptr_t address;
     constexpr uint32_t flags = ZX_VM_PERM_READ | ZX_VM_PERM_WRITE;
-    if ((rc = zx_vmar_map(root, flags, 0, block->rw.vmo, offset_vmo, length, &address)) != ZX_OK) {
+    if ((rc = zx_vmar_map(root, flags, 0, block->rw.vmo, offset_vmo, len, &address)) != ZX_OK) {
         zxlogf(ERROR, "zx::vmar::root_self()->map() failed: %s\n", zx_status_get_string(rc));
         return rc;
     }
     auto cleanup =
-        fbl::MakeAutoCall([root, address, length]() { zx_vmar_unmap(root, address, length); });
+        fbl::MakeAutoCall([root, address, len]() { zx_vmar_unmap(root, address, len); });
 
     // Decrypt in place
     uint8_t* data = reinterpret_cast<uint8_t*>(address);
-    if ((rc = decrypt_.Decrypt(data, offset_dev, length, data)) != ZX_OK) {
+    if ((rc = decrypt_.Decrypt(data, offset_dev, len, data)) != ZX_OK) {
         zxlogf(ERROR, "failed to decrypt: %s\n", zx_status_get_string(rc));
         return rc;
     }
@@ -32,8 +32,10 @@ public:
     static constexpr uint64_t kBlockRequest = 0x1;
     static constexpr uint64_t kStopRequest = 0x2;
 
-    // Configure the given |packet| to be an |op| request, with an optional |arg|.
-    static void MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg = nullptr);
+    // Configure the given |packet| to be an |op| request, with an optional |arg|.  Block requests
+    // also give the |offset| and |length|, in blocks, of the piece of the request to transform.
+    static void MakeRequest(zx_port_packet_t* packet, uint64_t op, void* arg = nullptr,
+                            uint64_t offset = 0, uint64_t length = 0);
 
     // Starts the worker, which will service requests sent from the given |device| on the given
     // |port|.  Cryptographic operations will use the key material from the given |volume|.
@@ -52,11 +54,13 @@ private:
     zx_status_t Run();
 
     // Copies the plaintext data to be written to the write buffer location given in |block|'s extra
-    // information, and encrypts it before sending it to the parent device.
-    zx_status_t EncryptWrite(block_op_t* block);
+    // information, and encrypts it before sending it to the parent device.  Only the |length|
+    // blocks starting |offset| blocks into the request are transformed.
+    zx_status_t EncryptWrite(block_op_t* block, uint64_t offset, uint64_t length);
 
     // Maps the ciphertext data in |block|, and decrypts it in place before completing the block op.
-    zx_status_t DecryptRead(block_op_t* block);
+    // Only the |length| blocks starting |offset| blocks into the request are transformed.
+    zx_status_t DecryptRead(block_op_t* block, uint64_t offset, uint64_t length);
 
     // The cipher objects used to perform cryptographic.  See notes on "random access" in
     // crypto/cipher.h.
@@ -360,6 +360,10 @@ zx_handle_t AmlDWMacDevice::EthmacGetBti() {
     return bti_.get();
 }
 
+zx_status_t AmlDWMacDevice::EthmacQueueRx(ethmac_netbuf_t* netbuf) {
+    return ZX_ERR_NOT_SUPPORTED;
+}
+
 zx_status_t AmlDWMacDevice::MDIOWrite(uint32_t reg, uint32_t val) {
 
     dwmac_regs_->miidata = val;
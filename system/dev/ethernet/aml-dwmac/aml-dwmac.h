@@ -98,6 +98,8 @@ public:
     zx_status_t MDIOWrite(uint32_t reg, uint32_t val);
     zx_status_t MDIORead(uint32_t reg, uint32_t* val);
     zx_handle_t EthmacGetBti();
+    // Receive buffers are not supported, so always returns ZX_ERR_NOT_SUPPORTED.
+    zx_status_t EthmacQueueRx(ethmac_netbuf_t* netbuf);
 
 private:
     enum {
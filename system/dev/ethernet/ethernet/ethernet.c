@@ -30,12 +30,26 @@
 
 #define PAGE_MASK (PAGE_SIZE - 1)
 
-// This is used for signaling that eth_tx_thread() should exit.
+// This is used for signaling that eth_tx_thread() or eth_rx_thread() should exit.
 static const zx_signals_t kSignalFifoTerminate = ZX_USER_SIGNAL_0;
 
 // ensure that we will not exceed fifo capacity
 static_assert((FIFO_DEPTH * FIFO_ESIZE) <= 4096, "");
 
+// offloads are reported to clients as the ethmac reports them
+static_assert(ETH_OFFLOAD_TX_CSUM_IP == ETHMAC_OFFLOAD_TX_CSUM_IP, "");
+static_assert(ETH_OFFLOAD_TX_CSUM_L4 == ETHMAC_OFFLOAD_TX_CSUM_L4, "");
+static_assert(ETH_OFFLOAD_RX_CSUM == ETHMAC_OFFLOAD_RX_CSUM, "");
+static_assert(ETH_OFFLOAD_TSO == ETHMAC_OFFLOAD_TSO, "");
+static_assert(ETH_OFFLOAD_LRO == ETHMAC_OFFLOAD_LRO, "");
+#define ETH_OFFLOAD_ALL (ETH_OFFLOAD_TX_CSUM_IP | ETH_OFFLOAD_TX_CSUM_L4 | ETH_OFFLOAD_RX_CSUM | \
+                         ETH_OFFLOAD_TSO | ETH_OFFLOAD_LRO)
+
+// offloads done in software for ethmacs which cannot do them
+#define ETH_OFFLOAD_SW (ETH_OFFLOAD_TX_CSUM_IP | ETH_OFFLOAD_TX_CSUM_L4)
+
+#define ETH_FIFO_TX_OFFLOADS (ETH_FIFO_TX_CSUM_IP | ETH_FIFO_TX_CSUM_L4 | ETH_FIFO_TX_TSO)
+
 // ethernet device
 typedef struct ethdev0 {
     // shared state
@@ -55,6 +69,13 @@ typedef struct ethdev0 {
     ethmac_info_t info;
     uint32_t status;
     zx_device_t* zxdev;
+
+    // instance whose rx buffers are queued directly to the ethmac, if any
+    // (see ETHMAC_FEATURE_RX_QUEUE)
+    struct ethdev* rx_owner;
+
+    // whether ETHMAC_SETPARAM_LRO is set on the ethmac
+    bool lro;
 } ethdev0_t;
 
 typedef struct tx_info {
@@ -63,6 +84,12 @@ typedef struct tx_info {
     ethmac_netbuf_t netbuf;
 } tx_info_t;
 
+typedef struct rx_info {
+    struct ethdev* edev;
+    void* fifo_cookie;
+    ethmac_netbuf_t netbuf;
+} rx_info_t;
+
 // transmit thread has been created
 #define ETHDEV_TX_THREAD (1u)
 
@@ -84,12 +111,21 @@ typedef struct tx_info {
 // This client has requested multicast promisc mode
 #define ETHDEV_MULTICAST_PROMISC (0x40u)
 
+// receive thread has been created
+#define ETHDEV_RX_THREAD (0x80u)
+
 // indicates the device is busy although its lock is released
 #define ETHDEV0_BUSY (1u)
 
-// Number of empty fifo entries to read at a time
+// Number of empty fifo entries to read at a time, and of completed entries to write at a time
 #define FIFO_BATCH_SZ 32
 
+// Longest time a completed rx entry is held back to be written along with others.  This is checked
+// as later frames arrive, and a timer armed when the first entry is held back makes the tx thread
+// write the batch once the time is up, should the ethmac set ETHMAC_RX_OPT_MORE on the last frame
+// of a burst.
+#define RX_FLUSH_LATENCY ZX_USEC(100)
+
 // How many multicast addresses to remember before punting and turning on multicast-promiscuous
 // TODO(eventually): enable deleting addresses
 // If this value is changed, change the EthernetMulticastPromiscOnOverflow() test in
@@ -115,6 +151,14 @@ typedef struct ethdev {
     eth_fifo_entry_t rx_entries[FIFO_BATCH_SZ];
     size_t rx_entry_count;
 
+    // completed rx entries not yet written back to the rx fifo,
+    // and when the first of them was completed
+    eth_fifo_entry_t rx_done[FIFO_BATCH_SZ];
+    size_t rx_done_count;
+    zx_time_t rx_done_time;
+    // fires RX_FLUSH_LATENCY after |rx_done_time|, waking the tx thread
+    zx_handle_t rx_flush_timer;
+
     // io buffer
     zx_handle_t io_vmo;
     void* io_buf;
@@ -123,17 +167,29 @@ typedef struct ethdev {
     zx_handle_t pmt;
 
     tx_info_t all_tx_bufs[FIFO_DEPTH];
-    mtx_t lock;               // Protects free_tx_bufs
+    mtx_t lock;               // Protects free_tx_bufs, free_rx_bufs and rx_thread_stop
     list_node_t free_tx_bufs; // tx_info_t elements
 
-    // fifo thread
+    // rx buffers queued directly to the ethmac by the rx thread
+    rx_info_t all_rx_bufs[FIFO_DEPTH];
+    list_node_t free_rx_bufs; // rx_info_t elements
+    size_t free_rx_count;
+    cnd_t free_rx_cnd;        // Signalled when free_rx_bufs gains an element
+    bool rx_thread_stop;
+
+    // fifo threads
     thrd_t tx_thr;
+    thrd_t rx_thr;
 
     zx_device_t* zxdev;
 
     uint8_t multicast[MULTICAST_LIST_LIMIT][ETH_MAC_SIZE];
     uint32_t n_multicast;
 
+    // ETH_OFFLOAD_ flags enabled by the client, and its TSO segment size
+    uint32_t offloads;
+    uint16_t tso_mss;
+
     uint32_t fail_rx_read;
     uint32_t fail_rx_write;
     uint32_t fail_tx_write;
@@ -279,7 +335,263 @@ static ssize_t eth_config_multicast_locked(ethdev_t* edev, eth_multicast_config_
     }
 }
 
-static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t extra) {
+// Returns the ETH_OFFLOAD_ flags clients of |edev0| may enable.
+static uint32_t eth_offloads(const ethdev0_t* edev0) {
+    return (edev0->info.offloads & ETH_OFFLOAD_ALL) | ETH_OFFLOAD_SW;
+}
+
+// LRO changes the frames every client receives, so it is only set on the ethmac while every
+// running client has enabled it.
+static void eth_update_lro_locked(ethdev0_t* edev0) {
+    if (!(edev0->info.offloads & ETHMAC_OFFLOAD_LRO)) {
+        return;
+    }
+    bool lro = !list_is_empty(&edev0->list_active);
+    ethdev_t* edev;
+    list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
+        if (!(edev->offloads & ETH_OFFLOAD_LRO)) {
+            lro = false;
+        }
+    }
+    if (lro == edev0->lro) {
+        return;
+    }
+    zx_status_t status = edev0->mac.ops->set_param(edev0->mac.ctx, ETHMAC_SETPARAM_LRO, lro, NULL);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "eth: failed to %s lro: %d\n", lro ? "enable" : "disable", status);
+        return;
+    }
+    edev0->lro = lro;
+}
+
+static zx_status_t eth_set_offloads_locked(ethdev_t* edev, uint32_t offloads, uint16_t tso_mss) {
+    if (offloads & ~eth_offloads(edev->edev0)) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if ((offloads & ETH_OFFLOAD_TSO) && tso_mss == 0) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    edev->offloads = offloads;
+    edev->tso_mss = tso_mss;
+    eth_update_lro_locked(edev->edev0);
+    return ZX_OK;
+}
+
+static inline uint16_t eth_get16(const uint8_t* p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static inline void eth_put16(uint8_t* p, uint16_t val) {
+    p[0] = (uint8_t)(val >> 8);
+    p[1] = (uint8_t)val;
+}
+
+// Adds |len| bytes at |data| to the ones' complement sum |sum|, as 16-bit big-endian words.
+static uint32_t eth_csum_add(uint32_t sum, const uint8_t* data, size_t len) {
+    for (; len > 1; data += 2, len -= 2) {
+        sum += eth_get16(data);
+    }
+    if (len > 0) {
+        sum += (uint32_t)data[0] << 8;
+    }
+    return sum;
+}
+
+static uint16_t eth_csum_fold(uint32_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+#define ETHERTYPE_VLAN 0x8100
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_IPV6 0x86dd
+#define IP_PROTO_TCP 6
+#define IP_PROTO_UDP 17
+
+// Fills in the checksums of the frame at |data| which are requested by |flags|, for ethmacs which
+// cannot.  Handles TCP and UDP over IPv4 and IPv6, with an optional VLAN tag; IPv6 extension
+// headers and IPv4 fragments only get the IPv4 header checksum.  Anything else is left alone.
+static void eth_tx_csum(uint8_t* data, size_t len, uint16_t flags) {
+    size_t off = 2 * ETH_MAC_SIZE;
+    if (len < off + 2) {
+        return;
+    }
+    uint16_t type = eth_get16(data + off);
+    off += 2;
+    if (type == ETHERTYPE_VLAN) {
+        if (len < off + 4) {
+            return;
+        }
+        type = eth_get16(data + off + 2);
+        off += 4;
+    }
+
+    uint8_t* ip = data + off;
+    uint8_t proto;
+    size_t l4_off;
+    size_t l4_len;
+    uint32_t sum;
+    if (type == ETHERTYPE_IPV4) {
+        if (len < off + 20) {
+            return;
+        }
+        size_t ihl = (ip[0] & 0xfu) * 4;
+        size_t total = eth_get16(ip + 2);
+        if ((ip[0] >> 4) != 4 || ihl < 20 || total < ihl || len < off + total) {
+            return;
+        }
+        if (flags & ETH_FIFO_TX_CSUM_IP) {
+            eth_put16(ip + 10, 0);
+            eth_put16(ip + 10, eth_csum_fold(eth_csum_add(0, ip, ihl)));
+        }
+        if (eth_get16(ip + 6) & 0x3fff) {
+            // a fragment; the checksum covers the whole datagram
+            return;
+        }
+        proto = ip[9];
+        l4_off = off + ihl;
+        l4_len = total - ihl;
+        // pseudo-header: source and destination addresses, protocol and length
+        sum = eth_csum_add(0, ip + 12, 8);
+    } else if (type == ETHERTYPE_IPV6) {
+        if (len < off + 40) {
+            return;
+        }
+        proto = ip[6];
+        l4_off = off + 40;
+        l4_len = eth_get16(ip + 4);
+        if (len < l4_off + l4_len) {
+            return;
+        }
+        sum = eth_csum_add(0, ip + 8, 32);
+    } else {
+        return;
+    }
+    if (!(flags & ETH_FIFO_TX_CSUM_L4)) {
+        return;
+    }
+
+    size_t csum_off;
+    if (proto == IP_PROTO_TCP) {
+        csum_off = 16;
+    } else if (proto == IP_PROTO_UDP) {
+        csum_off = 6;
+    } else {
+        return;
+    }
+    if (l4_len < csum_off + 2) {
+        return;
+    }
+    uint8_t* l4 = data + l4_off;
+    sum += proto + (uint32_t)l4_len;
+    eth_put16(l4 + csum_off, 0);
+    uint16_t csum = eth_csum_fold(eth_csum_add(sum, l4, l4_len));
+    if (proto == IP_PROTO_UDP && csum == 0) {
+        // zero means "no checksum" for UDP
+        csum = 0xffff;
+    }
+    eth_put16(l4 + csum_off, csum);
+}
+
+// Sets up |netbuf| for the offloads requested by |e|, which the client has enabled.  Those the
+// ethmac can do are passed to it; checksums it cannot do are filled in here.
+static void eth_tx_offload(ethdev_t* edev, const eth_fifo_entry_t* e, ethmac_netbuf_t* netbuf) {
+    uint32_t hw = edev->edev0->info.offloads;
+    netbuf->flags = 0;
+    netbuf->mss = 0;
+    if (e->flags & ETH_FIFO_TX_TSO) {
+        // TSO is only enabled when the ethmac has it, and covers every checksum.
+        netbuf->flags = ETHMAC_TX_TSO;
+        netbuf->mss = edev->tso_mss;
+        return;
+    }
+    uint16_t sw = 0;
+    if (e->flags & ETH_FIFO_TX_CSUM_IP) {
+        if (hw & ETHMAC_OFFLOAD_TX_CSUM_IP) {
+            netbuf->flags |= ETHMAC_TX_CSUM_IP;
+        } else {
+            sw |= ETH_FIFO_TX_CSUM_IP;
+        }
+    }
+    if (e->flags & ETH_FIFO_TX_CSUM_L4) {
+        if (hw & ETHMAC_OFFLOAD_TX_CSUM_L4) {
+            netbuf->flags |= ETHMAC_TX_CSUM_L4;
+        } else {
+            sw |= ETH_FIFO_TX_CSUM_L4;
+        }
+    }
+    if (sw) {
+        eth_tx_csum(edev->io_buf + e->offset, e->length, sw);
+    }
+}
+
+static void eth_rx_flush_locked(ethdev_t* edev) {
+    size_t count = edev->rx_done_count;
+    edev->rx_done_count = 0;
+    if (edev->rx_fifo == ZX_HANDLE_INVALID) {
+        return;
+    }
+
+    zx_status_t status;
+    size_t actual;
+    status = zx_fifo_write(edev->rx_fifo, sizeof(edev->rx_done[0]), edev->rx_done, count, &actual);
+    if (status == ZX_ERR_SHOULD_WAIT || (status == ZX_OK && actual < count)) {
+        if ((edev->fail_rx_write++ % FAIL_REPORT_RATE) == 0) {
+            zxlogf(ERROR, "eth [%s]: no rx_fifo space available (%u times)\n",
+                   edev->name, edev->fail_rx_write);
+        }
+    } else if (status != ZX_OK) {
+        // Fatal, should force teardown
+        zxlogf(ERROR, "eth [%s]: rx_fifo write failed %d\n", edev->name, status);
+    }
+}
+
+// Queues |e|, if not NULL, to be written back to the rx fifo.  Completed entries are written
+// in batches: the batch is flushed once it is full, once the ethmac ends a burst of frames by
+// omitting ETHMAC_RX_OPT_MORE from |flags|, or once its oldest entry has waited RX_FLUSH_LATENCY.
+static void eth_rx_complete_locked(ethdev_t* edev, const eth_fifo_entry_t* e, uint32_t flags) {
+    if (e != NULL) {
+        if (edev->rx_done_count == 0 && (flags & ETHMAC_RX_OPT_MORE)) {
+            edev->rx_done_time = zx_clock_get_monotonic();
+            zx_timer_set(edev->rx_flush_timer, edev->rx_done_time + RX_FLUSH_LATENCY, 0);
+        }
+        edev->rx_done[edev->rx_done_count++] = *e;
+    }
+    if (edev->rx_done_count == 0) {
+        return;
+    }
+    if (!(flags & ETHMAC_RX_OPT_MORE) || edev->rx_done_count == countof(edev->rx_done) ||
+        zx_clock_get_monotonic() - edev->rx_done_time >= RX_FLUSH_LATENCY) {
+        eth_rx_flush_locked(edev);
+    }
+}
+
+// Writes back the rx entries held by eth_rx_complete_locked() if no later frame has done so by the
+// time |rx_flush_timer| fires.  Called from the tx thread.
+static void eth_rx_flush_timer(ethdev_t* edev) {
+    ethdev0_t* edev0 = edev->edev0;
+    // eth_kill_locked() joins the tx thread with the lock held, so try again shortly rather than
+    // waiting for it.
+    if (mtx_trylock(&edev0->lock) != thrd_success) {
+        zx_timer_set(edev->rx_flush_timer, zx_deadline_after(RX_FLUSH_LATENCY), 0);
+        return;
+    }
+    if (edev->rx_done_count == 0 || (edev->state & ETHDEV_DEAD)) {
+        zx_timer_cancel(edev->rx_flush_timer);
+    } else if (zx_clock_get_monotonic() - edev->rx_done_time >= RX_FLUSH_LATENCY) {
+        eth_rx_flush_locked(edev);
+        zx_timer_cancel(edev->rx_flush_timer);
+    } else {
+        // A later batch was held back after this one was written.
+        zx_timer_set(edev->rx_flush_timer, edev->rx_done_time + RX_FLUSH_LATENCY, 0);
+    }
+    mtx_unlock(&edev0->lock);
+}
+
+static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t extra,
+                          uint32_t flags) {
     zx_status_t status;
     size_t count;
 
@@ -296,6 +608,8 @@ static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t
                 // Fatal, should force teardown
                 zxlogf(ERROR, "eth [%s]: rx fifo read failed %d\n", edev->name, status);
             }
+            // The frame is dropped, but anything already completed may still need flushing.
+            eth_rx_complete_locked(edev, NULL, flags);
             return;
         }
         edev->rx_entry_count = count;
@@ -314,20 +628,12 @@ static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t
         memcpy(edev->io_buf + e->offset, data, len);
         e->length = len;
         e->flags = ETH_FIFO_RX_OK | extra;
-    }
-
-    if ((status = zx_fifo_write(edev->rx_fifo, sizeof(*e), e, 1, NULL)) < 0) {
-        if (status == ZX_ERR_SHOULD_WAIT) {
-            if ((edev->fail_rx_write++ % FAIL_REPORT_RATE) == 0) {
-                zxlogf(ERROR, "eth [%s]: no rx_fifo space available (%u times)\n",
-                       edev->name, edev->fail_rx_write);
-            }
-        } else {
-            // Fatal, should force teardown
-            zxlogf(ERROR, "eth [%s]: rx_fifo write failed %d\n", edev->name, status);
+        if ((flags & ETHMAC_RX_CSUM_OK) && (edev->offloads & ETH_OFFLOAD_RX_CSUM)) {
+            e->flags |= ETH_FIFO_RX_CSUM_OK;
         }
-        return;
     }
+
+    eth_rx_complete_locked(edev, e, flags);
 }
 
 static void eth0_status(void* cookie, uint32_t status) {
@@ -368,11 +674,67 @@ static void eth0_recv(void* cookie, void* data, size_t len, uint32_t flags) {
     ethdev_t* edev;
     mtx_lock(&edev0->lock);
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
-        eth_handle_rx(edev, data, len, 0);
+        eth_handle_rx(edev, data, len, 0, flags);
     }
     mtx_unlock(&edev0->lock);
 }
 
+// Borrows an RX buffer from the pool, waiting for one to be returned if none is available.
+// Returns NULL if the rx thread has been asked to stop.
+static rx_info_t* eth_get_rx_info(ethdev_t* edev) {
+    mtx_lock(&edev->lock);
+    while (edev->free_rx_count == 0 && !edev->rx_thread_stop) {
+        cnd_wait(&edev->free_rx_cnd, &edev->lock);
+    }
+    rx_info_t* rx_info = NULL;
+    if (!edev->rx_thread_stop) {
+        rx_info = list_remove_head_type(&edev->free_rx_bufs, rx_info_t, netbuf.node);
+        edev->free_rx_count--;
+    }
+    mtx_unlock(&edev->lock);
+    return rx_info;
+}
+
+// Returns an RX buffer to the pool
+static void eth_put_rx_info(ethdev_t* edev, rx_info_t* rx_info) {
+    mtx_lock(&edev->lock);
+    list_add_head(&edev->free_rx_bufs, &rx_info->netbuf.node);
+    edev->free_rx_count++;
+    cnd_signal(&edev->free_rx_cnd);
+    mtx_unlock(&edev->lock);
+}
+
+static void eth0_complete_rx(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t status,
+                             uint32_t flags) {
+    ethdev0_t* edev0 = cookie;
+    rx_info_t* rx_info = containerof(netbuf, rx_info_t, netbuf);
+    ethdev_t* owner = rx_info->edev;
+    eth_fifo_entry_t entry = {.offset = netbuf->data - owner->io_buf,
+                              .length = status == ZX_OK ? netbuf->len : 0,
+                              .flags = status == ZX_OK ? ETH_FIFO_RX_OK : ETH_FIFO_INVALID,
+                              .cookie = rx_info->fifo_cookie};
+
+    if (status == ZX_OK && (flags & ETHMAC_RX_CSUM_OK) && (owner->offloads & ETH_OFFLOAD_RX_CSUM)) {
+        entry.flags |= ETH_FIFO_RX_CSUM_OK;
+    }
+
+    mtx_lock(&edev0->lock);
+    if (status == ZX_OK) {
+        // Every other client gets a copy, as it would have from eth0_recv().  This has to happen
+        // before the buffer goes back to its owner, who may reuse it straight away.
+        ethdev_t* edev;
+        list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
+            if (edev != owner) {
+                eth_handle_rx(edev, netbuf->data, netbuf->len, 0, flags);
+            }
+        }
+    }
+    eth_rx_complete_locked(owner, &entry, flags);
+    mtx_unlock(&edev0->lock);
+
+    eth_put_rx_info(owner, rx_info);
+}
+
 // Borrows a TX buffer from the pool. Logs and returns NULL if none is available
 static tx_info_t* eth_get_tx_info(ethdev_t* edev) {
     mtx_lock(&edev->lock);
@@ -411,14 +773,15 @@ static ethmac_ifc_t ethmac_ifc = {
     .status = eth0_status,
     .recv = eth0_recv,
     .complete_tx = eth0_complete_tx,
+    .complete_rx = eth0_complete_rx,
 };
 
-static void eth_tx_echo(ethdev0_t* edev0, const void* data, size_t len) {
+static void eth_tx_echo(ethdev0_t* edev0, const void* data, size_t len, uint32_t flags) {
     ethdev_t* edev;
     mtx_lock(&edev0->lock);
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
         if (edev->state & ETHDEV_TX_LISTEN) {
-            eth_handle_rx(edev, data, len, ETH_FIFO_RX_TX);
+            eth_handle_rx(edev, data, len, ETH_FIFO_RX_TX, flags);
         }
     }
     mtx_unlock(&edev0->lock);
@@ -464,8 +827,20 @@ static int eth_send(ethdev_t* edev, eth_fifo_entry_t* entries, uint32_t count) {
     // will be written back to the fifo. The rest will be written later by
     // the eth0_complete_tx callback.
     uint32_t to_write = 0;
+    // The ETH_FIFO_TX_ offload flags the client may use
+    uint16_t tx_offloads = 0;
+    if (edev->offloads & ETH_OFFLOAD_TX_CSUM_IP) {
+        tx_offloads |= ETH_FIFO_TX_CSUM_IP;
+    }
+    if (edev->offloads & ETH_OFFLOAD_TX_CSUM_L4) {
+        tx_offloads |= ETH_FIFO_TX_CSUM_L4;
+    }
+    if (edev->offloads & ETH_OFFLOAD_TSO) {
+        tx_offloads |= ETH_FIFO_TX_TSO;
+    }
     for (eth_fifo_entry_t* e = entries; count > 0; e++) {
-        if ((e->offset > edev->io_size) || ((e->length > (edev->io_size - e->offset)))) {
+        if ((e->offset > edev->io_size) || ((e->length > (edev->io_size - e->offset))) ||
+            (e->flags & ETH_FIFO_TX_OFFLOADS & ~tx_offloads)) {
             e->flags = ETH_FIFO_INVALID;
             entries[to_write++] = *e;
         } else {
@@ -486,10 +861,12 @@ static int eth_send(ethdev_t* edev, eth_fifo_entry_t* entries, uint32_t count) {
                                        (e->offset & PAGE_MASK);
             }
             tx_info->netbuf.len = e->length;
+            eth_tx_offload(edev, e, &tx_info->netbuf);
             tx_info->fifo_cookie = e->cookie;
             status = edev0->mac.ops->queue_tx(edev0->mac.ctx, opts, &tx_info->netbuf);
             if (edev->state & ETHDEV_TX_LOOPBACK) {
-                eth_tx_echo(edev0, edev->io_buf + e->offset, e->length);
+                eth_tx_echo(edev0, edev->io_buf + e->offset, e->length,
+                            (opts & ETHMAC_TX_OPT_MORE) ? ETHMAC_RX_OPT_MORE : 0u);
             }
             if (status != ZX_ERR_SHOULD_WAIT) {
                 // Transmission completed. To avoid extra mutex locking/unlocking,
@@ -524,18 +901,21 @@ static int eth_tx_thread(void* arg) {
         if ((status = zx_fifo_read(edev->tx_fifo, sizeof(entries[0]), entries,
                                    countof(entries), &count)) < 0) {
             if (status == ZX_ERR_SHOULD_WAIT) {
-                zx_signals_t observed;
-                if ((status = zx_object_wait_one(edev->tx_fifo,
-                                                 ZX_FIFO_READABLE |
-                                                 ZX_FIFO_PEER_CLOSED |
-                                                 kSignalFifoTerminate,
-                                                 ZX_TIME_INFINITE,
-                                                 &observed)) < 0) {
+                zx_wait_item_t items[] = {
+                    {.handle = edev->tx_fifo,
+                     .waitfor = ZX_FIFO_READABLE | ZX_FIFO_PEER_CLOSED | kSignalFifoTerminate},
+                    {.handle = edev->rx_flush_timer, .waitfor = ZX_TIMER_SIGNALED},
+                };
+                if ((status = zx_object_wait_many(items, countof(items),
+                                                  ZX_TIME_INFINITE)) < 0) {
                     zxlogf(ERROR, "eth [%s]: tx_fifo: error waiting: %d\n", edev->name, status);
                     break;
                 }
-                if (observed & kSignalFifoTerminate)
+                if (items[0].pending & kSignalFifoTerminate)
                     break;
+                if (items[1].pending & ZX_TIMER_SIGNALED) {
+                    eth_rx_flush_timer(edev);
+                }
                 continue;
             } else {
                 zxlogf(ERROR, "eth [%s]: tx_fifo: cannot read: %d\n", edev->name, status);
@@ -545,12 +925,132 @@ static int eth_tx_thread(void* arg) {
         if (eth_send(edev, entries, count)) {
             break;
         }
+        // A steady stream of tx requests keeps this thread from waiting on the timer above.
+        if (zx_object_wait_one(edev->rx_flush_timer, ZX_TIMER_SIGNALED, 0, NULL) == ZX_OK) {
+            eth_rx_flush_timer(edev);
+        }
     }
 
     zxlogf(INFO, "eth [%s]: tx_thread: exit: %d\n", edev->name, status);
     return 0;
 }
 
+// Returns an rx entry which was never given to the ethmac straight back to the client.
+static void eth_rx_return_invalid(ethdev_t* edev, eth_fifo_entry_t* e) {
+    e->length = 0;
+    e->flags = ETH_FIFO_INVALID;
+    zx_status_t status = zx_fifo_write(edev->rx_fifo, sizeof(*e), e, 1, NULL);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "eth [%s]: rx_fifo write failed %d\n", edev->name, status);
+    }
+}
+
+// Queues the rx buffers of the ethdev which owns the ethmac's receive queue directly to the
+// ethmac, which fills them in place and returns them through eth0_complete_rx().
+static int eth_rx_thread(void* arg) {
+    ethdev_t* edev = (ethdev_t*)arg;
+    ethdev0_t* edev0 = edev->edev0;
+    eth_fifo_entry_t entries[FIFO_BATCH_SZ];
+    zx_status_t status = ZX_OK;
+    size_t count;
+
+    for (;;) {
+        // Wait for a free rx_info_t before taking entries from the client, so that entries are
+        // never read which cannot be queued.
+        rx_info_t* rx_info = eth_get_rx_info(edev);
+        if (rx_info == NULL) {
+            break;
+        }
+        mtx_lock(&edev->lock);
+        size_t avail = edev->free_rx_count + 1;
+        mtx_unlock(&edev->lock);
+        if (avail > countof(entries)) {
+            avail = countof(entries);
+        }
+
+        status = zx_fifo_read(edev->rx_fifo, sizeof(entries[0]), entries, avail, &count);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            eth_put_rx_info(edev, rx_info);
+            zx_signals_t observed;
+            if ((status = zx_object_wait_one(edev->rx_fifo,
+                                             ZX_FIFO_READABLE |
+                                             ZX_FIFO_PEER_CLOSED |
+                                             kSignalFifoTerminate,
+                                             ZX_TIME_INFINITE,
+                                             &observed)) < 0) {
+                zxlogf(ERROR, "eth [%s]: rx_fifo: error waiting: %d\n", edev->name, status);
+                break;
+            }
+            if (observed & kSignalFifoTerminate)
+                break;
+            continue;
+        } else if (status != ZX_OK) {
+            eth_put_rx_info(edev, rx_info);
+            zxlogf(ERROR, "eth [%s]: rx_fifo: cannot read: %d\n", edev->name, status);
+            break;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            eth_fifo_entry_t* e = &entries[i];
+            if ((e->offset >= edev->io_size) || (e->length > (edev->io_size - e->offset))) {
+                eth_rx_return_invalid(edev, e);
+                continue;
+            }
+            if (rx_info == NULL && (rx_info = eth_get_rx_info(edev)) == NULL) {
+                // Asked to stop with entries in hand; give them back.
+                eth_rx_return_invalid(edev, e);
+                continue;
+            }
+            rx_info->fifo_cookie = e->cookie;
+            rx_info->netbuf.data = edev->io_buf + e->offset;
+            if (edev0->info.features & ETHMAC_FEATURE_DMA) {
+                rx_info->netbuf.phys = edev->paddr_map[e->offset / PAGE_SIZE] +
+                                       (e->offset & PAGE_MASK);
+            }
+            rx_info->netbuf.len = e->length;
+            if ((status = edev0->mac.ops->queue_rx(edev0->mac.ctx, &rx_info->netbuf)) != ZX_OK) {
+                zxlogf(ERROR, "eth [%s]: rx: cannot queue buffer: %d\n", edev->name, status);
+                eth_put_rx_info(edev, rx_info);
+                eth_rx_return_invalid(edev, e);
+                mtx_lock(&edev->lock);
+                edev->rx_thread_stop = true;
+                mtx_unlock(&edev->lock);
+            }
+            rx_info = NULL;
+        }
+        if (rx_info != NULL) {
+            eth_put_rx_info(edev, rx_info);
+        }
+    }
+
+    zxlogf(INFO, "eth [%s]: rx_thread: exit: %d\n", edev->name, status);
+    return 0;
+}
+
+static zx_status_t eth_rx_thread_start(ethdev_t* edev) {
+    mtx_lock(&edev->lock);
+    edev->rx_thread_stop = false;
+    mtx_unlock(&edev->lock);
+    zx_object_signal(edev->rx_fifo, kSignalFifoTerminate, 0);
+    int r = thrd_create_with_name(&edev->rx_thr, eth_rx_thread, edev, "eth-rx-thread");
+    if (r != thrd_success) {
+        zxlogf(ERROR, "eth [%s]: failed to start rx thread: %d\n", edev->name, r);
+        return ZX_ERR_INTERNAL;
+    }
+    return ZX_OK;
+}
+
+static void eth_rx_thread_stop(ethdev_t* edev) {
+    mtx_lock(&edev->lock);
+    edev->rx_thread_stop = true;
+    cnd_signal(&edev->free_rx_cnd);
+    mtx_unlock(&edev->lock);
+    zx_object_signal(edev->rx_fifo, 0, kSignalFifoTerminate);
+    int ret;
+    thrd_join(edev->rx_thr, &ret);
+    zxlogf(TRACE, "eth [%s]: rx thread exited\n", edev->name);
+}
+
 static zx_status_t eth_get_fifos_locked(ethdev_t* edev, struct zircon_ethernet_Fifos* fifos) {
     zx_status_t status;
     if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->tx, &edev->tx_fifo)) < 0) {
@@ -703,6 +1203,14 @@ static zx_status_t eth_start_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
         edev->state |= ETHDEV_RUNNING;
         list_delete(&edev->node);
         list_add_tail(&edev0->list_active, &edev->node);
+        // If the ethmac can receive into our buffers and no one else is doing so already, let it.
+        // Otherwise frames are copied into them as they arrive.
+        if ((edev0->info.features & ETHMAC_FEATURE_RX_QUEUE) && edev0->rx_owner == NULL &&
+            eth_rx_thread_start(edev) == ZX_OK) {
+            edev->state |= ETHDEV_RX_THREAD;
+            edev0->rx_owner = edev;
+        }
+        eth_update_lro_locked(edev0);
         // TODO - After we get IGMP, don't automatically set multicast promisc true
         eth_set_multicast_promisc_locked(edev, true);
     } else {
@@ -727,17 +1235,36 @@ static zx_status_t eth_stop_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
         eth_set_promisc_locked(edev, false);
         eth_set_multicast_promisc_locked(edev, false);
         eth_rebuild_multicast_filter_locked(edev);
-        if (list_is_empty(&edev0->list_active)) {
-            if (!(edev->state & ETHDEV_DEAD)) {
-                // Release the lock to allow other device operations in callback routine.
-                // Re-acquire lock afterwards. Set busy to prevent problems with other ioctls.
-                edev0->state |= ETHDEV0_BUSY;
-                mtx_unlock(&edev0->lock);
-                edev0->mac.ops->stop(edev0->mac.ctx);
-                mtx_lock(&edev0->lock);
-                edev0->state &= ~ETHDEV0_BUSY;
+        eth_update_lro_locked(edev0);
+        // The ethmac must be stopped once the last client stops, and also when the client
+        // whose buffers are queued to it stops, since that is how it returns them.
+        bool idle = list_is_empty(&edev0->list_active);
+        bool rx_owner = edev0->rx_owner == edev;
+        if ((idle || rx_owner) && !(edev->state & ETHDEV_DEAD)) {
+            // Give up the receive queue before unlocking, so that eth0_unbind() leaves it alone.
+            bool rx_thread = edev->state & ETHDEV_RX_THREAD;
+            edev->state &= ~ETHDEV_RX_THREAD;
+            if (rx_owner) {
+                edev0->rx_owner = NULL;
             }
+            // Release the lock to allow other device operations in callback routine.
+            // Re-acquire lock afterwards. Set busy to prevent problems with other ioctls.
+            edev0->state |= ETHDEV0_BUSY;
+            mtx_unlock(&edev0->lock);
+            if (rx_thread) {
+                eth_rx_thread_stop(edev);
+            }
+            edev0->mac.ops->stop(edev0->mac.ctx);
+            if (!idle) {
+                zx_status_t status = edev0->mac.ops->start(edev0->mac.ctx, &ethmac_ifc, edev0);
+                if (status != ZX_OK) {
+                    zxlogf(ERROR, "eth [%s]: failed to restart mac: %d\n", edev->name, status);
+                }
+            }
+            mtx_lock(&edev0->lock);
+            edev0->state &= ~ETHDEV0_BUSY;
         }
+        eth_rx_flush_locked(edev);
     }
 
     return ZX_OK;
@@ -804,6 +1331,7 @@ static zx_status_t eth_ioctl(void* ctx, uint32_t op,
                 info->features |= ETH_FEATURE_SYNTH;
             }
             info->mtu = edev->edev0->info.mtu;
+            info->offloads = eth_offloads(edev->edev0);
             *out_actual = sizeof(*info);
             status = ZX_OK;
         }
@@ -847,6 +1375,15 @@ static zx_status_t eth_ioctl(void* ctx, uint32_t op,
         }
         status = eth_config_multicast_locked(edev, (eth_multicast_config_t*)in_buf);
         break;
+    case IOCTL_ETHERNET_SET_OFFLOADS: {
+        if (in_len != sizeof(eth_offload_config_t) || in_buf == NULL) {
+            status = ZX_ERR_INVALID_ARGS;
+            goto done;
+        }
+        const eth_offload_config_t* config = in_buf;
+        status = eth_set_offloads_locked(edev, config->offloads, config->tso_mss);
+        break;
+    }
     default:
         // TODO: consider if we want this under the edev0->lock or not
         status = device_ioctl(edev->edev0->macdev, op, in_buf, in_len, out_buf, out_len, out_actual);
@@ -928,6 +1465,17 @@ static zx_status_t fidl_SetPromisc_locked(void* ctx, bool enabled, fidl_txn_t* t
     return REPLY(SetPromiscuousMode)(txn, eth_set_promisc_locked(edev, enabled));
 }
 
+static zx_status_t fidl_GetOffloads_locked(void* ctx, fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    return REPLY(GetOffloads)(txn, eth_offloads(edev->edev0));
+}
+
+static zx_status_t fidl_SetOffloads_locked(void* ctx, uint32_t offloads, uint16_t tso_mss,
+                                           fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    return REPLY(SetOffloads)(txn, eth_set_offloads_locked(edev, offloads, tso_mss));
+}
+
 #undef REPLY
 
 zircon_ethernet_Device_ops_t fidl_ops = {
@@ -941,6 +1489,8 @@ zircon_ethernet_Device_ops_t fidl_ops = {
     .SetClientName = fidl_SetClientName_locked,
     .GetStatus = fidl_GetStatus_locked,
     .SetPromiscuousMode = fidl_SetPromisc_locked,
+    .GetOffloads = fidl_GetOffloads_locked,
+    .SetOffloads = fidl_SetOffloads_locked,
 };
 
 static zx_status_t eth_message(void* ctx, fidl_msg_t* msg, fidl_txn_t* txn) {
@@ -966,6 +1516,13 @@ static void eth_kill_locked(ethdev_t* edev) {
     // make sure any future ioctls or other ops will fail
     edev->state |= ETHDEV_DEAD;
 
+    // The rx thread must be gone, and the ethmac must have returned our rx buffers, before the
+    // fifos and io buffer are released.  eth_stop_locked() and eth0_unbind() see to both, since
+    // they have to drop the lock to do so.
+    ZX_DEBUG_ASSERT(!(edev->state & ETHDEV_RX_THREAD));
+    ZX_DEBUG_ASSERT(edev->edev0->rx_owner != edev);
+    edev->rx_done_count = 0;
+
     // try to convince clients to close us
     if (edev->rx_fifo) {
         zx_handle_close(edev->rx_fifo);
@@ -1013,6 +1570,7 @@ static void eth_release(void* ctx) {
     ethdev_t* edev = ctx;
     if (edev) {
         free(edev->paddr_map);
+        zx_handle_close(edev->rx_flush_timer);
     }
     free(edev);
 }
@@ -1051,7 +1609,20 @@ static zx_status_t eth0_open(void* ctx, zx_device_t** out, uint32_t flags) {
         edev->all_tx_bufs[ndx].edev = edev;
         list_add_tail(&edev->free_tx_bufs, &edev->all_tx_bufs[ndx].netbuf.node);
     }
+    list_initialize(&edev->free_rx_bufs);
+    for (size_t ndx = 0; ndx < FIFO_DEPTH; ndx++) {
+        edev->all_rx_bufs[ndx].edev = edev;
+        list_add_tail(&edev->free_rx_bufs, &edev->all_rx_bufs[ndx].netbuf.node);
+    }
+    edev->free_rx_count = FIFO_DEPTH;
     mtx_init(&edev->lock, mtx_plain);
+    cnd_init(&edev->free_rx_cnd);
+
+    zx_status_t status;
+    if ((status = zx_timer_create(0, ZX_CLOCK_MONOTONIC, &edev->rx_flush_timer)) != ZX_OK) {
+        free(edev);
+        return status;
+    }
 
     device_add_args_t args = {
         .version = DEVICE_ADD_ARGS_VERSION,
@@ -1062,8 +1633,8 @@ static zx_status_t eth0_open(void* ctx, zx_device_t** out, uint32_t flags) {
         .flags = DEVICE_ADD_INSTANCE,
     };
 
-    zx_status_t status;
     if ((status = device_add(edev0->zxdev, &args, &edev->zxdev)) < 0) {
+        zx_handle_close(edev->rx_flush_timer);
         free(edev);
         return status;
     }
@@ -1081,6 +1652,24 @@ static void eth0_unbind(void* ctx) {
 
     mtx_lock(&edev0->lock);
 
+    // Take back the rx buffers queued to the ethmac before tearing down the instance which owns
+    // them.  Both the rx thread and the ethmac may be waiting in eth0_complete_rx() for the lock,
+    // so it is released meanwhile.
+    ethdev_t* rx_owner = edev0->rx_owner;
+    if (rx_owner != NULL) {
+        edev0->rx_owner = NULL;
+        bool rx_thread = rx_owner->state & ETHDEV_RX_THREAD;
+        rx_owner->state &= ~ETHDEV_RX_THREAD;
+        edev0->state |= ETHDEV0_BUSY;
+        mtx_unlock(&edev0->lock);
+        if (rx_thread) {
+            eth_rx_thread_stop(rx_owner);
+        }
+        edev0->mac.ops->stop(edev0->mac.ctx);
+        mtx_lock(&edev0->lock);
+        edev0->state &= ~ETHDEV0_BUSY;
+    }
+
     // tear down shared memory, fifos, and threads
     // to encourage any open instances to close
     ethdev_t* edev;
@@ -1143,6 +1732,14 @@ static zx_status_t eth_bind(void* ctx, zx_device_t* dev) {
         goto fail;
     }
 
+    if ((edev0->info.features & ETHMAC_FEATURE_RX_QUEUE) &&
+        (ops->queue_rx == NULL)) {
+        zxlogf(ERROR, "eth: bind: device '%s': does not implement ops->queue_rx()\n",
+               device_get_name(dev));
+        status = ZX_ERR_NOT_SUPPORTED;
+        goto fail;
+    }
+
     mtx_init(&edev0->lock, mtx_plain);
     list_initialize(&edev0->list_active);
     list_initialize(&edev0->list_idle);
@@ -81,6 +81,9 @@ int tap_device_thread(void* arg) {
 
 #define TAP_SHUTDOWN ZX_USER_SIGNAL_7
 
+// Most frames read from the socket at a time, which bounds how long lock_ is held by Recv().
+static constexpr size_t kRecvBatch = 64;
+
 TapDevice::TapDevice(zx_device_t* device, const ethertap_ioctl_config* config, zx::socket data)
   : ddk::Device<TapDevice, ddk::Unbindable>(device),
     options_(config->options),
@@ -89,6 +92,17 @@ TapDevice::TapDevice(zx_device_t* device, const ethertap_ioctl_config* config, z
     data_(fbl::move(data)) {
     ZX_DEBUG_ASSERT(data_.is_valid());
     memcpy(mac_, config->mac, 6);
+    if (options_ & ETHERTAP_OPT_RX_QUEUE) {
+        features_ |= ETHMAC_FEATURE_RX_QUEUE;
+    }
+    if (options_ & ETHERTAP_OPT_OFFLOADS) {
+        offloads_ = ETHMAC_OFFLOAD_TX_CSUM_IP | ETHMAC_OFFLOAD_TX_CSUM_L4 |
+                    ETHMAC_OFFLOAD_RX_CSUM | ETHMAC_OFFLOAD_TSO | ETHMAC_OFFLOAD_LRO;
+    }
+    list_initialize(&rx_queue_);
+    for (auto& buf : rx_bufs_) {
+        buf.reset(new uint8_t[mtu_]);
+    }
 
     int ret = thrd_create_with_name(&thread_, tap_device_thread, reinterpret_cast<void*>(this),
                                     "ethertap-thread");
@@ -114,6 +128,7 @@ zx_status_t TapDevice::EthmacQuery(uint32_t options, ethmac_info_t* info) {
     memset(info, 0, sizeof(*info));
     info->features = features_;
     info->mtu = mtu_;
+    info->offloads = offloads_;
     memcpy(info->mac, mac_, 6);
     return ZX_OK;
 }
@@ -121,6 +136,10 @@ zx_status_t TapDevice::EthmacQuery(uint32_t options, ethmac_info_t* info) {
 void TapDevice::EthmacStop() {
     ethertap_trace("EthmacStop\n");
     fbl::AutoLock lock(&lock_);
+    ethmac_netbuf_t* netbuf;
+    while ((netbuf = list_remove_head_type(&rx_queue_, ethmac_netbuf_t, node)) != nullptr) {
+        ethmac_proxy_->CompleteRx(netbuf, ZX_ERR_CANCELED, 0);
+    }
     ethmac_proxy_.reset();
 }
 
@@ -145,9 +164,24 @@ zx_status_t TapDevice::EthmacQueueTx(uint32_t options, ethmac_netbuf_t* netbuf)
     auto header = reinterpret_cast<ethertap_socket_header*>(temp_buf);
     uint8_t* data = temp_buf + sizeof(ethertap_socket_header_t);
     size_t length = netbuf->len;
-    ZX_DEBUG_ASSERT(length <= mtu_);
+    ZX_DEBUG_ASSERT(length <= mtu_ || (netbuf->flags & ETHMAC_TX_TSO));
+    if (length > ETHERTAP_MAX_MTU) {
+        // An unsegmented TSO packet, too large to pass through the socket.
+        return ZX_ERR_INVALID_ARGS;
+    }
     memcpy(data, netbuf->data, length);
     header->type = ETHERTAP_MSG_PACKET;
+    uint32_t info = 0;
+    if (netbuf->flags & ETHMAC_TX_CSUM_IP) {
+        info |= ETHERTAP_PACKET_CSUM_IP;
+    }
+    if (netbuf->flags & ETHMAC_TX_CSUM_L4) {
+        info |= ETHERTAP_PACKET_CSUM_L4;
+    }
+    if (netbuf->flags & ETHMAC_TX_TSO) {
+        info |= ETHERTAP_PACKET_TSO | static_cast<uint32_t>(netbuf->mss) << 16;
+    }
+    header->info = static_cast<int32_t>(info);
 
     if (unlikely(options_ & ETHERTAP_OPT_TRACE_PACKETS)) {
         ethertap_trace("sending %zu bytes\n", length);
@@ -164,9 +198,14 @@ zx_status_t TapDevice::EthmacQueueTx(uint32_t options, ethmac_netbuf_t* netbuf)
 
 zx_status_t TapDevice::EthmacSetParam(uint32_t param, int32_t value, void* data) {
     fbl::AutoLock lock(&lock_);
-    if (!(options_ & ETHERTAP_OPT_REPORT_PARAM) || dead_) {
+    if (dead_) {
         return ZX_ERR_NOT_SUPPORTED;
     }
+    if (!(options_ & ETHERTAP_OPT_REPORT_PARAM)) {
+        // LRO is accepted, though never done, when it has been advertised.
+        bool lro = param == ETHMAC_SETPARAM_LRO && (offloads_ & ETHMAC_OFFLOAD_LRO);
+        return lro ? ZX_OK : ZX_ERR_NOT_SUPPORTED;
+    }
 
     struct {
         ethertap_socket_header_t header;
@@ -211,10 +250,26 @@ zx_handle_t TapDevice::EthmacGetBti() {
     return ZX_HANDLE_INVALID;
 }
 
+zx_status_t TapDevice::EthmacQueueRx(ethmac_netbuf_t* netbuf) {
+    fbl::AutoLock lock(&lock_);
+    if (!(features_ & ETHMAC_FEATURE_RX_QUEUE)) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (dead_ || ethmac_proxy_ == nullptr) {
+        return ZX_ERR_BAD_STATE;
+    }
+    // Datagrams are truncated to the buffer they are read into, so only take buffers which can
+    // hold any frame.
+    if (netbuf->len < mtu_) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+    list_add_tail(&rx_queue_, &netbuf->node);
+    return ZX_OK;
+}
+
 int TapDevice::Thread() {
     ethertap_trace("starting main thread\n");
     zx_signals_t pending;
-    fbl::unique_ptr<uint8_t[]> buf(new uint8_t[mtu_]);
 
     zx_status_t status = ZX_OK;
     const zx_signals_t wait = ZX_SOCKET_READABLE | ZX_SOCKET_PEER_CLOSED | ETHERTAP_SIGNAL_ONLINE
@@ -234,7 +289,7 @@ int TapDevice::Thread() {
         }
 
         if (pending & ZX_SOCKET_READABLE) {
-            status = Recv(buf.get(), mtu_);
+            status = Recv();
             if (status != ZX_OK) {
                 break;
             }
@@ -304,23 +359,69 @@ zx_status_t TapDevice::UpdateLinkStatus(zx_signals_t observed) {
     return ZX_OK;
 }
 
-zx_status_t TapDevice::Recv(uint8_t* buffer, uint32_t capacity) {
-    size_t actual = 0;
-    zx_status_t status = data_.read(0u, buffer, capacity, &actual);
+// Reads and delivers the frames waiting on the socket.  Each frame is read before the previous one
+// is delivered, so that all but the last can be marked ETHMAC_RX_OPT_MORE.
+zx_status_t TapDevice::Recv() {
+    fbl::AutoLock lock(&lock_);
+    zx_status_t status = ZX_OK;
+    Frame prev = {};
+    bool have_prev = false;
+    for (size_t i = 0; i < kRecvBatch; ++i) {
+        Frame frame;
+        if ((status = ReadFrameLocked(rx_bufs_[i % 2].get(), &frame)) != ZX_OK) {
+            break;
+        }
+        if (have_prev) {
+            DeliverFrameLocked(prev, ETHMAC_RX_OPT_MORE);
+        }
+        prev = frame;
+        have_prev = true;
+    }
+    if (have_prev) {
+        DeliverFrameLocked(prev, 0u);
+    }
+
+    if (status == ZX_ERR_SHOULD_WAIT) {
+        return ZX_OK;
+    }
     if (status != ZX_OK) {
         zxlogf(ERROR, "ethertap: error reading data: %d\n", status);
+    }
+    return status;
+}
+
+zx_status_t TapDevice::ReadFrameLocked(uint8_t* buf, Frame* out) {
+    ethmac_netbuf_t* netbuf = list_peek_head_type(&rx_queue_, ethmac_netbuf_t, node);
+    uint8_t* data = netbuf != nullptr ? static_cast<uint8_t*>(netbuf->data) : buf;
+    size_t actual = 0;
+    zx_status_t status = data_.read(0u, data, mtu_, &actual);
+    if (status != ZX_OK) {
         return status;
     }
+    if (netbuf != nullptr) {
+        list_delete(&netbuf->node);
+    }
+    out->netbuf = netbuf;
+    out->data = data;
+    out->len = actual;
+    return ZX_OK;
+}
 
-    fbl::AutoLock lock(&lock_);
+void TapDevice::DeliverFrameLocked(const Frame& frame, uint32_t flags) {
+    if (offloads_ & ETHMAC_OFFLOAD_RX_CSUM) {
+        flags |= ETHMAC_RX_CSUM_OK;
+    }
     if (unlikely(options_ & ETHERTAP_OPT_TRACE_PACKETS)) {
-        ethertap_trace("received %zu bytes\n", actual);
-        hexdump8_ex(buffer, actual, 0);
+        ethertap_trace("received %zu bytes\n", frame.len);
+        hexdump8_ex(frame.data, frame.len, 0);
     }
-    if (ethmac_proxy_ != nullptr) {
-        ethmac_proxy_->Recv(buffer, actual, 0u);
+    if (frame.netbuf != nullptr) {
+        // Netbufs are only queued while started, and are all returned by EthmacStop().
+        frame.netbuf->len = static_cast<uint16_t>(frame.len);
+        ethmac_proxy_->CompleteRx(frame.netbuf, ZX_OK, flags);
+    } else if (ethmac_proxy_ != nullptr) {
+        ethmac_proxy_->Recv(frame.data, frame.len, flags);
     }
-    return ZX_OK;
 }
 
 }  // namespace eth
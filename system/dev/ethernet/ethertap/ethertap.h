@@ -12,6 +12,7 @@
 #include <zircon/compiler.h>
 #include <zircon/types.h>
 #include <zircon/device/ethertap.h>
+#include <zircon/listnode.h>
 #include <lib/zx/socket.h>
 #include <fbl/mutex.h>
 #include <fbl/unique_ptr.h>
@@ -43,11 +44,22 @@ class TapDevice : public ddk::Device<TapDevice, ddk::Unbindable>,
     zx_status_t EthmacSetParam(uint32_t param, int32_t value, void* data);
     // No DMA capability, so return invalid handle for get_bti
     zx_handle_t EthmacGetBti();
+    zx_status_t EthmacQueueRx(ethmac_netbuf_t* netbuf);
     int Thread();
 
   private:
+    // A frame read from the socket, either into a netbuf queued by EthmacQueueRx or into one of
+    // |rx_bufs_|.
+    struct Frame {
+        ethmac_netbuf_t* netbuf;
+        uint8_t* data;
+        size_t len;
+    };
+
     zx_status_t UpdateLinkStatus(zx_signals_t observed);
-    zx_status_t Recv(uint8_t* buffer, uint32_t capacity);
+    zx_status_t Recv();
+    zx_status_t ReadFrameLocked(uint8_t* buf, Frame* out) __TA_REQUIRES(lock_);
+    void DeliverFrameLocked(const Frame& frame, uint32_t flags) __TA_REQUIRES(lock_);
 
     // ethertap options
     uint32_t options_ = 0;
@@ -55,15 +67,21 @@ class TapDevice : public ddk::Device<TapDevice, ddk::Unbindable>,
     // ethermac fields
     uint32_t features_ = 0;
     uint32_t mtu_ = 0;
+    uint32_t offloads_ = 0;
     uint8_t mac_[6] = {};
 
     fbl::Mutex lock_;
     bool dead_ = false;
     fbl::unique_ptr<ddk::EthmacIfcProxy> ethmac_proxy_ __TA_GUARDED(lock_);
+    // Netbufs passed to EthmacQueueRx, in the order they are to be filled.
+    list_node_t rx_queue_ __TA_GUARDED(lock_);
 
     // Only accessed from Thread, so not locked.
     bool online_ = false;
     zx::socket data_;
+    // Frames are read one ahead of the one being delivered, so two buffers are needed to receive
+    // them into when no netbuf is queued.
+    fbl::unique_ptr<uint8_t[]> rx_bufs_[2];
 
     thrd_t thread_;
 };
@@ -27,12 +27,16 @@ zx_status_t usb_request_alloc(usb_request_t** out, zx_handle_t bti_handle, uint6
                               uint8_t ep_address);
 
 // usb_request_alloc_vmo() creates a new usb request with the given VMO.
+// The VMO is only mapped if the request's data is accessed with usb_request_copyfrom(),
+// usb_request_copyto() or usb_request_mmap(), so a controller can transfer directly to and
+// from the VMO's pages without it being mapped into the driver at all.
 zx_status_t usb_request_alloc_vmo(usb_request_t** out, zx_handle_t bti_handle,
                                   zx_handle_t vmo_handle, uint64_t vmo_offset, uint64_t length,
                                   uint8_t ep_address);
 
 // usb_request_init() initializes the statically allocated usb request with the given VMO.
 // This will free any resources allocated by the usb request but not the usb request itself.
+// As with usb_request_alloc_vmo(), the VMO is only mapped when its data is accessed.
 zx_status_t usb_request_init(usb_request_t* req, zx_handle_t bti_handle, zx_handle_t vmo_handle,
                              uint64_t vmo_offset, uint64_t length, uint8_t ep_address);
 
@@ -59,7 +63,8 @@ zx_status_t usb_request_cache_flush(usb_request_t* req, zx_off_t offset, size_t
 // in the request's buffer
 zx_status_t usb_request_cache_flush_invalidate(usb_request_t* req, zx_off_t offset, size_t length);
 
-// Looks up the physical pages backing this request's vm object.
+// Looks up the physical pages backing this request's vm object, from the page holding the
+// request's offset to the end of its transfer, and pins them until the request is released.
 zx_status_t usb_request_physmap(usb_request_t* req);
 
 // usb_request_release() frees the message data -- should be called only by the entity that allocated it
@@ -94,6 +99,15 @@ void usb_request_pool_add(usb_request_pool_t* pool, usb_request_t* req);
 // The request is not re-initialized in any way and should be set accordingly by the user.
 usb_request_t* usb_request_pool_get(usb_request_pool_t* pool, size_t length);
 
+// usb_request_pool_alloc() returns a request from the pool with a buffer of data_size
+// bytes, or allocates a new one.  New requests are pinned as they are allocated, so that
+// requests from the pool are ready for DMA without being pinned when they are queued.
+// The request's header.length and header.ep_address are set; other fields are left as
+// they were, as with usb_request_pool_get().  Return it with usb_request_pool_add().
+zx_status_t usb_request_pool_alloc(usb_request_pool_t* pool, usb_request_t** out,
+                                   zx_handle_t bti_handle, uint64_t data_size,
+                                   uint8_t ep_address);
+
 // releases all usb requests stored in the pool.
 void usb_request_pool_release(usb_request_pool_t* pool);
 
@@ -27,6 +27,25 @@ static inline void* req_buffer_virt(usb_request_t* req) {
     return (void*)(((uintptr_t)req->virt) + req->offset);
 }
 
+// Maps the request's vm object, if it is not mapped already.  Requests for a client's
+// VMO are only mapped once the CPU needs to touch their data, so that transfers which go
+// straight between the VMO's pages and the device need no mapping at all.
+static zx_status_t req_map(usb_request_t* req) {
+    if (req->virt != NULL || req->vmo_handle == ZX_HANDLE_INVALID) {
+        return ZX_OK;
+    }
+    //TODO(ravoorir): Do not map the entire vmo. Map only what is needed.
+    zx_vaddr_t mapped_addr;
+    zx_status_t status = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                                     0, req->vmo_handle, 0, req->size, &mapped_addr);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "usb_request: zx_vmar_map failed %d size: %zu\n", status, req->size);
+        return status;
+    }
+    req->virt = (void *)mapped_addr;
+    return ZX_OK;
+}
+
 // Frees any resources allocated by the usb request, but not the usb request itself.
 static void usb_request_release_static(usb_request_t* req) {
     if (req->vmo_handle != ZX_HANDLE_INVALID) {
@@ -36,7 +55,10 @@ static void usb_request_release_static(usb_request_t* req) {
             req->pmt = ZX_HANDLE_INVALID;
         }
 
-        zx_vmar_unmap(zx_vmar_root_self(), (uintptr_t)req->virt, req->size);
+        if (req->virt != NULL) {
+            zx_vmar_unmap(zx_vmar_root_self(), (uintptr_t)req->virt, req->size);
+            req->virt = NULL;
+        }
         zx_handle_close(req->vmo_handle);
         req->vmo_handle = ZX_HANDLE_INVALID;
     }
@@ -117,18 +139,8 @@ zx_status_t usb_request_alloc_vmo(usb_request_t** out, zx_handle_t bti_handle,
         return status;
     }
 
-    zx_vaddr_t mapped_addr;
-    status = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
-                         0, dup_handle, 0, size, &mapped_addr);
-    if (status != ZX_OK) {
-        zxlogf(ERROR, "usb_request_alloc_vmo: zx_vmar_map failed %d size: %zu\n", status, size);
-        zx_handle_close(dup_handle);
-        free(req);
-        return status;
-    }
-
     req->vmo_handle = dup_handle;
-    req->virt = (void *)mapped_addr;
+    req->virt = NULL;
     req->offset = vmo_offset;
     req->size = size;
     req->bti_handle = bti_handle;
@@ -162,18 +174,8 @@ zx_status_t usb_request_init(usb_request_t* req, zx_handle_t bti_handle, zx_hand
         return status;
     }
 
-    //TODO(ravoorir): Do not map the entire vmo. Map only what is needed.
-    zx_vaddr_t mapped_addr;
-    status = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
-                         0, dup_handle, 0, size, &mapped_addr);
-    if (status != ZX_OK) {
-        zxlogf(ERROR, "usb_request_init: zx_vmar_map failed %d size: %zu\n", status, size);
-        zx_handle_close(dup_handle);
-        return status;
-    }
-
     req->vmo_handle = dup_handle;
-    req->virt = (void *)mapped_addr;
+    req->virt = NULL;
     req->offset = vmo_offset;
     req->size = size;
     req->bti_handle = bti_handle;
@@ -187,18 +189,30 @@ zx_status_t usb_request_init(usb_request_t* req, zx_handle_t bti_handle, zx_hand
 }
 
 ssize_t usb_request_copyfrom(usb_request_t* req, void* data, size_t length, size_t offset) {
+    zx_status_t status = req_map(req);
+    if (status != ZX_OK) {
+        return status;
+    }
     length = MIN(req_buffer_size(req, offset), length);
     memcpy(data, req_buffer_virt(req) + offset, length);
     return length;
 }
 
 ssize_t usb_request_copyto(usb_request_t* req, const void* data, size_t length, size_t offset) {
+    zx_status_t status = req_map(req);
+    if (status != ZX_OK) {
+        return status;
+    }
     length = MIN(req_buffer_size(req, offset), length);
     memcpy(req_buffer_virt(req) + offset, data, length);
     return length;
 }
 
 zx_status_t usb_request_mmap(usb_request_t* req, void** data) {
+    zx_status_t status = req_map(req);
+    if (status != ZX_OK) {
+        return status;
+    }
     *data = req_buffer_virt(req);
     // TODO(jocelyndang): modify this once we start passing usb requests across process boundaries.
     return ZX_OK;
@@ -216,6 +230,10 @@ zx_status_t usb_request_cache_flush(usb_request_t* req, zx_off_t offset, size_t
     if (offset + length < offset || offset + length > req->size) {
         return ZX_ERR_OUT_OF_RANGE;
     }
+    if (req->virt == NULL) {
+        // Rather than mapping the VMO just to flush it.
+        return usb_request_cacheop(req, USB_REQUEST_CACHE_CLEAN, offset, length);
+    }
     return zx_cache_flush(req_buffer_virt(req) + offset, length, ZX_CACHE_FLUSH_DATA);
 }
 
@@ -223,33 +241,44 @@ zx_status_t usb_request_cache_flush_invalidate(usb_request_t* req, zx_off_t offs
     if (offset + length < offset || offset + length > req->size) {
         return ZX_ERR_OUT_OF_RANGE;
     }
+    if (req->virt == NULL) {
+        return usb_request_cacheop(req, USB_REQUEST_CACHE_CLEAN_INVALIDATE, offset, length);
+    }
     return zx_cache_flush(req_buffer_virt(req) + offset, length,
                           ZX_CACHE_FLUSH_DATA | ZX_CACHE_FLUSH_INVALIDATE);
 }
 
 zx_status_t usb_request_physmap(usb_request_t* req) {
-    if (req->phys_count > 0) {
-        return ZX_OK;
+    // Only the pages holding the transfer are pinned, rather than the rest of the VMO from
+    // the request's offset.  The pin is kept until the request is released, so a request
+    // which is reused, as from a pool, is only pinned again if a later transfer is longer.
+    uint64_t end = req->offset + req->header.length;
+    if (req->header.length == 0 || end < req->offset || end > req->size) {
+        end = req->size;
     }
     // zx_bti_pin returns whole pages, so take into account unaligned vmo
     // offset and length when calculating the amount of pages returned
-    uint64_t page_offset = ROUNDDOWN(req->offset, PAGE_SIZE);
-    // The buffer size is the vmo size from offset 0.
-    uint64_t page_length = req->size - page_offset;
-    uint64_t pages = ROUNDUP(page_length, PAGE_SIZE) / PAGE_SIZE;
+    const uint64_t pin_offset = ROUNDDOWN(req->offset, PAGE_SIZE);
+    const uint64_t pin_length = ROUNDUP(end, PAGE_SIZE) - pin_offset;
+    const uint64_t pages = pin_length / PAGE_SIZE;
+    if (pages == 0 || req->phys_count >= pages) {
+        return ZX_OK;
+    }
+
+    if (req->phys_count > 0) {
+        zx_status_t status = zx_pmt_unpin(req->pmt);
+        ZX_DEBUG_ASSERT(status == ZX_OK);
+        req->pmt = ZX_HANDLE_INVALID;
+        free(req->phys_list);
+        req->phys_list = NULL;
+        req->phys_count = 0;
+    }
 
     zx_paddr_t* paddrs = malloc(pages * sizeof(zx_paddr_t));
     if (paddrs == NULL) {
         zxlogf(ERROR, "usb_request_physmap: out of memory\n");
         return ZX_ERR_NO_MEMORY;
     }
-    const size_t sub_offset = page_offset & (PAGE_SIZE - 1);
-    const size_t pin_offset = page_offset - sub_offset;
-    const size_t pin_length = ROUNDUP(page_length + sub_offset, PAGE_SIZE);
-
-    if (pin_length / PAGE_SIZE != pages) {
-        return ZX_ERR_INVALID_ARGS;
-    }
     zx_handle_t pmt;
     uint32_t options = ZX_BTI_PERM_READ | ZX_BTI_PERM_WRITE;
     zx_status_t status = zx_bti_pin(req->bti_handle, options, req->vmo_handle,
@@ -259,8 +288,6 @@ zx_status_t usb_request_physmap(usb_request_t* req) {
         free(paddrs);
         return status;
     }
-    // Account for the initial misalignment if any
-    paddrs[0] += sub_offset;
     req->phys_list = paddrs;
     req->phys_count = pages;
     req->pmt = pmt;
@@ -330,6 +357,29 @@ usb_request_t* usb_request_pool_get(usb_request_pool_t* pool, size_t length) {
     return found ? req : NULL;
 }
 
+zx_status_t usb_request_pool_alloc(usb_request_pool_t* pool, usb_request_t** out,
+                                   zx_handle_t bti_handle, uint64_t data_size,
+                                   uint8_t ep_address) {
+    usb_request_t* req = usb_request_pool_get(pool, data_size);
+    if (req == NULL) {
+        zx_status_t status = usb_request_alloc(&req, bti_handle, data_size, ep_address);
+        if (status != ZX_OK) {
+            return status;
+        }
+        if (data_size > 0) {
+            status = usb_request_physmap(req);
+            if (status != ZX_OK) {
+                usb_request_release(req);
+                return status;
+            }
+        }
+    }
+    req->header.ep_address = ep_address;
+    req->header.length = data_size;
+    *out = req;
+    return ZX_OK;
+}
+
 void usb_request_pool_release(usb_request_pool_t* pool) {
     mtx_lock(&pool->lock);
 
@@ -521,13 +521,11 @@ int xhci_control_request(xhci_t* xhci, uint32_t slot_id, uint8_t request_type, u
             "length: %d\n", slot_id, request_type, request, value, index, length);
 
     // xhci_control_request is only used for reading first 8 bytes of the device descriptor,
-    // so it makes sense to pool them.
-    usb_request_t* req = usb_request_pool_get(&xhci->free_reqs, length);
-
-    if (req == NULL) {
-        zx_status_t status = usb_request_alloc(&req, xhci->bti_handle, length, 0);
-        if (status != ZX_OK) return status;
-    }
+    // so it makes sense to pool them.  Pooled requests stay pinned between uses.
+    usb_request_t* req;
+    zx_status_t status = usb_request_pool_alloc(&xhci->free_reqs, &req, xhci->bti_handle,
+                                                length, 0);
+    if (status != ZX_OK) return status;
 
     usb_setup_t* setup = &req->setup;
     setup->bmRequestType = request_type;
@@ -548,7 +546,7 @@ int xhci_control_request(xhci_t* xhci, uint32_t slot_id, uint8_t request_type, u
     req->complete_cb = xhci_control_complete;
     req->cookie = &completion;
     xhci_request_queue(xhci, req);
-    zx_status_t status = sync_completion_wait(&completion, ZX_SEC(1));
+    status = sync_completion_wait(&completion, ZX_SEC(1));
     if (status == ZX_OK) {
         status = req->response.status;
     } else if (status == ZX_ERR_TIMED_OUT) {
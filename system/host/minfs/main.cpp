@@ -160,6 +160,7 @@ bool MinfsCreator::IsOptionValid(Option option) {
     case Option::kReadonly:
     case Option::kOffset:
     case Option::kLength:
+    case Option::kExtents:
     case Option::kHelp:
         return true;
     default:
@@ -331,8 +332,11 @@ zx_status_t MinfsCreator::Mkfs() {
         return status;
     }
 
+    minfs::Options options = {};
+    options.extents = GetExtents();
+
     // Consume the bcache to mkfs.
-    if ((status = minfs::Mkfs(fbl::move(bc))) != ZX_OK) {
+    if ((status = minfs::Mkfs(options, fbl::move(bc))) != ZX_OK) {
         return status;
     }
 
@@ -77,6 +77,9 @@
 // clears the counters
 #define IOCTL_BLOCK_GET_STATS   \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 18)
+// Get the hit and miss counters of a block cache (see block_cache_stats_t).
+#define IOCTL_BLOCK_GET_CACHE_STATS \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_BLOCK, 19)
 
 // Block Impl ioctls (specific to each block device):
 
@@ -104,6 +107,17 @@ typedef struct {
     size_t total_blocks;    // Total number of blocks processed
 } block_stats_t;
 
+typedef struct {
+    uint64_t line_size;     // Size in bytes of each cache line
+    uint64_t line_count;    // Total number of cache lines
+    uint64_t dirty_count;   // Number of lines not yet written back
+    uint64_t read_hits;     // Lines read from the cache
+    uint64_t read_misses;   // Lines read from the device to satisfy a read
+    uint64_t write_hits;    // Lines written to the cache while already cached
+    uint64_t write_misses;  // Lines written to the cache while not cached
+    uint64_t writebacks;    // Lines written back to the device
+} block_cache_stats_t;
+
 // ssize_t ioctl_block_get_info(int fd, block_info_t* out);
 IOCTL_WRAPPER_OUT(ioctl_block_get_info, IOCTL_BLOCK_GET_INFO, block_info_t);
 
@@ -208,6 +222,9 @@ IOCTL_WRAPPER_IN(ioctl_block_fvm_upgrade, IOCTL_BLOCK_FVM_UPGRADE, upgrade_req_t
 // ssize_t ioctl_block_get_stats(int fd, bool clear, block_stats_t* out)
 IOCTL_WRAPPER_INOUT(ioctl_block_get_stats, IOCTL_BLOCK_GET_STATS, bool, block_stats_t);
 
+// ssize_t ioctl_block_get_cache_stats(int fd, block_cache_stats_t* out)
+IOCTL_WRAPPER_OUT(ioctl_block_get_cache_stats, IOCTL_BLOCK_GET_CACHE_STATS, block_cache_stats_t);
+
 // Multiple Block IO operations may be sent at once before a response is actually sent back.
 // Block IO ops may be sent concurrently to different vmoids, and they also may be sent
 // to different groups at any point in time.
@@ -22,7 +22,8 @@ typedef struct eth_info_t {
     uint32_t mtu;
     uint8_t mac[6];
     uint8_t pad[2];
-    uint32_t reserved[12];
+    uint32_t offloads;
+    uint32_t reserved[11];
 } eth_info_t;
 
 #define ETH_SIGNAL_STATUS ZX_USER_SIGNAL_0
@@ -36,6 +37,20 @@ typedef struct eth_info_t {
 // Device is a loopback network device
 #define ETH_FEATURE_LOOPBACK 4
 
+// Ethernet device offloads, which a client may enable with IOCTL_ETHERNET_SET_OFFLOADS
+
+// Fill in the IPv4 header checksum of frames sent with ETH_FIFO_TX_CSUM_IP
+#define ETH_OFFLOAD_TX_CSUM_IP (1u)
+// Fill in the TCP or UDP checksum of frames sent with ETH_FIFO_TX_CSUM_L4
+#define ETH_OFFLOAD_TX_CSUM_L4 (2u)
+// Mark received frames whose checksums have been verified with ETH_FIFO_RX_CSUM_OK
+#define ETH_OFFLOAD_RX_CSUM    (4u)
+// Split TCP segments sent with ETH_FIFO_TX_TSO into frames of at most tso_mss bytes of payload
+#define ETH_OFFLOAD_TSO        (8u)
+// Merge received TCP segments into frames of up to 64k; applies while every started client of
+// the device has enabled it
+#define ETH_OFFLOAD_LRO        (16u)
+
 // Get the fifos to submit tx and rx operations
 //   in: none
 //  out: eth_fifos_t*
@@ -107,6 +122,20 @@ typedef struct eth_multicast_config_t {
     uint8_t mac[6]; // used in ADD_MAC and DEL_MAC
 } eth_multicast_config_t;
 
+// Enable offloads for this client
+// Only offloads reported in eth_info_t.offloads may be enabled; the ETH_FIFO_TX_ offload flags
+// are rejected with ETH_FIFO_INVALID unless the matching offload is enabled.
+//   in: eth_offload_config_t*
+//   out: none
+#define IOCTL_ETHERNET_SET_OFFLOADS \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_ETH, 11)
+
+typedef struct eth_offload_config_t {
+    uint32_t offloads;  // ETH_OFFLOAD_ flags
+    uint16_t tso_mss;   // maximum TCP payload per frame, required with ETH_OFFLOAD_TSO
+    uint16_t reserved;
+} eth_offload_config_t;
+
 // Link status bits:
 #define ETH_STATUS_ONLINE (1u)
 
@@ -132,13 +161,16 @@ typedef struct eth_multicast_config_t {
 // are returned along with the fifo handles in the eth_fifos_t.
 
 // flags values for request messages
-// - none -
+#define ETH_FIFO_TX_CSUM_IP (0x10u) // fill in the IPv4 header checksum
+#define ETH_FIFO_TX_CSUM_L4 (0x20u) // fill in the TCP or UDP checksum
+#define ETH_FIFO_TX_TSO     (0x40u) // segment a large TCP packet, filling in every checksum
 
 // flags values for response messages
-#define ETH_FIFO_RX_OK   (1u)   // packet received okay
-#define ETH_FIFO_TX_OK   (1u)   // packet transmitted okay
-#define ETH_FIFO_INVALID (2u)   // offset+length not within io_vmo bounds
-#define ETH_FIFO_RX_TX   (4u)   // received our own tx packet (when TX_LISTEN)
+#define ETH_FIFO_RX_OK      (1u)    // packet received okay
+#define ETH_FIFO_TX_OK      (1u)    // packet transmitted okay
+#define ETH_FIFO_INVALID    (2u)    // offset+length not within io_vmo bounds, or bad offload
+#define ETH_FIFO_RX_TX      (4u)    // received our own tx packet (when TX_LISTEN)
+#define ETH_FIFO_RX_CSUM_OK (8u)    // IP and TCP/UDP checksums verified (when RX_CSUM enabled)
 
 typedef struct eth_fifo_entry {
     // offset from start of io_vmo to packet data
@@ -183,3 +215,6 @@ IOCTL_WRAPPER_IN(ioctl_ethernet_set_promisc, IOCTL_ETHERNET_SET_PROMISC, bool);
 // ssize_t ioctl_ethernet_config_multicast(int fd, const eth_multicast_config_t *);
 IOCTL_WRAPPER_IN(ioctl_ethernet_config_multicast, IOCTL_ETHERNET_CONFIG_MULTICAST,
                  eth_multicast_config_t)
+
+// ssize_t ioctl_ethernet_set_offloads(int fd, const eth_offload_config_t*);
+IOCTL_WRAPPER_IN(ioctl_ethernet_set_offloads, IOCTL_ETHERNET_SET_OFFLOADS, eth_offload_config_t);
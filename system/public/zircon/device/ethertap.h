@@ -28,6 +28,13 @@
 // Report EthmacSetParam() over Control channel of socket, and return success from EthmacSetParam().
 // If this option is not set, EthmacSetParam() will return ZX_ERR_NOT_SUPPORTED.
 #define ETHERTAP_OPT_REPORT_PARAM  (1u << 2)
+// Advertise ETHMAC_FEATURE_RX_QUEUE, and read received frames from the socket directly into the
+// buffers queued by the ethernet driver rather than passing them up to be copied.
+#define ETHERTAP_OPT_RX_QUEUE      (1u << 3)
+// Advertise every ETHMAC_OFFLOAD_ capability without performing any of them.  The offloads
+// requested for each transmitted packet are reported in its socket header (see below), received
+// frames are marked as having good checksums, and ETHMAC_SETPARAM_LRO is accepted.
+#define ETHERTAP_OPT_OFFLOADS      (1u << 4)
 
 // An ethertap device has a fixed mac address and mtu, and transfers ethernet frames over the
 // returned data socket. To destroy the device, close the socket.
@@ -52,9 +59,16 @@ typedef struct ethertap_ioctl_config {
 
 typedef struct ethertap_socket_header {
     uint32_t type;
-    int32_t info; // Might not be used yet; also there for 64-bit alignment
+    int32_t info; // See below; also there for 64-bit alignment
 } ethertap_socket_header_t;
 
+// With ETHERTAP_OPT_OFFLOADS, the info field of an ETHERTAP_MSG_PACKET holds the offloads which
+// were requested for the packet in its low 16 bits, and the TSO segment size in its high 16 bits.
+// Otherwise it is zero.
+#define ETHERTAP_PACKET_CSUM_IP (1u << 0)
+#define ETHERTAP_PACKET_CSUM_L4 (1u << 1)
+#define ETHERTAP_PACKET_TSO     (1u << 2)
+
 // If EthmacSetParam() reporting is requested, this struct is written to the Control
 // channel of the ethertap socket each time the function is called.
 //
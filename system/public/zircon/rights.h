@@ -99,4 +99,7 @@
 #define ZX_DEFAULT_SUSPEND_TOKEN_RIGHTS \
     (ZX_RIGHT_TRANSFER | ZX_RIGHT_INSPECT)
 
+#define ZX_DEFAULT_PAGER_RIGHTS \
+    ((ZX_RIGHTS_BASIC & (~ZX_RIGHT_WAIT)) | ZX_RIGHTS_IO)
+
 #endif // ZIRCON_RIGHTS_H_
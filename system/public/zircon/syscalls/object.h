@@ -35,6 +35,7 @@ typedef enum {
     ZX_INFO_PROCESS_HANDLE_STATS       = 21, // zx_info_process_handle_stats_t[1]
     ZX_INFO_SOCKET                     = 22, // zx_info_socket_t[1]
     ZX_INFO_VMO                        = 23, // zx_info_vmo_t[1]
+    ZX_INFO_TASK_VM_STATS              = 24, // zx_info_task_vm_stats_t[1]
 } zx_object_info_topic_t;
 
 typedef uint32_t zx_obj_props_t;
@@ -136,6 +137,19 @@ typedef struct zx_info_task_stats {
     size_t mem_scaled_shared_bytes;
 } zx_info_task_stats_t;
 
+// Statistics about the kernel's management of a task's memory. Kept apart
+// from zx_info_task_stats_t so that its layout doesn't change.
+typedef struct zx_info_task_vm_stats {
+    // Memory that the kernel has reclaimed from VMOs mapped into this task
+    // because it held only zeroes. Reads of that memory are now backed by the
+    // shared zero page. A VMO mapped more than once is counted more than once.
+    size_t mem_zero_reclaimed_bytes;
+
+    // Memory used by the hardware page tables that translate the task's
+    // address space.
+    size_t mem_page_table_bytes;
+} zx_info_task_vm_stats_t;
+
 typedef struct zx_info_vmar {
     // Base address of the region.
     uintptr_t base;
@@ -43,6 +43,7 @@ unsigned int AnalyzeField(const fbl::Array<ReportInfo>& reports,
                           uintptr_t ReportInfo::*field);
 double ApproxBinomialCdf(double p, double N, double n);
 int TestRunMain(int argc, char** argv);
+int PageTableStressMain(int argc, char** argv);
 zx_status_t LaunchTestRun(const char* bin, zx_handle_t h, zx_handle_t* out);
 int64_t JoinProcess(zx_handle_t proc);
 } // namespace
@@ -55,6 +56,9 @@ int main(int argc, char** argv) {
     if (argc > 1 && !strcmp(argv[1], "testrun")) {
         return TestRunMain(argc, argv);
     }
+    if (argc > 1 && !strcmp(argv[1], "ptstress")) {
+        return PageTableStressMain(argc, argv);
+    }
 
     struct stat stat_info;
     if (stat(kBinName, &stat_info) != 0 || !S_ISREG(stat_info.st_mode)) {
@@ -217,6 +221,102 @@ int TestRunMain(int argc, char** argv) {
     return 0;
 }
 
+zx_status_t GetPageTableBytes(size_t* bytes) {
+    zx_info_task_vm_stats_t info;
+    zx_status_t status = zx_object_get_info(zx_process_self(), ZX_INFO_TASK_VM_STATS,
+                                            &info, sizeof(info), nullptr, nullptr);
+    if (status != ZX_OK) {
+        return status;
+    }
+    *bytes = info.mem_page_table_bytes;
+    return ZX_OK;
+}
+
+// Repeatedly maps small regions at randomized addresses across the address
+// space, touches them so that page tables get built, and unmaps them again,
+// the way an allocator or JIT relying on ASLR would. Reports how much memory
+// the process's page tables use over time, and fails if that memory isn't
+// returned once the regions are gone.
+int PageTableStressMain(int argc, char** argv) {
+    static const size_t kMappingsPerRound = 256;
+    static const size_t kMaxMappingPages = 16;
+    // Allow for a few tables used by anything else the process maps meanwhile.
+    static const size_t kSlackBytes = 16 * PAGE_SIZE;
+
+    const size_t rounds = argc > 2 ? strtoul(argv[2], nullptr, 0) : 100;
+
+    zx_handle_t vmo;
+    zx_status_t status = zx_vmo_create(kMaxMappingPages * PAGE_SIZE, 0, &vmo);
+    if (status != ZX_OK) {
+        printf("Failed to create vmo: %d\n", status);
+        return 1;
+    }
+    auto close_vmo = fbl::MakeAutoCall([vmo]() { zx_handle_close(vmo); });
+
+    fbl::Array<uintptr_t> addrs(new uintptr_t[kMappingsPerRound], kMappingsPerRound);
+    fbl::Array<size_t> sizes(new size_t[kMappingsPerRound], kMappingsPerRound);
+    if (!addrs || !sizes) {
+        printf("Failed to allocate mapping arrays\n");
+        return 1;
+    }
+
+    size_t baseline;
+    if ((status = GetPageTableBytes(&baseline)) != ZX_OK) {
+        printf("Failed to get task stats: %d\n", status);
+        return 1;
+    }
+    printf("page table bytes at start: %zu\n", baseline);
+
+    size_t peak = baseline;
+    size_t after = baseline;
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < kMappingsPerRound; ++i) {
+            sizes[i] = (1 + rand() % kMaxMappingPages) * PAGE_SIZE;
+            status = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                                 0, vmo, 0, sizes[i], &addrs[i]);
+            if (status != ZX_OK) {
+                printf("Failed to map: %d\n", status);
+                return 1;
+            }
+            for (size_t off = 0; off < sizes[i]; off += PAGE_SIZE) {
+                *reinterpret_cast<volatile uint8_t*>(addrs[i] + off) = 1;
+            }
+        }
+
+        size_t during;
+        if ((status = GetPageTableBytes(&during)) != ZX_OK) {
+            printf("Failed to get task stats: %d\n", status);
+            return 1;
+        }
+        peak = MAX(peak, during);
+
+        for (size_t i = 0; i < kMappingsPerRound; ++i) {
+            status = zx_vmar_unmap(zx_vmar_root_self(), addrs[i], sizes[i]);
+            if (status != ZX_OK) {
+                printf("Failed to unmap: %d\n", status);
+                return 1;
+            }
+        }
+
+        if ((status = GetPageTableBytes(&after)) != ZX_OK) {
+            printf("Failed to get task stats: %d\n", status);
+            return 1;
+        }
+        if (round % 10 == 0 || round == rounds - 1) {
+            printf("round %4zu: page table bytes %8zu mapped, %8zu after unmap\n",
+                   round, during, after);
+        }
+    }
+
+    printf("page table bytes: start %zu, peak %zu, end %zu\n", baseline, peak, after);
+    if (after > baseline + kSlackBytes) {
+        printf("Page tables were not reclaimed after unmapping (%zu bytes leaked)\n",
+               after - baseline);
+        return 1;
+    }
+    return 0;
+}
+
 // This function unconditionally consumes the handle h.
 zx_status_t LaunchTestRun(const char* bin, zx_handle_t h, zx_handle_t* proc) {
     const char* argv[] = {bin, "testrun", nullptr};
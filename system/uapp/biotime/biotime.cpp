@@ -118,6 +118,16 @@ fail:
     return ZX_ERR_INTERNAL;
 }
 
+// Outstanding ops are tracked by reqid, modulo this many slots; at most
+// 128 may be outstanding.
+#define MAX_TRACKED 256
+
+typedef struct {
+    zx_duration_t total;
+    zx_duration_t max;
+    size_t count;
+} latency_t;
+
 typedef struct {
     blkdev_t* blk;
     size_t count;
@@ -126,9 +136,17 @@ typedef struct {
     int max_pending;
     bool write;
     bool linear;
+    // Percentage of ops which write, when mixing reads and writes.
+    int mix;
 
     fbl::atomic<int> pending;
     sync_completion_t signal;
+
+    // When each outstanding op was issued, and whether it writes.
+    zx_time_t issued[MAX_TRACKED];
+    bool writes[MAX_TRACKED];
+    latency_t read_latency;
+    latency_t write_latency;
 } bio_random_args_t;
 
 static fbl::atomic<reqid_t> next_reqid(0);
@@ -157,7 +175,11 @@ static int bio_random_thread(void* arg) {
         block_fifo_request_t req = {};
         req.reqid = next_reqid.fetch_add(1);
         req.vmoid = a->blk->vmoid;
-        req.opcode = a->write ? BLOCKIO_WRITE : BLOCKIO_READ;
+        bool write = a->write;
+        if (a->mix > 0) {
+            write = static_cast<int>(rand64(&r64) % 100) < a->mix;
+        }
+        req.opcode = write ? BLOCKIO_WRITE : BLOCKIO_READ;
         req.length = static_cast<uint32_t>(xfer);
         req.vmo_offset = off;
 
@@ -180,6 +202,8 @@ static int bio_random_thread(void* arg) {
         fprintf(stderr, "IO tid=%u vid=%u op=%x len=%zu vof=%zu dof=%zu\n",
                 req.reqid, req.vmoid, req.opcode, req.length, req.vmo_offset, req.dev_offset);
 #endif
+        a->issued[req.reqid % MAX_TRACKED] = zx_clock_get_monotonic();
+        a->writes[req.reqid % MAX_TRACKED] = write;
         zx_status_t r = zx_fifo_write(fifo, sizeof(req), &req, 1, NULL);
         if (r == ZX_ERR_SHOULD_WAIT) {
             r = zx_object_wait_one(fifo, ZX_FIFO_WRITABLE | ZX_FIFO_PEER_CLOSED,
@@ -234,6 +258,13 @@ static zx_status_t bio_random(bio_random_args_t* a, uint64_t* _total, zx_duratio
                     resp.status, count);
             goto fail;
         }
+        zx_duration_t latency = zx_time_sub_time(zx_clock_get_monotonic(),
+                                                 a->issued[resp.reqid % MAX_TRACKED]);
+        latency_t* l = a->writes[resp.reqid % MAX_TRACKED] ? &a->write_latency
+                                                            : &a->read_latency;
+        l->total += latency;
+        l->max = latency > l->max ? latency : l->max;
+        l->count++;
         count--;
         if (a->pending.fetch_sub(1) == a->max_pending) {
             sync_completion_signal(&a->signal);
@@ -256,6 +287,15 @@ fail:
     return ZX_ERR_IO;
 }
 
+static void print_latency(const char* name, const latency_t* l) {
+    if (l->count == 0) {
+        return;
+    }
+    fprintf(stderr, "%zu %ss: %zu us mean, %zu us max latency\n", l->count, name,
+            static_cast<size_t>(l->total / l->count / ZX_USEC(1)),
+            static_cast<size_t>(l->max / ZX_USEC(1)));
+}
+
 void usage(void) {
     fprintf(stderr, "usage: biotime <option>* <device>\n"
                     "\n"
@@ -264,7 +304,8 @@ void usage(void) {
                     "       -mo <num>     maximum outstanding ops (1..128)\n"
                     "       -read         test reading from the block device (default)\n"
                     "       -write        test writing to the block device\n"
-                    "       -live-dangerously  required if using \"-write\"\n"
+                    "       -mix <num>    percentage of ops which write, mixed with reads\n"
+                    "       -live-dangerously  required if using \"-write\" or \"-mix\"\n"
                     "       -linear       transfers in linear order (default)\n"
                     "       -random       random transfers across total range\n"
                     "       -output-file <filename>  destination file for "
@@ -321,6 +362,13 @@ int main(int argc, char** argv) {
             a.write = false;
         } else if (!strcmp(argv[0], "-write")) {
             a.write = true;
+        } else if (!strcmp(argv[0], "-mix")) {
+            needparam();
+            size_t n = number(argv[0]);
+            if (n > 100) {
+                error("error: mix must be between 0 and 100\n");
+            }
+            a.mix = static_cast<int>(n);
         } else if (!strcmp(argv[0], "-live-dangerously")) {
             live_dangerously = true;
         } else if (!strcmp(argv[0], "-linear")) {
@@ -344,9 +392,9 @@ int main(int argc, char** argv) {
     if (argc > 1) {
         error("error: unexpected arguments\n");
     }
-    if (a.write && !live_dangerously) {
+    if ((a.write || a.mix > 0) && !live_dangerously) {
         error("error: the option \"-live-dangerously\" is required when using"
-              " \"-write\"\n");
+              " \"-write\" or \"-mix\"\n");
     }
     const char* device_filename = argv[0];
 
@@ -377,6 +425,8 @@ int main(int argc, char** argv) {
     bytes_per_second(total, res);
     fprintf(stderr, "%zu ops in %zu ns: ", a.count, res);
     ops_per_second(a.count, res);
+    print_latency("read", &a.read_latency);
+    print_latency("write", &a.write_latency);
 
     if (output_file) {
         perftest::ResultsSet results;
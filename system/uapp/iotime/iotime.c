@@ -11,6 +11,7 @@
 
 #include <block-client/client.h>
 #include <fs-management/ramdisk.h>
+#include <lib/fdio/limits.h>
 #include <zircon/device/block.h>
 #include <zircon/device/ramdisk.h>
 #include <zircon/syscalls.h>
@@ -82,6 +83,11 @@ static zx_duration_t iotime_posix(int is_read, int fd, size_t total, size_t bufs
     return zx_time_sub_time(t1, t0);
 }
 
+// Transfers at most one fdio chunk per call, as remoteio did before it could
+// keep several requests in flight on behalf of a single large call.
+static zx_duration_t iotime_chunked(int is_read, int fd, size_t total, size_t bufsz) {
+    return iotime_posix(is_read, fd, total, (bufsz > FDIO_CHUNK_SIZE) ? FDIO_CHUNK_SIZE : bufsz);
+}
 
 static int make_ramdisk(size_t blocks) {
     char ramdisk_path[PATH_MAX];
@@ -165,9 +171,10 @@ static zx_duration_t iotime_fifo(char* dev, int is_read, int fd, size_t total, s
 
 static int usage(void) {
     fprintf(stderr,
-            "usage: iotime <read|write> <posix|block|fifo> <device|--ramdisk> <bytes> <bufsize>\n\n"
+            "usage: iotime <read|write> <posix|chunked|block|fifo> <device|--ramdisk> <bytes> <bufsize>\n\n"
             "        <bytes> and <bufsize> must be a multiple of 4k for block mode\n"
-            "        --ramdisk only supported for block mode\n");
+            "        chunked mode splits each call into %d byte calls, for comparison with posix\n"
+            "        --ramdisk only supported for block mode\n", FDIO_CHUNK_SIZE);
     return -1;
 }
 
@@ -201,6 +208,8 @@ int main(int argc, char** argv) {
     zx_duration_t res;
     if (!strcmp(argv[2], "posix")) {
         res = iotime_posix(is_read, fd, total, bufsz);
+    } else if (!strcmp(argv[2], "chunked")) {
+        res = iotime_chunked(is_read, fd, total, bufsz);
     } else if (!strcmp(argv[2], "block")) {
         res = iotime_block(is_read, fd, total, bufsz);
     } else if (!strcmp(argv[2], "fifo")) {
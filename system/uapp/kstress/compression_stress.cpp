@@ -0,0 +1,206 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/algorithm.h>
+#include <fbl/atomic.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
+#include <zircon/status.h>
+#include <zircon/syscalls.h>
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include "stress_test.h"
+
+class CompressionStressTest : public StressTest {
+public:
+    CompressionStressTest() = default;
+    virtual ~CompressionStressTest() = default;
+
+    virtual zx_status_t Start();
+    virtual zx_status_t Stop();
+
+    virtual const char* name() const { return "Compression Stress"; }
+
+private:
+    int stress_thread(size_t index);
+
+    static constexpr size_t kNumThreads = 4;
+
+    struct Worker {
+        CompressionStressTest* test;
+        size_t index;
+        thrd_t thread;
+        zx::vmo vmo;
+        uintptr_t ptr;
+        size_t num_pages;
+    };
+    Worker workers_[kNumThreads]{};
+
+    // used by the worker threads at runtime
+    fbl::atomic<bool> shutdown_{false};
+
+    // results, accumulated by the worker threads as they exit
+    fbl::atomic<uint64_t> accesses_{0};
+    fbl::atomic<uint64_t> slow_accesses_{0};
+    fbl::atomic<uint64_t> slow_ticks_{0};
+    fbl::atomic<uint64_t> max_ticks_{0};
+    fbl::atomic<uint64_t> corruptions_{0};
+};
+
+// our singleton
+CompressionStressTest compression_stress;
+
+// Compression Stresser
+//
+// Fills a set of mapped VMOs, sized to put the system under memory pressure,
+// with pages that compress roughly 2:1, then has each worker thread touch its
+// pages with a skewed distribution: most accesses go to a small hot set, so
+// that the rest of the pages go cold and become candidates for the kernel's
+// page compressor (kernel.page-compressor.enable).
+//
+// Every access checks the page's stamp, so pages that come back from the
+// compressed store with the wrong contents are reported. Accesses that take
+// long enough to have faulted are counted separately, which gives the
+// fault-in latency of compressed pages as seen from user space.
+
+namespace {
+
+// Accesses slower than this are assumed to have taken a page fault.
+constexpr zx_duration_t kSlowAccess = ZX_USEC(5);
+
+// One in this many accesses goes to the cold part of the region.
+constexpr int kColdAccessRatio = 10;
+
+uint64_t page_stamp(size_t worker, size_t page) {
+    return (static_cast<uint64_t>(worker) << 48) ^ (page * 0x9e3779b97f4a7c15ull);
+}
+
+void fill_page(uint8_t* page, uint64_t stamp) {
+    // The stamp, then random data in the first half and zeroes in the second.
+    memcpy(page, &stamp, sizeof(stamp));
+    for (size_t i = sizeof(stamp); i < PAGE_SIZE / 2; i++) {
+        page[i] = static_cast<uint8_t>(rand());
+    }
+    memset(page + PAGE_SIZE / 2, 0, PAGE_SIZE / 2);
+}
+
+} // namespace
+
+int CompressionStressTest::stress_thread(size_t index) {
+    Worker& w = workers_[index];
+    const size_t hot_pages = fbl::max<size_t>(w.num_pages / 16, 1);
+
+    const uint64_t ticks_per_sec = zx_ticks_per_second();
+    const uint64_t slow_ticks = kSlowAccess * ticks_per_sec / ZX_SEC(1);
+
+    uint64_t accesses = 0;
+    uint64_t slow_accesses = 0;
+    uint64_t slow_total = 0;
+    uint64_t max_ticks = 0;
+    unsigned int seed = static_cast<unsigned int>(index);
+
+    while (!shutdown_.load()) {
+        size_t page;
+        if (rand_r(&seed) % kColdAccessRatio == 0) {
+            page = rand_r(&seed) % w.num_pages;
+        } else {
+            page = rand_r(&seed) % hot_pages;
+        }
+
+        const uint64_t* addr = reinterpret_cast<const uint64_t*>(w.ptr + page * PAGE_SIZE);
+        zx_ticks_t start = zx_ticks_get();
+        uint64_t stamp = *addr;
+        zx_ticks_t elapsed = zx_ticks_get() - start;
+
+        if (stamp != page_stamp(index, page)) {
+            fprintf(stderr, "compression stress: page %zu of worker %zu is corrupt "
+                            "(stamp %#" PRIx64 ")\n", page, index, stamp);
+            corruptions_.fetch_add(1);
+        }
+
+        accesses++;
+        if (elapsed >= slow_ticks) {
+            Printf("f");
+            slow_accesses++;
+            slow_total += elapsed;
+        }
+        max_ticks = fbl::max<uint64_t>(max_ticks, elapsed);
+    }
+
+    accesses_.fetch_add(accesses);
+    slow_accesses_.fetch_add(slow_accesses);
+    slow_ticks_.fetch_add(slow_total);
+    uint64_t cur_max = max_ticks_.load();
+    while (max_ticks > cur_max && !max_ticks_.compare_exchange_strong(&cur_max, max_ticks)) {
+    }
+
+    return 0;
+}
+
+zx_status_t CompressionStressTest::Start() {
+    // Use half of free memory, which combined with the other tests should push
+    // the system below the page compressor's free memory watermark.
+    const size_t total_pages = kmem_stats_.free_bytes / 2 / PAGE_SIZE;
+    const size_t pages_per_worker = total_pages / kNumThreads;
+
+    PrintfAlways("Compression stress test: using %zu threads with %zu pages each\n",
+                 kNumThreads, pages_per_worker);
+
+    for (size_t i = 0; i < kNumThreads; i++) {
+        Worker& w = workers_[i];
+        w.test = this;
+        w.index = i;
+        w.num_pages = pages_per_worker;
+
+        zx_status_t status = zx::vmo::create(w.num_pages * PAGE_SIZE, 0, &w.vmo);
+        if (status != ZX_OK) {
+            return status;
+        }
+        status = zx::vmar::root_self()->map(0, w.vmo, 0, w.num_pages * PAGE_SIZE,
+                                            ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, &w.ptr);
+        if (status != ZX_OK) {
+            return status;
+        }
+        for (size_t page = 0; page < w.num_pages; page++) {
+            fill_page(reinterpret_cast<uint8_t*>(w.ptr + page * PAGE_SIZE), page_stamp(i, page));
+        }
+    }
+
+    auto worker = [](void* arg) -> int {
+        Worker* w = static_cast<Worker*>(arg);
+
+        return w->test->stress_thread(w->index);
+    };
+
+    for (auto& w : workers_) {
+        thrd_create_with_name(&w.thread, worker, &w, "compression_stress_worker");
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t CompressionStressTest::Stop() {
+    shutdown_.store(true);
+
+    for (auto& w : workers_) {
+        thrd_join(w.thread, nullptr);
+        zx::vmar::root_self()->unmap(w.ptr, w.num_pages * PAGE_SIZE);
+    }
+
+    const uint64_t ticks_per_usec = zx_ticks_per_second() / 1000000;
+    const uint64_t slow = slow_accesses_.load();
+    PrintfAlways("Compression stress test: %" PRIu64 " accesses, %" PRIu64 " faulted "
+                 "(avg %" PRIu64 "us, max %" PRIu64 "us), %" PRIu64 " corrupt\n",
+                 accesses_.load(), slow,
+                 slow ? slow_ticks_.load() / slow / ticks_per_usec : 0,
+                 max_ticks_.load() / ticks_per_usec, corruptions_.load());
+
+    return corruptions_.load() ? ZX_ERR_IO_DATA_INTEGRITY : ZX_OK;
+}
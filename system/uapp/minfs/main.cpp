@@ -84,6 +84,7 @@ int usage() {
                     "    -m|--metrics                  Collect filesystem metrics\n"
                     "    -s|--fvm_data_slices SLICES   When mkfs on top of FVM,\n"
                     "                                  preallocate |SLICES| slices of data. \n"
+                    "    -e|--extents                  When mkfs, map new files with extents\n"
                     "    -h|--help                     Display this message\n"
                     "\n"
                     "On Fuchsia, MinFS takes the block device argument by handle.\n"
@@ -121,11 +122,12 @@ int main(int argc, char** argv) {
             {"metrics", no_argument, nullptr, 'm'},
             {"verbose", no_argument, nullptr, 'v'},
             {"fvm_data_slices", required_argument, nullptr, 's'},
+            {"extents", no_argument, nullptr, 'e'},
             {"help", no_argument, nullptr, 'h'},
             {nullptr, 0, nullptr, 0},
         };
         int opt_index;
-        int c = getopt_long(argc, argv, "rmvhs:", opts, &opt_index);
+        int c = getopt_long(argc, argv, "rmvhes:", opts, &opt_index);
         if (c < 0) {
             break;
         }
@@ -142,6 +144,9 @@ int main(int argc, char** argv) {
         case 's':
             options.fvm_data_slices = static_cast<uint32_t>(strtoul(optarg, NULL, 0));
             break;
+        case 'e':
+            options.extents = true;
+            break;
         case 'h':
         default:
             return usage();
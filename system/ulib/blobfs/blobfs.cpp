@@ -37,6 +37,10 @@ using digest::MerkleTree;
 namespace blobfs {
 namespace {
 
+// Asserted on the readable event of a blob once it may be read. Readable blobs
+// never change, so clients may read them directly from the VMO given by GetVmo.
+constexpr zx_signals_t kBlobReadableSignals = ZX_USER_SIGNAL_0 | FILE_SIGNAL_VMO_SHARED;
+
 zx_status_t CheckFvmConsistency(const blobfs_info_t* info, int block_fd) {
     if ((info->flags & kBlobFlagFVM) == 0) {
         return ZX_OK;
@@ -180,6 +184,8 @@ zx_status_t VnodeBlob::InitVmos() {
         return ZX_OK;
     }
 
+    fs::Ticker ticker(blobfs_->CollectingMetrics());
+
     // Reverts blob back to uninitialized state on error.
     auto cleanup = fbl::MakeAutoCall([this]() { BlobCloseHandles(); });
 
@@ -192,6 +198,17 @@ zx_status_t VnodeBlob::InitVmos() {
         FS_TRACE_ERROR("Multiplication overflow");
         return ZX_ERR_OUT_OF_RANGE;
     }
+
+    if (blobfs_->pager_ != nullptr) {
+        // The pager verifies each chunk of data as it is read in.
+        if ((status = InitPaged(vmo_size)) != ZX_OK) {
+            return status;
+        }
+        blobfs_->UpdateMerkleOpenMetrics(inode_.blob_size, ticker.End());
+        cleanup.cancel();
+        return ZX_OK;
+    }
+
     if ((status = fzl::MappedVmo::Create(vmo_size, "blob", &blob_)) != ZX_OK) {
         FS_TRACE_ERROR("Failed to initialize vmo; error: %d\n", status);
         return status;
@@ -201,23 +218,46 @@ zx_status_t VnodeBlob::InitVmos() {
         return status;
     }
 
-    if ((inode_.flags & kBlobFlagLZ4Compressed) != 0) {
-        if ((status = InitCompressed()) != ZX_OK) {
+    if ((inode_.flags & kBlobFlagChunkCompressed) != 0) {
+        if ((status = InitChunkCompressed()) != ZX_OK) {
             return status;
         }
     } else {
-        if ((status = InitUncompressed()) != ZX_OK) {
+        if ((inode_.flags & kBlobFlagLZ4Compressed) != 0) {
+            status = InitCompressed();
+        } else {
+            status = InitUncompressed();
+        }
+        if (status != ZX_OK || (status = Verify()) != ZX_OK) {
             return status;
         }
     }
-    if ((status = Verify()) != ZX_OK) {
-        return status;
-    }
 
+    blobfs_->UpdateMerkleOpenMetrics(inode_.blob_size, ticker.End());
     cleanup.cancel();
     return ZX_OK;
 }
 
+zx_status_t VnodeBlob::InitPaged(size_t vmo_size) {
+    TRACE_DURATION("blobfs", "Blobfs::InitPaged", "size", inode_.blob_size,
+                   "blocks", inode_.num_blocks);
+    zx::vmo vmo;
+    zx_status_t status = blobfs_->pager_->CreateBlobVmo(inode_, &digest_[0], vmo_size,
+                                                        &vmo, &pager_key_);
+    if (status != ZX_OK) {
+        FS_TRACE_ERROR("Failed to create paged vmo; error: %d\n", status);
+        return status;
+    }
+    if ((status = fzl::MappedVmo::CreateFromVmo(vmo.release(), vmo_size, &blob_)) != ZX_OK) {
+        FS_TRACE_ERROR("Failed to map paged vmo; error: %d\n", status);
+        return status;
+    }
+    // The block device never touches a paged VMO; the pager reads into its
+    // own buffers.
+    vmoid_ = VMOID_INVALID;
+    return ZX_OK;
+}
+
 zx_status_t VnodeBlob::InitCompressed() {
     TRACE_DURATION("blobfs", "Blobfs::InitCompressed", "size", inode_.blob_size,
                    "blocks", inode_.num_blocks);
@@ -265,8 +305,8 @@ zx_status_t VnodeBlob::InitCompressed() {
 
     // Decompress the compressed data into the target buffer.
     size_t target_size = inode_.blob_size;
-    status = Decompressor::Decompress(GetData(), &target_size,
-                                      compressed_blob->GetData(), &compressed_size);
+    status = Decompressor::DecompressBlob(inode_.flags, GetData(), &target_size,
+                                          compressed_blob->GetData(), &compressed_size);
     if (status != ZX_OK) {
         FS_TRACE_ERROR("Failed to decompress data: %d\n", status);
         return status;
@@ -281,6 +321,123 @@ zx_status_t VnodeBlob::InitCompressed() {
     return ZX_OK;
 }
 
+zx_status_t VnodeBlob::InitChunkCompressed() {
+    TRACE_DURATION("blobfs", "Blobfs::InitChunkCompressed", "size", inode_.blob_size,
+                   "blocks", inode_.num_blocks);
+    zx_status_t status;
+    ChunkPipeline* pipeline = blobfs_->pipeline_.get();
+    if (pipeline == nullptr) {
+        if ((status = InitCompressed()) != ZX_OK) {
+            return status;
+        }
+        return Verify();
+    }
+
+    fs::Ticker ticker(blobfs_->CollectingMetrics());
+    fs::Ticker read_ticker(blobfs_->CollectingMetrics());
+    uint64_t start = inode_.start_block + DataStartBlock(blobfs_->info_);
+    uint64_t merkle_blocks = MerkleTreeBlocks(inode_);
+
+    fbl::unique_ptr<fzl::MappedVmo> compressed_blob;
+    size_t compressed_blocks = (inode_.num_blocks - merkle_blocks);
+    size_t compressed_size;
+    if (mul_overflow(compressed_blocks, kBlobfsBlockSize, &compressed_size)) {
+        FS_TRACE_ERROR("Multiplication overflow\n");
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    const uint64_t table_blocks = fbl::round_up(ChunkTableSize(inode_.blob_size),
+                                                kBlobfsBlockSize) / kBlobfsBlockSize;
+    if (table_blocks > compressed_blocks) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    if ((status = fzl::MappedVmo::Create(compressed_size, "compressed-blob",
+                                        &compressed_blob)) != ZX_OK) {
+        FS_TRACE_ERROR("Failed to initialized compressed vmo; error: %d\n", status);
+        return status;
+    }
+    vmoid_t compressed_vmoid;
+    if ((status = blobfs_->AttachVmo(compressed_blob->GetVmo(), &compressed_vmoid)) != ZX_OK) {
+        FS_TRACE_ERROR("Failed to attach commpressed VMO to blkdev: %d\n", status);
+        return status;
+    }
+    auto detach = fbl::MakeAutoCall([this, &compressed_vmoid]() {
+        blobfs_->DetachVmo(compressed_vmoid);
+    });
+
+    // Read the uncompressed merkle tree, along with the seek table which
+    // locates each chunk.
+    fs::ReadTxn txn(blobfs_);
+    txn.Enqueue(vmoid_, 0, start, merkle_blocks);
+    txn.Enqueue(compressed_vmoid, 0, start + merkle_blocks, table_blocks);
+    if ((status = txn.Transact()) != ZX_OK) {
+        FS_TRACE_ERROR("Failed to flush read transaction: %d\n", status);
+        return status;
+    }
+    fs::Duration read_time = read_ticker.End();
+
+    const uint8_t* compressed = static_cast<const uint8_t*>(compressed_blob->GetData());
+    if ((status = Decompressor::ValidateChunkTable(compressed, table_blocks * kBlobfsBlockSize,
+                                                   compressed_size,
+                                                   inode_.blob_size)) != ZX_OK) {
+        FS_TRACE_ERROR("Invalid chunk table\n");
+        return status;
+    }
+
+    ChunkPipeline::Job job;
+    job.compressed = compressed;
+    job.data = static_cast<uint8_t*>(GetData());
+    job.blob_size = inode_.blob_size;
+    job.merkle = static_cast<const uint8_t*>(GetMerkle());
+    job.merkle_size = MerkleTree::GetTreeLength(inode_.blob_size);
+    job.digest = reinterpret_cast<const uint8_t*>(&digest_[0]);
+    job.collecting_metrics = blobfs_->CollectingMetrics();
+    pipeline->Begin(&job);
+    auto finish = fbl::MakeAutoCall([pipeline]() { pipeline->Finish(); });
+
+    // Read the chunks a few at a time, handing each batch to the workers as
+    // soon as it arrives.
+    const uint64_t chunk_count = ChunkCount(inode_.blob_size);
+    uint64_t read_blocks = table_blocks;
+    for (uint64_t chunk = 0; chunk < chunk_count;) {
+        const uint64_t next = fbl::min(chunk + kPipelineReadChunks, chunk_count);
+        uint64_t chunk_start, chunk_end;
+        Decompressor::ChunkBounds(compressed, next - 1, &chunk_start, &chunk_end);
+        const uint64_t end_block = fbl::round_up(chunk_end, kBlobfsBlockSize) / kBlobfsBlockSize;
+        if (end_block > read_blocks) {
+            read_ticker.Reset();
+            fs::ReadTxn txn(blobfs_);
+            txn.Enqueue(compressed_vmoid, read_blocks, start + merkle_blocks + read_blocks,
+                        end_block - read_blocks);
+            if ((status = txn.Transact()) != ZX_OK) {
+                FS_TRACE_ERROR("Failed to flush read transaction: %d\n", status);
+                return status;
+            }
+            read_time += read_ticker.End();
+            read_blocks = end_block;
+        }
+        if ((status = pipeline->SetReadable(next)) != ZX_OK) {
+            break;
+        }
+        chunk = next;
+    }
+
+    finish.cancel();
+    status = pipeline->Finish();
+    if (status != ZX_OK) {
+        char name[Digest::kLength * 2 + 1];
+        ZX_ASSERT(job.digest.ToString(name, sizeof(name)) == ZX_OK);
+        FS_TRACE_ERROR("blobfs verify(%s) Failure: %s\n", name, zx_status_get_string(status));
+        return status;
+    }
+
+    blobfs_->UpdateMerkleDecompressMetrics(read_blocks * kBlobfsBlockSize, inode_.blob_size,
+                                           read_time, job.decompress_duration);
+    blobfs_->UpdateMerkleVerifyMetrics(inode_.blob_size, job.merkle_size, job.verify_duration);
+    blobfs_->UpdatePipelineMetrics(read_time, job.decompress_duration, job.verify_duration,
+                                   ticker.End());
+    return ZX_OK;
+}
+
 zx_status_t VnodeBlob::InitUncompressed() {
     TRACE_DURATION("blobfs", "Blobfs::InitUncompressed", "size", inode_.blob_size,
                    "blocks", inode_.num_blocks);
@@ -325,6 +482,10 @@ VnodeBlob::VnodeBlob(Blobfs* bs)
 
 void VnodeBlob::BlobCloseHandles() {
     blob_ = nullptr;
+    if (pager_key_ != 0) {
+        blobfs_->pager_->ReleaseBlob(pager_key_);
+        pager_key_ = 0;
+    }
     readable_event_.reset();
 }
 
@@ -389,7 +550,8 @@ zx_status_t VnodeBlob::SpaceAllocate(uint64_t size_data) {
             return status;
         }
         status = write_info_->compressor.Initialize(write_info_->compressed_blob->GetData(),
-                                                    write_info_->compressed_blob->GetSize());
+                                                    write_info_->compressed_blob->GetSize(),
+                                                    inode_.blob_size);
         if (status != ZX_OK) {
             fprintf(stderr, "blobfs: Failed to initalize compressor: %d\n", status);
             return status;
@@ -424,7 +586,7 @@ zx_status_t VnodeBlob::WriteMetadata(fbl::unique_ptr<WritebackWork> wb) {
     // All data has been written to the containing VMO.
     SetState(kBlobStateReadable);
     if (readable_event_.is_valid()) {
-        zx_status_t status = readable_event_.signal(0u, ZX_USER_SIGNAL_0);
+        zx_status_t status = readable_event_.signal(0u, kBlobReadableSignals);
         if (status != ZX_OK) {
             SetState(kBlobStateError);
             return status;
@@ -508,7 +670,9 @@ zx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
             blobfs_->UnreserveBlocks(inode_.num_blocks - blocks,
                                      inode_.start_block + blocks);
             inode_.num_blocks = blocks;
-            inode_.flags |= kBlobFlagLZ4Compressed;
+            inode_.flags |= kBlobFlagChunkCompressed;
+            // Persisted with the node below by WriteMetadata.
+            blobfs_->info_.version = kBlobfsVersion;
         } else {
             uint64_t blocks = fbl::round_up(inode_.blob_size, kBlobfsBlockSize) / kBlobfsBlockSize;
             if ((status = EnqueuePaginated(&wb, blobfs_, this, blob_->GetVmo(),
@@ -581,7 +745,7 @@ zx_status_t VnodeBlob::GetReadableEvent(zx_handle_t* out) {
         if (status != ZX_OK) {
             return status;
         } else if (GetState() == kBlobStateReadable) {
-            readable_event_.signal(0u, ZX_USER_SIGNAL_0);
+            readable_event_.signal(0u, kBlobReadableSignals);
         }
     }
     status = zx_handle_duplicate(readable_event_.get(), ZX_RIGHTS_BASIC | ZX_RIGHT_READ, out);
@@ -1302,6 +1466,7 @@ void Blobfs::Sync(SyncCallback closure) {
 
 void Blobfs::UpdateAllocationMetrics(uint64_t size_data, const fs::Duration& duration) {
     if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
         metrics_.blobs_created++;
         metrics_.blobs_created_total_size += size_data;
         metrics_.total_allocation_time_ticks += duration;
@@ -1310,6 +1475,7 @@ void Blobfs::UpdateAllocationMetrics(uint64_t size_data, const fs::Duration& dur
 
 void Blobfs::UpdateLookupMetrics(uint64_t size) {
     if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
         metrics_.blobs_opened++;
         metrics_.blobs_opened_total_size += size;
     }
@@ -1319,6 +1485,7 @@ void Blobfs::UpdateClientWriteMetrics(uint64_t data_size, uint64_t merkle_size,
                                       const fs::Duration& enqueue_duration,
                                       const fs::Duration& generate_duration) {
     if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
         metrics_.data_bytes_written += data_size;
         metrics_.merkle_bytes_written += merkle_size;
         metrics_.total_write_enqueue_time_ticks += enqueue_duration;
@@ -1328,6 +1495,7 @@ void Blobfs::UpdateClientWriteMetrics(uint64_t data_size, uint64_t merkle_size,
 
 void Blobfs::UpdateWritebackMetrics(uint64_t size, const fs::Duration& duration) {
     if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
         metrics_.total_writeback_time_ticks += duration;
         metrics_.total_writeback_bytes_written += size;
     }
@@ -1335,6 +1503,7 @@ void Blobfs::UpdateWritebackMetrics(uint64_t size, const fs::Duration& duration)
 
 void Blobfs::UpdateMerkleDiskReadMetrics(uint64_t size, const fs::Duration& duration) {
     if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
         metrics_.total_read_from_disk_time_ticks += duration;
         metrics_.bytes_read_from_disk += size;
     }
@@ -1345,6 +1514,7 @@ void Blobfs::UpdateMerkleDecompressMetrics(uint64_t size_compressed,
                                            const fs::Duration& read_duration,
                                            const fs::Duration& decompress_duration) {
     if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
         metrics_.bytes_compressed_read_from_disk += size_compressed;
         metrics_.bytes_decompressed_from_disk += size_uncompressed;
         metrics_.total_read_compressed_time_ticks += read_duration;
@@ -1355,6 +1525,7 @@ void Blobfs::UpdateMerkleDecompressMetrics(uint64_t size_compressed,
 void Blobfs::UpdateMerkleVerifyMetrics(uint64_t size_data, uint64_t size_merkle,
                                        const fs::Duration& duration) {
     if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
         metrics_.blobs_verified++;
         metrics_.blobs_verified_total_size_data += size_data;
         metrics_.blobs_verified_total_size_merkle += size_merkle;
@@ -1362,6 +1533,38 @@ void Blobfs::UpdateMerkleVerifyMetrics(uint64_t size_data, uint64_t size_merkle,
     }
 }
 
+void Blobfs::UpdateMerkleOpenMetrics(uint64_t size_data, const fs::Duration& duration) {
+    if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
+        metrics_.blobs_initialized++;
+        metrics_.blobs_initialized_total_size += size_data;
+        metrics_.total_initialization_time_ticks += duration;
+    }
+}
+
+void Blobfs::UpdateMerklePageInMetrics(uint64_t size, const fs::Duration& duration) {
+    if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
+        metrics_.chunks_paged_in++;
+        metrics_.bytes_paged_in += size;
+        metrics_.total_page_in_time_ticks += duration;
+    }
+}
+
+void Blobfs::UpdatePipelineMetrics(const fs::Duration& read_duration,
+                                   const fs::Duration& decompress_duration,
+                                   const fs::Duration& verify_duration,
+                                   const fs::Duration& duration) {
+    if (CollectingMetrics()) {
+        fbl::AutoLock lock(&metrics_lock_);
+        metrics_.blobs_pipelined++;
+        metrics_.total_pipeline_time_ticks += duration;
+        metrics_.total_pipeline_read_time_ticks += read_duration;
+        metrics_.total_pipeline_decompress_time_ticks += decompress_duration;
+        metrics_.total_pipeline_verify_time_ticks += verify_duration;
+    }
+}
+
 Blobfs::Blobfs(fbl::unique_fd fd, const blobfs_info_t* info)
     : blockfd_(fbl::move(fd)) {
     memcpy(&info_, info, sizeof(blobfs_info_t));
@@ -1373,6 +1576,10 @@ Blobfs::~Blobfs() {
     ZX_ASSERT(open_hash_.is_empty());
     closed_hash_.clear();
 
+    // Cached vnodes have already released their blobs, so nothing depends
+    // on the pager anymore.
+    pager_ = nullptr;
+
     if (blockfd_) {
         ioctl_block_fifo_close(Fd());
     }
@@ -1444,6 +1651,17 @@ zx_status_t Blobfs::Create(fbl::unique_fd fd, const blobfs_info_t* info,
         return status;
     }
 
+    if ((status = BlobPager::Create(fs.get(), &fs->pager_)) != ZX_OK) {
+        // Blobs can still be read, just not on demand.
+        fprintf(stderr, "blobfs: Failed to create pager: %d\n", status);
+        // Without the pager, chunk compressed blobs are read whole when
+        // opened, so overlap their reads with decompression instead.
+        if ((status = ChunkPipeline::Create(&fs->pipeline_)) != ZX_OK) {
+            // Chunk compressed blobs are then decompressed once fully read.
+            fprintf(stderr, "blobfs: Failed to create decompression pipeline: %d\n", status);
+        }
+    }
+
     *out = fbl::move(fs);
     return ZX_OK;
 }
@@ -46,7 +46,7 @@ zx_status_t blobfs_check_info(const blobfs_info_t* info, uint64_t max) {
         fprintf(stderr, "blobfs: bad magic\n");
         return ZX_ERR_INVALID_ARGS;
     }
-    if (info->version != kBlobfsVersion) {
+    if ((info->version < kBlobfsMinVersion) || (info->version > kBlobfsVersion)) {
         fprintf(stderr, "blobfs: FS Version: %08x. Driver version: %08x\n", info->version,
                 kBlobfsVersion);
         return ZX_ERR_INVALID_ARGS;
@@ -139,7 +139,7 @@ zx_status_t blobfs_add_mapped_blob_with_merkle(Blobfs* bs, void* blob_data, uint
     auto compressed_data = fbl::unique_ptr<uint8_t[]>(new uint8_t[max]);
     bool compressed = false;
     if ((length >= kCompressionMinBytesSaved) &&
-        (compressor.Initialize(compressed_data.get(), max) == ZX_OK) &&
+        (compressor.Initialize(compressed_data.get(), max, length) == ZX_OK) &&
         (compressor.Update(blob_data, length) == ZX_OK) &&
         (compressor.End() == ZX_OK) &&
         (length - kCompressionMinBytesSaved >= compressor.Size())) {
@@ -165,7 +165,7 @@ zx_status_t blobfs_add_mapped_blob_with_merkle(Blobfs* bs, void* blob_data, uint
     blobfs_inode_t* inode = inode_block->GetInode();
     inode->blob_size = length;
     inode->num_blocks = MerkleTreeBlocks(*inode) + data_blocks;
-    inode->flags |= (compressed ? kBlobFlagLZ4Compressed : 0);
+    inode->flags |= (compressed ? kBlobFlagChunkCompressed : 0);
 
     if ((status = bs->AllocateBlocks(inode->num_blocks,
                                      reinterpret_cast<size_t*>(&inode->start_block))) != ZX_OK) {
@@ -483,6 +483,10 @@ zx_status_t Blobfs::WriteNode(fbl::unique_ptr<InodeBlock> ino_block) {
 }
 
 zx_status_t Blobfs::WriteData(blobfs_inode_t* inode, const void* merkle_data, const void* blob_data) {
+    if (inode->flags & kBlobFlagChunkCompressed) {
+        // Persisted by the WriteInfo which follows every blob.
+        info_.version = kBlobfsVersion;
+    }
     const size_t merkle_blocks = MerkleTreeBlocks(*inode);
     const size_t data_blocks = inode->num_blocks - merkle_blocks;
     for (size_t n = 0; n < merkle_blocks; n++) {
@@ -584,7 +588,7 @@ zx_status_t Blobfs::VerifyBlob(size_t node_index) {
     // Create data buffer.
     fbl::unique_ptr<uint8_t[]> data(new uint8_t[target_size]);
 
-    if (inode.flags & kBlobFlagLZ4Compressed) {
+    if (inode.flags & (kBlobFlagLZ4Compressed | kBlobFlagChunkCompressed)) {
         // Read in uncompressed merkle blocks.
         for (unsigned i = 0; i < merkle_blocks; i++) {
             ReadBlock(data_start_block_ + inode.start_block + i);
@@ -612,8 +616,9 @@ zx_status_t Blobfs::VerifyBlob(size_t node_index) {
         zx_status_t status;
         target_size = inode.blob_size;
         uint8_t* data_ptr = data.get() + (merkle_blocks * kBlobfsBlockSize);
-        if ((status = Decompressor::Decompress(data_ptr, &target_size, compressed_data.get(),
-                                               &compressed_size)) != ZX_OK) {
+        if ((status = Decompressor::DecompressBlob(inode.flags, data_ptr, &target_size,
+                                                   compressed_data.get(),
+                                                   &compressed_size)) != ZX_OK) {
             return status;
         }
         if (target_size != inode.blob_size) {
@@ -18,9 +18,11 @@
 #include <block-client/cpp/client.h>
 #include <digest/digest.h>
 #include <fbl/algorithm.h>
+#include <fbl/auto_lock.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/intrusive_wavl_tree.h>
 #include <fbl/macros.h>
+#include <fbl/mutex.h>
 #include <fbl/ref_counted.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_fd.h>
@@ -41,6 +43,8 @@
 #include <blobfs/format.h>
 #include <blobfs/lz4.h>
 #include <blobfs/metrics.h>
+#include <blobfs/pager.h>
+#include <blobfs/pipeline.h>
 #include <blobfs/writeback.h>
 
 namespace blobfs {
@@ -223,17 +227,25 @@ private:
 
     // Read both VMOs into memory, if we haven't already.
     //
-    // TODO(ZX-1481): When we have can register the Blob Store as a pager
-    // service, and it can properly handle pages faults on a vnode's contents,
-    // then we can avoid reading the entire blob up-front. Until then, read
-    // the contents of a VMO into memory when it is opened.
+    // If blobfs has a pager, only the Merkle tree is read here; the data is
+    // read and verified by the pager as it is accessed. Otherwise, the
+    // entire blob is read and verified when it is opened.
     zx_status_t InitVmos();
 
+    // Initialize a blob whose VMO is backed by the pager.
+    zx_status_t InitPaged(size_t vmo_size);
+
     // Initialize a compressed blob by reading it from disk and decompressing
     // it.
     // Does not verify the blob.
     zx_status_t InitCompressed();
 
+    // Initialize a chunk compressed blob by reading it from disk, while
+    // the chunks which have already arrived are decompressed and verified
+    // in parallel.
+    // Verifies the blob.
+    zx_status_t InitChunkCompressed();
+
     // Initialize a deompressed blob by reading it from disk.
     // Does not verify the blob.
     zx_status_t InitUncompressed();
@@ -261,6 +273,8 @@ private:
     // 2) The Blob itself, aligned to the nearest kBlobfsBlockSize
     fbl::unique_ptr<fzl::MappedVmo> blob_ = {};
     vmoid_t vmoid_ = {};
+    // Identifies the blob to the pager, if blob_ is backed by it.
+    uint64_t pager_key_ = 0;
 
     // Watches any clones of "blob_" provided to clients.
     // Observes the ZX_VMO_ZERO_CHILDREN signal.
@@ -346,6 +360,7 @@ public:
     void DisableMetrics() { collecting_metrics_ = false; }
     void DumpMetrics() const {
         if (collecting_metrics_) {
+            fbl::AutoLock lock(&metrics_lock_);
             metrics_.Dump();
         }
     }
@@ -442,6 +457,22 @@ public:
     void UpdateMerkleVerifyMetrics(uint64_t size_data, uint64_t size_merkle,
                                    const fs::Duration& duration);
 
+    // Updates aggregate information about the time taken to make blobs
+    // readable when they are first accessed since mounting.
+    void UpdateMerkleOpenMetrics(uint64_t size_data, const fs::Duration& duration);
+
+    // Updates aggregate information about blob data supplied by the pager
+    // since mounting.
+    void UpdateMerklePageInMetrics(uint64_t size, const fs::Duration& duration);
+
+    // Updates aggregate information about blobs which passed through the
+    // decompression pipeline since mounting. The time spent in each stage
+    // may add up to more than |duration| when the stages overlap.
+    void UpdatePipelineMetrics(const fs::Duration& read_duration,
+                               const fs::Duration& decompress_duration,
+                               const fs::Duration& verify_duration,
+                               const fs::Duration& duration);
+
     blobfs_info_t info_;
 
     zx_status_t CreateWork(fbl::unique_ptr<WritebackWork>* out, VnodeBlob* vnode) {
@@ -591,7 +622,18 @@ private:
     size_t free_node_lower_bound_ = 0;
 
     bool collecting_metrics_ = false;
-    BlobfsMetrics metrics_ = {};
+    // Metrics are also updated by the pager thread.
+    mutable fbl::Mutex metrics_lock_;
+    BlobfsMetrics metrics_ __TA_GUARDED(metrics_lock_) = {};
+
+    // Supplies the data of opened blobs on demand. May be null, in which case
+    // blobs are read in their entirety when opened.
+    fbl::unique_ptr<BlobPager> pager_;
+
+    // Decompresses and verifies chunk compressed blobs as they are read. Only
+    // created when |pager_| is not, since paged blobs are never read whole.
+    // May be null, in which case they are decompressed after being read.
+    fbl::unique_ptr<ChunkPipeline> pipeline_;
 
     fbl::Closure on_unmount_ = {};
 };
@@ -27,7 +27,11 @@ namespace blobfs {
 
 constexpr uint64_t kBlobfsMagic0  = (0xac2153479e694d21ULL);
 constexpr uint64_t kBlobfsMagic1  = (0x985000d4d4d3d314ULL);
-constexpr uint32_t kBlobfsVersion = 0x00000006;
+constexpr uint32_t kBlobfsVersion = 0x00000007;
+// Oldest on-disk version still mounted. Version 6 images predate chunk
+// compressed blobs; they are bumped to kBlobfsVersion when the first one is
+// written, so older drivers never see a flag they cannot decode.
+constexpr uint32_t kBlobfsMinVersion = 0x00000006;
 
 constexpr uint32_t kBlobFlagClean        = 1;
 constexpr uint32_t kBlobFlagDirty        = 2;
@@ -136,6 +140,37 @@ constexpr uint64_t kStartBlockMinimum  = 1; // Smallest 'data' block possible.
 // Identifies that the on-disk storage of the blob is LZ4 compressed.
 constexpr uint32_t kBlobFlagLZ4Compressed = 0x00000001;
 
+// Identifies that the on-disk storage of the blob is a seek table
+// (blobfs_chunk_table_t) followed by independently LZ4 compressed chunks.
+constexpr uint32_t kBlobFlagChunkCompressed = 0x00000002;
+
+// The amount of blob data held by each chunk of a chunk compressed blob;
+// only the last chunk may be shorter. A multiple of the Merkle tree node
+// size, so that each chunk can be verified on its own.
+constexpr uint64_t kCompressionChunkSize = 32 * kBlobfsBlockSize;
+
+constexpr uint64_t kChunkTableMagic = (0x6b6e7568632d626cULL);
+
+// The header of the seek table of a chunk compressed blob. It is followed by
+// |chunk_count| uint64_t offsets at which each compressed chunk ends,
+// measured from the start of the header. The first chunk begins immediately
+// after the table, and every other chunk where its predecessor ends.
+typedef struct {
+    uint64_t magic;
+    uint32_t chunk_size;
+    uint32_t chunk_count;
+} blobfs_chunk_table_t;
+
+constexpr uint64_t ChunkCount(uint64_t blob_size) {
+    return fbl::round_up(blob_size, kCompressionChunkSize) / kCompressionChunkSize;
+}
+
+// Size of the seek table, including its header, of a chunk compressed blob
+// holding |blob_size| bytes.
+constexpr uint64_t ChunkTableSize(uint64_t blob_size) {
+    return sizeof(blobfs_chunk_table_t) + ChunkCount(blob_size) * sizeof(uint64_t);
+}
+
 using digest::Digest;
 typedef struct {
     uint8_t  merkle_root_hash[Digest::kLength];
@@ -6,10 +6,19 @@
 
 #include <lz4/lz4frame.h>
 
+#include <blobfs/format.h>
+
 namespace blobfs {
 
+// The largest frame header written by LZ4F_compressBegin().
+constexpr size_t kMaxFrameHeaderSize = 19;
+
 // A Compressor is used to compress a blob transparently before it is written
 // back to disk.
+//
+// The blob is compressed in the chunked format described by
+// blobfs_chunk_table_t: one LZ4 frame for every kCompressionChunkSize bytes
+// of the blob, preceded by a table of where each frame ends.
 class Compressor {
 public:
     Compressor();
@@ -28,18 +37,23 @@ public:
     size_t Size() const;
 
     // Initializes the compression object with a provided
-    // buffer of a specified size.
+    // buffer of a specified size, to compress a blob of |blob_size| bytes.
     //
     // Although Compressor uses this buffer, it does not own the buffer,
     // assuming that a parent object is responsible for the lifetime.
-    zx_status_t Initialize(void* buf, size_t buf_max);
+    zx_status_t Initialize(void* buf, size_t buf_max, size_t blob_size);
 
     // Returns the maximum possible size a buffer would need to be
     // in order to compress a blob of size |blob_size|.
     //
     // Typically used in conjunction with |Initialize()|.
     size_t BufferMax(size_t blob_size) const {
-        return LZ4F_compressBound(blob_size, nullptr);
+        return ChunkTableSize(blob_size) + ChunkCount(blob_size) * ChunkBufferMax();
+    }
+
+    // Returns the maximum possible compressed size of a single chunk.
+    static size_t ChunkBufferMax() {
+        return kMaxFrameHeaderSize + LZ4F_compressBound(kCompressionChunkSize, nullptr);
     }
 
     // Continues the compression after initialization.
@@ -58,10 +72,25 @@ private:
 
     size_t buf_remaining() const { return buf_max_ - buf_used_; }
 
+    blobfs_chunk_table_t* Table() const {
+        return reinterpret_cast<blobfs_chunk_table_t*>(buf_);
+    }
+
+    uint64_t* ChunkEnds() const {
+        return reinterpret_cast<uint64_t*>(Table() + 1);
+    }
+
+    // Closes the frame of the current chunk and records where it ends.
+    zx_status_t EndChunk();
+
     LZ4F_compressionContext_t ctx_;
     void* buf_;
     size_t buf_max_;
     size_t buf_used_;
+    // The number of chunks which have been started.
+    uint32_t chunks_;
+    // The amount of data consumed by the current chunk.
+    size_t chunk_used_;
 };
 
 // A Decompressor is used to decompress a blob transparently before it is
@@ -73,6 +102,26 @@ public:
     // filled (or both).
     static zx_status_t Decompress(void* target_buf, size_t* target_size,
                                   const void* src_buf, size_t* src_size);
+
+    // Decompresses a blob stored in the compressed format identified
+    // by the inode |flags|, with the same semantics as |Decompress()|.
+    static zx_status_t DecompressBlob(uint32_t flags, void* target_buf, size_t* target_size,
+                                      const void* src_buf, size_t* src_size);
+
+    // Checks that the first |table_size| bytes of a chunk compressed blob
+    // hold a well formed seek table for a blob of |blob_size| bytes, which
+    // fits within |compressed_size| bytes.
+    static zx_status_t ValidateChunkTable(const void* table, size_t table_size,
+                                          size_t compressed_size, size_t blob_size);
+
+    // Returns the range [*start, *end) occupied by chunk |index|, relative
+    // to the start of the already validated seek table |table|.
+    static void ChunkBounds(const void* table, uint64_t index, uint64_t* start, uint64_t* end);
+
+    // Decompresses every chunk of the chunk compressed blob held by the
+    // |src_size| bytes of |src_buf| into |target_buf|.
+    static zx_status_t DecompressChunked(void* target_buf, size_t* target_size,
+                                         const void* src_buf, size_t* src_size);
 };
 
 } // namespace blobfs
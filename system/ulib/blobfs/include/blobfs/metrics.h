@@ -61,6 +61,28 @@ struct BlobfsMetrics {
     uint64_t blobs_verified_total_size_data = 0;
     uint64_t blobs_verified_total_size_merkle = 0;
     zx::ticks total_verification_time_ticks = {};
+    // Made readable by "InitVmos"; for paged blobs, this excludes the data.
+    uint64_t blobs_initialized = 0;
+    uint64_t blobs_initialized_total_size = 0;
+    zx::ticks total_initialization_time_ticks = {};
+
+    // PAGING STATS
+
+    // Data read, verified and supplied by the pager as it was faulted in.
+    uint64_t chunks_paged_in = 0;
+    uint64_t bytes_paged_in = 0;
+    zx::ticks total_page_in_time_ticks = {};
+
+    // PIPELINE STATS
+
+    // Chunk compressed blobs which were decompressed and verified while
+    // still being read. The time spent in each stage is summed across
+    // threads, so the stages overlap when their sum exceeds the total.
+    uint64_t blobs_pipelined = 0;
+    zx::ticks total_pipeline_time_ticks = {};
+    zx::ticks total_pipeline_read_time_ticks = {};
+    zx::ticks total_pipeline_decompress_time_ticks = {};
+    zx::ticks total_pipeline_verify_time_ticks = {};
 
     // FVM STATS
     // TODO(smklein)
@@ -0,0 +1,127 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file contains the pager which lets blobs be read lazily from disk.
+
+#pragma once
+
+#ifndef __Fuchsia__
+#error Fuchsia-only Header
+#endif
+
+#include <threads.h>
+
+#include <block-client/cpp/client.h>
+#include <digest/digest.h>
+#include <fbl/array.h>
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/macros.h>
+#include <fbl/mutex.h>
+#include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
+#include <fbl/unique_ptr.h>
+#include <lib/fzl/mapped-vmo.h>
+#include <lib/zx/pager.h>
+#include <lib/zx/port.h>
+#include <lib/zx/vmo.h>
+
+#include <blobfs/format.h>
+
+namespace blobfs {
+
+class Blobfs;
+
+using digest::Digest;
+
+// The unit in which the pager reads, verifies and supplies blob data.
+// A multiple of the Merkle tree node size, so each chunk can be verified
+// on its own. Matches the chunks of chunk compressed blobs, so that each
+// can be decompressed independently.
+constexpr size_t kPagerChunkSize = kCompressionChunkSize;
+
+// Backs the VMOs of opened blobs with a kernel pager. The Merkle tree of a
+// blob is read when its VMO is created; the data is read, decompressed and
+// verified one chunk at a time, on a dedicated thread, as it is faulted in.
+class BlobPager {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(BlobPager);
+
+    static zx_status_t Create(Blobfs* bs, fbl::unique_ptr<BlobPager>* out);
+    ~BlobPager();
+
+    // Creates a VMO of |vmo_size| bytes for the blob described by |inode|
+    // with Merkle root |digest|, laid out like an eagerly read blob: the
+    // Merkle tree, followed by the data. |out_key| identifies the blob to
+    // ReleaseBlob().
+    zx_status_t CreateBlobVmo(const blobfs_inode_t& inode, const uint8_t* digest,
+                              size_t vmo_size, zx::vmo* out, uint64_t* out_key);
+
+    // Stops supplying pages for the blob identified by |key|.
+    void ReleaseBlob(uint64_t key);
+
+private:
+    // The state needed to supply the pages of a single blob.
+    struct PagedBlob : public fbl::RefCounted<PagedBlob>,
+                       public fbl::WAVLTreeContainable<fbl::RefPtr<PagedBlob>> {
+        uint64_t GetKey() const { return key; }
+
+        uint64_t key = 0;
+        zx::vmo vmo;
+        blobfs_inode_t inode = {};
+        Digest digest;
+        fbl::Array<uint8_t> merkle;
+        size_t merkle_size = 0;
+        // Offset of the data within |vmo|.
+        uint64_t data_offset = 0;
+        // Set for each chunk of data which has been supplied.
+        fbl::Array<bool> supplied;
+        // The seek table of a chunk compressed blob.
+        fbl::Array<uint8_t> chunk_table;
+        // The entire data of an LZ4 compressed blob, decompressed on first
+        // access.
+        fbl::unique_ptr<fzl::MappedVmo> decompressed;
+    };
+
+    explicit BlobPager(Blobfs* bs);
+
+    static int PagerThread(void* arg);
+
+    // Reads the Merkle tree of |blob| from disk into |blob->merkle| and
+    // supplies it to |blob->vmo|. The seek table of a chunk compressed blob
+    // is read into |blob->chunk_table| at the same time.
+    zx_status_t SupplyMerkle(PagedBlob* blob);
+
+    // Reads, verifies and supplies the chunk of |blob| containing |offset|.
+    zx_status_t SupplyChunk(PagedBlob* blob, uint64_t offset);
+
+    // Calls SupplyChunk(), retrying for a while if it fails for a reason
+    // which might go away, such as running out of memory.
+    zx_status_t SupplyChunkWithRetry(PagedBlob* blob, uint64_t offset);
+
+    // Reads and decompresses the entire data of an LZ4 compressed blob.
+    zx_status_t Decompress(PagedBlob* blob);
+
+    // Reads and decompresses a single chunk of a chunk compressed blob
+    // into |transfer_|.
+    zx_status_t DecompressChunk(PagedBlob* blob, uint64_t chunk);
+
+    Blobfs* const bs_;
+    zx::pager pager_;
+    zx::port port_;
+    thrd_t pager_thrd_;
+    bool thread_started_ = false;
+
+    // Staging buffer for uncompressed chunks; only used by the pager thread.
+    fbl::unique_ptr<fzl::MappedVmo> transfer_;
+    vmoid_t transfer_vmoid_ = VMOID_INVALID;
+    // Staging buffer for compressed chunks; only used by the pager thread.
+    fbl::unique_ptr<fzl::MappedVmo> compressed_transfer_;
+    vmoid_t compressed_transfer_vmoid_ = VMOID_INVALID;
+
+    fbl::Mutex lock_;
+    uint64_t next_key_ __TA_GUARDED(lock_) = 1;
+    fbl::WAVLTree<uint64_t, fbl::RefPtr<PagedBlob>> blobs_ __TA_GUARDED(lock_);
+};
+
+} // namespace blobfs
@@ -0,0 +1,111 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file contains the pipeline which decompresses and verifies chunk
+// compressed blobs while they are still being read from disk.
+
+#pragma once
+
+#ifndef __Fuchsia__
+#error Fuchsia-only Header
+#endif
+
+#include <threads.h>
+
+#include <digest/digest.h>
+#include <fbl/macros.h>
+#include <fbl/mutex.h>
+#include <fbl/unique_ptr.h>
+#include <fs/ticker.h>
+#include <zircon/types.h>
+
+namespace blobfs {
+
+using digest::Digest;
+
+// The largest number of worker threads used by the pipeline.
+constexpr size_t kPipelineMaxThreads = 4;
+
+// The number of chunks read from disk at a time while the workers process
+// the chunks already read.
+constexpr uint64_t kPipelineReadChunks = 4;
+
+// Decompresses and verifies the chunks of a chunk compressed blob on a small
+// pool of threads, while the caller continues to read the remainder of the
+// blob from disk.
+//
+// Only one blob passes through the pipeline at a time.
+class ChunkPipeline {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(ChunkPipeline);
+
+    // Describes a single blob passing through the pipeline.
+    struct Job {
+        // The compressed data, starting with its seek table, which has
+        // already been validated.
+        const uint8_t* compressed = nullptr;
+        // The destination of the decompressed data.
+        uint8_t* data = nullptr;
+        size_t blob_size = 0;
+        const uint8_t* merkle = nullptr;
+        size_t merkle_size = 0;
+        Digest digest;
+        bool collecting_metrics = false;
+
+        // Time spent decompressing and verifying, summed across workers.
+        fs::Duration decompress_duration = {};
+        fs::Duration verify_duration = {};
+
+    private:
+        friend ChunkPipeline;
+
+        // Chunks [0, readable_) have been read from disk.
+        uint64_t readable_ = 0;
+        // The next chunk to be handed to a worker.
+        uint64_t next_ = 0;
+        zx_status_t status_ = ZX_OK;
+    };
+
+    static zx_status_t Create(fbl::unique_ptr<ChunkPipeline>* out);
+    ~ChunkPipeline();
+
+    // Makes |job| the blob being processed. No chunk is processed until
+    // it is marked readable.
+    void Begin(Job* job);
+
+    // Marks chunks [0, count) of the current blob as read from disk, and
+    // returns the first failure seen so far, so that the caller can stop
+    // reading early.
+    zx_status_t SetReadable(uint64_t count);
+
+    // Waits for every readable chunk to be processed, then detaches the
+    // current blob. Returns the first failure to decompress or verify a
+    // chunk.
+    zx_status_t Finish();
+
+private:
+    ChunkPipeline() = default;
+
+    static int WorkerThread(void* arg);
+
+    // Decompresses and verifies a single chunk of |job|.
+    static zx_status_t ProcessChunk(Job* job, uint64_t chunk, fs::Duration* decompress,
+                                    fs::Duration* verify);
+
+    // True if a worker may take a chunk of the current job.
+    bool HasWork() const __TA_REQUIRES(lock_);
+
+    fbl::Mutex lock_;
+    cnd_t work_cvar_;
+    cnd_t done_cvar_;
+    Job* job_ __TA_GUARDED(lock_) = nullptr;
+    // Chunks of |job_| currently being processed.
+    uint64_t in_flight_ __TA_GUARDED(lock_) = 0;
+    bool stopping_ __TA_GUARDED(lock_) = false;
+
+    thrd_t threads_[kPipelineMaxThreads];
+    size_t thread_count_ = 0;
+};
+
+} // namespace blobfs
@@ -4,6 +4,7 @@
 
 #include <lz4/lz4frame.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <fbl/algorithm.h>
@@ -30,8 +31,15 @@ void Compressor::Reset() {
     buf_ = nullptr;
 }
 
-zx_status_t Compressor::Initialize(void* buf, size_t buf_max) {
+zx_status_t Compressor::Initialize(void* buf, size_t buf_max, size_t blob_size) {
     ZX_DEBUG_ASSERT(!Compressing());
+    const size_t table_size = ChunkTableSize(blob_size);
+    if (blob_size == 0 || ChunkCount(blob_size) > UINT32_MAX) {
+        return ZX_ERR_INVALID_ARGS;
+    } else if (buf_max < table_size) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+
     LZ4F_errorCode_t errc = LZ4F_createCompressionContext(&ctx_, LZ4F_VERSION);
     if (LZ4F_isError(errc)) {
         return ZX_ERR_NO_MEMORY;
@@ -39,32 +47,72 @@ zx_status_t Compressor::Initialize(void* buf, size_t buf_max) {
 
     buf_ = buf;
     buf_max_ = buf_max;
-    buf_used_ = 0;
+    buf_used_ = table_size;
+    chunks_ = 0;
+    chunk_used_ = 0;
+
+    // The chunk offsets are filled in as each chunk is finished.
+    memset(buf_, 0, table_size);
+    Table()->magic = kChunkTableMagic;
+    Table()->chunk_size = kCompressionChunkSize;
+    Table()->chunk_count = static_cast<uint32_t>(ChunkCount(blob_size));
+    return ZX_OK;
+}
 
-    size_t r = LZ4F_compressBegin(ctx_, Buffer(), buf_remaining(), nullptr);
-    if (LZ4F_isError(r)) {
-        return ZX_ERR_BUFFER_TOO_SMALL;
-    }
-    buf_used_ += r;
+zx_status_t Compressor::Update(const void* data_, size_t length) {
+    const uint8_t* data = static_cast<const uint8_t*>(data_);
+    while (length > 0) {
+        if (chunk_used_ == 0) {
+            if (chunks_ == Table()->chunk_count) {
+                // More data than the blob was initialized with.
+                return ZX_ERR_IO_DATA_INTEGRITY;
+            }
+            size_t r = LZ4F_compressBegin(ctx_, Buffer(), buf_remaining(), nullptr);
+            if (LZ4F_isError(r)) {
+                return ZX_ERR_IO_DATA_INTEGRITY;
+            }
+            buf_used_ += r;
+            chunks_++;
+        }
 
+        size_t chunk_length = fbl::min(length, kCompressionChunkSize - chunk_used_);
+        size_t r = LZ4F_compressUpdate(ctx_, Buffer(), buf_remaining(), data, chunk_length,
+                                       nullptr);
+        if (LZ4F_isError(r)) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        buf_used_ += r;
+        chunk_used_ += chunk_length;
+        data += chunk_length;
+        length -= chunk_length;
+
+        zx_status_t status;
+        if (chunk_used_ == kCompressionChunkSize && (status = EndChunk()) != ZX_OK) {
+            return status;
+        }
+    }
     return ZX_OK;
 }
 
-zx_status_t Compressor::Update(const void* data, size_t length) {
-    size_t r = LZ4F_compressUpdate(ctx_, Buffer(), buf_remaining(), data, length, nullptr);
+zx_status_t Compressor::EndChunk() {
+    size_t r = LZ4F_compressEnd(ctx_, Buffer(), buf_remaining(), nullptr);
     if (LZ4F_isError(r)) {
         return ZX_ERR_IO_DATA_INTEGRITY;
     }
     buf_used_ += r;
+    ChunkEnds()[chunks_ - 1] = buf_used_;
+    chunk_used_ = 0;
     return ZX_OK;
 }
 
 zx_status_t Compressor::End() {
-    size_t r = LZ4F_compressEnd(ctx_, Buffer(), buf_remaining(), nullptr);
-    if (LZ4F_isError(r)) {
+    zx_status_t status;
+    if (chunk_used_ != 0 && (status = EndChunk()) != ZX_OK) {
+        return status;
+    } else if (chunks_ != Table()->chunk_count) {
+        // Less data than the blob was initialized with.
         return ZX_ERR_IO_DATA_INTEGRITY;
     }
-    buf_used_ += r;
     return ZX_OK;
 }
 
@@ -112,11 +160,17 @@ zx_status_t Decompressor::Decompress(void* target_buf_, size_t* target_size,
 
         if (r == 0) {
             break;
+        } else if (dst_sz_next == 0 && src_sz_next == 0) {
+            // The frame holds more data than the target can take.
+            return ZX_ERR_IO_DATA_INTEGRITY;
         }
 
         dst_sz_next = *target_size - target_drained;
-        src_sz_next = r;
-
+        src_sz_next = fbl::min(r, *src_size - src_drained);
+        if (src_sz_next == 0) {
+            // The frame continues past the end of the source.
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
     }
 
     *target_size = target_drained;
@@ -124,4 +178,77 @@ zx_status_t Decompressor::Decompress(void* target_buf_, size_t* target_size,
     return ZX_OK;
 }
 
+zx_status_t Decompressor::DecompressBlob(uint32_t flags, void* target_buf, size_t* target_size,
+                                         const void* src_buf, size_t* src_size) {
+    if (flags & kBlobFlagChunkCompressed) {
+        return DecompressChunked(target_buf, target_size, src_buf, src_size);
+    }
+    return Decompress(target_buf, target_size, src_buf, src_size);
+}
+
+zx_status_t Decompressor::ValidateChunkTable(const void* table_, size_t table_size,
+                                             size_t compressed_size, size_t blob_size) {
+    const blobfs_chunk_table_t* table = static_cast<const blobfs_chunk_table_t*>(table_);
+    if (table_size < sizeof(blobfs_chunk_table_t) || table->magic != kChunkTableMagic ||
+        table->chunk_size != kCompressionChunkSize ||
+        table->chunk_count != ChunkCount(blob_size) ||
+        table_size < ChunkTableSize(blob_size)) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+
+    const uint64_t* ends = reinterpret_cast<const uint64_t*>(table + 1);
+    uint64_t start = ChunkTableSize(blob_size);
+    for (uint64_t i = 0; i < table->chunk_count; i++) {
+        if (ends[i] <= start || ends[i] > compressed_size ||
+            ends[i] - start > Compressor::ChunkBufferMax()) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        start = ends[i];
+    }
+    return ZX_OK;
+}
+
+void Decompressor::ChunkBounds(const void* table_, uint64_t index, uint64_t* start,
+                               uint64_t* end) {
+    const blobfs_chunk_table_t* table = static_cast<const blobfs_chunk_table_t*>(table_);
+    const uint64_t* ends = reinterpret_cast<const uint64_t*>(table + 1);
+    ZX_DEBUG_ASSERT(index < table->chunk_count);
+    *start = (index == 0) ? sizeof(blobfs_chunk_table_t) + table->chunk_count * sizeof(uint64_t)
+                          : ends[index - 1];
+    *end = ends[index];
+}
+
+zx_status_t Decompressor::DecompressChunked(void* target_buf_, size_t* target_size,
+                                            const void* src_buf_, size_t* src_size) {
+    TRACE_DURATION("blobfs", "Decompressor::DecompressChunked", "target_size", *target_size,
+                   "src_size", *src_size);
+    uint8_t* target_buf = reinterpret_cast<uint8_t*>(target_buf_);
+    const uint8_t* src_buf = reinterpret_cast<const uint8_t*>(src_buf_);
+
+    // The target is expected to be exactly the size of the blob.
+    const size_t blob_size = *target_size;
+    zx_status_t status = ValidateChunkTable(src_buf, *src_size, *src_size, blob_size);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    uint64_t start, end = 0;
+    for (uint64_t i = 0; i < ChunkCount(blob_size); i++) {
+        ChunkBounds(src_buf, i, &start, &end);
+        const uint64_t offset = i * kCompressionChunkSize;
+        const size_t expected = fbl::min(kCompressionChunkSize, blob_size - offset);
+        size_t chunk_target = expected;
+        size_t chunk_src = end - start;
+        if ((status = Decompress(target_buf + offset, &chunk_target, src_buf + start,
+                                 &chunk_src)) != ZX_OK) {
+            return status;
+        } else if (chunk_target != expected || chunk_src != end - start) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+    }
+
+    *src_size = end;
+    return ZX_OK;
+}
+
 } // namespace blobfs
@@ -45,6 +45,19 @@ void BlobfsMetrics::Dump() const {
            TicksToMs(total_read_from_disk_time_ticks),
            bytes_read_from_disk / mb,
            TicksToMs(total_verification_time_ticks));
+    printf("  Initialized %zu blobs (%zu MB) in %zu ms\n", blobs_initialized,
+           blobs_initialized_total_size / mb,
+           TicksToMs(total_initialization_time_ticks));
+    printf("Paging Info:\n");
+    printf("  Paged in %zu chunks (%zu MB) in %zu ms\n", chunks_paged_in,
+           bytes_paged_in / mb, TicksToMs(total_page_in_time_ticks));
+    printf("Pipeline Info:\n");
+    printf("  Pipelined %zu blobs in %zu ms\n", blobs_pipelined,
+           TicksToMs(total_pipeline_time_ticks));
+    printf("  Spent %zu ms reading, %zu ms decompressing, %zu ms verifying\n",
+           TicksToMs(total_pipeline_read_time_ticks),
+           TicksToMs(total_pipeline_decompress_time_ticks),
+           TicksToMs(total_pipeline_verify_time_ticks));
 }
 
 } // namespace blobfs
@@ -0,0 +1,477 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <digest/merkle-tree.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/auto_call.h>
+#include <fbl/auto_lock.h>
+#include <fs/block-txn.h>
+#include <fs/ticker.h>
+#include <fs/trace.h>
+#include <lib/zx/time.h>
+#include <zircon/status.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/port.h>
+
+#include <blobfs/blobfs.h>
+#include <blobfs/lz4.h>
+#include <blobfs/pager.h>
+
+using digest::MerkleTree;
+
+namespace blobfs {
+namespace {
+
+// How often, and how patiently, a chunk which failed to be supplied is
+// retried before its blob's VMO is given up on.
+constexpr int kSupplyAttempts = 5;
+constexpr zx::duration kSupplyRetryDelay = zx::msec(10);
+
+// Errors which retrying the same chunk won't fix: the data on disk is bad,
+// or the blob's VMO is gone.
+bool IsPermanentSupplyError(zx_status_t status) {
+    switch (status) {
+    case ZX_ERR_IO_DATA_INTEGRITY:
+    case ZX_ERR_OUT_OF_RANGE:
+    case ZX_ERR_INVALID_ARGS:
+    case ZX_ERR_BAD_STATE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+BlobPager::BlobPager(Blobfs* bs) : bs_(bs) {}
+
+BlobPager::~BlobPager() {
+    if (thread_started_) {
+        zx_port_packet_t packet = {};
+        packet.type = ZX_PKT_TYPE_USER;
+        ZX_ASSERT(port_.queue(&packet) == ZX_OK);
+        int r;
+        thrd_join(pager_thrd_, &r);
+    }
+
+    if (transfer_vmoid_ != VMOID_INVALID) {
+        bs_->DetachVmo(transfer_vmoid_);
+    }
+    if (compressed_transfer_vmoid_ != VMOID_INVALID) {
+        bs_->DetachVmo(compressed_transfer_vmoid_);
+    }
+}
+
+zx_status_t BlobPager::Create(Blobfs* bs, fbl::unique_ptr<BlobPager>* out) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<BlobPager> pager(new (&ac) BlobPager(bs));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    // Large enough for the blocks holding any single compressed chunk, which
+    // need not start on a block boundary.
+    const size_t compressed_transfer_size =
+        fbl::round_up(Compressor::ChunkBufferMax(), kBlobfsBlockSize) + kBlobfsBlockSize;
+
+    zx_status_t status;
+    if ((status = zx::pager::create(0, &pager->pager_)) != ZX_OK) {
+        return status;
+    } else if ((status = zx::port::create(0, &pager->port_)) != ZX_OK) {
+        return status;
+    } else if ((status = fzl::MappedVmo::Create(kPagerChunkSize, "blob-pager",
+                                               &pager->transfer_)) != ZX_OK) {
+        return status;
+    } else if ((status = bs->AttachVmo(pager->transfer_->GetVmo(),
+                                       &pager->transfer_vmoid_)) != ZX_OK) {
+        return status;
+    } else if ((status = fzl::MappedVmo::Create(compressed_transfer_size, "blob-pager-compressed",
+                                               &pager->compressed_transfer_)) != ZX_OK) {
+        return status;
+    } else if ((status = bs->AttachVmo(pager->compressed_transfer_->GetVmo(),
+                                       &pager->compressed_transfer_vmoid_)) != ZX_OK) {
+        return status;
+    } else if (thrd_create_with_name(&pager->pager_thrd_, BlobPager::PagerThread,
+                                     pager.get(), "blobfs-pager") != thrd_success) {
+        return ZX_ERR_NO_RESOURCES;
+    }
+    pager->thread_started_ = true;
+
+    *out = fbl::move(pager);
+    return ZX_OK;
+}
+
+zx_status_t BlobPager::CreateBlobVmo(const blobfs_inode_t& inode, const uint8_t* digest,
+                                     size_t vmo_size, zx::vmo* out, uint64_t* out_key) {
+    TRACE_DURATION("blobfs", "BlobPager::CreateBlobVmo", "size", inode.blob_size);
+    fbl::AllocChecker ac;
+    fbl::RefPtr<PagedBlob> blob = fbl::AdoptRef(new (&ac) PagedBlob());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    const uint64_t merkle_blocks = MerkleTreeBlocks(inode);
+    const uint64_t data_size = BlobDataBlocks(inode) * kBlobfsBlockSize;
+    const size_t chunks = fbl::round_up(data_size, kPagerChunkSize) / kPagerChunkSize;
+    blob->inode = inode;
+    blob->digest = digest;
+    blob->data_offset = merkle_blocks * kBlobfsBlockSize;
+    blob->merkle_size = MerkleTree::GetTreeLength(inode.blob_size);
+    blob->supplied.reset(new (&ac) bool[chunks](), chunks);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    {
+        fbl::AutoLock lock(&lock_);
+        blob->key = next_key_++;
+    }
+
+    zx::vmo vmo;
+    zx_status_t status = pager_.create_vmo(port_, blob->key, vmo_size, 0, &vmo);
+    if (status != ZX_OK) {
+        FS_TRACE_ERROR("blobfs: Failed to create pager vmo: %d\n", status);
+        return status;
+    } else if ((status = vmo.duplicate(ZX_RIGHT_SAME_RIGHTS, &blob->vmo)) != ZX_OK) {
+        return status;
+    }
+
+    // The tree is needed to verify every chunk, so it is read up front.
+    if ((status = SupplyMerkle(blob.get())) != ZX_OK) {
+        FS_TRACE_ERROR("blobfs: Failed to read merkle tree: %d\n", status);
+        return status;
+    }
+
+    *out_key = blob->key;
+    {
+        fbl::AutoLock lock(&lock_);
+        blobs_.insert(fbl::move(blob));
+    }
+    *out = fbl::move(vmo);
+    return ZX_OK;
+}
+
+void BlobPager::ReleaseBlob(uint64_t key) {
+    fbl::RefPtr<PagedBlob> blob;
+    {
+        fbl::AutoLock lock(&lock_);
+        blob = blobs_.erase(key);
+    }
+    // Any request still queued for the blob is dropped by the pager thread
+    // once it fails to find it.
+}
+
+zx_status_t BlobPager::SupplyMerkle(PagedBlob* blob) {
+    const uint64_t merkle_blocks = blob->data_offset / kBlobfsBlockSize;
+    uint64_t table_blocks = 0;
+    if (blob->inode.flags & kBlobFlagChunkCompressed) {
+        // The seek table immediately follows the tree, so it is read with it.
+        table_blocks = fbl::round_up(ChunkTableSize(blob->inode.blob_size),
+                                     kBlobfsBlockSize) / kBlobfsBlockSize;
+        if (table_blocks > blob->inode.num_blocks - merkle_blocks) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+    }
+    const uint64_t read_blocks = merkle_blocks + table_blocks;
+    if (read_blocks == 0) {
+        return ZX_OK;
+    }
+
+    fbl::AllocChecker ac;
+    blob->merkle.reset(new (&ac) uint8_t[blob->data_offset], blob->data_offset);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    fs::Ticker ticker(bs_->CollectingMetrics());
+    fbl::unique_ptr<fzl::MappedVmo> merkle;
+    zx_status_t status = fzl::MappedVmo::Create(read_blocks * kBlobfsBlockSize, "blob-merkle",
+                                               &merkle);
+    if (status != ZX_OK) {
+        return status;
+    }
+    vmoid_t merkle_vmoid;
+    if ((status = bs_->AttachVmo(merkle->GetVmo(), &merkle_vmoid)) != ZX_OK) {
+        return status;
+    }
+    auto detach = fbl::MakeAutoCall([this, &merkle_vmoid]() {
+        bs_->DetachVmo(merkle_vmoid);
+    });
+
+    fs::ReadTxn txn(bs_);
+    txn.Enqueue(merkle_vmoid, 0, blob->inode.start_block + DataStartBlock(bs_->info_),
+                read_blocks);
+    if ((status = txn.Transact()) != ZX_OK) {
+        return status;
+    }
+    bs_->UpdateMerkleDiskReadMetrics(read_blocks * kBlobfsBlockSize, ticker.End());
+
+    if (table_blocks != 0) {
+        const size_t table_size = table_blocks * kBlobfsBlockSize;
+        const uint8_t* table = static_cast<const uint8_t*>(merkle->GetData()) +
+                               blob->data_offset;
+        const size_t compressed_size = (blob->inode.num_blocks - merkle_blocks) *
+                                       kBlobfsBlockSize;
+        if ((status = Decompressor::ValidateChunkTable(table, table_size, compressed_size,
+                                                       blob->inode.blob_size)) != ZX_OK) {
+            FS_TRACE_ERROR("blobfs: Invalid chunk table\n");
+            return status;
+        }
+        blob->chunk_table.reset(new (&ac) uint8_t[table_size], table_size);
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        memcpy(blob->chunk_table.get(), table, table_size);
+    }
+
+    if (blob->data_offset == 0) {
+        return ZX_OK;
+    }
+    memcpy(blob->merkle.get(), merkle->GetData(), blob->data_offset);
+    return zx_pager_supply_pages(pager_.get(), blob->vmo.get(), 0, blob->data_offset,
+                                 merkle->GetVmo(), 0);
+}
+
+zx_status_t BlobPager::Decompress(PagedBlob* blob) {
+    TRACE_DURATION("blobfs", "BlobPager::Decompress", "size", blob->inode.blob_size);
+    fs::Ticker ticker(bs_->CollectingMetrics());
+    const uint64_t merkle_blocks = blob->data_offset / kBlobfsBlockSize;
+    const uint64_t compressed_blocks = blob->inode.num_blocks - merkle_blocks;
+    size_t compressed_size = compressed_blocks * kBlobfsBlockSize;
+    const size_t data_size = BlobDataBlocks(blob->inode) * kBlobfsBlockSize;
+
+    fbl::unique_ptr<fzl::MappedVmo> compressed;
+    zx_status_t status = fzl::MappedVmo::Create(compressed_size, "compressed-blob", &compressed);
+    if (status != ZX_OK) {
+        return status;
+    }
+    vmoid_t compressed_vmoid;
+    if ((status = bs_->AttachVmo(compressed->GetVmo(), &compressed_vmoid)) != ZX_OK) {
+        return status;
+    }
+    auto detach = fbl::MakeAutoCall([this, &compressed_vmoid]() {
+        bs_->DetachVmo(compressed_vmoid);
+    });
+
+    fs::ReadTxn txn(bs_);
+    txn.Enqueue(compressed_vmoid, 0,
+                blob->inode.start_block + DataStartBlock(bs_->info_) + merkle_blocks,
+                compressed_blocks);
+    if ((status = txn.Transact()) != ZX_OK) {
+        return status;
+    }
+    fs::Duration read_time = ticker.End();
+    ticker.Reset();
+
+    fbl::unique_ptr<fzl::MappedVmo> decompressed;
+    if ((status = fzl::MappedVmo::Create(data_size, "blob-decompressed",
+                                        &decompressed)) != ZX_OK) {
+        return status;
+    }
+    size_t target_size = blob->inode.blob_size;
+    status = Decompressor::Decompress(decompressed->GetData(), &target_size,
+                                      compressed->GetData(), &compressed_size);
+    if (status != ZX_OK) {
+        return status;
+    } else if (target_size != blob->inode.blob_size) {
+        FS_TRACE_ERROR("Failed to fully decompress blob (%zu of %zu expected)\n",
+                       target_size, blob->inode.blob_size);
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    // Commit the tail of the last block too, so that every chunk can be
+    // moved into the blob's VMO as a whole.
+    memset(static_cast<uint8_t*>(decompressed->GetData()) + target_size, 0,
+           data_size - target_size);
+
+    bs_->UpdateMerkleDecompressMetrics(compressed_blocks * kBlobfsBlockSize,
+                                       blob->inode.blob_size, read_time, ticker.End());
+    blob->decompressed = fbl::move(decompressed);
+    return ZX_OK;
+}
+
+zx_status_t BlobPager::DecompressChunk(PagedBlob* blob, uint64_t chunk) {
+    TRACE_DURATION("blobfs", "BlobPager::DecompressChunk", "chunk", chunk);
+    fs::Ticker ticker(bs_->CollectingMetrics());
+    uint64_t start, end;
+    Decompressor::ChunkBounds(blob->chunk_table.get(), chunk, &start, &end);
+
+    // Read the blocks which hold the chunk; it rarely starts or ends on a
+    // block boundary.
+    const uint64_t first_block = start / kBlobfsBlockSize;
+    const uint64_t block_count = fbl::round_up(end, kBlobfsBlockSize) / kBlobfsBlockSize -
+                                 first_block;
+    ZX_DEBUG_ASSERT(block_count * kBlobfsBlockSize <= compressed_transfer_->GetSize());
+    fs::ReadTxn txn(bs_);
+    txn.Enqueue(compressed_transfer_vmoid_, 0,
+                blob->inode.start_block + DataStartBlock(bs_->info_) +
+                blob->data_offset / kBlobfsBlockSize + first_block,
+                block_count);
+    zx_status_t status;
+    if ((status = txn.Transact()) != ZX_OK) {
+        return status;
+    }
+    fs::Duration read_time = ticker.End();
+    ticker.Reset();
+
+    const uint64_t chunk_start = chunk * kPagerChunkSize;
+    const size_t expected = fbl::min(kPagerChunkSize, blob->inode.blob_size - chunk_start);
+    size_t target_size = expected;
+    size_t src_size = end - start;
+    const uint8_t* src = static_cast<const uint8_t*>(compressed_transfer_->GetData()) +
+                         start % kBlobfsBlockSize;
+    if ((status = Decompressor::Decompress(transfer_->GetData(), &target_size, src,
+                                           &src_size)) != ZX_OK) {
+        return status;
+    } else if (target_size != expected || src_size != end - start) {
+        FS_TRACE_ERROR("Failed to fully decompress chunk %" PRIu64 " (%zu of %zu expected)\n",
+                       chunk, target_size, expected);
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    // Commit the tail of the last block too, so that the chunk can be moved
+    // into the blob's VMO as a whole.
+    const size_t chunk_size = fbl::min(kPagerChunkSize,
+                                       BlobDataBlocks(blob->inode) * kBlobfsBlockSize -
+                                       chunk_start);
+    memset(static_cast<uint8_t*>(transfer_->GetData()) + expected, 0, chunk_size - expected);
+
+    bs_->UpdateMerkleDecompressMetrics(end - start, expected, read_time, ticker.End());
+    return ZX_OK;
+}
+
+zx_status_t BlobPager::SupplyChunk(PagedBlob* blob, uint64_t offset) {
+    if (offset < blob->data_offset) {
+        // The Merkle tree was supplied when the VMO was created.
+        return ZX_OK;
+    }
+    const uint64_t chunk = (offset - blob->data_offset) / kPagerChunkSize;
+    if (chunk >= blob->supplied.size()) {
+        return ZX_ERR_OUT_OF_RANGE;
+    } else if (blob->supplied[chunk]) {
+        return ZX_OK;
+    }
+
+    TRACE_DURATION("blobfs", "BlobPager::SupplyChunk", "chunk", chunk);
+    fs::Ticker ticker(bs_->CollectingMetrics());
+    const uint64_t data_size = BlobDataBlocks(blob->inode) * kBlobfsBlockSize;
+    const uint64_t chunk_start = chunk * kPagerChunkSize;
+    const size_t chunk_size = fbl::min(kPagerChunkSize, data_size - chunk_start);
+
+    zx_status_t status;
+    zx_handle_t source;
+    uint64_t source_offset;
+    const uint8_t* data;
+    if ((blob->inode.flags & kBlobFlagChunkCompressed) != 0) {
+        if ((status = DecompressChunk(blob, chunk)) != ZX_OK) {
+            return status;
+        }
+        source = transfer_->GetVmo();
+        source_offset = 0;
+        data = static_cast<const uint8_t*>(transfer_->GetData());
+    } else if ((blob->inode.flags & kBlobFlagLZ4Compressed) != 0) {
+        // Blobs written before the chunked format existed can only be
+        // decompressed as a whole.
+        if (!blob->decompressed && (status = Decompress(blob)) != ZX_OK) {
+            return status;
+        }
+        source = blob->decompressed->GetVmo();
+        source_offset = chunk_start;
+        data = static_cast<const uint8_t*>(blob->decompressed->GetData()) + chunk_start;
+    } else {
+        fs::ReadTxn txn(bs_);
+        txn.Enqueue(transfer_vmoid_, 0,
+                    blob->inode.start_block + DataStartBlock(bs_->info_) +
+                    (blob->data_offset + chunk_start) / kBlobfsBlockSize,
+                    chunk_size / kBlobfsBlockSize);
+        if ((status = txn.Transact()) != ZX_OK) {
+            return status;
+        }
+        source = transfer_->GetVmo();
+        source_offset = 0;
+        data = static_cast<const uint8_t*>(transfer_->GetData());
+    }
+
+    const size_t verify_size = fbl::min(chunk_size, blob->inode.blob_size - chunk_start);
+    status = MerkleTree::VerifyRange(data, blob->inode.blob_size, blob->merkle.get(),
+                                     blob->merkle_size, chunk_start, verify_size, blob->digest);
+    if (status != ZX_OK) {
+        char name[Digest::kLength * 2 + 1];
+        ZX_ASSERT(blob->digest.ToString(name, sizeof(name)) == ZX_OK);
+        FS_TRACE_ERROR("blobfs verify(%s) chunk %" PRIu64 " Failure: %s\n", name, chunk,
+                       zx_status_get_string(status));
+        return status;
+    }
+
+    status = zx_pager_supply_pages(pager_.get(), blob->vmo.get(),
+                                   blob->data_offset + chunk_start, chunk_size,
+                                   source, source_offset);
+    if (status != ZX_OK) {
+        return status;
+    }
+    blob->supplied[chunk] = true;
+    bs_->UpdateMerklePageInMetrics(chunk_size, ticker.End());
+    return ZX_OK;
+}
+
+zx_status_t BlobPager::SupplyChunkWithRetry(PagedBlob* blob, uint64_t offset) {
+    zx::duration delay = kSupplyRetryDelay;
+    zx_status_t status;
+    for (int attempt = 1;; ++attempt) {
+        status = SupplyChunk(blob, offset);
+        if (status == ZX_OK || IsPermanentSupplyError(status) || attempt == kSupplyAttempts) {
+            return status;
+        }
+        FS_TRACE_WARN("blobfs: Failed to supply offset %" PRIu64 " of blob, retrying: %s\n",
+                      offset, zx_status_get_string(status));
+        zx::nanosleep(zx::deadline_after(delay));
+        delay *= 2;
+    }
+}
+
+int BlobPager::PagerThread(void* arg) {
+    BlobPager* pager = reinterpret_cast<BlobPager*>(arg);
+
+    while (true) {
+        zx_port_packet_t packet;
+        zx_status_t status = pager->port_.wait(zx::time::infinite(), &packet);
+        if (status != ZX_OK) {
+            FS_TRACE_ERROR("blobfs: pager port wait failed: %d\n", status);
+            return 0;
+        } else if (packet.type == ZX_PKT_TYPE_USER) {
+            // Queued by the destructor.
+            return 0;
+        } else if (packet.type != ZX_PKT_TYPE_PAGE_REQUEST) {
+            continue;
+        }
+
+        fbl::RefPtr<PagedBlob> blob;
+        {
+            fbl::AutoLock lock(&pager->lock_);
+            auto iter = pager->blobs_.find(packet.key);
+            if (!iter.IsValid()) {
+                continue;
+            }
+            blob = iter.CopyPointer();
+        }
+
+        const uint64_t end = packet.page_request.offset + packet.page_request.length;
+        for (uint64_t offset = packet.page_request.offset; offset < end;
+             offset += kBlobfsBlockSize) {
+            if ((status = pager->SupplyChunkWithRetry(blob.get(), offset)) != ZX_OK) {
+                // Fail the faulting threads rather than leave them waiting
+                // on pages that will never arrive.
+                FS_TRACE_ERROR("blobfs: Failed to supply offset %" PRIu64 " of blob: %s\n",
+                               offset, zx_status_get_string(status));
+                pager->pager_.detach_vmo(blob->vmo);
+                break;
+            }
+        }
+    }
+}
+
+} // namespace blobfs
@@ -0,0 +1,156 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <inttypes.h>
+
+#include <digest/merkle-tree.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/auto_lock.h>
+#include <fs/trace.h>
+#include <zircon/syscalls.h>
+
+#include <blobfs/format.h>
+#include <blobfs/lz4.h>
+#include <blobfs/pipeline.h>
+
+using digest::MerkleTree;
+
+namespace blobfs {
+
+ChunkPipeline::~ChunkPipeline() {
+    {
+        fbl::AutoLock lock(&lock_);
+        ZX_DEBUG_ASSERT(job_ == nullptr);
+        stopping_ = true;
+        cnd_broadcast(&work_cvar_);
+    }
+    for (size_t i = 0; i < thread_count_; i++) {
+        int r;
+        thrd_join(threads_[i], &r);
+    }
+}
+
+zx_status_t ChunkPipeline::Create(fbl::unique_ptr<ChunkPipeline>* out) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<ChunkPipeline> pipeline(new (&ac) ChunkPipeline());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    if (cnd_init(&pipeline->work_cvar_) != thrd_success) {
+        return ZX_ERR_NO_RESOURCES;
+    } else if (cnd_init(&pipeline->done_cvar_) != thrd_success) {
+        return ZX_ERR_NO_RESOURCES;
+    }
+
+    // The thread reading from disk takes a core of its own.
+    const size_t cpus = zx_system_get_num_cpus();
+    const size_t threads = fbl::clamp(cpus > 1 ? cpus - 1 : 1, static_cast<size_t>(1),
+                                      kPipelineMaxThreads);
+    for (; pipeline->thread_count_ < threads; pipeline->thread_count_++) {
+        if (thrd_create_with_name(&pipeline->threads_[pipeline->thread_count_],
+                                  ChunkPipeline::WorkerThread, pipeline.get(),
+                                  "blobfs-pipeline") != thrd_success) {
+            return ZX_ERR_NO_RESOURCES;
+        }
+    }
+
+    *out = fbl::move(pipeline);
+    return ZX_OK;
+}
+
+void ChunkPipeline::Begin(Job* job) {
+    fbl::AutoLock lock(&lock_);
+    ZX_DEBUG_ASSERT(job_ == nullptr);
+    job_ = job;
+}
+
+zx_status_t ChunkPipeline::SetReadable(uint64_t count) {
+    fbl::AutoLock lock(&lock_);
+    ZX_DEBUG_ASSERT(job_ != nullptr);
+    ZX_DEBUG_ASSERT(count >= job_->readable_);
+    job_->readable_ = count;
+    cnd_broadcast(&work_cvar_);
+    return job_->status_;
+}
+
+zx_status_t ChunkPipeline::Finish() {
+    fbl::AutoLock lock(&lock_);
+    ZX_DEBUG_ASSERT(job_ != nullptr);
+    // Once a chunk has failed, no more are handed out.
+    while (in_flight_ != 0 || HasWork()) {
+        cnd_wait(&done_cvar_, lock_.GetInternal());
+    }
+    zx_status_t status = job_->status_;
+    job_ = nullptr;
+    return status;
+}
+
+bool ChunkPipeline::HasWork() const {
+    return job_ != nullptr && job_->status_ == ZX_OK && job_->next_ < job_->readable_;
+}
+
+zx_status_t ChunkPipeline::ProcessChunk(Job* job, uint64_t chunk, fs::Duration* decompress,
+                                        fs::Duration* verify) {
+    TRACE_DURATION("blobfs", "ChunkPipeline::ProcessChunk", "chunk", chunk);
+    fs::Ticker ticker(job->collecting_metrics);
+    uint64_t start, end;
+    Decompressor::ChunkBounds(job->compressed, chunk, &start, &end);
+    const uint64_t offset = chunk * kCompressionChunkSize;
+    const size_t expected = fbl::min(kCompressionChunkSize, job->blob_size - offset);
+    size_t target_size = expected;
+    size_t src_size = end - start;
+    zx_status_t status = Decompressor::Decompress(job->data + offset, &target_size,
+                                                  job->compressed + start, &src_size);
+    if (status != ZX_OK) {
+        return status;
+    } else if (target_size != expected || src_size != end - start) {
+        FS_TRACE_ERROR("Failed to fully decompress chunk %" PRIu64 " (%zu of %zu expected)\n",
+                       chunk, target_size, expected);
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    *decompress = ticker.End();
+    ticker.Reset();
+
+    // Each chunk covers whole Merkle nodes, so it can be checked without
+    // waiting for its neighbours.
+    status = MerkleTree::Verify(job->data, job->blob_size, job->merkle, job->merkle_size,
+                                offset, expected, job->digest);
+    *verify = ticker.End();
+    return status;
+}
+
+int ChunkPipeline::WorkerThread(void* arg) {
+    ChunkPipeline* pipeline = reinterpret_cast<ChunkPipeline*>(arg);
+    fbl::AutoLock lock(&pipeline->lock_);
+    while (true) {
+        while (!pipeline->stopping_ && !pipeline->HasWork()) {
+            cnd_wait(&pipeline->work_cvar_, pipeline->lock_.GetInternal());
+        }
+        if (pipeline->stopping_) {
+            return 0;
+        }
+
+        Job* job = pipeline->job_;
+        uint64_t chunk = job->next_++;
+        pipeline->in_flight_++;
+
+        fs::Duration decompress = {};
+        fs::Duration verify = {};
+        pipeline->lock_.Release();
+        zx_status_t status = ProcessChunk(job, chunk, &decompress, &verify);
+        pipeline->lock_.Acquire();
+
+        job->decompress_duration += decompress;
+        job->verify_duration += verify;
+        if (status != ZX_OK && job->status_ == ZX_OK) {
+            job->status_ = status;
+        }
+        pipeline->in_flight_--;
+        cnd_broadcast(&pipeline->done_cvar_);
+    }
+}
+
+} // namespace blobfs
@@ -20,6 +20,8 @@ MODULE_SRCS := \
     $(COMMON_SRCS) \
     $(LOCAL_DIR)/blobfs.cpp \
     $(LOCAL_DIR)/metrics.cpp \
+    $(LOCAL_DIR)/pager.cpp \
+    $(LOCAL_DIR)/pipeline.cpp \
     $(LOCAL_DIR)/writeback.cpp \
     $(LOCAL_DIR)/vnode.cpp \
     $(LOCAL_DIR)/rpc.cpp \
@@ -41,10 +41,14 @@ void VnodeBlob::fbl_recycle() {
 
 void VnodeBlob::TearDown() {
     ZX_ASSERT(clone_watcher_.object() == ZX_HANDLE_INVALID);
-    if (blob_ != nullptr) {
+    if (blob_ != nullptr && vmoid_ != VMOID_INVALID) {
         blobfs_->DetachVmo(vmoid_);
     }
     blob_ = nullptr;
+    if (pager_key_ != 0) {
+        blobfs_->pager_->ReleaseBlob(pager_key_);
+        pager_key_ = 0;
+    }
 }
 
 VnodeBlob::~VnodeBlob() {
@@ -15,7 +15,10 @@
 #include <fbl/macros.h>
 #include <fbl/unique_ptr.h>
 #include <lib/fdio/debug.h>
+#include <openssl/aes.h>
 #include <openssl/cipher.h>
+#include <openssl/cpu.h>
+#include <openssl/crypto.h>
 #include <zircon/errors.h>
 #include <zircon/types.h>
 
@@ -23,19 +26,59 @@
 
 #define ZXDEBUG 0
 
+#if defined(OPENSSL_X86_64) && !defined(OPENSSL_NO_ASM)
+// BoringSSL's AES-NI implementation of XTS, which interleaves six blocks at a time.  The generic
+// XTS cipher encrypts one block at a time.
+extern "C" {
+void aes_hw_xts_encrypt(const uint8_t* in, uint8_t* out, size_t length, const AES_KEY* key1,
+                        const AES_KEY* key2, const uint8_t iv[16]);
+void aes_hw_xts_decrypt(const uint8_t* in, uint8_t* out, size_t length, const AES_KEY* key1,
+                        const AES_KEY* key2, const uint8_t iv[16]);
+}
+// These routines are not part of BoringSSL's API.  The prototypes above and the key schedule
+// layout read by aesni-x86_64.S (the round count at byte 240) were checked against API version 9;
+// re-check both before changing the version below when rolling BoringSSL.
+static_assert(BORINGSSL_API_VERSION == 9, "aes_hw_xts_* not checked against this BoringSSL");
+static_assert(offsetof(AES_KEY, rounds) == 240, "AES_KEY layout differs from aesni-x86_64.S");
+#define HW_XTS 1
+#else
+#define HW_XTS 0
+#endif
+
 namespace crypto {
 
 // The previously opaque crypto implementation context.  Guaranteed to clean up on destruction.
 struct Cipher::Context {
-    Context() { EVP_CIPHER_CTX_init(&impl); }
+    Context() : xts(nullptr) { EVP_CIPHER_CTX_init(&impl); }
 
-    ~Context() { EVP_CIPHER_CTX_cleanup(&impl); }
+    ~Context() {
+        EVP_CIPHER_CTX_cleanup(&impl);
+        mandatory_memset(&key1, 0, sizeof(key1));
+        mandatory_memset(&key2, 0, sizeof(key2));
+    }
 
     EVP_CIPHER_CTX impl;
+
+    // If set, random access AES-XTS transforms whole sectors directly with |key1| and |key2|,
+    // bypassing |impl|.
+    void (*xts)(const uint8_t* in, uint8_t* out, size_t length, const AES_KEY* key1,
+                const AES_KEY* key2, const uint8_t iv[16]);
+    AES_KEY key1;
+    AES_KEY key2;
 };
 
 namespace {
 
+// Returns true if the CPU supports the AES-NI instructions used by |aes_hw_xts_encrypt|.
+bool HwXtsCapable() {
+#if HW_XTS
+    CRYPTO_library_init();
+    return (OPENSSL_ia32cap_get()[1] & (1 << (57 - 32))) != 0;
+#else
+    return false;
+#endif
+}
+
 // Get the cipher for the given |version|.
 zx_status_t GetCipher(Cipher::Algorithm cipher, const EVP_CIPHER** out) {
     switch (cipher) {
@@ -182,6 +225,26 @@ zx_status_t Cipher::Init(Algorithm algo, Direction direction, const Secret& key,
     direction_ = direction;
     block_size_ = cipher->block_size;
 
+    // Random access AES-XTS transforms many sectors per request; use the pipelined AES-NI
+    // implementation if possible.  |AES_set_*_key| produce schedules in the format it expects.
+    if (algo == kAES256_XTS && alignment != 0 && alignment >= AES_BLOCK_SIZE && HwXtsCapable()) {
+        const size_t half = key.len() / 2;
+        int err = direction == kEncrypt
+                      ? AES_set_encrypt_key(key.get(), static_cast<unsigned>(half * 8),
+                                            &ctx_->key1)
+                      : AES_set_decrypt_key(key.get(), static_cast<unsigned>(half * 8),
+                                            &ctx_->key1);
+        if (err != 0 ||
+            AES_set_encrypt_key(key.get() + half, static_cast<unsigned>(half * 8),
+                                &ctx_->key2) != 0) {
+            xprintf("failed to expand AES-XTS keys\n");
+            return ZX_ERR_INTERNAL;
+        }
+#if HW_XTS
+        ctx_->xts = direction == kEncrypt ? aes_hw_xts_encrypt : aes_hw_xts_decrypt;
+#endif
+    }
+
     cleanup.cancel();
     return ZX_OK;
 }
@@ -215,6 +278,18 @@ zx_status_t Cipher::Transform(const uint8_t* in, zx_off_t offset, size_t length,
         }
         iv_[0] = iv0_ + static_cast<uint64_t>(offset / alignment_);
         uint8_t* iv8 = reinterpret_cast<uint8_t*>(iv_.get());
+        // Transform all the whole sectors in one pass, without reinitializing the EVP context for
+        // each.  Each sector has its own tweak, so the assembly is still called once per sector.
+        if (ctx_->xts) {
+            size_t whole = length - (length % alignment_);
+            for (size_t off = 0; off < whole; off += alignment_) {
+                ctx_->xts(in + off, out + off, alignment_, &ctx_->key1, &ctx_->key2, iv8);
+                iv_[0] += 1;
+            }
+            out += whole;
+            in += whole;
+            length -= whole;
+        }
         while (length > 0) {
             size_t chunk_len = length < alignment_ ? length : alignment_;
             if (EVP_CipherInit_ex(&ctx_->impl, nullptr, nullptr, nullptr, iv8, -1) < 0 ||
@@ -19,9 +19,10 @@ __BEGIN_CDECLS;
 // The ethermac interface supports both synchronous and asynchronous transmissions using the
 // proto->queue_tx() and ifc->complete_tx() methods.
 //
-// Receive operations are supported with the ifc->recv() interface.
-// TODO: implement netbuf-based receive operations by implementing proto->queue_rx() and
-// ifc->complete_rx()
+// Receive operations are supported with the ifc->recv() interface, which copies each frame out of
+// the ethmac driver's buffer.  Drivers advertising FEATURE_RX_QUEUE also accept buffers from the
+// generic ethernet driver with proto->queue_rx(), fill them directly, and return them with
+// ifc->complete_rx(); frames which arrive while no buffer is queued are still passed to recv().
 //
 // The FEATURE_WLAN flag indicates a device that supports wlan operations.
 //
@@ -29,26 +30,57 @@ __BEGIN_CDECLS;
 //
 // The FEATURE_DMA flag indicates that the device can copy the buffer data using DMA and will ensure
 // that physical addresses are provided in netbufs.
+//
+// The FEATURE_RX_QUEUE flag indicates that the device implements proto->queue_rx().
 
 #define ETHMAC_FEATURE_WLAN     (1u)
 #define ETHMAC_FEATURE_SYNTH    (2u)
 #define ETHMAC_FEATURE_DMA      (4u)
+#define ETHMAC_FEATURE_RX_QUEUE (8u)
+
+// The OFFLOAD_ flags in ethmac_info_t.offloads indicate work the device can do in hardware.
+//
+// OFFLOAD_TX_CSUM_IP and OFFLOAD_TX_CSUM_L4: the device fills in the IPv4 header checksum, and the
+// TCP or UDP checksum, of netbufs queued with ETHMAC_TX_CSUM_IP and ETHMAC_TX_CSUM_L4.
+//
+// OFFLOAD_RX_CSUM: the device verifies the checksums of received frames, and delivers those whose
+// IP and TCP or UDP checksums are good with ETHMAC_RX_CSUM_OK.
+//
+// OFFLOAD_TSO: the device splits TCP segments queued with ETHMAC_TX_TSO into frames carrying at
+// most netbuf->mss bytes of payload each, filling in every checksum.
+//
+// OFFLOAD_LRO: the device can merge consecutive TCP segments of a flow into a single frame, while
+// ETHMAC_SETPARAM_LRO is set.  Merged frames may be up to 64k in length.
+//
+// The generic ethernet driver only requests offloads which the device has advertised.
+
+#define ETHMAC_OFFLOAD_TX_CSUM_IP (1u)
+#define ETHMAC_OFFLOAD_TX_CSUM_L4 (2u)
+#define ETHMAC_OFFLOAD_RX_CSUM    (4u)
+#define ETHMAC_OFFLOAD_TSO        (8u)
+#define ETHMAC_OFFLOAD_LRO        (16u)
 
 typedef struct ethmac_info {
     uint32_t features;
     uint32_t mtu;
     uint8_t mac[ETH_MAC_SIZE];
     uint8_t reserved0[2];
-    uint32_t reserved1[4];
+    uint32_t offloads;
+    uint32_t reserved1[3];
 } ethmac_info_t;
 
+// Offloads requested for a netbuf passed to queue_tx(), in netbuf->flags.
+#define ETHMAC_TX_CSUM_IP (1u)
+#define ETHMAC_TX_CSUM_L4 (2u)
+#define ETHMAC_TX_TSO     (4u)
+
 typedef struct ethmac_netbuf {
     // Provided by the generic ethernet driver
     void* data;
     zx_paddr_t phys;  // Only used if ETHMAC_FEATURE_DMA is available
     uint16_t len;
-    uint16_t reserved;
-    uint32_t flags;
+    uint16_t mss;     // Maximum TCP payload per frame; only used with ETHMAC_TX_TSO
+    uint32_t flags;   // ETHMAC_TX_ flags, for queue_tx()
 
     // Shared between the generic ethernet and ethmac drivers
     list_node_t node;
@@ -72,8 +104,26 @@ typedef struct ethmac_ifc_virt {
     // Upon a return of ZX_OK, the packet has been enqueued, but no information is returned as to
     // the completion state of the transmission itself.
     void (*complete_tx)(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t status);
+
+    // complete_rx() is called to return ownership of a netbuf passed to queue_rx().  On ZX_OK,
+    // netbuf->len has been set to the length of the frame received into it.  Any other status
+    // means the netbuf holds no data; stop() returns every queued netbuf this way before it
+    // returns.  |flags| is as for recv().
+    void (*complete_rx)(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t status,
+                        uint32_t flags);
 } ethmac_ifc_t;
 
+// Passed to recv() and complete_rx() to indicate that the driver has more frames to deliver
+// immediately after this one.  Allows the generic ethernet driver to batch completions to its
+// clients; the driver must deliver the last frame of a burst without this flag.  Completions held
+// back for a batch are not flushed on a timer, so a frame delivered with this flag may not reach
+// the client until the driver delivers another.
+#define ETHMAC_RX_OPT_MORE (1u)
+
+// Passed to recv() and complete_rx() by devices advertising OFFLOAD_RX_CSUM, to indicate that the
+// IP header checksum, and any TCP or UDP checksum, of the frame have been verified.
+#define ETHMAC_RX_CSUM_OK (2u)
+
 // Indicates that additional data is available to be sent after this call finishes. Allows a ethmac
 // driver to batch tx to hardware if possible.
 #define ETHMAC_TX_OPT_MORE (1u)
@@ -97,6 +147,9 @@ typedef struct ethmac_ifc_virt {
 
 #define ETHMAC_SETPARAM_DUMP_REGS (4u)
 
+// |value| is bool. |data| is unused.  Only valid on devices advertising OFFLOAD_LRO.
+#define ETHMAC_SETPARAM_LRO (5u)
+
 // The ethernet midlayer will never call ethermac_protocol
 // methods from multiple threads simultaneously, but it
 // can call send() methods at the same time as non-send
@@ -144,6 +197,16 @@ typedef struct ethmac_protocol_ops {
     // The caller does *not* take ownership of the BTI handle and must never close
     // the handle.
     zx_handle_t (*get_bti)(void* ctx);
+
+    // Give the driver a buffer to receive a frame into.  netbuf->len is the capacity of the
+    // buffer, and netbuf->phys is provided as for queue_tx().  Return status indicates queue state:
+    //   ZX_OK: The driver owns the netbuf until it passes it to complete_rx().
+    //   Other: The netbuf could not be queued, and still belongs to the caller.
+    //
+    // This method is only valid on devices that advertise ETHMAC_FEATURE_RX_QUEUE, and may be
+    // called at any time after start() is called.  Buffers are filled in the order they are
+    // queued.
+    zx_status_t (*queue_rx)(void* ctx, ethmac_netbuf_t* netbuf);
 } ethmac_protocol_ops_t;
 
 typedef struct ethmac_protocol {
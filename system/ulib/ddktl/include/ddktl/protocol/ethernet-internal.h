@@ -20,6 +20,7 @@ namespace internal {
 DECLARE_HAS_MEMBER_FN(has_ethmac_status, EthmacStatus);
 DECLARE_HAS_MEMBER_FN(has_ethmac_recv, EthmacRecv);
 DECLARE_HAS_MEMBER_FN(has_ethmac_complete_tx, EthmacCompleteTx);
+DECLARE_HAS_MEMBER_FN(has_ethmac_complete_rx, EthmacCompleteRx);
 
 template <typename D>
 constexpr void CheckEthmacIfc() {
@@ -45,6 +46,14 @@ constexpr void CheckEthmacIfc() {
                   "EthmacCompleteTx must be a non-static member function with signature "
                   "'void EthmacCompleteTx(ethmac_netbuf_t*, zx_status_t)', and be visible to "
                   "ddk::EthmacIfc<D> (either because they are public, or because of friendship).");
+    static_assert(internal::has_ethmac_complete_rx<D>::value,
+                  "EthmacIfc subclasses must implement EthmacCompleteRx");
+    static_assert(fbl::is_same<decltype(&D::EthmacCompleteRx),
+                                void (D::*)(ethmac_netbuf_t*, zx_status_t, uint32_t)>::value,
+                  "EthmacCompleteRx must be a non-static member function with signature "
+                  "'void EthmacCompleteRx(ethmac_netbuf_t*, zx_status_t, uint32_t)', and be "
+                  "visible to ddk::EthmacIfc<D> (either because they are public, or because of "
+                  "friendship).");
 }
 
 DECLARE_HAS_MEMBER_FN(has_ethmac_query, EthmacQuery);
@@ -53,6 +62,7 @@ DECLARE_HAS_MEMBER_FN(has_ethmac_start, EthmacStart);
 DECLARE_HAS_MEMBER_FN(has_ethmac_queue_tx, EthmacQueueTx);
 DECLARE_HAS_MEMBER_FN(has_ethmac_set_param, EthmacSetParam);
 DECLARE_HAS_MEMBER_FN(has_ethmac_get_bti, EthmacGetBti);
+DECLARE_HAS_MEMBER_FN(has_ethmac_queue_rx, EthmacQueueRx);
 
 template <typename D>
 constexpr void CheckEthmacProtocolSubclass() {
@@ -102,6 +112,14 @@ constexpr void CheckEthmacProtocolSubclass() {
                   "EthmacGetBti must be a non-static member function with signature "
                   "'zx_handle_t EthmacGetBti()', and be visible to ddk::EthmacProtocol<D> "
                   "(either because they are public, or because of friendship).");
+    static_assert(internal::has_ethmac_queue_rx<D>::value,
+                  "EthmacProtocol subclasses must implement EthmacQueueRx");
+    static_assert(fbl::is_same<decltype(&D::EthmacQueueRx),
+                                zx_status_t (D::*)(ethmac_netbuf_t*)>::value,
+                  "EthmacQueueRx must be a non-static member function with signature "
+                  "'zx_status_t EthmacQueueRx(ethmac_netbuf_t*)', and be visible to "
+                  "ddk::EthmacProtocol<D> (either because they are public, or because of "
+                  "friendship).");
 }
 
 }  // namespace internal
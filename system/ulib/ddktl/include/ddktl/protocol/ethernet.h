@@ -64,6 +64,14 @@
 //         // Receive data buffer from ethmac device
 //     }
 //
+//     void EthmacCompleteTx(ethmac_netbuf_t* netbuf, zx_status_t status) {
+//         // Take ownership of a transmitted netbuf back
+//     }
+//
+//     void EthmacCompleteRx(ethmac_netbuf_t* netbuf, zx_status_t status, uint32_t flags) {
+//         // Take ownership of a netbuf queued for receive back
+//     }
+//
 //   private:
 //     zx_device_t* parent_;
 //     fbl::unique_ptr<ddk::EthmacProtocolProxy> proxy_;
@@ -114,6 +122,16 @@
 //         return ZX_OK;
 //     }
 //
+//     zx_handle_t EthmacGetBti() {
+//         // Return the BTI used to pin buffers, if the device supports DMA
+//         return ZX_HANDLE_INVALID;
+//     }
+//
+//     zx_status_t EthmacQueueRx(ethmac_netbuf_t* netbuf) {
+//         // Receive into the buffer, if the device supports ETHMAC_FEATURE_RX_QUEUE
+//         return ZX_ERR_NOT_SUPPORTED;
+//     }
+//
 //   private:
 //     zx_device_t* parent_;
 //     fbl::unique_ptr<ddk::EthmacIfcProxy> proxy_;
@@ -129,6 +147,7 @@ public:
         ifc_.status = Status;
         ifc_.recv = Recv;
         ifc_.complete_tx = CompleteTx;
+        ifc_.complete_rx = CompleteRx;
     }
 
     ethmac_ifc_t* ethmac_ifc() { return &ifc_; }
@@ -146,6 +165,11 @@ private:
         static_cast<D*>(cookie)->EthmacCompleteTx(netbuf, status);
     }
 
+    static void CompleteRx(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t status,
+                           uint32_t flags) {
+        static_cast<D*>(cookie)->EthmacCompleteRx(netbuf, status, flags);
+    }
+
     ethmac_ifc_t ifc_ = {};
 };
 
@@ -166,6 +190,10 @@ public:
         ifc_->complete_tx(cookie_, netbuf, status);
     }
 
+    void CompleteRx(ethmac_netbuf_t* netbuf, zx_status_t status, uint32_t flags) {
+        ifc_->complete_rx(cookie_, netbuf, status, flags);
+    }
+
 private:
     ethmac_ifc_t* ifc_;
     void* cookie_;
@@ -182,6 +210,7 @@ public:
         ops_.queue_tx = QueueTx;
         ops_.set_param = SetParam;
         ops_.get_bti = GetBti;
+        ops_.queue_rx = QueueRx;
 
         // Can only inherit from one base_protocol implemenation
         ZX_ASSERT(ddk_proto_id_ == 0);
@@ -215,6 +244,10 @@ private:
         return static_cast<D*>(ctx)->EthmacGetBti();
     }
 
+    static zx_status_t QueueRx(void* ctx, ethmac_netbuf_t* netbuf) {
+        return static_cast<D*>(ctx)->EthmacQueueRx(netbuf);
+    }
+
     ethmac_protocol_ops_t ops_ = {};
 };
 
@@ -246,6 +279,10 @@ public:
         return ops_->set_param(ctx_, param, value, data);
     }
 
+    zx_status_t QueueRx(ethmac_netbuf_t* netbuf) {
+        return ops_->queue_rx(ctx_, netbuf);
+    }
+
 private:
     ethmac_protocol_ops_t* ops_;
     void* ctx_;
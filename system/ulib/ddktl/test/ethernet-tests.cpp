@@ -41,14 +41,21 @@ class TestEthmacIfc : public ddk::Device<TestEthmacIfc>,
         complete_tx_called_ = true;
     }
 
+    void EthmacCompleteRx(ethmac_netbuf_t* netbuf, zx_status_t status, uint32_t flags) {
+        complete_rx_this_ = get_this();
+        complete_rx_called_ = true;
+    }
+
     bool VerifyCalls() const {
         BEGIN_HELPER;
         EXPECT_EQ(this_, status_this_, "");
         EXPECT_EQ(this_, recv_this_, "");
         EXPECT_EQ(this_, complete_tx_this_, "");
+        EXPECT_EQ(this_, complete_rx_this_, "");
         EXPECT_TRUE(status_called_, "");
         EXPECT_TRUE(recv_called_, "");
         EXPECT_TRUE(complete_tx_called_, "");
+        EXPECT_TRUE(complete_rx_called_, "");
         END_HELPER;
     }
 
@@ -61,9 +68,11 @@ class TestEthmacIfc : public ddk::Device<TestEthmacIfc>,
     uintptr_t status_this_ = 0u;
     uintptr_t recv_this_ = 0u;
     uintptr_t complete_tx_this_ = 0u;
+    uintptr_t complete_rx_this_ = 0u;
     bool status_called_ = false;
     bool recv_called_ = false;
     bool complete_tx_called_ = false;
+    bool complete_rx_called_ = false;
 };
 
 class TestEthmacProtocol : public ddk::Device<TestEthmacProtocol, ddk::GetProtocolable>,
@@ -115,6 +124,11 @@ class TestEthmacProtocol : public ddk::Device<TestEthmacProtocol, ddk::GetProtoc
     }
     zx_handle_t EthmacGetBti() { return ZX_HANDLE_INVALID;}
 
+    zx_status_t EthmacQueueRx(ethmac_netbuf_t* netbuf) {
+        queue_rx_this_ = get_this();
+        queue_rx_called_ = true;
+        return ZX_OK;
+    }
 
     bool VerifyCalls() const {
         BEGIN_HELPER;
@@ -123,11 +137,13 @@ class TestEthmacProtocol : public ddk::Device<TestEthmacProtocol, ddk::GetProtoc
         EXPECT_EQ(this_, stop_this_, "");
         EXPECT_EQ(this_, queue_tx_this_, "");
         EXPECT_EQ(this_, set_param_this_, "");
+        EXPECT_EQ(this_, queue_rx_this_, "");
         EXPECT_TRUE(query_called_, "");
         EXPECT_TRUE(start_called_, "");
         EXPECT_TRUE(stop_called_, "");
         EXPECT_TRUE(queue_tx_called_, "");
         EXPECT_TRUE(set_param_called_, "");
+        EXPECT_TRUE(queue_rx_called_, "");
         END_HELPER;
     }
 
@@ -137,6 +153,7 @@ class TestEthmacProtocol : public ddk::Device<TestEthmacProtocol, ddk::GetProtoc
         proxy_->Status(0);
         proxy_->Recv(nullptr, 0, 0);
         proxy_->CompleteTx(nullptr, ZX_OK);
+        proxy_->CompleteRx(nullptr, ZX_OK, 0);
         return true;
     }
 
@@ -147,11 +164,13 @@ class TestEthmacProtocol : public ddk::Device<TestEthmacProtocol, ddk::GetProtoc
     uintptr_t start_this_ = 0u;
     uintptr_t queue_tx_this_ = 0u;
     uintptr_t set_param_this_ = 0u;
+    uintptr_t queue_rx_this_ = 0u;
     bool query_called_ = false;
     bool stop_called_ = false;
     bool start_called_ = false;
     bool queue_tx_called_ = false;
     bool set_param_called_ = false;
+    bool queue_rx_called_ = false;
 
     fbl::unique_ptr<ddk::EthmacIfcProxy> proxy_;
 };
@@ -165,6 +184,7 @@ static bool test_ethmac_ifc() {
     ifc->status(&dev, 0);
     ifc->recv(&dev, nullptr, 0, 0);
     ifc->complete_tx(&dev, nullptr, ZX_OK);
+    ifc->complete_rx(&dev, nullptr, ZX_OK, 0);
 
     EXPECT_TRUE(dev.VerifyCalls(), "");
 
@@ -180,6 +200,7 @@ static bool test_ethmac_ifc_proxy() {
     proxy.Status(0);
     proxy.Recv(nullptr, 0, 0);
     proxy.CompleteTx(nullptr, ZX_OK);
+    proxy.CompleteRx(nullptr, ZX_OK, 0);
 
     EXPECT_TRUE(dev.VerifyCalls(), "");
 
@@ -206,6 +227,7 @@ static bool test_ethmac_protocol() {
     ethmac_netbuf_t netbuf = {};
     EXPECT_EQ(ZX_OK, proto.ops->queue_tx(proto.ctx, 0, &netbuf), "");
     EXPECT_EQ(ZX_OK, proto.ops->set_param(proto.ctx, 0, 0, nullptr), "");
+    EXPECT_EQ(ZX_OK, proto.ops->queue_rx(proto.ctx, &netbuf), "");
 
     EXPECT_TRUE(dev.VerifyCalls(), "");
 
@@ -234,6 +256,7 @@ static bool test_ethmac_protocol_proxy() {
     ethmac_netbuf_t netbuf = {};
     EXPECT_EQ(ZX_OK, proxy.QueueTx(0, &netbuf), "");
     EXPECT_EQ(ZX_OK, proxy.SetParam(0, 0, nullptr));
+    EXPECT_EQ(ZX_OK, proxy.QueueRx(&netbuf), "");
 
     EXPECT_TRUE(protocol_dev.VerifyCalls(), "");
 
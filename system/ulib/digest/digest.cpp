@@ -54,10 +54,14 @@ Digest& Digest::operator=(const uint8_t* rhs) {
 
 zx_status_t Digest::Init() {
     ZX_DEBUG_ASSERT(ref_count_ == 0);
-    fbl::AllocChecker ac;
-    ctx_.reset(new (&ac) Context());
-    if (!ac.check()) {
-        return ZX_ERR_NO_MEMORY;
+    // The context is kept across Final() so that hashing many small inputs,
+    // such as Merkle tree nodes, doesn't allocate for each of them.
+    if (!ctx_) {
+        fbl::AllocChecker ac;
+        ctx_.reset(new (&ac) Context());
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
     }
     SHA256_Init(&ctx_->impl);
     return ZX_OK;
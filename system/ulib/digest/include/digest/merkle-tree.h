@@ -67,6 +67,23 @@ public:
                               const void* tree, size_t tree_len, size_t offset,
                               size_t length, const Digest& digest);
 
+    // Like |Verify|, but |data| holds only the |length| bytes of the data at
+    // |offset| rather than all |data_len| of them.  |offset| must be a multiple
+    // of |kNodeSize|, and the range must end on a node boundary or at
+    // |data_len|.
+    static zx_status_t VerifyRange(const void* data, size_t data_len,
+                                   const void* tree, size_t tree_len, size_t offset,
+                                   size_t length, const Digest& digest);
+
+    // Writes the digests of |count| consecutive nodes of one level of a Merkle
+    // tree, starting with node |first|, to |out|, which must have room for
+    // |count * Digest::kLength| bytes.  |data| holds the whole level, which is
+    // |data_len| bytes long and at height |level| in the tree (data nodes have
+    // level 0).  Nodes are hashed independently of each other; when there are
+    // enough of them, the work is spread across several threads.
+    static zx_status_t HashNodes(const void* data, size_t data_len, uint64_t level,
+                                 size_t first, size_t count, uint8_t* out);
+
     // The stateful instance methods below are only needed when creating a
     // Merkle tree using the Init/Update/Final methods.
     MerkleTree();
@@ -98,14 +115,22 @@ private:
     static zx_status_t VerifyRoot(const void* data, size_t data_len,
                                   uint64_t level, const Digest& root);
 
+    // Implements |Verify| and |VerifyRange|.  |data| holds the data from byte
+    // |data_offset| on.
+    static zx_status_t VerifyFrom(const void* data, size_t data_offset,
+                                  size_t data_len, const void* tree,
+                                  size_t tree_len, size_t offset, size_t length,
+                                  const Digest& digest);
+
     // Checks the integrity of portion of a Merkle tree level given by the
     // offset and length.  It checks integrity using next level up of the given
     // Merkle tree. |tree_len| must be at least as much as returned by
     // |GetTreeLength(data_len)|.  |offset| and |length| must describe a range
-    // wholly within |data_len|.
-    static zx_status_t VerifyLevel(const void* data, size_t data_len,
-                                   const void* tree, size_t offset,
-                                   size_t length, uint64_t level);
+    // wholly within |data_len|.  |data| holds the level from byte
+    // |data_offset| on, which must be no later than |offset|.
+    static zx_status_t VerifyLevel(const void* data, size_t data_offset,
+                                   size_t data_len, const void* tree,
+                                   size_t offset, size_t length, uint64_t level);
 
     // See CreateFinal.  This implements that method, with an extra parameter to
     // allow levels other than the bottommost to be padded.
@@ -4,8 +4,10 @@
 
 #include <digest/merkle-tree.h>
 
+#include <pthread.h>
 #include <stdint.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <digest/digest.h>
 #include <fbl/algorithm.h>
@@ -65,16 +67,228 @@ size_t DigestUpdate(Digest* digest, const uint8_t* in, size_t offset, size_t len
 // Wrapper for Digest::Final.  This pads the hashed data with zeros up to a
 // node boundary before finalizing the digest.
 void DigestFinal(Digest* digest, size_t offset) {
+    static const uint8_t kZeroes[MerkleTree::kNodeSize] = {};
     offset = offset % MerkleTree::kNodeSize;
     if (offset != 0) {
-        size_t pad_len = MerkleTree::kNodeSize - offset;
-        uint8_t pad[pad_len];
-        memset(pad, 0, pad_len);
-        digest->Update(pad, pad_len);
+        digest->Update(kZeroes, MerkleTree::kNodeSize - offset);
     }
     digest->Final();
 }
 
+////////
+// Helper functions for hashing many nodes at once.
+
+// Levels with fewer nodes than this per available thread are hashed on the
+// calling thread; below it, handing nodes to another thread costs more than
+// it saves.
+const size_t kMinNodesPerThread = 64;
+
+// Upper bound on the number of threads hashing a single level.
+const size_t kMaxThreads = 8;
+
+// The number of nodes hashed per batch when verifying, bounding the scratch
+// space used for the computed digests.
+const size_t kVerifyBatchNodes = kMinNodesPerThread * kMaxThreads;
+
+// Hashes the nodes [first, first + count) of a level, one after another,
+// reusing a single digest context.  |data| holds the level from byte
+// |data_offset| on.
+zx_status_t HashNodesSerial(const uint8_t* data, size_t data_offset, size_t data_len,
+                            uint64_t level, size_t first, size_t count, uint8_t* out) {
+    zx_status_t rc;
+    Digest digest;
+    for (size_t i = first; i < first + count; ++i) {
+        size_t offset = i * MerkleTree::kNodeSize;
+        if ((rc = DigestInit(&digest, offset | level, data_len - offset)) != ZX_OK) {
+            return rc;
+        }
+        size_t length = DigestUpdate(&digest, data + (offset - data_offset), offset,
+                                     data_len - offset);
+        DigestFinal(&digest, offset + length);
+        digest.CopyTo(out, Digest::kLength);
+        out += Digest::kLength;
+    }
+    return ZX_OK;
+}
+
+struct HashJob {
+    const uint8_t* data;
+    size_t data_offset;
+    size_t data_len;
+    uint64_t level;
+    size_t first;
+    size_t count;
+    uint8_t* out;
+    zx_status_t rc;
+    // Pool bookkeeping, guarded by the pool's lock.
+    HashJob* next;
+    bool done;
+};
+
+void RunJob(HashJob* job) {
+    job->rc = HashNodesSerial(job->data, job->data_offset, job->data_len, job->level,
+                              job->first, job->count, job->out);
+}
+
+size_t MaxThreads() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus < 1 ? 1 : fbl::min(static_cast<size_t>(cpus), kMaxThreads);
+}
+
+// Threads that hash nodes for every caller in the process.  They are started
+// the first time a level is big enough to split, and live until the process
+// exits, so that verifying a blob a batch at a time doesn't create and join
+// threads for every batch.
+class HashPool {
+public:
+    // Returns the process's pool, starting its threads if needed, or null if
+    // it couldn't be allocated.
+    static HashPool* Get() {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+        pthread_once(&once, [] {
+            fbl::AllocChecker ac;
+            pool_ = new (&ac) HashPool();
+            if (!ac.check()) {
+                pool_ = nullptr;
+            }
+        });
+        return pool_;
+    }
+
+    // Runs |jobs|, the last of them on the calling thread.  The caller also
+    // takes queued jobs itself rather than waiting, so this finishes even if
+    // none of the pool's threads could be started.
+    void Run(HashJob* jobs, size_t num_jobs) {
+        pthread_mutex_lock(&lock_);
+        for (size_t i = 0; i < num_jobs - 1; ++i) {
+            Enqueue(&jobs[i]);
+        }
+        pthread_cond_broadcast(&work_cond_);
+        pthread_mutex_unlock(&lock_);
+
+        RunJob(&jobs[num_jobs - 1]);
+
+        pthread_mutex_lock(&lock_);
+        HashJob* job;
+        while ((job = Dequeue()) != nullptr) {
+            pthread_mutex_unlock(&lock_);
+            RunJob(job);
+            pthread_mutex_lock(&lock_);
+            Complete(job);
+        }
+        for (size_t i = 0; i < num_jobs - 1; ++i) {
+            while (!jobs[i].done) {
+                pthread_cond_wait(&done_cond_, &lock_);
+            }
+        }
+        pthread_mutex_unlock(&lock_);
+    }
+
+private:
+    HashPool() {
+        pthread_mutex_init(&lock_, nullptr);
+        pthread_cond_init(&work_cond_, nullptr);
+        pthread_cond_init(&done_cond_, nullptr);
+        for (size_t i = 1; i < MaxThreads(); ++i) {
+            pthread_t thread;
+            if (pthread_create(&thread, nullptr, Worker, this) != 0) {
+                break;
+            }
+            pthread_detach(thread);
+        }
+    }
+
+    static void* Worker(void* arg) {
+        HashPool* pool = static_cast<HashPool*>(arg);
+        pthread_mutex_lock(&pool->lock_);
+        for (;;) {
+            HashJob* job;
+            while ((job = pool->Dequeue()) == nullptr) {
+                pthread_cond_wait(&pool->work_cond_, &pool->lock_);
+            }
+            pthread_mutex_unlock(&pool->lock_);
+            RunJob(job);
+            pthread_mutex_lock(&pool->lock_);
+            pool->Complete(job);
+        }
+        return nullptr;
+    }
+
+    void Enqueue(HashJob* job) {
+        job->next = nullptr;
+        job->done = false;
+        if (tail_) {
+            tail_->next = job;
+        } else {
+            head_ = job;
+        }
+        tail_ = job;
+    }
+
+    HashJob* Dequeue() {
+        HashJob* job = head_;
+        if (job) {
+            head_ = job->next;
+            if (!head_) {
+                tail_ = nullptr;
+            }
+        }
+        return job;
+    }
+
+    void Complete(HashJob* job) {
+        job->done = true;
+        pthread_cond_broadcast(&done_cond_);
+    }
+
+    static HashPool* pool_;
+
+    pthread_mutex_t lock_;
+    pthread_cond_t work_cond_;
+    pthread_cond_t done_cond_;
+    HashJob* head_ = nullptr;
+    HashJob* tail_ = nullptr;
+};
+
+HashPool* HashPool::pool_;
+
+// See MerkleTree::HashNodes.  |data| holds the level from byte |data_offset|
+// on, which must be the start of a node no later than node |first|.
+zx_status_t HashNodesAt(const uint8_t* data, size_t data_offset, size_t data_len,
+                        uint64_t level, size_t first, size_t count, uint8_t* out) {
+    size_t num_jobs = fbl::min(count / kMinNodesPerThread, MaxThreads());
+    if (num_jobs <= 1) {
+        return HashNodesSerial(data, data_offset, data_len, level, first, count, out);
+    }
+
+    // Split the nodes evenly; the calling thread takes the last share.
+    HashJob jobs[kMaxThreads];
+    size_t per_job = count / num_jobs;
+    for (size_t i = 0; i < num_jobs; ++i) {
+        size_t offset = i * per_job;
+        jobs[i].data = data;
+        jobs[i].data_offset = data_offset;
+        jobs[i].data_len = data_len;
+        jobs[i].level = level;
+        jobs[i].first = first + offset;
+        jobs[i].count = (i == num_jobs - 1) ? count - offset : per_job;
+        jobs[i].out = out + offset * Digest::kLength;
+        jobs[i].rc = ZX_OK;
+    }
+    HashPool* pool = HashPool::Get();
+    if (!pool) {
+        return HashNodesSerial(data, data_offset, data_len, level, first, count, out);
+    }
+    pool->Run(jobs, num_jobs);
+
+    for (size_t i = 0; i < num_jobs; ++i) {
+        if (jobs[i].rc != ZX_OK) {
+            return jobs[i].rc;
+        }
+    }
+    return ZX_OK;
+}
+
 ////////
 // Helper functions for working between levels of the tree.
 
@@ -104,15 +318,54 @@ size_t MerkleTree::GetTreeLength(size_t data_len) {
     return (next_len == 0 ? 0 : next_len + GetTreeLength(next_len));
 }
 
+zx_status_t MerkleTree::HashNodes(const void* data, size_t data_len, uint64_t level,
+                                  size_t first, size_t count, uint8_t* out) {
+    // Must have data and room for the digests if hashing anything.
+    if (count != 0 && (!out || (!data && data_len != 0))) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    // Must not overrun the level.  An empty level still has one node.
+    size_t nodes = fbl::max(fbl::round_up(data_len, kNodeSize) / kNodeSize, size_t(1));
+    if (first > nodes || count > nodes - first) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    return HashNodesAt(static_cast<const uint8_t*>(data), 0, data_len, level, first, count, out);
+}
+
 zx_status_t MerkleTree::Create(const void* data, size_t data_len, void* tree, size_t tree_len,
                                Digest* digest) {
+    // Since all the data is at hand, the tree is built a whole level at a
+    // time rather than through CreateInit/CreateUpdate/CreateFinal, which
+    // lets each level be hashed in parallel.  Both produce the same tree.
+    if (tree_len < GetTreeLength(data_len)) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+    if ((!data && data_len != 0) || (!tree && data_len > kNodeSize) || !digest) {
+        return ZX_ERR_INVALID_ARGS;
+    }
     zx_status_t rc;
-    MerkleTree mt;
-    if ((rc = mt.CreateInit(data_len, tree_len)) != ZX_OK ||
-        (rc = mt.CreateUpdate(data, data_len, tree)) != ZX_OK ||
-        (rc = mt.CreateFinal(tree, digest)) != ZX_OK) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    uint8_t* out = static_cast<uint8_t*>(tree);
+    uint64_t level = 0;
+    while (data_len > kNodeSize) {
+        size_t nodes = fbl::round_up(data_len, kNodeSize) / kNodeSize;
+        if ((rc = HashNodes(in, data_len, level, 0, nodes, out)) != ZX_OK) {
+            return rc;
+        }
+        // Pad the last node of the next level up with zeros.
+        size_t next_len = NextAligned(data_len);
+        memset(out + nodes * Digest::kLength, 0, next_len - nodes * Digest::kLength);
+        // Ascend the tree.
+        in = out;
+        out += next_len;
+        data_len = next_len;
+        ++level;
+    }
+    uint8_t root[Digest::kLength];
+    if ((rc = HashNodes(in, data_len, level, 0, 1, root)) != ZX_OK) {
         return rc;
     }
+    *digest = root;
     return ZX_OK;
 }
 
@@ -246,16 +499,42 @@ zx_status_t MerkleTree::CreateFinalInternal(const void* data, void* tree, Digest
 
 zx_status_t MerkleTree::Verify(const void* data, size_t data_len, const void* tree, size_t tree_len,
                                size_t offset, size_t length, const Digest& root) {
+    return VerifyFrom(data, 0, data_len, tree, tree_len, offset, length, root);
+}
+
+zx_status_t MerkleTree::VerifyRange(const void* data, size_t data_len, const void* tree,
+                                    size_t tree_len, size_t offset, size_t length,
+                                    const Digest& root) {
+    // Only the nodes wholly within the range are at hand.
+    size_t end = offset + length;
+    if (end < offset || end > data_len) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    if (offset % kNodeSize != 0 || (end % kNodeSize != 0 && end != data_len)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    // Data that fits in one node is hashed as a whole.
+    if (data_len <= kNodeSize && length != data_len) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    return VerifyFrom(data, offset, data_len, tree, tree_len, offset, length, root);
+}
+
+zx_status_t MerkleTree::VerifyFrom(const void* data, size_t data_offset, size_t data_len,
+                                   const void* tree, size_t tree_len, size_t offset,
+                                   size_t length, const Digest& root) {
     uint64_t level = 0;
     size_t root_len = data_len;
     while (data_len > kNodeSize) {
         zx_status_t rc;
         // Verify the data in this level.
-        if ((rc = VerifyLevel(data, data_len, tree, offset, length, level)) != ZX_OK) {
+        if ((rc = VerifyLevel(data, data_offset, data_len, tree, offset, length,
+                              level)) != ZX_OK) {
             return rc;
         }
-        // Ascend to the next level up.
+        // Ascend to the next level up, which the tree holds in full.
         data = tree;
+        data_offset = 0;
         root_len = NextLength(data_len);
         data_len = NextAligned(data_len);
         tree = static_cast<const uint8_t*>(tree) + data_len;
@@ -288,8 +567,9 @@ zx_status_t MerkleTree::VerifyRoot(const void* data, size_t root_len, uint64_t l
     return (actual == expected ? ZX_OK : ZX_ERR_IO_DATA_INTEGRITY);
 }
 
-zx_status_t MerkleTree::VerifyLevel(const void* data, size_t data_len, const void* tree,
-                                    size_t offset, size_t length, uint64_t level) {
+zx_status_t MerkleTree::VerifyLevel(const void* data, size_t data_offset, size_t data_len,
+                                    const void* tree, size_t offset, size_t length,
+                                    uint64_t level) {
     zx_status_t rc;
     ZX_DEBUG_ASSERT(offset + length >= offset);
     // Must have more than one node of data and digests to check against.
@@ -304,24 +584,33 @@ zx_status_t MerkleTree::VerifyLevel(const void* data, size_t data_len, const voi
     offset -= offset % kNodeSize;
     size_t finish = fbl::round_up(offset + length, kNodeSize);
     length = fbl::min(finish, data_len) - offset;
-    const uint8_t* in = static_cast<const uint8_t*>(data) + offset;
     // The digests are in the next level up.
-    Digest actual;
     const uint8_t* expected = static_cast<const uint8_t*>(tree) + (offset / kDigestsPerNode);
-    // Check the data of this level against the digests.
-    while (length > 0) {
-        if ((rc = DigestInit(&actual, offset | level, data_len - offset)) != ZX_OK) {
+    size_t first = offset / kNodeSize;
+    size_t count = fbl::round_up(length, kNodeSize) / kNodeSize;
+    if (count == 0) {
+        return ZX_OK;
+    }
+    // Check the data of this level against the digests, a batch of nodes at a
+    // time.
+    size_t batch = fbl::min(count, kVerifyBatchNodes);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> actual(new (&ac) uint8_t[batch * Digest::kLength]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    while (count > 0) {
+        batch = fbl::min(count, kVerifyBatchNodes);
+        if ((rc = HashNodesAt(static_cast<const uint8_t*>(data), data_offset, data_len, level,
+                              first, batch, actual.get())) != ZX_OK) {
             return rc;
         }
-        size_t chunk = DigestUpdate(&actual, in, offset, length);
-        in += chunk;
-        offset += chunk;
-        length -= chunk;
-        DigestFinal(&actual, offset);
-        if (actual != expected) {
+        if (memcmp(actual.get(), expected, batch * Digest::kLength) != 0) {
             return ZX_ERR_IO_DATA_INTEGRITY;
         }
-        expected += Digest::kLength;
+        expected += batch * Digest::kLength;
+        first += batch;
+        count -= batch;
     }
     return ZX_OK;
 }
@@ -153,6 +153,19 @@ typedef struct {
 // May not be supplied with FDIO_MMAP_FLAG_PRIVATE.
 #define FDIO_MMAP_FLAG_EXACT   (1u << 17)
 
+// Signals which a server may assert on the event of a file (|file.e|).
+//
+// FILE_SIGNAL_VMO_SHARED: GetVmo(FDIO_MMAP_FLAG_READ) returns the VMO which
+// holds the contents of the file, rather than a snapshot of them. Clients may
+// read the file directly from that VMO, up to the size reported by Stat, for
+// as long as FILE_SIGNAL_RESIZED remains deasserted.
+// FILE_SIGNAL_RESIZED: The size of the file has changed. Never deasserted;
+// connections opened afterwards are handed a different event.
+//
+// The device signals used by poll() occupy ZX_USER_SIGNAL_0 through 4.
+#define FILE_SIGNAL_VMO_SHARED ZX_USER_SIGNAL_5
+#define FILE_SIGNAL_RESIZED    ZX_USER_SIGNAL_6
+
 static_assert(FDIO_MMAP_FLAG_READ == ZX_VM_PERM_READ, "Vmar / Mmap flags should be aligned");
 static_assert(FDIO_MMAP_FLAG_WRITE == ZX_VM_PERM_WRITE, "Vmar / Mmap flags should be aligned");
 static_assert(FDIO_MMAP_FLAG_EXEC == ZX_VM_PERM_EXECUTE, "Vmar / Mmap flags should be aligned");
@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <threads.h>
+
 #include "private.h"
 
 typedef struct zxrio zxrio_t;
@@ -16,8 +20,48 @@ struct zxrio {
 
     // event handle for device state signals
     zx_handle_t event;
+
+    // set if large reads may keep several requests in flight on |h|; cleared
+    // for good if a pipelined read loses track of its replies
+    atomic_bool pipelined;
+
+    // serializes pipelined reads, which read their replies from |h|
+    // directly rather than through zx_channel_call
+    mtx_t pipeline_lock;
+
+    // txid of the most recent pipelined request
+    zx_txid_t pipeline_txid;
+
+    // guards the fields below
+    mtx_t vmo_lock;
+
+    // one of ZXRIO_VMO_*
+    uint32_t vmo_state;
+
+    // number of reads through |h| while the VMO is pending
+    uint32_t vmo_reads;
+
+    // the VMO holding the contents of the file, and the size of the file
+    // when it was acquired; only valid while the VMO is active
+    zx_handle_t vmo;
+    uint64_t vmo_size;
+
+    // set if the seek offset is tracked by |seek| rather than the server
+    bool seek_local;
+    off_t seek;
+
+    // number of reads at the server's seek offset in progress; the offset
+    // is not tracked locally again until they have all finished
+    uint32_t remote_reads;
 };
 
+// The file may be read through its VMO once it has been read often enough.
+#define ZXRIO_VMO_PENDING  0
+// Reads are served from the VMO.
+#define ZXRIO_VMO_ACTIVE   1
+// Reads always go to the server.
+#define ZXRIO_VMO_DISABLED 2
+
 // These are for the benefit of namespace.c
 // which needs lower level access to remoteio internals
 
@@ -96,6 +96,10 @@ static zx_status_t zxrio_object_extract_handle(const zxrio_node_info_t* info,
 static zx_status_t zxrio_close(fdio_t* io) {
     zxrio_t* rio = (zxrio_t*)io;
 
+    if (rio->vmo != ZX_HANDLE_INVALID) {
+        zx_handle_close(rio->vmo);
+        rio->vmo = ZX_HANDLE_INVALID;
+    }
     zx_status_t r = fidl_close(rio);
     zx_handle_t h = rio->h;
     rio->h = ZX_HANDLE_INVALID;
@@ -139,9 +143,100 @@ static zx_status_t zxrio_connect(zx_handle_t svc, zx_handle_t cnxn,
     return r;
 }
 
+// The number of reads of a file sent to the server before its VMO is acquired,
+// so that files which are only read a few times never pay to acquire it.
+#define ZXRIO_VMO_READS 4
+
+// Returns the signals currently asserted on the event of |rio|.
+static zx_signals_t zxrio_event_signals(zxrio_t* rio) {
+    zx_signals_t observed = 0;
+    zx_object_wait_one(rio->event, FILE_SIGNAL_VMO_SHARED | FILE_SIGNAL_RESIZED, 0, &observed);
+    return observed;
+}
+
+// Hands the seek offset tracked while reading through the VMO back to the
+// server. Called with |vmo_lock| held.
+static zx_status_t zxrio_seek_sync(zxrio_t* rio) {
+    if (!rio->seek_local) {
+        return ZX_OK;
+    }
+    rio->seek_local = false;
+    off_t offset;
+    return fidl_seek(rio, rio->seek, SEEK_SET, &offset);
+}
+
+// Stops reading |rio| through its VMO. Called with |vmo_lock| held.
+static zx_status_t zxrio_vmo_disable(zxrio_t* rio) {
+    if (rio->vmo != ZX_HANDLE_INVALID) {
+        zx_handle_close(rio->vmo);
+        rio->vmo = ZX_HANDLE_INVALID;
+    }
+    rio->vmo_state = ZXRIO_VMO_DISABLED;
+    return zxrio_seek_sync(rio);
+}
+
+// Returns true if a read of |rio| may be served from its VMO, acquiring the
+// VMO once the file has been read ZXRIO_VMO_READS times. Called with
+// |vmo_lock| held.
+static bool zxrio_vmo_usable(zxrio_t* rio) {
+    if (rio->vmo_state == ZXRIO_VMO_PENDING) {
+        if (++rio->vmo_reads < ZXRIO_VMO_READS) {
+            return false;
+        }
+        // Only files whose server keeps the VMO coherent with their
+        // contents may be read through it.
+        if (rio->event == ZX_HANDLE_INVALID ||
+            !(zxrio_event_signals(rio) & FILE_SIGNAL_VMO_SHARED)) {
+            rio->vmo_state = ZXRIO_VMO_DISABLED;
+            return false;
+        }
+        vnattr_t attr;
+        if (fidl_getvmo(rio, FDIO_MMAP_FLAG_READ, &rio->vmo) != ZX_OK) {
+            rio->vmo = ZX_HANDLE_INVALID;
+            rio->vmo_state = ZXRIO_VMO_DISABLED;
+            return false;
+        } else if (fidl_stat(rio, &attr) != ZX_OK) {
+            zxrio_vmo_disable(rio);
+            return false;
+        }
+        rio->vmo_size = attr.size;
+        rio->vmo_state = ZXRIO_VMO_ACTIVE;
+    }
+    if (rio->vmo_state != ZXRIO_VMO_ACTIVE) {
+        return false;
+    }
+    // Also catches a resize between acquiring the VMO and reading the size.
+    if (zxrio_event_signals(rio) & FILE_SIGNAL_RESIZED) {
+        zxrio_vmo_disable(rio);
+        return false;
+    }
+    return true;
+}
+
+// Reads up to |len| bytes at |offset| from the VMO of |rio|. Called with
+// |vmo_lock| held, while the VMO is active.
+static ssize_t zxrio_vmo_read_at(zxrio_t* rio, void* data, size_t len, uint64_t offset) {
+    if (offset >= rio->vmo_size) {
+        return 0;
+    }
+    if (len > rio->vmo_size - offset) {
+        len = rio->vmo_size - offset;
+    }
+    zx_status_t status = zx_vmo_read(rio->vmo, data, offset, len);
+    if (status != ZX_OK) {
+        return status;
+    }
+    return len;
+}
+
 static ssize_t zxrio_write(fdio_t* io, const void* data, size_t len) {
     zxrio_t* rio = (zxrio_t*) io;
-    zx_status_t status = ZX_OK;
+    mtx_lock(&rio->vmo_lock);
+    zx_status_t status = zxrio_seek_sync(rio);
+    mtx_unlock(&rio->vmo_lock);
+    if (status != ZX_OK) {
+        return status;
+    }
     uint64_t count = 0;
     uint64_t xfer;
     while (len > 0) {
@@ -193,8 +288,182 @@ static zx_status_t zxrio_get_attr(fdio_t* io, vnattr_t* out) {
     return fidl_stat(rio, out);
 }
 
-static ssize_t zxrio_read(fdio_t* io, void* data, size_t len) {
-    zxrio_t* rio = (zxrio_t*) io;
+// The number of read requests which a single large read keeps outstanding
+// on the channel at once.
+#define ZXRIO_PIPELINE_DEPTH 8
+
+static_assert(sizeof(fuchsia_io_FileReadResponse) == sizeof(fuchsia_io_FileReadAtResponse),
+              "Read and ReadAt replies are decoded alike");
+
+// Sends a Read or ReadAt request for |count| bytes, without waiting for the reply.
+static zx_status_t zxrio_read_request(zxrio_t* rio, uint32_t ordinal, uint64_t count,
+                                      uint64_t offset, zx_txid_t* out_txid) {
+    // Userspace txids lie within 1..0x7FFFFFFF; the kernel allocates the
+    // remainder to zx_channel_call, so the two never collide.
+    rio->pipeline_txid = (rio->pipeline_txid % 0x7FFFFFFF) + 1;
+    *out_txid = rio->pipeline_txid;
+
+    if (ordinal == ZXFIDL_READ_AT) {
+        fuchsia_io_FileReadAtRequest request;
+        memset(&request, 0, sizeof(request));
+        request.hdr.txid = *out_txid;
+        request.hdr.ordinal = ZXFIDL_READ_AT;
+        request.count = count;
+        request.offset = offset;
+        return zx_channel_write(rio->h, 0, &request, sizeof(request), NULL, 0);
+    }
+    fuchsia_io_FileReadRequest request;
+    memset(&request, 0, sizeof(request));
+    request.hdr.txid = *out_txid;
+    request.hdr.ordinal = ZXFIDL_READ;
+    request.count = count;
+    return zx_channel_write(rio->h, 0, &request, sizeof(request), NULL, 0);
+}
+
+// Waits for the reply to request |txid|, which asked for |count| bytes.
+// Copies the data into |data|, unless it is NULL.
+//
+// Returns an error if the reply could not be received; otherwise the status
+// of the read itself is returned in |out_status|.
+static zx_status_t zxrio_read_reply(zxrio_t* rio, zx_txid_t txid, void* data, uint64_t count,
+                                    zx_status_t* out_status, uint64_t* out_actual) {
+    uint8_t msg[FIDL_ALIGN(sizeof(fuchsia_io_FileReadResponse)) + FDIO_CHUNK_SIZE];
+    zx_handle_t handles[FDIO_MAX_HANDLES];
+    uint32_t dsize;
+    uint32_t hcount;
+    zx_status_t status;
+    for (;;) {
+        status = zx_channel_read(rio->h, 0, msg, handles, sizeof(msg), countof(handles),
+                                 &dsize, &hcount);
+        if (status != ZX_ERR_SHOULD_WAIT) {
+            break;
+        }
+        zx_signals_t pending;
+        status = zx_object_wait_one(rio->h, ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED,
+                                    ZX_TIME_INFINITE, &pending);
+        if (status != ZX_OK) {
+            return status;
+        } else if (!(pending & ZX_CHANNEL_READABLE)) {
+            return ZX_ERR_PEER_CLOSED;
+        }
+    }
+    if (status != ZX_OK) {
+        return status;
+    }
+    // Replies to reads never carry handles.
+    zx_handle_close_many(handles, hcount);
+
+    const fuchsia_io_FileReadResponse* response = (const fuchsia_io_FileReadResponse*) msg;
+    const size_t header_size = FIDL_ALIGN(sizeof(*response));
+    if (dsize < header_size || response->hdr.txid != txid) {
+        return ZX_ERR_IO;
+    }
+    if (response->s != ZX_OK) {
+        *out_status = response->s;
+        *out_actual = 0;
+        return ZX_OK;
+    }
+    uint64_t actual = response->data.count;
+    if (actual > count || dsize < header_size + actual) {
+        return ZX_ERR_IO;
+    }
+    if (data != NULL) {
+        memcpy(data, msg + header_size, actual);
+    }
+    *out_status = ZX_OK;
+    *out_actual = actual;
+    return ZX_OK;
+}
+
+// Reads |len| bytes with a Read or ReadAt request for each chunk, keeping up
+// to ZXRIO_PIPELINE_DEPTH requests in flight. The server handles the requests
+// on a channel one at a time, in order, so the replies arrive in the order in
+// which the requests were sent, and Read requests advance the seek offset
+// exactly as they would if each had waited for the last.
+//
+// Once a request comes back short or fails, no more requests are sent. The
+// data of the requests already in flight is kept when reading at the seek
+// offset, since the server has consumed it, and discarded otherwise.
+//
+// If a reply cannot be received, the replies still in flight are drained so
+// that they are not mistaken for those of a later read, and pipelining is
+// turned off for the rio in case the channel no longer holds them in order.
+static ssize_t zxrio_read_pipelined(zxrio_t* rio, uint32_t ordinal, void* data, size_t len,
+                                    off_t offset) {
+    zx_txid_t txids[ZXRIO_PIPELINE_DEPTH];
+    uint64_t counts[ZXRIO_PIPELINE_DEPTH];
+    size_t sent = 0;
+    size_t received = 0;
+    uint64_t requested = 0;
+    uint64_t count = 0;
+    bool stopped = false;
+    zx_status_t status = ZX_OK;
+
+    mtx_lock(&rio->pipeline_lock);
+    for (;;) {
+        while (!stopped && requested < len && sent - received < ZXRIO_PIPELINE_DEPTH) {
+            size_t slot = sent % ZXRIO_PIPELINE_DEPTH;
+            uint64_t xfer = (len - requested > FDIO_CHUNK_SIZE) ? FDIO_CHUNK_SIZE
+                                                               : len - requested;
+            zx_status_t r = zxrio_read_request(rio, ordinal, xfer, offset + requested,
+                                               &txids[slot]);
+            if (r != ZX_OK) {
+                status = r;
+                stopped = true;
+                break;
+            }
+            counts[slot] = xfer;
+            requested += xfer;
+            sent++;
+        }
+        if (received == sent) {
+            break;
+        }
+
+        size_t slot = received++ % ZXRIO_PIPELINE_DEPTH;
+        bool keep = !stopped || ordinal == ZXFIDL_READ;
+        zx_status_t read_status;
+        uint64_t actual;
+        zx_status_t r = zxrio_read_reply(rio, txids[slot], keep ? data + count : NULL,
+                                         counts[slot], &read_status, &actual);
+        if (r != ZX_OK) {
+            status = r;
+            rio->pipelined = false;
+            while (received < sent) {
+                slot = received++ % ZXRIO_PIPELINE_DEPTH;
+                if (zxrio_read_reply(rio, txids[slot], NULL, counts[slot], &read_status,
+                                     &actual) != ZX_OK) {
+                    break;
+                }
+            }
+            break;
+        }
+        if (read_status != ZX_OK) {
+            if (!stopped) {
+                status = read_status;
+            }
+            stopped = true;
+            continue;
+        }
+        if (keep) {
+            count += actual;
+        }
+        if (actual != counts[slot]) {
+            stopped = true;
+        }
+    }
+    mtx_unlock(&rio->pipeline_lock);
+
+    if (count == 0) {
+        return status;
+    }
+    return count;
+}
+
+static ssize_t zxrio_read_remote(zxrio_t* rio, void* data, size_t len) {
+    if (rio->pipelined && len > FDIO_CHUNK_SIZE) {
+        return zxrio_read_pipelined(rio, ZXFIDL_READ, data, len, 0);
+    }
     zx_status_t status = ZX_OK;
     uint64_t count = 0;
     uint64_t xfer;
@@ -217,8 +486,58 @@ static ssize_t zxrio_read(fdio_t* io, void* data, size_t len) {
     return count;
 }
 
+static ssize_t zxrio_read(fdio_t* io, void* data, size_t len) {
+    zxrio_t* rio = (zxrio_t*) io;
+    mtx_lock(&rio->vmo_lock);
+    if (rio->remote_reads == 0 && zxrio_vmo_usable(rio)) {
+        if (!rio->seek_local &&
+            fidl_seek(rio, 0, SEEK_CUR, &rio->seek) == ZX_OK) {
+            rio->seek_local = true;
+        }
+        if (rio->seek_local) {
+            ssize_t r = zxrio_vmo_read_at(rio, data, len, rio->seek);
+            if (r >= 0) {
+                rio->seek += r;
+                mtx_unlock(&rio->vmo_lock);
+                return r;
+            }
+        }
+        zxrio_vmo_disable(rio);
+    }
+    ssize_t r = zxrio_seek_sync(rio);
+    if (r != ZX_OK) {
+        mtx_unlock(&rio->vmo_lock);
+        return r;
+    }
+    // The server holds the seek offset now, so the read need not hold the
+    // lock. Reads which begin meanwhile go to the server as well, rather than
+    // taking the offset back before this one has moved it.
+    rio->remote_reads++;
+    mtx_unlock(&rio->vmo_lock);
+    r = zxrio_read_remote(rio, data, len);
+    mtx_lock(&rio->vmo_lock);
+    rio->remote_reads--;
+    mtx_unlock(&rio->vmo_lock);
+    return r;
+}
+
 static ssize_t zxrio_read_at(fdio_t* io, void* data, size_t len, off_t offset) {
     zxrio_t* rio = (zxrio_t*) io;
+    if (offset >= 0) {
+        mtx_lock(&rio->vmo_lock);
+        if (zxrio_vmo_usable(rio)) {
+            ssize_t r = zxrio_vmo_read_at(rio, data, len, offset);
+            if (r >= 0) {
+                mtx_unlock(&rio->vmo_lock);
+                return r;
+            }
+            zxrio_vmo_disable(rio);
+        }
+        mtx_unlock(&rio->vmo_lock);
+    }
+    if (rio->pipelined && len > FDIO_CHUNK_SIZE) {
+        return zxrio_read_pipelined(rio, ZXFIDL_READ_AT, data, len, offset);
+    }
     zx_status_t status = ZX_OK;
     uint64_t count = 0;
     uint64_t xfer;
@@ -244,7 +563,23 @@ static ssize_t zxrio_read_at(fdio_t* io, void* data, size_t len, off_t offset) {
 
 static off_t zxrio_seek(fdio_t* io, off_t offset, int whence) {
     zxrio_t* rio = (zxrio_t*)io;
-    zx_status_t status = fidl_seek(rio, offset, whence, &offset);
+    mtx_lock(&rio->vmo_lock);
+    if (rio->seek_local && (whence == SEEK_SET || whence == SEEK_CUR)) {
+        off_t target = offset;
+        if (whence == SEEK_CUR && __builtin_add_overflow(rio->seek, offset, &target)) {
+            target = -1;
+        }
+        if (target >= 0) {
+            rio->seek = target;
+        }
+        mtx_unlock(&rio->vmo_lock);
+        return (target >= 0) ? target : ZX_ERR_INVALID_ARGS;
+    }
+    zx_status_t status = zxrio_seek_sync(rio);
+    if (status == ZX_OK) {
+        status = fidl_seek(rio, offset, whence, &offset);
+    }
+    mtx_unlock(&rio->vmo_lock);
     if (status != ZX_OK) {
         return status;
     }
@@ -497,6 +832,12 @@ static zx_status_t fdio_from_handles(zx_handle_t handle, zxrio_node_info_t* info
         if (io == NULL) {
             return ZX_ERR_NO_RESOURCES;
         }
+        // Reads of files never block waiting for data, so large reads may
+        // safely request more than the next chunk ahead of time. Frequently
+        // read files may also be read through their VMOs, if the server
+        // allows it.
+        ((zxrio_t*) io)->pipelined = true;
+        ((zxrio_t*) io)->vmo_state = ZXRIO_VMO_PENDING;
         *out = io;
         return ZX_OK;
     case FDIO_PROTOCOL_DEVICE:
@@ -751,6 +1092,10 @@ static zx_status_t zxrio_clone(fdio_t* io, zx_handle_t* handles, uint32_t* types
 static zx_status_t zxrio_unwrap(fdio_t* io, zx_handle_t* handles, uint32_t* types) {
     zxrio_t* rio = (void*)io;
     LOG(1, "fdio: zxrio_unwrap(%p,...)\n");
+    // The server takes back the seek offset along with the channel.
+    mtx_lock(&rio->vmo_lock);
+    zxrio_vmo_disable(rio);
+    mtx_unlock(&rio->vmo_lock);
     handles[0] = rio->h;
     types[0] = PA_FDIO_REMOTE;
     if (rio->event != ZX_HANDLE_INVALID) {
@@ -898,5 +1243,16 @@ fdio_t* fdio_remote_create(zx_handle_t h, zx_handle_t event) {
     atomic_init(&rio->io.refcount, 1);
     rio->h = h;
     rio->event = event;
+    atomic_init(&rio->pipelined, false);
+    mtx_init(&rio->pipeline_lock, mtx_plain);
+    rio->pipeline_txid = 0;
+    mtx_init(&rio->vmo_lock, mtx_plain);
+    rio->vmo_state = ZXRIO_VMO_DISABLED;
+    rio->vmo_reads = 0;
+    rio->vmo = ZX_HANDLE_INVALID;
+    rio->vmo_size = 0;
+    rio->seek_local = false;
+    rio->seek = 0;
+    rio->remote_reads = 0;
     return &rio->io;
 }
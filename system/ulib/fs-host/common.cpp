@@ -32,6 +32,8 @@ struct {
         "Byte offset at which minfs partition starts"},
     {"length",   Option::kLength,   "[bytes]", "Remaining Length",
         "Length in bytes of minfs partition"},
+    {"extents",  Option::kExtents,  "",        nullptr,
+        "Map the blocks of new files with extents"},
     {"help",     Option::kHelp,     "",        nullptr,
         "Display this message"},
 };
@@ -229,7 +231,7 @@ zx_status_t FsCreator::ProcessArgs(int argc, char** argv) {
 
         int opt_index;
 
-        int c = getopt_long(argc, argv, "+dro:l:h", opts, &opt_index);
+        int c = getopt_long(argc, argv, "+dro:l:eh", opts, &opt_index);
         if (c < 0) {
             break;
         }
@@ -247,6 +249,9 @@ zx_status_t FsCreator::ProcessArgs(int argc, char** argv) {
         case 'l':
             length_ = atoll(optarg);
             break;
+        case 'e':
+            extents_ = true;
+            break;
         case 'h':
         default:
             return Usage();
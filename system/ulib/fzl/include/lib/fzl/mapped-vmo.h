@@ -25,6 +25,11 @@ public:
 
     static zx_status_t Create(size_t size, const char* name, fbl::unique_ptr<MappedVmo>* out);
 
+    // Maps the first |size| bytes of an existing |vmo|, taking ownership of
+    // the handle. On failure, |vmo| is closed.
+    static zx_status_t CreateFromVmo(zx_handle_t vmo, size_t size,
+                                     fbl::unique_ptr<MappedVmo>* out);
+
     // Attempts to reduce both the VMO size and VMAR mapping
     // from length |len_| to |len|.
     //
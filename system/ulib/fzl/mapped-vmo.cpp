@@ -51,6 +51,28 @@ zx_status_t MappedVmo::Create(size_t size, const char* name, fbl::unique_ptr<Map
     return ZX_OK;
 }
 
+zx_status_t MappedVmo::CreateFromVmo(zx_handle_t vmo, size_t size,
+                                     fbl::unique_ptr<MappedVmo>* out) {
+    uintptr_t addr;
+    zx_status_t status;
+    if ((status = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                              0, vmo, 0, size, &addr)) != ZX_OK) {
+        zx_handle_close(vmo);
+        return status;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<MappedVmo> mvmo(new (&ac) MappedVmo(vmo, addr, size));
+    if (!ac.check()) {
+        zx_vmar_unmap(zx_vmar_root_self(), addr, size);
+        zx_handle_close(vmo);
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    *out = fbl::move(mvmo);
+    return ZX_OK;
+}
+
 zx_status_t MappedVmo::Shrink(size_t len) {
     if (len == 0 || len > len_) {
         return ZX_ERR_INVALID_ARGS;
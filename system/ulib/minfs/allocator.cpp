@@ -35,6 +35,19 @@ size_t AllocatorPromise::Allocate(WriteTxn* txn) {
     return allocator_->Allocate(txn);
 }
 
+size_t AllocatorPromise::AllocateNear(WriteTxn* txn, size_t goal) {
+    ZX_DEBUG_ASSERT(allocator_ != nullptr);
+    ZX_DEBUG_ASSERT(reserved_ > 0);
+    reserved_--;
+    return allocator_->AllocateNear(txn, goal);
+}
+
+void AllocatorPromise::Merge(fbl::unique_ptr<AllocatorPromise> other) {
+    ZX_DEBUG_ASSERT(other->allocator_ == allocator_);
+    reserved_ += other->reserved_;
+    other->reserved_ = 0;
+}
+
 AllocatorFvmMetadata::AllocatorFvmMetadata() = default;
 AllocatorFvmMetadata::AllocatorFvmMetadata(uint32_t* data_slices,
                                            uint32_t* metadata_slices,
@@ -122,7 +135,12 @@ zx_status_t Allocator::Reserve(WriteTxn* txn, size_t count,
     }
 
     reserved_ += count;
-    (*out_promise).reset(new AllocatorPromise(this, count));
+    if (*out_promise != nullptr) {
+        ZX_DEBUG_ASSERT((*out_promise)->allocator_ == this);
+        (*out_promise)->reserved_ += count;
+    } else {
+        (*out_promise).reset(new AllocatorPromise(this, count));
+    }
     return ZX_OK;
 }
 
@@ -138,14 +156,28 @@ size_t Allocator::Allocate(WriteTxn* txn) {
         ZX_ASSERT(map_.Find(false, 0, hint_, 1, &bitoff_start) == ZX_OK);
     }
 
-    ZX_ASSERT(map_.Set(bitoff_start, bitoff_start + 1) == ZX_OK);
+    Claim(txn, bitoff_start);
+    hint_ = bitoff_start + 1;
+    return bitoff_start;
+}
+
+size_t Allocator::AllocateNear(WriteTxn* txn, size_t goal) {
+    ZX_DEBUG_ASSERT(reserved_ > 0);
+    if (goal >= map_.size() || map_.Get(goal, goal + 1)) {
+        return Allocate(txn);
+    }
+
+    Claim(txn, goal);
+    return goal;
+}
+
+void Allocator::Claim(WriteTxn* txn, size_t index) {
+    ZX_ASSERT(map_.Set(index, index + 1) == ZX_OK);
 
-    Persist(txn, bitoff_start, 1);
+    Persist(txn, index, 1);
     metadata_.PoolAllocate(1);
     reserved_ -= 1;
     sb_->Write(txn);
-    hint_ = bitoff_start + 1;
-    return bitoff_start;
 }
 
 void Allocator::Free(WriteTxn* txn, size_t index) {
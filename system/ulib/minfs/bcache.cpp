@@ -8,7 +8,9 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
+#include <fbl/auto_lock.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
 #include <fs/trace.h>
@@ -19,12 +21,151 @@
 
 namespace minfs {
 
+#ifdef __Fuchsia__
+zx_status_t Bcache::Readblk(blk_t bno, void* data) {
+    fbl::AutoLock lock(&cache_lock_);
+    int slot = FindCached(bno);
+    if (slot < 0) {
+        // Double the readahead window for as long as reads stay sequential.
+        if (bno == last_read_ + 1) {
+            readahead_ = fbl::min(readahead_ * 2, kMinfsReadaheadMax);
+        } else {
+            readahead_ = 1;
+        }
+        uint32_t count = bno < blockmax_ ? fbl::min(readahead_, blockmax_ - bno) : 1;
+        uint32_t filled;
+        zx_status_t status;
+        if ((status = FillCache(bno, count, &filled)) != ZX_OK) {
+            FS_TRACE_ERROR("minfs: cannot read block %u: %d\n", bno, status);
+            return status;
+        }
+        slot = static_cast<int>(filled);
+    }
+    last_read_ = bno;
+    cache_[slot].last_use = ++cache_clock_;
+    memcpy(data, SlotData(slot), kMinfsBlockSize);
+    return ZX_OK;
+}
+
+zx_status_t Bcache::Writeblk(blk_t bno, const void* data) {
+    fbl::AutoLock lock(&cache_lock_);
+    int found = FindCached(bno);
+    uint32_t slot = found < 0 ? EvictSlot() : static_cast<uint32_t>(found);
+    memcpy(SlotData(slot), data, kMinfsBlockSize);
+    block_fifo_request_t request = SlotRequest(BLOCKIO_WRITE, slot, bno);
+    zx_status_t status = fifo_client_.Transaction(&request, 1);
+    if (status != ZX_OK) {
+        cache_[slot].valid = false;
+        FS_TRACE_ERROR("minfs: cannot write block %u: %d\n", bno, status);
+        return status;
+    }
+    cache_[slot] = {bno, true, ++cache_clock_, false};
+    return ZX_OK;
+}
+
+zx_status_t Bcache::Transaction(block_fifo_request_t* requests, size_t count) {
+    zx_status_t status = fifo_client_.Transaction(requests, count);
+
+    // Drop cached copies of anything which was (or may have been) written,
+    // so that the next Readblk observes the device.
+    const uint64_t factor = kMinfsBlockSize / info_.block_size;
+    fbl::AutoLock lock(&cache_lock_);
+    for (size_t i = 0; i < count; i++) {
+        if ((requests[i].opcode & BLOCKIO_OP_MASK) != BLOCKIO_WRITE) {
+            continue;
+        }
+        uint64_t start = requests[i].dev_offset / factor;
+        uint64_t end = fbl::round_up(requests[i].dev_offset + requests[i].length, factor) / factor;
+        for (uint32_t slot = 0; slot < kMinfsBlockCacheSize; slot++) {
+            if (cache_[slot].valid && cache_[slot].bno >= start && cache_[slot].bno < end) {
+                cache_[slot].valid = false;
+            }
+        }
+    }
+    return status;
+}
+
+zx_status_t Bcache::FillCache(blk_t bno, uint32_t count, uint32_t* out_slot) {
+    block_fifo_request_t requests[kMinfsReadaheadMax];
+    uint32_t slots[kMinfsReadaheadMax];
+    ZX_DEBUG_ASSERT(count > 0 && count <= kMinfsReadaheadMax);
+
+    uint32_t n = 0;
+    for (; n < count; n++) {
+        if (n > 0 && FindCached(bno + n) >= 0) {
+            break;
+        }
+        // Claim each slot as it is chosen, so that it is not chosen again.
+        slots[n] = EvictSlot();
+        cache_[slots[n]] = {bno + n, false, ++cache_clock_, true};
+        requests[n] = SlotRequest(BLOCKIO_READ, slots[n], bno + n);
+    }
+
+    zx_status_t status = fifo_client_.Transaction(requests, n);
+    for (uint32_t i = 0; i < n; i++) {
+        cache_[slots[i]].valid = (status == ZX_OK);
+        cache_[slots[i]].pending = false;
+    }
+    if (status != ZX_OK) {
+        return status;
+    }
+    *out_slot = slots[0];
+    return ZX_OK;
+}
+
+int Bcache::FindCached(blk_t bno) const {
+    for (uint32_t slot = 0; slot < kMinfsBlockCacheSize; slot++) {
+        if (cache_[slot].valid && cache_[slot].bno == bno) {
+            return static_cast<int>(slot);
+        }
+    }
+    return -1;
+}
+
+uint32_t Bcache::EvictSlot() const {
+    static_assert(kMinfsReadaheadMax < kMinfsBlockCacheSize,
+                  "readahead must leave a slot which isn't pending");
+    uint32_t victim = kMinfsBlockCacheSize;
+    for (uint32_t slot = 0; slot < kMinfsBlockCacheSize; slot++) {
+        if (cache_[slot].pending) {
+            continue;
+        }
+        if (!cache_[slot].valid) {
+            return slot;
+        }
+        if (victim == kMinfsBlockCacheSize || cache_[slot].last_use < cache_[victim].last_use) {
+            victim = slot;
+        }
+    }
+    ZX_DEBUG_ASSERT(victim < kMinfsBlockCacheSize);
+    return victim;
+}
+
+block_fifo_request_t Bcache::SlotRequest(uint32_t opcode, uint32_t slot, blk_t bno) {
+    const uint64_t factor = kMinfsBlockSize / info_.block_size;
+    block_fifo_request_t request = {};
+    request.opcode = opcode;
+    request.group = BlockGroupID();
+    request.vmoid = cache_vmoid_;
+    request.length = static_cast<uint32_t>(factor);
+    request.vmo_offset = slot * factor;
+    request.dev_offset = bno * factor;
+    return request;
+}
+
+zx_status_t Bcache::InitCache() {
+    zx_status_t status;
+    if ((status = fzl::MappedVmo::Create(kMinfsBlockCacheSize * kMinfsBlockSize, "minfs-bcache",
+                                         &cache_vmo_)) != ZX_OK) {
+        return status;
+    }
+    return AttachVmo(cache_vmo_->GetVmo(), &cache_vmoid_);
+}
+#else
 zx_status_t Bcache::Readblk(blk_t bno, void* data) {
     off_t off = static_cast<off_t>(bno) * kMinfsBlockSize;
     assert(off / kMinfsBlockSize == bno); // Overflow
-#ifndef __Fuchsia__
     off += offset_;
-#endif
     if (lseek(fd_.get(), off, SEEK_SET) < 0) {
         FS_TRACE_ERROR("minfs: cannot seek to block %u\n", bno);
         return ZX_ERR_IO;
@@ -39,9 +180,7 @@ zx_status_t Bcache::Readblk(blk_t bno, void* data) {
 zx_status_t Bcache::Writeblk(blk_t bno, const void* data) {
     off_t off = static_cast<off_t>(bno) * kMinfsBlockSize;
     assert(off / kMinfsBlockSize == bno); // Overflow
-#ifndef __Fuchsia__
     off += offset_;
-#endif
     if (lseek(fd_.get(), off, SEEK_SET) < 0) {
         FS_TRACE_ERROR("minfs: cannot seek to block %u\n", bno);
         return ZX_ERR_IO;
@@ -53,6 +192,8 @@ zx_status_t Bcache::Writeblk(blk_t bno, const void* data) {
     return ZX_OK;
 }
 
+#endif
+
 int Bcache::Sync() {
     fs::WriteTxn sync_txn(this);
     sync_txn.EnqueueFlush();
@@ -83,6 +224,10 @@ zx_status_t Bcache::Create(fbl::unique_ptr<Bcache>* out, fbl::unique_fd fd, uint
     if ((status = block_client::Client::Create(fbl::move(fifo), &bc->fifo_client_)) != ZX_OK) {
         return status;
     }
+    if ((status = bc->InitCache()) != ZX_OK) {
+        FS_TRACE_ERROR("minfs: Cannot create block cache: %d\n", status);
+        return status;
+    }
 #endif
 
     *out = fbl::move(bc);
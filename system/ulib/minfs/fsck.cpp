@@ -49,8 +49,10 @@ private:
                                blk_t* bno_out);
     zx_status_t CheckDirectory(minfs_inode_t* inode, ino_t ino,
                                ino_t parent, uint32_t flags);
+    zx_status_t CheckDirectoryIndex(minfs_inode_t* inode, ino_t ino);
     const char* CheckDataBlock(blk_t bno);
     zx_status_t CheckFile(minfs_inode_t* inode, ino_t ino);
+    zx_status_t CheckExtents(minfs_inode_t* inode, ino_t ino);
 
     fbl::unique_ptr<Minfs> fs_;
     RawBitmap checked_inodes_;
@@ -276,6 +278,108 @@ zx_status_t MinfsChecker::CheckDirectory(minfs_inode_t* inode, ino_t ino,
     return ZX_OK;
 }
 
+zx_status_t MinfsChecker::CheckDirectoryIndex(minfs_inode_t* inode, ino_t ino) {
+    minfs_inode_t index_inode;
+    zx_status_t status;
+    if ((status = GetInode(&index_inode, inode->dir_index_ino)) < 0) {
+        FS_TRACE_ERROR("check: ino#%u: index ino#%u not readable\n", ino, inode->dir_index_ino);
+        return status;
+    } else if (index_inode.magic != kMinfsMagicFile) {
+        FS_TRACE_ERROR("check: ino#%u: index ino#%u is not a file\n", ino, inode->dir_index_ino);
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    // The index is referenced by the directory alone, and owns its blocks.
+    if ((status = CheckInode(inode->dir_index_ino, ino, false)) < 0) {
+        return status;
+    }
+
+    if (inode->dir_index_seq != inode->seq_num) {
+        // A stale index is ignored, and rebuilt once the directory is next modified.
+        xprintf("ino#%u: stale directory index\n", ino);
+        return ZX_OK;
+    }
+    const uint32_t buckets = inode->dir_index_buckets;
+    if (buckets == 0 || buckets > kMinfsDirIndexMaxBuckets ||
+        index_inode.size < buckets * kMinfsBlockSize) {
+        FS_TRACE_WARN("check: ino#%u: index has bad bucket count %u\n", ino, buckets);
+        conforming_ = false;
+        return ZX_OK;
+    }
+
+    fbl::RefPtr<VnodeMinfs> dir;
+    fbl::RefPtr<VnodeMinfs> index;
+    if ((status = VnodeMinfs::Recreate(fs_.get(), ino, &dir)) != ZX_OK) {
+        return status;
+    } else if ((status = VnodeMinfs::Recreate(fs_.get(), inode->dir_index_ino, &index)) != ZX_OK) {
+        return status;
+    }
+
+    // Every entry of the index must refer to a distinct live direntry in the
+    // right bucket. Together with the entry count matching the dirent count,
+    // this ensures that every direntry is indexed exactly once.
+    RawBitmap indexed;
+    if ((status = indexed.Reset(kMinfsMaxDirectorySize / sizeof(uint32_t))) != ZX_OK) {
+        return status;
+    }
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<minfs_dir_index_bucket_t> bucket(new (&ac) minfs_dir_index_bucket_t);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    uint32_t total = 0;
+    for (uint32_t b = 0; b < buckets; b++) {
+        if ((status = index->ReadExactInternal(bucket.get(), kMinfsBlockSize,
+                                               b * kMinfsBlockSize)) != ZX_OK) {
+            FS_TRACE_ERROR("check: ino#%u: cannot read index bucket %u\n", ino, b);
+            return status;
+        }
+        if (bucket->magic != kMinfsDirIndexMagic ||
+            bucket->count > kMinfsDirIndexBucketEntries) {
+            FS_TRACE_WARN("check: ino#%u: index bucket %u is corrupt\n", ino, b);
+            conforming_ = false;
+            return ZX_OK;
+        }
+        for (uint32_t i = 0; i < bucket->count; i++) {
+            const minfs_dir_index_entry_t& entry = bucket->entries[i];
+            uint32_t record[DirentSize(NAME_MAX) / sizeof(uint32_t)];
+            minfs_dirent_t* de = reinterpret_cast<minfs_dirent_t*>(record);
+            size_t actual;
+            bool valid = (entry.hash % buckets == b) && (entry.off % sizeof(uint32_t) == 0) &&
+                         (entry.off < kMinfsMaxDirectorySize) &&
+                         !indexed.Get(entry.off / 4, entry.off / 4 + 1);
+            if (valid) {
+                status = dir->ReadInternal(record, sizeof(record), entry.off, &actual);
+                valid = (status == ZX_OK) && (actual >= MINFS_DIRENT_SIZE) && (de->ino != 0) &&
+                        (actual >= DirentSize(de->namelen)) &&
+                        (DirIndexHash(fbl::StringPiece(de->name, de->namelen)) == entry.hash);
+            }
+            if (!valid) {
+                FS_TRACE_WARN("check: ino#%u: index bucket %u entry %u (off %u) is invalid\n",
+                              ino, b, i, entry.off);
+                conforming_ = false;
+                continue;
+            }
+            indexed.Set(entry.off / 4, entry.off / 4 + 1);
+            total++;
+        }
+    }
+    if (total != inode->dirent_count) {
+        FS_TRACE_WARN("check: ino#%u: index holds %u entries, directory holds %u\n",
+                      ino, total, inode->dirent_count);
+        conforming_ = false;
+    }
+
+    minfs_dirent_t last;
+    size_t actual;
+    status = dir->ReadInternal(&last, MINFS_DIRENT_SIZE, inode->dir_last_off, &actual);
+    if (status != ZX_OK || actual != MINFS_DIRENT_SIZE || !(last.reclen & kMinfsReclenLast)) {
+        FS_TRACE_WARN("check: ino#%u: index has bad last dirent offset %u\n",
+                      ino, inode->dir_last_off);
+        conforming_ = false;
+    }
+    return ZX_OK;
+}
+
 const char* MinfsChecker::CheckDataBlock(blk_t bno) {
     if (bno == 0) {
         return "reserved bno";
@@ -294,7 +398,61 @@ const char* MinfsChecker::CheckDataBlock(blk_t bno) {
     return nullptr;
 }
 
+zx_status_t MinfsChecker::CheckExtents(minfs_inode_t* inode, ino_t ino) {
+    if (!(fs_->Info().flags & kMinfsFlagExtents) || inode->magic != kMinfsMagicFile) {
+        FS_TRACE_WARN("check: ino#%u: unexpectedly extent mapped\n", ino);
+        conforming_ = false;
+    }
+
+    const minfs_extent_t* extents = InodeExtents(inode);
+    uint32_t block_count = 0;
+    // The first file block which may be mapped by the next extent.
+    blk_t next_fblock = 0;
+    uint32_t i = 0;
+    for (; i < kMinfsInodeExtents && extents[i].count != 0; i++) {
+        xprintf(" extent %u: [%u, %u) @%u\n", i, extents[i].fblock,
+                extents[i].fblock + extents[i].count, extents[i].start);
+        if (extents[i].fblock < next_fblock ||
+            static_cast<uint64_t>(extents[i].fblock) + extents[i].count > kMinfsMaxFileBlock) {
+            FS_TRACE_WARN("check: ino#%u: extent %u out of order\n", ino, i);
+            conforming_ = false;
+        }
+        next_fblock = extents[i].fblock + extents[i].count;
+        for (blk_t b = 0; b < extents[i].count; b++) {
+            const char* msg;
+            if ((msg = CheckDataBlock(extents[i].start + b)) != nullptr) {
+                FS_TRACE_WARN("check: ino#%u: block %u(@%u): %s\n", ino,
+                              extents[i].fblock + b, extents[i].start + b, msg);
+                conforming_ = false;
+            }
+            block_count++;
+        }
+    }
+    for (; i < kMinfsInodeExtents; i++) {
+        if (extents[i].fblock != 0 || extents[i].start != 0 || extents[i].count != 0) {
+            FS_TRACE_WARN("check: ino#%u: extent %u follows the end of the list\n", ino, i);
+            conforming_ = false;
+        }
+    }
+
+    unsigned max_blocks = fbl::round_up(inode->size, kMinfsBlockSize) / kMinfsBlockSize;
+    if (next_fblock > max_blocks) {
+        FS_TRACE_WARN("check: ino#%u: filesize too small\n", ino);
+        conforming_ = false;
+    }
+    if (block_count != inode->block_count) {
+        FS_TRACE_WARN("check: ino#%u: block count %u, actual blocks %u\n",
+             ino, inode->block_count, block_count);
+        conforming_ = false;
+    }
+    return ZX_OK;
+}
+
 zx_status_t MinfsChecker::CheckFile(minfs_inode_t* inode, ino_t ino) {
+    if (inode->flags & kMinfsInodeFlagExtents) {
+        return CheckExtents(inode, ino);
+    }
+
     xprintf("Direct blocks: \n");
     for (unsigned n = 0; n < kMinfsDirect; n++) {
         xprintf(" %d,", inode->dnum[n]);
@@ -457,6 +615,15 @@ zx_status_t MinfsChecker::CheckInode(ino_t ino, ino_t parent, bool dot_or_dotdot
         if ((status = CheckDirectory(&inode, ino, parent, CD_RECURSE)) < 0) {
             return status;
         }
+        if (inode.dir_index_ino != 0) {
+            if (!(fs_->Info().flags & kMinfsFlagDirIndex)) {
+                FS_TRACE_ERROR("check: ino#%u: indexed directory on unindexed volume\n", ino);
+                return ZX_ERR_IO_DATA_INTEGRITY;
+            }
+            if ((status = CheckDirectoryIndex(&inode, ino)) < 0) {
+                return status;
+            }
+        }
     } else {
         xprintf("ino#%u: FILE blks=%u links=%u size=%u\n", ino, inode.block_count, inode.link_count,
                 inode.size);
@@ -104,6 +104,10 @@ struct fakeFs {
 } // namespace anonymous
 
 int emu_mkfs(const char* path) {
+    return emu_mkfs(path, {});
+}
+
+int emu_mkfs(const char* path, const minfs::Options& options) {
     fbl::unique_fd fd(open(path, O_RDWR));
     if (!fd) {
         fprintf(stderr, "error: could not open path %s\n", path);
@@ -124,7 +128,7 @@ int emu_mkfs(const char* path) {
         return -1;
     }
 
-    return Mkfs(fbl::move(bc));
+    return Mkfs(options, fbl::move(bc));
 }
 
 int emu_mount(const char* path) {
@@ -411,6 +415,29 @@ int emu_stat(const char* fn, struct stat* s) {
     STATUS(status);
 }
 
+int emu_unlink(const char* path) {
+    ZX_DEBUG_ASSERT_MSG(!host_path(path), "'emu_' functions can only operate on target paths");
+    path += PREFIX_SIZE;
+    fbl::RefPtr<fs::Vnode> vndir = fakeFs.fake_root;
+    const char* name = strrchr(path, '/');
+    zx_status_t status;
+    if (name == nullptr) {
+        name = path;
+    } else {
+        fbl::StringPiece dirpath(path, name - path);
+        if ((status = fakeFs.fake_vfs->Open(fakeFs.fake_root, &vndir, dirpath, &dirpath,
+                                            O_RDONLY, 0)) != ZX_OK) {
+            STATUS(status);
+        }
+        name++;
+    }
+    status = fakeFs.fake_vfs->Unlink(vndir, fbl::StringPiece(name));
+    if (vndir != fakeFs.fake_root) {
+        vndir->Close();
+    }
+    STATUS(status);
+}
+
 #define DIR_BUFSIZE 2048
 
 typedef struct MINDIR {
@@ -41,6 +41,13 @@ public:
 
     // Allocate a new item in allocator_. Return the index of the newly allocated item.
     size_t Allocate(WriteTxn* txn);
+
+    // Like Allocate, but allocates |goal| itself if it is free.
+    size_t AllocateNear(WriteTxn* txn, size_t goal);
+
+    // Takes over the elements reserved by |other|, which must have been made by the
+    // same Allocator.
+    void Merge(fbl::unique_ptr<AllocatorPromise> other);
 private:
     friend class Allocator;
 
@@ -197,12 +204,18 @@ public:
                               AllocatorMetadata metadata, fbl::unique_ptr<Allocator>* out);
 
     // Reserve |count| elements. This is required in order to later allocate them.
-    // Outputs a |promise| which contains reservation details.
+    // Outputs a |promise| which contains reservation details. If |promise| already
+    // holds a reservation from this allocator, it is extended by |count| elements.
     zx_status_t Reserve(WriteTxn* txn, size_t count, fbl::unique_ptr<AllocatorPromise>* promise);
 
     // Free an item from the allocator.
     void Free(WriteTxn* txn, size_t index);
 
+    // Return the number of elements which are reserved, but not yet allocated.
+    size_t GetReserved() const {
+        return reserved_;
+    }
+
 private:
     friend class MinfsChecker;
     friend class AllocatorPromise;
@@ -216,6 +229,12 @@ private:
     // Allocate an element and return the newly allocated index.
     size_t Allocate(WriteTxn* txn);
 
+    // Like Allocate, but allocates |goal| itself if it is free.
+    size_t AllocateNear(WriteTxn* txn, size_t goal);
+
+    // Mark the free element |index| as allocated, consuming one reserved element.
+    void Claim(WriteTxn* txn, size_t index);
+
     // Write back the allocation of the following items to disk.
     void Persist(WriteTxn* txn, size_t index, size_t count);
 
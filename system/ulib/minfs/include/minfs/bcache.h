@@ -11,6 +11,7 @@
 
 #ifdef __Fuchsia__
 #include <block-client/cpp/client.h>
+#include <fbl/mutex.h>
 #include <fs/fvm.h>
 #include <lib/zx/vmo.h>
 #else
@@ -30,6 +31,14 @@
 
 namespace minfs {
 
+#ifdef __Fuchsia__
+// The number of blocks held by the block cache which backs Readblk.
+constexpr uint32_t kMinfsBlockCacheSize = 64;
+
+// The largest number of blocks read ahead of a sequential Readblk.
+constexpr uint32_t kMinfsReadaheadMax = 16;
+#endif
+
 class Bcache : public fs::TransactionHandler {
 public:
     DISALLOW_COPY_ASSIGN_AND_MOVE(Bcache);
@@ -56,12 +65,14 @@ public:
         return info_.block_size;
     }
 
-    zx_status_t Transaction(block_fifo_request_t* requests, size_t count) final {
-        return fifo_client_.Transaction(requests, count);
-    }
+    // Writes issued through a transaction invalidate any copies held by the
+    // block cache.
+    zx_status_t Transaction(block_fifo_request_t* requests, size_t count) final;
 #endif // __Fuchsia__
     // Raw block read functions.
-    // These do not track blocks (or attempt to access the block cache)
+    // On Fuchsia, these go through the block fifo and a small cache of
+    // recently read blocks, which is filled ahead of sequential reads.
+    // Writes go straight through to the device.
     // NOTE: Not marked as final, since these are overridden methods on host,
     // but not on __Fuchsia__.
     zx_status_t Readblk(blk_t bno, void* data);
@@ -136,9 +147,52 @@ private:
     Bcache(fbl::unique_fd fd, uint32_t blockmax);
 
 #ifdef __Fuchsia__
+    // A block held by the block cache.
+    struct CacheEntry {
+        blk_t bno;
+        bool valid;
+        // Clock value of the most recent access, for LRU eviction.
+        uint64_t last_use;
+        // Set while FillCache is reading into the slot, so that the slot
+        // isn't handed out again before the read completes.
+        bool pending;
+    };
+
+    // Creates the block cache and registers it with the block device.
+    zx_status_t InitCache();
+
+    // Reads |count| blocks, starting at |bno|, into the cache. Blocks after
+    // the first are only read until one is found to be cached already.
+    // Returns the slot holding |bno|.
+    zx_status_t FillCache(blk_t bno, uint32_t count, uint32_t* out_slot) __TA_REQUIRES(cache_lock_);
+
+    // Returns the slot holding |bno|, or -1 if it is not cached.
+    int FindCached(blk_t bno) const __TA_REQUIRES(cache_lock_);
+
+    // Returns an invalid slot if there is one, otherwise the least recently
+    // used slot. Never returns a pending slot.
+    uint32_t EvictSlot() const __TA_REQUIRES(cache_lock_);
+
+    void* SlotData(uint32_t slot) const {
+        return static_cast<uint8_t*>(cache_vmo_->GetData()) + slot * kMinfsBlockSize;
+    }
+
+    // Builds a single block request between |slot| and |bno|.
+    block_fifo_request_t SlotRequest(uint32_t opcode, uint32_t slot, blk_t bno);
+
     block_client::Client fifo_client_{}; // Fast path to interact with block device
     block_info_t info_{};
     fbl::atomic<groupid_t> next_group_ = {};
+
+    fbl::Mutex cache_lock_;
+    fbl::unique_ptr<fzl::MappedVmo> cache_vmo_;
+    vmoid_t cache_vmoid_ = VMOID_INVALID;
+    CacheEntry cache_[kMinfsBlockCacheSize] __TA_GUARDED(cache_lock_) = {};
+    uint64_t cache_clock_ __TA_GUARDED(cache_lock_) = 0;
+    // The block most recently read through Readblk, and the number of blocks
+    // to read ahead if the next read follows it.
+    blk_t last_read_ __TA_GUARDED(cache_lock_) = 0;
+    uint32_t readahead_ __TA_GUARDED(cache_lock_) = 1;
 #else
     off_t offset_{};
 #endif
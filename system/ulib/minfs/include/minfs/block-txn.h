@@ -6,6 +6,7 @@
 
 #include <fbl/algorithm.h>
 #include <fbl/macros.h>
+#include <fbl/vector.h>
 
 #include <fs/block-txn.h>
 
@@ -44,12 +45,15 @@ public:
 
     size_t BlkCount() const;
 
-protected:
-    // Activate the transaction, writing it out to disk.
+    // Converts the enqueued requests into block fifo requests which read from
+    // |vmoid|, appends them to |out|, and clears them from the transaction.
     //
-    // Each transaction uses the |vmo| / |vmoid| pair supplied, since the
-    // transactions should be all reading from a single in-memory buffer.
-    zx_status_t Flush(zx_handle_t vmo, vmoid_t vmoid);
+    // Each transaction uses the same |vmoid|, since the transactions should be all
+    // reading from a single in-memory buffer. Requests which continue the last
+    // request of |out|, both in the buffer and on disk, are merged into it. Blocks
+    // of |out| which these requests write again are dropped from it, so that the
+    // requests of |out| never overlap and may complete in any order.
+    void TakeRequests(vmoid_t vmoid, fbl::Vector<block_fifo_request_t>* out);
 
 private:
     Bcache* bc_;
@@ -16,6 +16,7 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -34,10 +35,19 @@ typedef uint32_t ino_t;
 constexpr uint64_t kMinfsMagic0         = (0x002153466e694d21ULL);
 constexpr uint64_t kMinfsMagic1         = (0x385000d3d3d3d304ULL);
 constexpr uint32_t kMinfsVersion        = 0x00000005;
+// The version of volumes formatted with kMinfsFlagExtents. Drivers which
+// predate extents only check the version, so it keeps them from mounting
+// volumes they would misread.
+constexpr uint32_t kMinfsVersionExtents = 0x00000006;
+// The version of volumes formatted with kMinfsFlagDirIndex, with or without
+// extents. Older drivers would leak the index of a directory they remove.
+constexpr uint32_t kMinfsVersionDirIndex = 0x00000007;
 
 constexpr ino_t    kMinfsRootIno        = 1;
 constexpr uint32_t kMinfsFlagClean      = 0x00000001; // Currently unused
 constexpr uint32_t kMinfsFlagFVM        = 0x00000002; // Mounted on FVM
+constexpr uint32_t kMinfsFlagExtents    = 0x00000004; // New files are extent mapped
+constexpr uint32_t kMinfsFlagDirIndex   = 0x00000008; // Large directories are indexed
 constexpr uint32_t kMinfsBlockSize      = 8192;
 constexpr uint32_t kMinfsBlockBits      = (kMinfsBlockSize * 8);
 constexpr uint32_t kMinfsInodeSize      = 256;
@@ -123,7 +133,11 @@ typedef struct {
     uint32_t seq_num;               // bumped when modified
     uint32_t gen_num;               // bumped when deleted
     uint32_t dirent_count;          // for directories
-    uint32_t rsvd[5];
+    ino_t dir_index_ino;            // for directories: hashed index, or 0
+    uint32_t dir_index_seq;         // for directories: seq_num of the index
+    uint32_t dir_index_buckets;     // for directories: buckets in the index
+    uint32_t dir_last_off;          // for directories: offset of the last dirent
+    uint32_t flags;                 // kMinfsInodeFlag*
     blk_t dnum[kMinfsDirect];    // direct blocks
     blk_t inum[kMinfsIndirect];  // indirect blocks
     blk_t dinum[kMinfsDoublyIndirect]; // doubly indirect blocks
@@ -132,6 +146,46 @@ typedef struct {
 static_assert(sizeof(minfs_inode_t) == kMinfsInodeSize,
               "minfs inode size is wrong");
 
+// Extent mapped files:
+// - on volumes with kMinfsFlagExtents, the block pointers of a file inode
+//   (dnum, inum and dinum) may instead hold a list of extents, identified
+//   by kMinfsInodeFlagExtents
+// - extents are sorted by fblock and do not overlap; the list ends at the
+//   first extent with a count of zero, and unused extents are zeroed
+// - blocks of the file which no extent covers are sparse
+// - a file which needs more extents than fit in the inode is converted back
+//   to block tables, and stays that way
+
+constexpr uint32_t kMinfsInodeFlagExtents = 0x00000001;
+
+typedef struct {
+    blk_t fblock;                   // first file-relative block of the extent
+    blk_t start;                    // first data block of the extent
+    uint32_t count;                 // number of blocks in the extent
+} minfs_extent_t;
+
+constexpr uint32_t kMinfsInodeExtents =
+    ((kMinfsDirect + kMinfsIndirect + kMinfsDoublyIndirect) * sizeof(blk_t)) /
+    sizeof(minfs_extent_t);
+
+static_assert(kMinfsInodeExtents * sizeof(minfs_extent_t) ==
+              (kMinfsDirect + kMinfsIndirect + kMinfsDoublyIndirect) * sizeof(blk_t),
+              "minfs extents must exactly cover the block pointers of an inode");
+static_assert(offsetof(minfs_inode_t, inum) ==
+              offsetof(minfs_inode_t, dnum) + kMinfsDirect * sizeof(blk_t) &&
+              offsetof(minfs_inode_t, dinum) ==
+              offsetof(minfs_inode_t, inum) + kMinfsIndirect * sizeof(blk_t),
+              "minfs block pointers must be contiguous");
+
+// The extents of an inode with kMinfsInodeFlagExtents.
+inline minfs_extent_t* InodeExtents(minfs_inode_t* inode) {
+    return reinterpret_cast<minfs_extent_t*>(inode->dnum);
+}
+
+inline const minfs_extent_t* InodeExtents(const minfs_inode_t* inode) {
+    return reinterpret_cast<const minfs_extent_t*>(inode->dnum);
+}
+
 typedef struct {
     ino_t ino;                      // inode number
     uint32_t reclen;                // Low 28 bits: Length of record
@@ -178,6 +232,49 @@ static_assert(kMinfsMaxDirectorySize <= kMinfsReclenMask,
 //   also increase in size.
 
 
+// Hashed directory index:
+// - directories with many entries may be given an index, stored as the data of
+//   a separate file inode (dir_index_ino) which is referenced only by the
+//   directory. The file holds dir_index_buckets blocks, each a
+//   minfs_dir_index_bucket_t
+// - a live dirent named 'name' at offset 'off' is recorded as {hash, off} in
+//   bucket (hash % dir_index_buckets), where hash is the FNV-1a hash of name
+// - indexes are only built on volumes with kMinfsFlagDirIndex, which are
+//   marked kMinfsVersionDirIndex so that drivers unaware of the index (and
+//   so unable to free it along with its directory) refuse to mount them
+// - the dirents themselves are unchanged. Since every modification of a
+//   directory bumps seq_num, the index (along with dir_last_off) is only
+//   trusted while dir_index_seq == seq_num
+
+constexpr uint32_t kMinfsDirIndexMagic = 0x78646e69;
+
+// Directories are indexed once they hold at least this many entries.
+constexpr uint32_t kMinfsDirIndexMinDirents = 512;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t off;
+} minfs_dir_index_entry_t;
+
+constexpr uint32_t kMinfsDirIndexBucketEntries =
+    (kMinfsBlockSize - 2 * sizeof(uint32_t)) / sizeof(minfs_dir_index_entry_t);
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    minfs_dir_index_entry_t entries[kMinfsDirIndexBucketEntries];
+} minfs_dir_index_bucket_t;
+
+static_assert(sizeof(minfs_dir_index_bucket_t) == kMinfsBlockSize,
+              "minfs directory index bucket size is wrong");
+
+// Enough buckets to index the largest possible directory at half occupancy.
+constexpr uint32_t kMinfsDirIndexMaxBuckets = 256;
+
+static_assert(kMinfsDirIndexMaxBuckets * kMinfsDirIndexBucketEntries >=
+              2 * (kMinfsMaxDirectorySize / DirentSize(1)),
+              "minfs directory index cannot hold the largest directory");
+
 // blocksize   8K    16K    32K
 // 16 dir =  128K   256K   512K
 // 32 ind =  512M  1024M  2048M
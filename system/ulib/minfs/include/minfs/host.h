@@ -19,6 +19,7 @@
 #include <fbl/macros.h>
 #include <fbl/unique_ptr.h>
 #include <minfs/bcache.h>
+#include <minfs/minfs.h>
 
 #define PATH_PREFIX "::"
 #define PREFIX_SIZE 2
@@ -33,6 +34,7 @@ static inline bool host_path(const char* path) {
     return false;
 }
 int emu_mkfs(const char* path);
+int emu_mkfs(const char* path, const minfs::Options& options);
 int emu_mount(const char* path);
 int emu_mount_bcache(fbl::unique_ptr<minfs::Bcache> bc);
 bool emu_is_mounted();
@@ -49,6 +51,7 @@ int emu_ftruncate(int fd, off_t len);
 off_t emu_lseek(int fd, off_t offset, int whence);
 int emu_fstat(int fd, struct stat* s);
 int emu_stat(const char* fn, struct stat* s);
+int emu_unlink(const char* path);
 
 int emu_mkdir(const char* path, mode_t mode);
 DIR* emu_opendir(const char* name);
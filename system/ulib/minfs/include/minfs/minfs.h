@@ -29,6 +29,9 @@ typedef struct minfs_options {
 
     // Number of slices to preallocate for data when the filesystem is created.
     uint32_t fvm_data_slices = 1;
+
+    // Map the blocks of new files with extents, when the filesystem is created.
+    bool extents = false;
 } minfs_options_t;
 
 using Options = minfs_options_t;
@@ -46,12 +46,10 @@ public:
     void Reset();
 
 #ifdef __Fuchsia__
-    // Actually transacts the enqueued work, and resets the WritebackWork to
+    // Signals the closure (if any) with the |status| of writing out the work,
+    // whose requests have already been taken, and resets the WritebackWork to
     // its initial state.
-    //
-    // Returns the number of blocks of the writeback buffer that have been
-    // consumed.
-    size_t Complete(zx_handle_t vmo, vmoid_t vmoid);
+    void Finish(zx_status_t status);
 
     // Adds a closure to the WritebackWork, such that it will be signalled
     // when the WritebackWork is flushed to disk.
@@ -101,6 +99,17 @@ public:
         return block_promise_->Allocate(work_.get());
     }
 
+    size_t AllocateBlockNear(size_t goal) {
+        ZX_DEBUG_ASSERT(block_promise_ != nullptr);
+        return block_promise_->AllocateNear(work_.get(), goal);
+    }
+
+    // Reserves |count| blocks from |allocator| in addition to those reserved
+    // when the transaction began.
+    zx_status_t ReserveBlocks(Allocator* allocator, size_t count) {
+        return allocator->Reserve(work_.get(), count, &block_promise_);
+    }
+
     void SetWork(fbl::unique_ptr<WritebackWork> work) {
         work_ = fbl::move(work);
     }
@@ -115,6 +124,17 @@ public:
         return fbl::move(work_);
     }
 
+    void SetBlockPromise(fbl::unique_ptr<AllocatorPromise> block_promise) {
+        ZX_DEBUG_ASSERT(block_promise_ == nullptr);
+        block_promise_ = fbl::move(block_promise);
+    }
+
+    // Returns the blocks reserved for this transaction which have not been allocated,
+    // so that they may be held past its end.
+    fbl::unique_ptr<AllocatorPromise> RemoveBlockPromise() {
+        return fbl::move(block_promise_);
+    }
+
 private:
     fbl::unique_ptr<WritebackWork> work_;
     fbl::unique_ptr<AllocatorPromise> inode_promise_;
@@ -142,6 +162,10 @@ public:
     // enqueued, preventing them from closing while the writeback is pending.
     void Enqueue(fbl::unique_ptr<WritebackWork> work) __TA_EXCLUDES(writeback_lock_);
 
+    // Returns the number of block fifo requests issued, and the number of blocks
+    // they have written, since the buffer was created.
+    void GetMetrics(uint64_t* out_requests, uint64_t* out_blocks) __TA_EXCLUDES(writeback_lock_);
+
 private:
     WritebackBuffer(Bcache* bc, fbl::unique_ptr<fzl::MappedVmo> buffer);
 
@@ -162,6 +186,16 @@ private:
     // safely guarantee that space exists within the buffer.
     void CopyToBufferLocked(WriteTxn* txn) __TA_REQUIRES(writeback_lock_);
 
+    // Writes back the |count| units of work in |batch| with a single block
+    // transaction, merging requests which are contiguous both in the buffer and
+    // on disk, and releases them. Blocks written by more than one unit of work
+    // are only written from the last of them.
+    //
+    // Returns the number of blocks of the writeback buffer that have been
+    // consumed, and the number of block fifo requests issued in |out_requests|.
+    size_t CompleteBatch(fbl::unique_ptr<WritebackWork>* batch, size_t count,
+                         size_t* out_requests);
+
     static int WritebackThread(void* arg);
 
     // The waiter struct may be used as a stack-allocated queue for producers.
@@ -197,6 +231,9 @@ private:
     size_t start_ __TA_GUARDED(writeback_lock_){};
     size_t len_ __TA_GUARDED(writeback_lock_){};
     const size_t cap_ = 0;
+
+    uint64_t fifo_requests_ __TA_GUARDED(writeback_lock_){};
+    uint64_t blocks_written_ __TA_GUARDED(writeback_lock_){};
 };
 
 #endif
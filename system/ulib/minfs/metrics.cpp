@@ -7,6 +7,8 @@
 #include <lib/fzl/time.h>
 #include <lib/zx/time.h>
 
+#include <minfs/format.h>
+
 #include "metrics.h"
 
 namespace minfs {
@@ -44,6 +46,11 @@ void MinfsMetrics::Dump() const {
            vnodes_opened_cache_hit, vnodes_opened, TicksToMs(vnode_open_ticks));
     printf("  %zu / %zu Lookup (lookup by path) successful calls, %zu ms\n",
            lookup_calls_success, lookup_calls, TicksToMs(lookup_ticks));
+    constexpr uint64_t kBlocksPerMB = (1 << 20) / kMinfsBlockSize;
+    printf("Writeback stats:\n");
+    printf("  %zu block fifo requests writing %zu KB (%zu requests per MB)\n",
+           writeback_requests, writeback_blocks * kMinfsBlockSize / KB,
+           writeback_blocks ? writeback_requests * kBlocksPerMB / writeback_blocks : 0);
 }
 
 } // namespace minfs
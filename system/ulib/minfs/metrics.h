@@ -66,6 +66,10 @@ struct MinfsMetrics {
     uint64_t lookup_calls_success = 0;
     zx::ticks lookup_ticks = {};
 
+    // WRITEBACK STATS
+    uint64_t writeback_requests = 0; // Block fifo requests issued by the writeback thread
+    uint64_t writeback_blocks = 0;
+
     // FVM STATS
     // TODO(smklein)
 };
@@ -15,6 +15,7 @@
 #include <fs/remote.h>
 #include <fs/watcher.h>
 #include <lib/sync/completion.h>
+#include <lib/zx/event.h>
 #include <lib/zx/vmo.h>
 #endif
 
@@ -81,8 +82,6 @@ constexpr uint32_t kMxFsSyncDefault = 0; // default: no implicit time update
 constexpr uint32_t kMxFsSyncMtime = (1 << 0);
 constexpr uint32_t kMxFsSyncCtime = (1 << 1);
 
-constexpr uint32_t kMinfsBlockCacheSize = 64;
-
 // Used by fsck
 class MinfsChecker;
 class VnodeMinfs;
@@ -153,6 +152,14 @@ public:
     // Allocate a new data block.
     void BlockNew(Transaction* state, blk_t* out_bno);
 
+    // Allocate a new data block, preferring |goal| if it is free.
+    void BlockNewNear(Transaction* state, blk_t goal, blk_t* out_bno);
+
+    // Reserve |count| more data blocks for allocation within |state|.
+    zx_status_t BlocksReserve(Transaction* state, size_t count) {
+        return state->ReserveBlocks(block_allocator_.get(), count);
+    }
+
     // Free a data block.
     void BlockFree(WriteTxn* txn, blk_t bno);
 
@@ -197,7 +204,16 @@ public:
     // Signals the completion object as soon as...
     // (1) A sync probe has entered and exited the writeback queue, and
     // (2) The block cache has sync'd with the underlying block device.
+    //
+    // Flushes the delayed writes of all vnodes first. If any of them cannot be
+    // allocated, the rest is still written back, and the closure receives that error.
     void Sync(SyncCallback closure);
+
+    // Allocates and enqueues the delayed writes of every open vnode.
+    //
+    // Returns the first error encountered; the writes which could not be allocated
+    // remain delayed.
+    zx_status_t FlushDelayedWrites();
 #endif
 
     // The following methods are used to read one block from the specified extent,
@@ -230,6 +246,10 @@ public:
     void UpdateUnlinkMetrics(bool success, const fs::Duration& duration);
     // Update aggregate information about renaming Vnodes.
     void UpdateRenameMetrics(bool success, const fs::Duration& duration);
+#ifdef __Fuchsia__
+    // Update aggregate information about writing back to disk.
+    void UpdateWritebackMetrics();
+#endif
     // Print information about filesystem metrics.
     void DumpMetrics() const;
 
@@ -238,6 +258,12 @@ public:
         return sb_->Info();
     }
 
+    // Return the number of blocks reserved, but not yet allocated, including those
+    // held for delayed writes.
+    size_t BlocksReserved() const {
+        return block_allocator_->GetReserved();
+    }
+
     // TODO(rvargas): Make private.
     fbl::unique_ptr<Bcache> bc_;
 
@@ -299,7 +325,7 @@ private:
 
 struct DirectoryOffset {
     size_t off = 0;      // Offset in directory of current record
-    size_t off_prev = 0; // Offset in directory of previous record
+    size_t off_prev = 0; // Offset in directory of previous record, or |off| if unknown
 };
 
 struct DirArgs {
@@ -349,6 +375,15 @@ public:
     // fbl::Recyclable interface.
     void fbl_recycle() final;
 
+#ifdef __Fuchsia__
+    // Returns true if data written to the vnode has not been allocated on disk yet.
+    bool HasDelayedWrites() const { return delayed_start_ < delayed_end_; }
+
+    // Allocates the blocks of any delayed writes, and enqueues them to be written back.
+    // On failure, the blocks which could not be allocated remain delayed.
+    zx_status_t FlushDelayedWrites();
+#endif
+
     // TODO(rvargas): Make private.
     Minfs* const fs_;
 
@@ -425,6 +460,47 @@ private:
 
     zx_status_t UnlinkChild(Transaction* state, fbl::RefPtr<VnodeMinfs> child,
                             minfs_dirent_t* de, DirectoryOffset* offs);
+
+    // Like |ForEachDirent|, but only visits the direntries which may be named |args->name|:
+    // those recorded in its bucket of the hashed index, if the directory has a valid index, and
+    // every direntry otherwise.
+    zx_status_t ForEachNamedDirent(DirArgs* args, const DirentCallback func);
+
+    // Equivalent to |ForEachDirent| with |DirentCallbackFindSpace|, but tries the last direntry
+    // of an indexed directory before scanning for space.
+    zx_status_t FindDirentSpace(DirArgs* args);
+
+    // Hashed directory index.
+    //
+    // Returns true if the directory has an index which is up to date.
+    bool DirIndexValid() const {
+        return inode_.dir_index_ino != 0 && inode_.dir_index_seq == inode_.seq_num;
+    }
+    // Stops trusting the index, until it is rebuilt.
+    void DirIndexInvalidate() { inode_.dir_index_seq = inode_.seq_num - 1; }
+    // Records a modification of the direntries. The index remains valid only if it was valid
+    // beforehand, and has been kept up to date by the caller.
+    void DirentsChanged();
+    // Builds the index of a directory which has grown large enough to need one, unless it
+    // already has a valid index. Uses its own transaction; on failure, the directory simply
+    // remains unindexed.
+    void EnsureDirIndex();
+    zx_status_t RebuildDirIndex();
+    // Collects the live direntries into |buckets| buckets, failing with ZX_ERR_NO_SPACE if
+    // one overflows. Also returns the offset of the final direntry.
+    zx_status_t BuildDirIndexTable(uint32_t buckets,
+                                   fbl::unique_ptr<minfs_dir_index_bucket_t[]>* out,
+                                   size_t* out_last_off);
+    // Returns the index, along with the offset within it and the entry count of the bucket
+    // which holds |name|.
+    zx_status_t DirIndexBucket(fbl::StringPiece name, fbl::RefPtr<VnodeMinfs>* out_index,
+                               size_t* out_bucket_off, uint32_t* out_count);
+    // Records or erases the direntry |name| at offset |off| in the index.
+    zx_status_t DirIndexInsert(Transaction* state, fbl::StringPiece name, size_t off);
+    zx_status_t DirIndexRemove(Transaction* state, fbl::StringPiece name, size_t off);
+    // Finds the offset of the direntry preceding the direntry |name| at |off|, which the
+    // index does not record.
+    zx_status_t DirIndexPrevious(fbl::StringPiece name, size_t off, size_t* out_prev);
     // Remove the link to a vnode (referring to inodes exclusively).
     // Has no impact on direntries (or parent inode).
     void RemoveInodeLink(WritebackWork* wb);
@@ -458,6 +534,8 @@ private:
         READ,
         WRITE,
         DELETE,
+        // Maps the blocks given in |bnos|, which are already allocated, into the file.
+        ADOPT,
     } blk_op_t;
 
     typedef struct bop_params {
@@ -482,6 +560,7 @@ private:
 
         blk_op_t GetOp() const { return op_; }
         blk_t GetBno(blk_t index) const { return array_[index]; }
+        blk_t GetAdoptedBno(blk_t index) const { return bnos_[index]; }
         void SetBno(blk_t index, blk_t value) {
             ZX_DEBUG_ASSERT(index < GetCount());
 
@@ -585,6 +664,14 @@ private:
     // bnos
     zx_status_t BlocksShrink(Transaction* state, blk_t start);
 
+    bool IsExtentMapped() const { return (inode_.flags & kMinfsInodeFlagExtents) != 0; }
+    // Equivalents of |BlockGet| and |BlocksShrink| for extent mapped files.
+    zx_status_t ExtentGet(Transaction* state, blk_t n, blk_t* bno);
+    zx_status_t ExtentsShrink(Transaction* state, blk_t start);
+    // Rewrites the extents of the file as block tables, then maps block |n| of the file to
+    // the allocated block |bno|. Used once the file needs more extents than the inode holds.
+    zx_status_t ExtentsToBlockMap(Transaction* state, blk_t n, blk_t bno);
+
     // Update the vnode's inode and write it to disk.
     void InodeSync(WritebackWork* wb, uint32_t flags);
 
@@ -598,11 +685,26 @@ private:
 #ifdef __Fuchsia__
     zx_status_t GetHandles(uint32_t flags, zx_handle_t* hnd, uint32_t* type,
                            zxrio_node_info_t* extra) final;
+    zx_status_t GetVmo(int flags, zx_handle_t* out) final;
     void Sync(SyncCallback closure) final;
     zx_status_t AttachRemote(fs::MountChannel h) final;
     zx_status_t InitVmo();
     zx_status_t InitIndirectVmo();
 
+    // Writes |data| into the VMO, deferring the allocation of blocks on disk until
+    // FlushDelayedWrites().
+    zx_status_t WriteDelayed(const void* data, size_t len, size_t offset, size_t* out_actual);
+
+    // Releases the blocks reserved for delayed writes without writing them out.
+    void DropDelayedWrites();
+
+    // Tells clients reading the file through its VMO that the size of the file changed.
+    void NotifyResize();
+
+    // Initializes the indirect VMO, and grows it to hold the indirect blocks which map
+    // block |n| of the file.
+    zx_status_t GrowIndirectVmo(blk_t n);
+
     // Loads indirect blocks up to and including the doubly indirect block at |index|.
     zx_status_t LoadIndirectWithinDoublyIndirect(uint32_t index);
 
@@ -654,6 +756,18 @@ private:
     vmoid_t vmoid_{};
     vmoid_t vmoid_indirect_{};
 
+    // Data written to blocks [delayed_start_, delayed_end_) of the file is only held in
+    // vmo_, with the blocks it needs reserved by delayed_promise_. The blocks are
+    // allocated when the writes are flushed, so that runs of small writes are allocated
+    // contiguously and written back together.
+    blk_t delayed_start_ = 0;
+    blk_t delayed_end_ = 0;
+    fbl::unique_ptr<AllocatorPromise> delayed_promise_;
+
+    // Handed to the clients of a file, with FILE_SIGNAL_VMO_SHARED asserted, so that
+    // they may read it through vmo_. Replaced each time the size of the file changes.
+    zx::event vmo_event_;
+
     fs::RemoteContainer remoter_{};
     fs::WatcherContainer watcher_{};
 #endif
@@ -666,6 +780,10 @@ private:
     // VnodeMinfs's own refcount, since there may still be filesystem
     // work to do after the last file descriptor has been closed.
     uint32_t fd_count_{};
+
+    // Set once the directory held too many colliding names to be indexed, so that the
+    // index is not rebuilt on every create.
+    bool dir_index_full_ = false;
 };
 
 // Return the block offset in vmo_indirect_ of indirect blocks pointed to by the doubly indirect
@@ -691,6 +809,11 @@ constexpr size_t GetVmoSizeForDoublyIndirect() {
     return (kMinfsIndirect + kMinfsDoublyIndirect) * kMinfsBlockSize;
 }
 
+// The hash of a direntry name, as recorded in the hashed directory index.
+inline uint32_t DirIndexHash(fbl::StringPiece name) {
+    return fnv1a32(name.data(), name.length());
+}
+
 // Tries to calculate the required number of blocks into |num_req_blocks|
 // for a write at the given |offset| and |length|.
 zx_status_t GetRequiredBlockCount(size_t offset, size_t length, uint32_t* num_req_blocks);
@@ -22,6 +22,7 @@
 
 #ifdef __Fuchsia__
 #include <fbl/auto_lock.h>
+#include <fbl/vector.h>
 #include <lib/async/cpp/task.h>
 #include <lib/zx/event.h>
 
@@ -86,6 +87,8 @@ void minfs_dump_info(const minfs_info_t* info) {
     xprintf("minfs: inode table  @ %10u\n", info->ino_block);
     xprintf("minfs: data blocks  @ %10u\n", info->dat_block);
     xprintf("minfs: FVM-aware: %s\n", (info->flags & kMinfsFlagFVM) ? "YES" : "NO");
+    xprintf("minfs: extents: %s\n", (info->flags & kMinfsFlagExtents) ? "YES" : "NO");
+    xprintf("minfs: dir index: %s\n", (info->flags & kMinfsFlagDirIndex) ? "YES" : "NO");
 }
 
 void minfs_dump_inode(const minfs_inode_t* inode, ino_t ino) {
@@ -103,9 +106,15 @@ zx_status_t minfs_check_info(const minfs_info_t* info, Bcache* bc) {
         FS_TRACE_ERROR("minfs: bad magic\n");
         return ZX_ERR_INVALID_ARGS;
     }
-    if (info->version != kMinfsVersion) {
+    uint32_t version = kMinfsVersion;
+    if (info->flags & kMinfsFlagDirIndex) {
+        version = kMinfsVersionDirIndex;
+    } else if (info->flags & kMinfsFlagExtents) {
+        version = kMinfsVersionExtents;
+    }
+    if (info->version != version) {
         FS_TRACE_ERROR("minfs: FS Version: %08x. Driver version: %08x\n", info->version,
-                       kMinfsVersion);
+                       version);
         return ZX_ERR_INVALID_ARGS;
     }
     if ((info->block_size != kMinfsBlockSize) || (info->inode_size != kMinfsInodeSize)) {
@@ -281,10 +290,51 @@ zx_status_t Minfs::BeginTransaction(size_t reserve_inodes, size_t reserve_blocks
 }
 
 #ifdef __Fuchsia__
+zx_status_t Minfs::FlushDelayedWrites() {
+    // Avoid flushing, or releasing references to vnodes, while holding |hash_lock_|.
+    fbl::Vector<fbl::RefPtr<VnodeMinfs>> vnodes;
+    {
+        fbl::AutoLock lock(&hash_lock_);
+        for (auto& raw_vn : vnode_hash_) {
+            if (!raw_vn.HasDelayedWrites()) {
+                continue;
+            }
+            auto vn = fbl::internal::MakeRefPtrUpgradeFromRaw(&raw_vn, hash_lock_);
+            if (vn != nullptr) {
+                vnodes.push_back(fbl::move(vn));
+            }
+        }
+    }
+
+    // Keep flushing the other vnodes after a failure, but report the first one.
+    zx_status_t result = ZX_OK;
+    for (size_t i = 0; i < vnodes.size(); i++) {
+        zx_status_t status;
+        if ((status = vnodes[i]->FlushDelayedWrites()) != ZX_OK) {
+            FS_TRACE_ERROR("minfs: Failed to flush delayed writes of ino#%u: %d\n",
+                           vnodes[i]->GetKey(), status);
+            if (result == ZX_OK) {
+                result = status;
+            }
+        }
+    }
+    return result;
+}
+
 void Minfs::Sync(SyncCallback closure) {
+    zx_status_t flush_status = FlushDelayedWrites();
+
     fbl::unique_ptr<Transaction> state;
     ZX_ASSERT(BeginTransaction(0, 0, &state) == ZX_OK);
-    state->GetWork()->SetClosure(fbl::move(closure));
+    if (flush_status != ZX_OK) {
+        // Still write back everything else, but the data which could not be
+        // allocated is not on disk.
+        state->GetWork()->SetClosure([flush_status, cb = fbl::move(closure)](zx_status_t) {
+            cb(flush_status);
+        });
+    } else {
+        state->GetWork()->SetClosure(fbl::move(closure));
+    }
     CommitTransaction(fbl::move(state));
 }
 #endif
@@ -313,6 +363,19 @@ zx_status_t Minfs::InoFree(VnodeMinfs* vn, WritebackWork* wb) {
     inodes_->Free(wb, vn->ino_);
     uint32_t block_count = vn->inode_.block_count;
 
+    if (vn->IsExtentMapped()) {
+        const minfs_extent_t* extents = InodeExtents(&vn->inode_);
+        for (uint32_t i = 0; i < kMinfsInodeExtents && extents[i].count != 0; i++) {
+            for (blk_t b = 0; b < extents[i].count; b++) {
+                ValidateBno(extents[i].start + b);
+                block_count--;
+                block_allocator_->Free(wb, extents[i].start + b);
+            }
+        }
+        ZX_DEBUG_ASSERT(block_count == 0);
+        return ZX_OK;
+    }
+
     // release all direct blocks
     for (unsigned n = 0; n < kMinfsDirect; n++) {
         if (vn->inode_.dnum[n] == 0) {
@@ -541,6 +604,11 @@ void Minfs::BlockNew(Transaction* state, blk_t* out_bno) {
     *out_bno = static_cast<blk_t>(allocated_bno);
 }
 
+void Minfs::BlockNewNear(Transaction* state, blk_t goal, blk_t* out_bno) {
+    size_t allocated_bno = state->AllocateBlockNear(goal);
+    *out_bno = static_cast<blk_t>(allocated_bno);
+}
+
 void Minfs::BlockFree(WriteTxn* txn, blk_t bno) {
     block_allocator_->Free(txn, bno);
 }
@@ -769,6 +837,7 @@ void Minfs::Shutdown(fs::Vfs::ShutdownCallback cb) {
             async::PostTask(dispatcher(), [this, cb = fbl::move(cb)]() mutable {
                 // Ensure writeback buffer completes before auxilliary structures
                 // are deleted.
+                UpdateWritebackMetrics();
                 writeback_ = nullptr;
                 bc_->Sync();
 
@@ -799,8 +868,11 @@ zx_status_t Mkfs(const Options& options, fbl::unique_ptr<Bcache> bc) {
     memset(&info, 0x00, sizeof(info));
     info.magic0 = kMinfsMagic0;
     info.magic1 = kMinfsMagic1;
-    info.version = kMinfsVersion;
-    info.flags = kMinfsFlagClean;
+    info.version = kMinfsVersionDirIndex;
+    info.flags = kMinfsFlagClean | kMinfsFlagDirIndex;
+    if (options.extents) {
+        info.flags |= kMinfsFlagExtents;
+    }
     info.block_size = kMinfsBlockSize;
     info.inode_size = kMinfsInodeSize;
 
@@ -1134,6 +1206,16 @@ void Minfs::UpdateOpenMetrics(bool cache_hit, const fs::Duration& duration) {
 #endif
 }
 
+#ifdef __Fuchsia__
+void Minfs::UpdateWritebackMetrics() {
+#ifdef FS_WITH_METRICS
+    if (collecting_metrics_) {
+        writeback_->GetMetrics(&metrics_.writeback_requests, &metrics_.writeback_blocks);
+    }
+#endif
+}
+#endif
+
 void Minfs::DumpMetrics() const {
 #ifdef FS_WITH_METRICS
     if (collecting_metrics_) {
@@ -17,6 +17,7 @@
 #include <zircon/time.h>
 
 #ifdef __Fuchsia__
+#include <zircon/device/device.h>
 #include <zircon/syscalls.h>
 #include <lib/fdio/vfs.h>
 #include <fbl/auto_lock.h>
@@ -33,6 +34,11 @@
 
 namespace {
 
+#ifdef __Fuchsia__
+// The largest number of blocks written back by a single flush of delayed writes.
+constexpr uint32_t kMinfsMaxDelayedBlocks = 128;
+#endif
+
 zx_time_t minfs_gettime_utc() {
     // linux/zircon compatible
     struct timespec ts;
@@ -70,6 +76,9 @@ void VnodeMinfs::InodeSync(WritebackWork* wb, uint32_t flags) {
 // the file. Does not update mtime/atime.
 zx_status_t VnodeMinfs::BlocksShrink(Transaction* state, blk_t start) {
     ZX_DEBUG_ASSERT(state != nullptr);
+    if (IsExtentMapped()) {
+        return ExtentsShrink(state, start);
+    }
     bop_params_t boparams(start, static_cast<blk_t>(kMinfsMaxFileBlock - start), nullptr);
     zx_status_t status;
     if ((status = BlockOp(state, DELETE, &boparams)) != ZX_OK) {
@@ -213,6 +222,21 @@ zx_status_t VnodeMinfs::InitVmo() {
                                ticker.End());
     });
 
+    if (IsExtentMapped()) {
+        // Each extent is read with a single request.
+        const minfs_extent_t* extents = InodeExtents(&inode_);
+        for (uint32_t i = 0; i < kMinfsInodeExtents && extents[i].count != 0; i++) {
+            fs_->ValidateBno(extents[i].start);
+            fs_->ValidateBno(extents[i].start + extents[i].count - 1);
+            dnum_count += extents[i].count;
+            txn.Enqueue(vmoid_, extents[i].fblock, extents[i].start + fs_->Info().dat_block,
+                        extents[i].count);
+        }
+        status = txn.Transact();
+        ValidateVmoTail();
+        return status;
+    }
+
     // Initialize all direct blocks
     blk_t bno;
     for (uint32_t d = 0; d < kMinfsDirect; d++) {
@@ -347,6 +371,14 @@ zx_status_t VnodeMinfs::BlockOpDirect(Transaction* state, DirectArgs* params) {
                 params->SetBno(i, bno);
                 break;
             }
+            case ADOPT: {
+                // The block is already allocated, and counted by the inode.
+                ZX_DEBUG_ASSERT(bno == 0);
+                bno = params->GetAdoptedBno(i);
+                fs_->ValidateBno(bno);
+                params->SetBno(i, bno);
+                break;
+            }
             default: {
                 return ZX_ERR_NOT_SUPPORTED;
             }
@@ -361,7 +393,7 @@ zx_status_t VnodeMinfs::BlockOpIndirect(Transaction* state, IndirectArgs* params
     zx_status_t status;
 
 #ifdef __Fuchsia__
-    if (params->GetOp() == READ || params->GetOp() == WRITE) {
+    if (params->GetOp() != DELETE) {
         validate_vmo_size(vmo_indirect_->GetVmo(), params->GetOffset() + params->GetCount());
     }
 #endif
@@ -375,6 +407,7 @@ zx_status_t VnodeMinfs::BlockOpIndirect(Transaction* state, IndirectArgs* params
             case READ:
                 return ZX_OK;
             case WRITE:
+            case ADOPT:
                 AllocateIndirect(state, i, params);
                 break;
             default:
@@ -424,7 +457,7 @@ zx_status_t VnodeMinfs::BlockOpDindirect(Transaction* state, DindirectArgs* para
     zx_status_t status;
 
 #ifdef __Fuchsia__
-    if (params->GetOp() == READ || params->GetOp() == WRITE) {
+    if (params->GetOp() != DELETE) {
         validate_vmo_size(vmo_indirect_->GetVmo(), params->GetOffset() + params->GetCount());
     }
 #endif
@@ -439,6 +472,7 @@ zx_status_t VnodeMinfs::BlockOpDindirect(Transaction* state, DindirectArgs* para
             case READ:
                 return ZX_OK;
             case WRITE:
+            case ADOPT:
                 AllocateIndirect(state, i, params);
                 break;
             default:
@@ -613,34 +647,194 @@ zx_status_t VnodeMinfs::BlockOp(Transaction* state, blk_op_t op, bop_params_t* b
     return found == boparams->count ? ZX_OK : ZX_ERR_OUT_OF_RANGE;
 }
 
+#ifdef __Fuchsia__
+zx_status_t VnodeMinfs::GrowIndirectVmo(blk_t n) {
+    if (n < kMinfsDirect) {
+        return ZX_OK;
+    }
+
+    zx_status_t status;
+    // If the vmo_indirect_ vmo has not been created, make it now.
+    if ((status = InitIndirectVmo()) != ZX_OK) {
+        return status;
+    }
+
+    // Number of blocks prior to dindirect blocks
+    blk_t pre_dindirect = kMinfsDirect + kMinfsDirectPerIndirect * kMinfsIndirect;
+    if (n >= pre_dindirect) {
+        // Index of last doubly indirect block
+        blk_t dibindex = (n - pre_dindirect) / kMinfsDirectPerDindirect;
+        ZX_DEBUG_ASSERT(dibindex < kMinfsDoublyIndirect);
+        uint64_t vmo_size = GetVmoSizeForIndirect(dibindex);
+        // Grow VMO if we need more space to fit doubly indirect blocks
+        if (vmo_indirect_->GetSize() < vmo_size) {
+            if ((status = vmo_indirect_->Grow(vmo_size)) != ZX_OK) {
+                return status;
+            }
+        }
+    }
+    return ZX_OK;
+}
+#endif
+
 zx_status_t VnodeMinfs::BlockGet(Transaction* state, blk_t n, blk_t* bno) {
+    if (IsExtentMapped()) {
+        return ExtentGet(state, n, bno);
+    }
+
 #ifdef __Fuchsia__
-    if (n >= kMinfsDirect) {
+    zx_status_t status;
+    if ((status = GrowIndirectVmo(n)) != ZX_OK) {
+        return status;
+    }
+#endif
+
+    bop_params_t boparams(n, 1, bno);
+    return BlockOp(state, state ? WRITE : READ, &boparams);
+}
+
+zx_status_t VnodeMinfs::ExtentGet(Transaction* state, blk_t n, blk_t* bno) {
+    minfs_extent_t* extents = InodeExtents(&inode_);
+
+    // Find the extent holding |n|, or the position at which an extent holding |n|
+    // would be inserted.
+    uint32_t used = 0;
+    while (used < kMinfsInodeExtents && extents[used].count != 0) {
+        used++;
+    }
+    uint32_t i = 0;
+    for (; i < used && extents[i].fblock <= n; i++) {
+        if (n - extents[i].fblock < extents[i].count) {
+            *bno = extents[i].start + (n - extents[i].fblock);
+            fs_->ValidateBno(*bno);
+            return ZX_OK;
+        }
+    }
+    if (state == nullptr) {
+        // Sparse.
+        *bno = 0;
+        return ZX_OK;
+    }
+
+    // Allocate a block which extends a neighbouring extent, if possible.
+    minfs_extent_t* prev = (i > 0) ? &extents[i - 1] : nullptr;
+    minfs_extent_t* next = (i < used) ? &extents[i] : nullptr;
+    bool prev_adjacent = prev != nullptr && prev->fblock + prev->count == n;
+    bool next_adjacent = next != nullptr && next->fblock == n + 1;
+    blk_t new_bno;
+    if (prev_adjacent) {
+        fs_->BlockNewNear(state, prev->start + prev->count, &new_bno);
+    } else if (next_adjacent) {
+        fs_->BlockNewNear(state, next->start - 1, &new_bno);
+    } else {
+        fs_->BlockNew(state, &new_bno);
+    }
+    fs_->ValidateBno(new_bno);
+    inode_.block_count++;
+
+    bool extends_prev = prev_adjacent && prev->start + prev->count == new_bno;
+    bool extends_next = next_adjacent && next->start == new_bno + 1;
+    if (extends_prev && extends_next) {
+        // The new block joins two extents.
+        prev->count += 1 + next->count;
+        memmove(next, next + 1, (used - i - 1) * sizeof(minfs_extent_t));
+        memset(&extents[used - 1], 0, sizeof(minfs_extent_t));
+    } else if (extends_prev) {
+        prev->count++;
+    } else if (extends_next) {
+        next->fblock--;
+        next->start--;
+        next->count++;
+    } else if (used < kMinfsInodeExtents) {
+        memmove(&extents[i + 1], &extents[i], (used - i) * sizeof(minfs_extent_t));
+        extents[i].fblock = n;
+        extents[i].start = new_bno;
+        extents[i].count = 1;
+    } else {
         zx_status_t status;
-        // If the vmo_indirect_ vmo has not been created, make it now.
-        if ((status = InitIndirectVmo()) != ZX_OK) {
+        if ((status = ExtentsToBlockMap(state, n, new_bno)) != ZX_OK) {
             return status;
         }
+    }
 
-        // Number of blocks prior to dindirect blocks
-        blk_t pre_dindirect = kMinfsDirect + kMinfsDirectPerIndirect * kMinfsIndirect;
-        if (n >= pre_dindirect) {
-            // Index of last doubly indirect block
-            blk_t dibindex = (n - pre_dindirect) / kMinfsDirectPerDindirect;
-            ZX_DEBUG_ASSERT(dibindex < kMinfsDoublyIndirect);
-            uint64_t vmo_size = GetVmoSizeForIndirect(dibindex);
-            // Grow VMO if we need more space to fit doubly indirect blocks
-            if (vmo_indirect_->GetSize() < vmo_size) {
-                if ((status = vmo_indirect_->Grow(vmo_size)) != ZX_OK) {
-                    return status;
-                }
-            }
+    InodeSync(state->GetWork(), kMxFsSyncDefault);
+    *bno = new_bno;
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::ExtentsShrink(Transaction* state, blk_t start) {
+    minfs_extent_t* extents = InodeExtents(&inode_);
+    bool dirty = false;
+    for (uint32_t i = 0; i < kMinfsInodeExtents && extents[i].count != 0; i++) {
+        if (extents[i].fblock + extents[i].count <= start) {
+            continue;
+        }
+        blk_t keep = (extents[i].fblock < start) ? start - extents[i].fblock : 0;
+        for (blk_t b = keep; b < extents[i].count; b++) {
+            fs_->ValidateBno(extents[i].start + b);
+            fs_->BlockFree(state->GetWork(), extents[i].start + b);
+            inode_.block_count--;
+        }
+        extents[i].count = keep;
+        if (keep == 0) {
+            memset(&extents[i], 0, sizeof(minfs_extent_t));
         }
+        dirty = true;
+    }
+
+    if (dirty) {
+        InodeSync(state->GetWork(), kMxFsSyncDefault);
+    }
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::ExtentsToBlockMap(Transaction* state, blk_t n, blk_t bno) {
+    TRACE_DURATION("minfs", "VnodeMinfs::ExtentsToBlockMap", "ino", ino_);
+    minfs_extent_t extents[kMinfsInodeExtents];
+    memcpy(extents, InodeExtents(&inode_), sizeof(extents));
+
+    // Reserve the indirect blocks needed to map every block of the file. The reservation
+    // made for the current operation only covers the blocks being written.
+    blk_t end = fbl::max(n, extents[kMinfsInodeExtents - 1].fblock +
+                            extents[kMinfsInodeExtents - 1].count - 1) + 1;
+    blk_t required;
+    zx_status_t status;
+    if ((status = GetRequiredBlockCount(0, static_cast<size_t>(end) * kMinfsBlockSize,
+                                        &required)) != ZX_OK) {
+        return status;
+    } else if ((status = fs_->BlocksReserve(state, required - end)) != ZX_OK) {
+        return status;
+    }
+#ifdef __Fuchsia__
+    if ((status = GrowIndirectVmo(end - 1)) != ZX_OK) {
+        return status;
     }
 #endif
 
-    bop_params_t boparams(n, 1, bno);
-    return BlockOp(state, state ? WRITE : READ, &boparams);
+    memset(inode_.dnum, 0, sizeof(extents));
+    inode_.flags &= ~kMinfsInodeFlagExtents;
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<blk_t[]> bnos(new (&ac) blk_t[kMinfsDirectPerIndirect]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    for (uint32_t i = 0; i < kMinfsInodeExtents; i++) {
+        for (blk_t done = 0; done < extents[i].count;) {
+            blk_t count = fbl::min(extents[i].count - done, kMinfsDirectPerIndirect);
+            bop_params_t boparams(extents[i].fblock + done, count, bnos.get());
+            for (blk_t b = 0; b < count; b++) {
+                bnos[b] = extents[i].start + done + b;
+            }
+            if ((status = BlockOp(state, ADOPT, &boparams)) != ZX_OK) {
+                return status;
+            }
+            done += count;
+        }
+    }
+    bop_params_t boparams(n, 1, bnos.get());
+    bnos[0] = bno;
+    return BlockOp(state, ADOPT, &boparams);
 }
 
 // Immediately stop iterating over the directory.
@@ -650,6 +844,19 @@ zx_status_t VnodeMinfs::BlockGet(Transaction* state, blk_t n, blk_t* bno) {
 // Identify that the direntry record was modified. Stop iterating.
 #define DIR_CB_SAVE_SYNC 2
 
+// The number of directory index entries read at a time while searching a bucket.
+constexpr uint32_t kDirIndexReadBatch = 64;
+
+// Offsets within the directory index of parts of the bucket at |bucket_off|.
+static size_t DirIndexCountOffset(size_t bucket_off) {
+    return bucket_off + offsetof(minfs_dir_index_bucket_t, count);
+}
+
+static size_t DirIndexEntryOffset(size_t bucket_off, uint32_t entry) {
+    return bucket_off + offsetof(minfs_dir_index_bucket_t, entries) +
+           entry * sizeof(minfs_dir_index_entry_t);
+}
+
 zx_status_t VnodeMinfs::ReadExactInternal(void* data, size_t len, size_t off) {
     size_t actual;
     zx_status_t status = ReadInternal(data, len, off, &actual);
@@ -736,6 +943,15 @@ zx_status_t VnodeMinfs::UnlinkChild(Transaction* state,
     size_t off_next = off + MinfsReclen(de, off);
     minfs_dirent_t de_prev, de_next;
     zx_status_t status;
+    fbl::StringPiece name(de->name, de->namelen);
+
+    if ((off_prev == off) && DirIndexValid()) {
+        // Direntries found through the index come without their predecessor.
+        if (DirIndexPrevious(name, off, &off_prev) != ZX_OK) {
+            // The free space is merely left uncoalesced.
+            off_prev = off;
+        }
+    }
 
     // Read the direntries we're considering merging with.
     // Verify they are free and small enough to merge.
@@ -791,6 +1007,14 @@ zx_status_t VnodeMinfs::UnlinkChild(Transaction* state,
         TruncateInternal(state, off + MINFS_DIRENT_SIZE);
     }
 
+    if (DirIndexValid()) {
+        if (DirIndexRemove(state, name, offs->off) != ZX_OK) {
+            DirIndexInvalidate();
+        } else if (de->reclen & kMinfsReclenLast) {
+            inode_.dir_last_off = static_cast<uint32_t>(off);
+        }
+    }
+
     inode_.dirent_count--;
 
     if (MinfsMagicType(childvn->inode_.magic) == kMinfsTypeDir) {
@@ -961,6 +1185,7 @@ zx_status_t VnodeMinfs::AppendDirent(DirArgs* args) {
     }
 
     uint32_t reclen = static_cast<uint32_t>(MinfsReclen(de, args->offs.off));
+    bool was_last_record = de->reclen & kMinfsReclenLast;
     if (de->ino == 0) {
         // empty entry, do we fit?
         if (args->reclen > reclen) {
@@ -978,7 +1203,6 @@ zx_status_t VnodeMinfs::AppendDirent(DirArgs* args) {
             return ZX_ERR_NO_SPACE;
         }
         // shrink existing entry
-        bool was_last_record = de->reclen & kMinfsReclenLast;
         de->reclen = size;
         if ((status = WriteExactInternal(args->state, de,
                                          DirentSize(de->namelen),
@@ -1005,8 +1229,16 @@ zx_status_t VnodeMinfs::AppendDirent(DirArgs* args) {
         inode_.link_count++;
     }
 
+    if (DirIndexValid()) {
+        if (DirIndexInsert(args->state, args->name, args->offs.off) != ZX_OK) {
+            DirIndexInvalidate();
+        } else if (was_last_record) {
+            inode_.dir_last_off = static_cast<uint32_t>(args->offs.off);
+        }
+    }
+
     inode_.dirent_count++;
-    inode_.seq_num++;
+    DirentsChanged();
     InodeSync(args->state->GetWork(), kMxFsSyncMtime);
     args->state->GetWork()->PinVnode(fbl::move(fbl::WrapRefPtr(this)));
     return ZX_OK;
@@ -1043,7 +1275,7 @@ zx_status_t VnodeMinfs::ForEachDirent(DirArgs* args, const DirentCallback func)
         case DIR_CB_NEXT:
             break;
         case DIR_CB_SAVE_SYNC:
-            inode_.seq_num++;
+            DirentsChanged();
             InodeSync(args->state->GetWork(), kMxFsSyncMtime);
             args->state->GetWork()->PinVnode(fbl::move(fbl::WrapRefPtr(this)));
             return ZX_OK;
@@ -1056,6 +1288,369 @@ zx_status_t VnodeMinfs::ForEachDirent(DirArgs* args, const DirentCallback func)
     return ZX_ERR_NOT_FOUND;
 }
 
+zx_status_t VnodeMinfs::ForEachNamedDirent(DirArgs* args, const DirentCallback func) {
+    if (!DirIndexValid()) {
+        return ForEachDirent(args, func);
+    }
+
+    fbl::RefPtr<VnodeMinfs> index;
+    size_t bucket_off;
+    uint32_t count;
+    zx_status_t status;
+    if ((status = DirIndexBucket(args->name, &index, &bucket_off, &count)) != ZX_OK) {
+        DirIndexInvalidate();
+        return ForEachDirent(args, func);
+    }
+
+    const uint32_t hash = DirIndexHash(args->name);
+    minfs_dir_index_entry_t entries[kDirIndexReadBatch];
+    char data[kMinfsMaxDirentSize];
+    minfs_dirent_t* de = reinterpret_cast<minfs_dirent_t*>(data);
+    for (uint32_t i = 0; i < count; i += kDirIndexReadBatch) {
+        uint32_t batch = fbl::min(count - i, kDirIndexReadBatch);
+        if ((status = index->ReadExactInternal(entries, batch * sizeof(entries[0]),
+                                               DirIndexEntryOffset(bucket_off, i))) != ZX_OK) {
+            return status;
+        }
+        for (uint32_t j = 0; j < batch; j++) {
+            if (entries[j].hash != hash) {
+                continue;
+            }
+            size_t off = entries[j].off;
+            size_t r;
+            if ((status = ReadInternal(data, kMinfsMaxDirentSize, off, &r)) != ZX_OK) {
+                return status;
+            } else if (validate_dirent(de, r, off) != ZX_OK || de->ino == 0) {
+                FS_TRACE_ERROR("minfs: ino#%u: index refers to invalid dirent at %zu\n", ino_, off);
+                DirIndexInvalidate();
+                return ForEachDirent(args, func);
+            } else if (fbl::StringPiece(de->name, de->namelen) != args->name) {
+                continue;
+            }
+
+            args->offs.off = off;
+            // The index does not record the previous direntry; UnlinkChild looks it up.
+            args->offs.off_prev = off;
+            switch ((status = func(fbl::RefPtr<VnodeMinfs>(this), de, args))) {
+            case DIR_CB_NEXT:
+                break;
+            case DIR_CB_SAVE_SYNC:
+                DirentsChanged();
+                InodeSync(args->state->GetWork(), kMxFsSyncMtime);
+                args->state->GetWork()->PinVnode(fbl::move(fbl::WrapRefPtr(this)));
+                return ZX_OK;
+            case DIR_CB_DONE:
+            default:
+                return status;
+            }
+        }
+    }
+    return ZX_ERR_NOT_FOUND;
+}
+
+zx_status_t VnodeMinfs::FindDirentSpace(DirArgs* args) {
+    if (DirIndexValid()) {
+        // Appending to the final direntry avoids scanning the directory. Space freed
+        // earlier in the directory is only reused once the directory is full.
+        char data[kMinfsMaxDirentSize];
+        minfs_dirent_t* de = reinterpret_cast<minfs_dirent_t*>(data);
+        size_t off = inode_.dir_last_off;
+        size_t r;
+        if ((ReadInternal(data, kMinfsMaxDirentSize, off, &r) == ZX_OK) &&
+            (validate_dirent(de, r, off) == ZX_OK) && (de->reclen & kMinfsReclenLast)) {
+            args->offs.off = off;
+            args->offs.off_prev = off;
+            if (DirentCallbackFindSpace(fbl::RefPtr<VnodeMinfs>(this), de, args) == DIR_CB_DONE) {
+                return ZX_OK;
+            }
+        }
+    }
+    return ForEachDirent(args, DirentCallbackFindSpace);
+}
+
+void VnodeMinfs::DirentsChanged() {
+    bool indexed = DirIndexValid();
+    inode_.seq_num++;
+    if (indexed) {
+        inode_.dir_index_seq = inode_.seq_num;
+    }
+}
+
+void VnodeMinfs::EnsureDirIndex() {
+    if (!(fs_->Info().flags & kMinfsFlagDirIndex) || dir_index_full_) {
+        return;
+    } else if (inode_.dirent_count < kMinfsDirIndexMinDirents || DirIndexValid()) {
+        return;
+    }
+    zx_status_t status;
+    if ((status = RebuildDirIndex()) != ZX_OK) {
+        FS_TRACE_WARN("minfs: ino#%u: cannot index directory: %d\n", ino_, status);
+    }
+}
+
+zx_status_t VnodeMinfs::RebuildDirIndex() {
+    TRACE_DURATION("minfs", "VnodeMinfs::RebuildDirIndex", "ino", ino_);
+    // Size the index for twice the current number of direntries, so that the
+    // directory can grow for a while before the index needs to be rebuilt.
+    uint32_t buckets = 1;
+    while ((buckets < kMinfsDirIndexMaxBuckets) &&
+           (buckets * kMinfsDirIndexBucketEntries < 2 * inode_.dirent_count)) {
+        buckets *= 2;
+    }
+
+    fbl::unique_ptr<minfs_dir_index_bucket_t[]> table;
+    size_t off;
+    zx_status_t status;
+    while ((status = BuildDirIndexTable(buckets, &table, &off)) == ZX_ERR_NO_SPACE) {
+        if (buckets == kMinfsDirIndexMaxBuckets) {
+            // Too many names share a bucket for any index to hold them. Leave the
+            // directory unindexed while it is loaded, rather than scanning it again
+            // on every create.
+            dir_index_full_ = true;
+            return status;
+        }
+        buckets *= 2;
+    }
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    const size_t index_size = buckets * kMinfsBlockSize;
+    blk_t reserve_blocks;
+    if ((status = GetRequiredBlockCount(0, index_size, &reserve_blocks)) != ZX_OK) {
+        return status;
+    }
+    fbl::unique_ptr<Transaction> state;
+    if ((status = fs_->BeginTransaction(inode_.dir_index_ino == 0 ? 1 : 0, reserve_blocks,
+                                        &state)) != ZX_OK) {
+        return status;
+    }
+
+    fbl::RefPtr<VnodeMinfs> index;
+    if (inode_.dir_index_ino == 0) {
+        status = fs_->VnodeNew(state.get(), &index, kMinfsTypeFile);
+    } else {
+        status = fs_->VnodeGet(&index, inode_.dir_index_ino);
+    }
+    if (status != ZX_OK) {
+        return status;
+    }
+    if ((status = index->WriteExactInternal(state.get(), table.get(), index_size, 0)) != ZX_OK) {
+        return status;
+    }
+    if (index->inode_.size > index_size) {
+        // The index shrank along with the directory.
+        if ((status = index->TruncateInternal(state.get(), index_size)) != ZX_OK) {
+            return status;
+        }
+        index->InodeSync(state->GetWork(), kMxFsSyncMtime);
+    }
+
+    inode_.dir_index_ino = index->ino_;
+    inode_.dir_index_buckets = buckets;
+    inode_.dir_last_off = static_cast<uint32_t>(off);
+    inode_.dir_index_seq = inode_.seq_num;
+    InodeSync(state->GetWork(), kMxFsSyncDefault);
+    state->GetWork()->PinVnode(fbl::move(fbl::WrapRefPtr(this)));
+    state->GetWork()->PinVnode(fbl::move(index));
+    fs_->CommitTransaction(fbl::move(state));
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::BuildDirIndexTable(uint32_t buckets,
+                                           fbl::unique_ptr<minfs_dir_index_bucket_t[]>* out,
+                                           size_t* out_last_off) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<minfs_dir_index_bucket_t[]> table(new (&ac) minfs_dir_index_bucket_t[buckets]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    memset(table.get(), 0, buckets * sizeof(minfs_dir_index_bucket_t));
+    for (uint32_t i = 0; i < buckets; i++) {
+        table[i].magic = kMinfsDirIndexMagic;
+    }
+
+    // Record every live direntry, and find the last one.
+    char data[kMinfsMaxDirentSize];
+    minfs_dirent_t* de = reinterpret_cast<minfs_dirent_t*>(data);
+    size_t off = 0;
+    zx_status_t status;
+    while (true) {
+        size_t r;
+        if ((status = ReadInternal(data, kMinfsMaxDirentSize, off, &r)) != ZX_OK) {
+            return status;
+        } else if ((status = validate_dirent(de, r, off)) != ZX_OK) {
+            return status;
+        }
+        if (de->ino != 0) {
+            uint32_t hash = DirIndexHash(fbl::StringPiece(de->name, de->namelen));
+            minfs_dir_index_bucket_t* bucket = &table[hash % buckets];
+            if (bucket->count == kMinfsDirIndexBucketEntries) {
+                return ZX_ERR_NO_SPACE;
+            }
+            bucket->entries[bucket->count].hash = hash;
+            bucket->entries[bucket->count].off = static_cast<uint32_t>(off);
+            bucket->count++;
+        }
+        if (de->reclen & kMinfsReclenLast) {
+            break;
+        }
+        off += MinfsReclen(de, off);
+    }
+
+    *out = fbl::move(table);
+    *out_last_off = off;
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::DirIndexBucket(fbl::StringPiece name, fbl::RefPtr<VnodeMinfs>* out_index,
+                                       size_t* out_bucket_off, uint32_t* out_count) {
+    ZX_DEBUG_ASSERT(DirIndexValid());
+    if (inode_.dir_index_buckets == 0 || inode_.dir_index_buckets > kMinfsDirIndexMaxBuckets) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    zx_status_t status;
+    if ((status = fs_->VnodeGet(out_index, inode_.dir_index_ino)) != ZX_OK) {
+        return status;
+    }
+    size_t bucket_off = (DirIndexHash(name) % inode_.dir_index_buckets) * kMinfsBlockSize;
+    uint32_t header[2];
+    static_assert(offsetof(minfs_dir_index_bucket_t, entries) == sizeof(header), "");
+    if ((status = (*out_index)->ReadExactInternal(header, sizeof(header), bucket_off)) != ZX_OK) {
+        return status;
+    } else if (header[0] != kMinfsDirIndexMagic || header[1] > kMinfsDirIndexBucketEntries) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    *out_bucket_off = bucket_off;
+    *out_count = header[1];
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::DirIndexInsert(Transaction* state, fbl::StringPiece name, size_t off) {
+    fbl::RefPtr<VnodeMinfs> index;
+    size_t bucket_off;
+    uint32_t count;
+    zx_status_t status;
+    if ((status = DirIndexBucket(name, &index, &bucket_off, &count)) != ZX_OK) {
+        return status;
+    } else if (count == kMinfsDirIndexBucketEntries) {
+        // The index is rebuilt with more buckets before the next direntry is added.
+        return ZX_ERR_NO_SPACE;
+    }
+
+    minfs_dir_index_entry_t entry;
+    entry.hash = DirIndexHash(name);
+    entry.off = static_cast<uint32_t>(off);
+    if ((status = index->WriteExactInternal(state, &entry, sizeof(entry),
+                                            DirIndexEntryOffset(bucket_off, count))) != ZX_OK) {
+        return status;
+    }
+    count++;
+    if ((status = index->WriteExactInternal(state, &count, sizeof(count),
+                                            DirIndexCountOffset(bucket_off))) != ZX_OK) {
+        return status;
+    }
+    state->GetWork()->PinVnode(fbl::move(index));
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::DirIndexRemove(Transaction* state, fbl::StringPiece name, size_t off) {
+    fbl::RefPtr<VnodeMinfs> index;
+    size_t bucket_off;
+    uint32_t count;
+    zx_status_t status;
+    if ((status = DirIndexBucket(name, &index, &bucket_off, &count)) != ZX_OK) {
+        return status;
+    }
+
+    const uint32_t hash = DirIndexHash(name);
+    minfs_dir_index_entry_t entries[kDirIndexReadBatch];
+    uint32_t position = count;
+    for (uint32_t i = 0; i < count && position == count; i += kDirIndexReadBatch) {
+        uint32_t batch = fbl::min(count - i, kDirIndexReadBatch);
+        if ((status = index->ReadExactInternal(entries, batch * sizeof(entries[0]),
+                                               DirIndexEntryOffset(bucket_off, i))) != ZX_OK) {
+            return status;
+        }
+        for (uint32_t j = 0; j < batch; j++) {
+            if (entries[j].hash == hash && entries[j].off == off) {
+                position = i + j;
+                break;
+            }
+        }
+    }
+    if (position == count) {
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    // Fill the hole with the final entry of the bucket.
+    count--;
+    if (position != count) {
+        if ((status = index->ReadExactInternal(entries, sizeof(entries[0]),
+                                               DirIndexEntryOffset(bucket_off, count))) != ZX_OK) {
+            return status;
+        } else if ((status = index->WriteExactInternal(
+                        state, entries, sizeof(entries[0]),
+                        DirIndexEntryOffset(bucket_off, position))) != ZX_OK) {
+            return status;
+        }
+    }
+    if ((status = index->WriteExactInternal(state, &count, sizeof(count),
+                                            DirIndexCountOffset(bucket_off))) != ZX_OK) {
+        return status;
+    }
+    state->GetWork()->PinVnode(fbl::move(index));
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::DirIndexPrevious(fbl::StringPiece name, size_t off, size_t* out_prev) {
+    fbl::RefPtr<VnodeMinfs> index;
+    size_t bucket_off;
+    uint32_t count;
+    zx_status_t status;
+    if ((status = DirIndexBucket(name, &index, &bucket_off, &count)) != ZX_OK) {
+        return status;
+    }
+
+    // Every entry of the bucket is the start of a direntry, as is the first
+    // direntry, ".". Walk forward from the closest one which precedes |off|.
+    size_t start = 0;
+    minfs_dir_index_entry_t entries[kDirIndexReadBatch];
+    for (uint32_t i = 0; i < count; i += kDirIndexReadBatch) {
+        uint32_t batch = fbl::min(count - i, kDirIndexReadBatch);
+        if ((status = index->ReadExactInternal(entries, batch * sizeof(entries[0]),
+                                               DirIndexEntryOffset(bucket_off, i))) != ZX_OK) {
+            return status;
+        }
+        for (uint32_t j = 0; j < batch; j++) {
+            if (entries[j].off < off && entries[j].off > start) {
+                start = entries[j].off;
+            }
+        }
+    }
+
+    char data[kMinfsMaxDirentSize];
+    minfs_dirent_t* de = reinterpret_cast<minfs_dirent_t*>(data);
+    size_t prev = start;
+    while (start < off) {
+        size_t r;
+        if ((status = ReadInternal(data, kMinfsMaxDirentSize, start, &r)) != ZX_OK) {
+            return status;
+        } else if ((status = validate_dirent(de, r, start)) != ZX_OK) {
+            return status;
+        } else if (de->reclen & kMinfsReclenLast) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        prev = start;
+        start += MinfsReclen(de, start);
+    }
+    if (start != off) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    *out_prev = prev;
+    return ZX_OK;
+}
+
 void VnodeMinfs::fbl_recycle() {
     ZX_DEBUG_ASSERT(fd_count_ == 0);
     if (!IsUnlinked()) {
@@ -1112,6 +1707,17 @@ zx_status_t VnodeMinfs::Open(uint32_t flags, fbl::RefPtr<Vnode>* out_redirect) {
 void VnodeMinfs::Purge(WritebackWork* wb) {
     ZX_DEBUG_ASSERT(fd_count_ == 0);
     ZX_DEBUG_ASSERT(IsUnlinked());
+#ifdef __Fuchsia__
+    // Nothing can read the data of the vnode anymore.
+    DropDelayedWrites();
+#endif
+    if (IsDirectory() && inode_.dir_index_ino != 0) {
+        // The directory index is only referenced by its directory.
+        fbl::RefPtr<VnodeMinfs> index;
+        if (fs_->VnodeGet(&index, inode_.dir_index_ino) == ZX_OK) {
+            index->RemoveInodeLink(wb);
+        }
+    }
     fs_->VnodeRelease(this);
 #ifdef __Fuchsia__
     // TODO(smklein): Only init indirect vmo if it's needed
@@ -1135,6 +1741,12 @@ zx_status_t VnodeMinfs::Close() {
         Purge(state->GetWork());
         fs_->CommitTransaction(fbl::move(state));
     }
+#ifdef __Fuchsia__
+    if (fd_count_ == 0) {
+        // Nothing else can write to the vnode; write back its data now.
+        return FlushDelayedWrites();
+    }
+#endif
     return ZX_OK;
 }
 
@@ -1232,6 +1844,9 @@ zx_status_t VnodeMinfs::Write(const void* data, size_t len, size_t offset,
         fs_->UpdateWriteMetrics(*out_actual, ticker.End());
     });
 
+#ifdef __Fuchsia__
+    return WriteDelayed(data, len, offset, out_actual);
+#else
     blk_t reserve_blocks;
     // Calculate maximum number of blocks to reserve for this write operation.
     zx_status_t status = GetRequiredBlockCount(offset, len, &reserve_blocks);
@@ -1253,8 +1868,176 @@ zx_status_t VnodeMinfs::Write(const void* data, size_t len, size_t offset,
         fs_->CommitTransaction(fbl::move(state));
     }
     return ZX_OK;
+#endif
 }
 
+#ifdef __Fuchsia__
+zx_status_t VnodeMinfs::WriteDelayed(const void* data, size_t len, size_t offset,
+                                     size_t* out_actual) {
+    if (len == 0) {
+        return ZX_OK;
+    } else if (offset >= kMinfsMaxFileSize) {
+        return ZX_ERR_FILE_BIG;
+    }
+    len = fbl::min(len, kMinfsMaxFileSize - offset);
+
+    zx_status_t status;
+    if ((status = InitVmo()) != ZX_OK) {
+        return status;
+    }
+
+    // Only a single run of blocks is delayed at a time. Flush it before writing
+    // elsewhere in the file, or once it has grown large.
+    blk_t start = static_cast<blk_t>(offset / kMinfsBlockSize);
+    blk_t end = static_cast<blk_t>(fbl::round_up(offset + len, kMinfsBlockSize) /
+                                   kMinfsBlockSize);
+    if (HasDelayedWrites() && (start > delayed_end_ || end < delayed_start_ ||
+                               delayed_end_ - delayed_start_ >= kMinfsMaxDelayedBlocks)) {
+        if ((status = FlushDelayedWrites()) != ZX_OK) {
+            return status;
+        }
+    }
+
+    // Reserve the blocks which this write adds to the run, along with the indirect
+    // blocks which may be needed to map them.
+    blk_t run_start = HasDelayedWrites() ? fbl::min(start, delayed_start_) : start;
+    blk_t run_end = HasDelayedWrites() ? fbl::max(end, delayed_end_) : end;
+    blk_t required;
+    blk_t reserved = 0;
+    if ((status = GetRequiredBlockCount(static_cast<size_t>(run_start) * kMinfsBlockSize,
+                                        static_cast<size_t>(run_end - run_start) *
+                                        kMinfsBlockSize, &required)) != ZX_OK) {
+        return status;
+    } else if (HasDelayedWrites() &&
+               (status = GetRequiredBlockCount(
+                    static_cast<size_t>(delayed_start_) * kMinfsBlockSize,
+                    static_cast<size_t>(delayed_end_ - delayed_start_) * kMinfsBlockSize,
+                    &reserved)) != ZX_OK) {
+        return status;
+    }
+
+    fbl::unique_ptr<Transaction> state;
+    if ((status = fs_->BeginTransaction(0, required - reserved, &state)) != ZX_OK) {
+        if (status == ZX_ERR_NO_SPACE && HasDelayedWrites()) {
+            // The run may hold more blocks in reserve than it ends up allocating.
+            if ((status = FlushDelayedWrites()) != ZX_OK) {
+                return status;
+            }
+            return WriteDelayed(data, len, offset, out_actual);
+        }
+        return status;
+    }
+
+    // Update the in-memory VMO.
+    const size_t vmo_size = fbl::round_up(offset + len, kMinfsBlockSize);
+    if (vmo_size > vmo_size_) {
+        if ((status = vmo_.set_size(vmo_size)) != ZX_OK) {
+            return status;
+        }
+        vmo_size_ = vmo_size;
+    }
+    if ((status = vmo_.write(data, offset, len)) != ZX_OK) {
+        return status;
+    }
+
+    // Hold on to the reserved blocks until the run is flushed.
+    fbl::unique_ptr<AllocatorPromise> promise = state->RemoveBlockPromise();
+    if (delayed_promise_ == nullptr) {
+        delayed_promise_ = fbl::move(promise);
+    } else if (promise != nullptr) {
+        delayed_promise_->Merge(fbl::move(promise));
+    }
+    delayed_start_ = run_start;
+    delayed_end_ = run_end;
+
+    if (offset + len > inode_.size) {
+        inode_.size = static_cast<uint32_t>(offset + len);
+        NotifyResize();
+    }
+    // Successful writes update mtime.
+    inode_.modify_time = minfs_gettime_utc();
+    ValidateVmoTail();
+    *out_actual = len;
+
+    if (state->GetWork()->BlkCount() > 0) {
+        // The volume was extended to satisfy the reservation.
+        fs_->CommitTransaction(fbl::move(state));
+    }
+    return ZX_OK;
+}
+
+zx_status_t VnodeMinfs::FlushDelayedWrites() {
+    if (!HasDelayedWrites()) {
+        return ZX_OK;
+    }
+    TRACE_DURATION("minfs", "VnodeMinfs::FlushDelayedWrites", "ino", ino_,
+                   "blocks", delayed_end_ - delayed_start_);
+
+    zx_status_t status;
+    fbl::unique_ptr<Transaction> state;
+    if ((status = fs_->BeginTransaction(0, 0, &state)) != ZX_OK) {
+        return status;
+    }
+    state->SetBlockPromise(fbl::move(delayed_promise_));
+
+    // Allocate every block of the run at once, so that they are placed contiguously,
+    // and coalesce their writes into as few requests as possible.
+    blk_t queued = 0;
+    blk_t n = delayed_start_;
+    for (; n < delayed_end_; n++) {
+        blk_t bno;
+        if ((status = BlockGet(state.get(), n, &bno)) != ZX_OK) {
+            break;
+        }
+        ZX_DEBUG_ASSERT(bno != 0);
+        state->GetWork()->Enqueue(vmo_.get(), n, bno + fs_->Info().dat_block, 1);
+
+        // Bound the size of each unit of writeback work.
+        if (++queued == kMinfsMaxDelayedBlocks && n + 1 < delayed_end_) {
+            InodeSync(state->GetWork(), kMxFsSyncDefault);
+            state->GetWork()->PinVnode(fbl::WrapRefPtr(this));
+            fbl::unique_ptr<AllocatorPromise> promise = state->RemoveBlockPromise();
+            fs_->CommitTransaction(fbl::move(state));
+            if ((status = fs_->BeginTransaction(0, 0, &state)) != ZX_OK) {
+                // Keep the rest of the run delayed, so that a later flush may retry it.
+                delayed_promise_ = fbl::move(promise);
+                delayed_start_ = n + 1;
+                return status;
+            }
+            state->SetBlockPromise(fbl::move(promise));
+            queued = 0;
+        }
+    }
+
+    InodeSync(state->GetWork(), kMxFsSyncDefault);
+    state->GetWork()->PinVnode(fbl::WrapRefPtr(this));
+    if (status != ZX_OK) {
+        // Write back the blocks which were allocated, and keep the rest of the run
+        // delayed, so that a later flush may retry it.
+        FS_TRACE_ERROR("minfs: Failed to allocate block %u of ino#%u: %d\n", n, ino_, status);
+        delayed_promise_ = state->RemoveBlockPromise();
+        delayed_start_ = n;
+        fs_->CommitTransaction(fbl::move(state));
+        return status;
+    }
+    fs_->CommitTransaction(fbl::move(state));
+    delayed_start_ = delayed_end_ = 0;
+    return ZX_OK;
+}
+
+void VnodeMinfs::DropDelayedWrites() {
+    delayed_promise_ = nullptr;
+    delayed_start_ = delayed_end_ = 0;
+}
+
+void VnodeMinfs::NotifyResize() {
+    if (vmo_event_.is_valid()) {
+        vmo_event_.signal(0, FILE_SIGNAL_RESIZED);
+        vmo_event_.reset();
+    }
+}
+#endif
+
 zx_status_t VnodeMinfs::Append(const void* data, size_t len, size_t* out_end,
                                size_t* out_actual) {
     zx_status_t status = Write(data, len, inode_.size, out_actual);
@@ -1380,7 +2163,7 @@ zx_status_t VnodeMinfs::LookupInternal(fbl::RefPtr<fs::Vnode>* out, fbl::StringP
     auto get_metrics = fbl::MakeAutoCall([&ticker, &success, this]() {
         fs_->UpdateLookupMetrics(success, ticker.End());
     });
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) < 0) {
+    if ((status = ForEachNamedDirent(&args, DirentCallbackFind)) < 0) {
         return status;
     }
     fbl::RefPtr<VnodeMinfs> vn;
@@ -1534,6 +2317,9 @@ void VnodeMinfs::Allocate(Minfs* fs, uint32_t type, fbl::RefPtr<VnodeMinfs>* out
     (*out)->inode_.magic = MinfsMagic(type);
     (*out)->inode_.create_time = (*out)->inode_.modify_time = minfs_gettime_utc();
     (*out)->inode_.link_count = (type == kMinfsTypeDir ? 2 : 1);
+    if (type == kMinfsTypeFile && (fs->Info().flags & kMinfsFlagExtents)) {
+        (*out)->inode_.flags |= kMinfsInodeFlagExtents;
+    }
 }
 
 zx_status_t VnodeMinfs::Recreate(Minfs* fs, ino_t ino, fbl::RefPtr<VnodeMinfs>* out) {
@@ -1564,11 +2350,13 @@ zx_status_t VnodeMinfs::Create(fbl::RefPtr<fs::Vnode>* out, fbl::StringPiece nam
         return ZX_ERR_BAD_STATE;
     }
 
+    EnsureDirIndex();
+
     DirArgs args = DirArgs();
     args.name = name;
     // ensure file does not exist
     zx_status_t status;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) != ZX_ERR_NOT_FOUND) {
+    if ((status = ForEachNamedDirent(&args, DirentCallbackFind)) != ZX_ERR_NOT_FOUND) {
         return ZX_ERR_ALREADY_EXISTS;
     }
 
@@ -1579,7 +2367,7 @@ zx_status_t VnodeMinfs::Create(fbl::RefPtr<fs::Vnode>* out, fbl::StringPiece nam
     // before updating any other metadata.
     args.type = type;
     args.reclen = static_cast<uint32_t>(DirentSize(static_cast<uint8_t>(name.length())));
-    status = ForEachDirent(&args, DirentCallbackFindSpace);
+    status = FindDirentSpace(&args);
     if (status == ZX_ERR_NOT_FOUND) {
         return ZX_ERR_NO_SPACE;
     } else if (status != ZX_OK) {
@@ -1657,7 +2445,10 @@ zx_status_t VnodeMinfs::Ioctl(uint32_t op, const void* in_buf, size_t in_len, vo
             info->fs_id = fs_->GetFsId();
 #endif
             info->total_bytes = fs_->Info().block_count * fs_->Info().block_size;
-            info->used_bytes = fs_->Info().alloc_block_count * fs_->Info().block_size;
+            // Blocks reserved for delayed writes are counted as used, since they
+            // are no longer available to other writers.
+            info->used_bytes = (fs_->Info().alloc_block_count + fs_->BlocksReserved()) *
+                               fs_->Info().block_size;
             info->total_nodes = fs_->Info().inode_count;
             info->used_nodes = fs_->Info().alloc_inode_count;
             memcpy(info->name, kFsName, strlen(kFsName));
@@ -1702,7 +2493,7 @@ zx_status_t VnodeMinfs::Unlink(fbl::StringPiece name, bool must_be_dir) {
     args.name = name;
     args.type = must_be_dir ? kMinfsTypeDir : 0;
     args.state = state.get();
-    status = ForEachDirent(&args, DirentCallbackUnlink);
+    status = ForEachNamedDirent(&args, DirentCallbackUnlink);
     if (status == ZX_OK) {
         state->GetWork()->PinVnode(fbl::move(fbl::WrapRefPtr(this)));
         fs_->CommitTransaction(fbl::move(state));
@@ -1722,13 +2513,28 @@ zx_status_t VnodeMinfs::Truncate(size_t len) {
         fs_->UpdateTruncateMetrics(ticker.End());
     });
 
+    zx_status_t status;
+#ifdef __Fuchsia__
+    if ((status = FlushDelayedWrites()) != ZX_OK) {
+        return status;
+    }
+#endif
+
     fbl::unique_ptr<Transaction> state;
     // Since we will only edit existing blocks, no new blocks are required.
     ZX_ASSERT(fs_->BeginTransaction(0, 0, &state) == ZX_OK);
-    zx_status_t status = TruncateInternal(state.get(), len);
+#ifdef __Fuchsia__
+    const uint32_t old_size = inode_.size;
+#endif
+    status = TruncateInternal(state.get(), len);
     if (status == ZX_OK) {
         // Successful truncates update inode
         InodeSync(state->GetWork(), kMxFsSyncMtime);
+#ifdef __Fuchsia__
+        if (inode_.size != old_size) {
+            NotifyResize();
+        }
+#endif
     }
     state->GetWork()->PinVnode(fbl::move(fbl::WrapRefPtr(this)));
     fs_->CommitTransaction(fbl::move(state));
@@ -1870,7 +2676,7 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
     // acquire the 'oldname' node (it must exist)
     DirArgs args = DirArgs();
     args.name = oldname;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) < 0) {
+    if ((status = ForEachNamedDirent(&args, DirentCallbackFind)) < 0) {
         return status;
     } else if ((status = fs_->VnodeGet(&oldvn, args.ino)) < 0) {
         return status;
@@ -1893,7 +2699,8 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
     args.type = oldvn->IsDirectory() ? kMinfsTypeDir : kMinfsTypeFile;
     args.reclen = static_cast<uint32_t>(DirentSize(static_cast<uint8_t>(newname.length())));
 
-    status = newdir->ForEachDirent(&args, DirentCallbackFindSpace);
+    newdir->EnsureDirIndex();
+    status = newdir->FindDirentSpace(&args);
     if (status == ZX_ERR_NOT_FOUND) {
         return ZX_ERR_NO_SPACE;
     } else if (status != ZX_OK) {
@@ -1919,7 +2726,7 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
     args.state = state.get();
     args.name = newname;
     args.ino = oldvn->ino_;
-    status = newdir->ForEachDirent(&args, DirentCallbackAttemptRename);
+    status = newdir->ForEachNamedDirent(&args, DirentCallbackAttemptRename);
     if (status == ZX_ERR_NOT_FOUND) {
         // if 'newname' does not exist, create it
         args.offs = append_offs;
@@ -1940,7 +2747,7 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
         auto vn = fbl::RefPtr<VnodeMinfs>::Downcast(vn_fs);
         args.name = "..";
         args.ino = newdir->ino_;
-        if ((status = vn->ForEachDirent(&args, DirentCallbackUpdateInode)) < 0) {
+        if ((status = vn->ForEachNamedDirent(&args, DirentCallbackUpdateInode)) < 0) {
             return status;
         }
     }
@@ -1951,7 +2758,7 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
 
     // finally, remove oldname from its original position
     args.name = oldname;
-    if ((status = ForEachDirent(&args, DirentCallbackForceUnlink)) != ZX_OK) {
+    if ((status = ForEachNamedDirent(&args, DirentCallbackForceUnlink)) != ZX_OK) {
         return status;
     }
     state->GetWork()->PinVnode(oldvn);
@@ -1977,11 +2784,13 @@ zx_status_t VnodeMinfs::Link(fbl::StringPiece name, fbl::RefPtr<fs::Vnode> _targ
         return ZX_ERR_NOT_FILE;
     }
 
+    EnsureDirIndex();
+
     // The destination should not exist
     DirArgs args = DirArgs();
     args.name = name;
     zx_status_t status;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) != ZX_ERR_NOT_FOUND) {
+    if ((status = ForEachNamedDirent(&args, DirentCallbackFind)) != ZX_ERR_NOT_FOUND) {
         return (status == ZX_OK) ? ZX_ERR_ALREADY_EXISTS : status;
     }
 
@@ -1989,7 +2798,7 @@ zx_status_t VnodeMinfs::Link(fbl::StringPiece name, fbl::RefPtr<fs::Vnode> _targ
     // before updating any other metadata.
     args.type = kMinfsTypeFile; // We can't hard link directories
     args.reclen = static_cast<uint32_t>(DirentSize(static_cast<uint8_t>(name.length())));
-    status = ForEachDirent(&args, DirentCallbackFindSpace);
+    status = FindDirentSpace(&args);
     if (status == ZX_ERR_NOT_FOUND) {
         return ZX_ERR_NO_SPACE;
     } else if (status != ZX_OK) {
@@ -2028,10 +2837,49 @@ zx_status_t VnodeMinfs::GetHandles(uint32_t flags, zx_handle_t* hnd, uint32_t* t
                                    zxrio_node_info_t* extra) {
     if (IsDirectory()) {
         *type = FDIO_PROTOCOL_DIRECTORY;
-    } else {
-        *type = FDIO_PROTOCOL_FILE;
+        return ZX_OK;
     }
-    return ZX_OK;
+    *type = FDIO_PROTOCOL_FILE;
+
+    zx_status_t status;
+    if (!vmo_event_.is_valid()) {
+        if ((status = zx::event::create(0, &vmo_event_)) != ZX_OK) {
+            return status;
+        }
+        // Files are always readable and writable.
+        vmo_event_.signal(0, DEVICE_SIGNAL_READABLE | DEVICE_SIGNAL_WRITABLE |
+                          FILE_SIGNAL_VMO_SHARED);
+    }
+    return zx_handle_duplicate(vmo_event_.get(), ZX_RIGHTS_BASIC | ZX_RIGHT_READ, hnd);
+}
+
+zx_status_t VnodeMinfs::GetVmo(int flags, zx_handle_t* out) {
+    if (IsDirectory()) {
+        return ZX_ERR_NOT_SUPPORTED;
+    } else if ((flags & FDIO_MMAP_FLAG_WRITE) && !(flags & FDIO_MMAP_FLAG_PRIVATE)) {
+        // Blocks are only allocated on behalf of Write.
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    zx_status_t status;
+    if ((status = InitVmo()) != ZX_OK) {
+        return status;
+    }
+
+    zx_rights_t rights = ZX_RIGHTS_BASIC | ZX_RIGHT_MAP | ZX_RIGHTS_PROPERTY;
+    rights |= (flags & FDIO_MMAP_FLAG_READ) ? ZX_RIGHT_READ : 0;
+    rights |= (flags & FDIO_MMAP_FLAG_WRITE) ? ZX_RIGHT_WRITE : 0;
+    rights |= (flags & FDIO_MMAP_FLAG_EXEC) ? ZX_RIGHT_EXECUTE : 0;
+    if (flags & FDIO_MMAP_FLAG_PRIVATE) {
+        zx::vmo clone;
+        if ((status = vmo_.clone(ZX_VMO_CLONE_COPY_ON_WRITE, 0, vmo_size_, &clone)) != ZX_OK) {
+            return status;
+        }
+        return zx_handle_replace(clone.release(), rights, out);
+    }
+    // Writes land in vmo_ before they reach the disk, so a duplicate of it
+    // always holds the current contents of the file.
+    return zx_handle_duplicate(vmo_.get(), rights, out);
 }
 
 void VnodeMinfs::Sync(SyncCallback closure) {
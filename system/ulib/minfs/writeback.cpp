@@ -28,6 +28,48 @@ namespace minfs {
 
 #ifdef __Fuchsia__
 
+namespace {
+
+// The largest number of units of work written back with a single transaction.
+constexpr size_t kMaxWritebackBatch = 32;
+
+// Removes device blocks [dev_offset, dev_offset + length) from the requests in
+// |requests|, since a later request writes them again.
+void DropOverwritten(uint64_t dev_offset, uint64_t length,
+                     fbl::Vector<block_fifo_request_t>* requests) {
+    const uint64_t dev_end = dev_offset + length;
+    size_t i = 0;
+    while (i < requests->size()) {
+        block_fifo_request_t& request = (*requests)[i];
+        const uint64_t start = request.dev_offset;
+        const uint64_t end = request.dev_offset + request.length;
+        if (end <= dev_offset || dev_end <= start) {
+            i++;
+        } else if (dev_offset <= start && end <= dev_end) {
+            requests->erase(i);
+        } else if (start < dev_offset && dev_end < end) {
+            // Split the request around the blocks written again.
+            block_fifo_request_t tail = request;
+            tail.vmo_offset += dev_end - start;
+            tail.dev_offset = dev_end;
+            tail.length = static_cast<uint32_t>(end - dev_end);
+            request.length = static_cast<uint32_t>(dev_offset - start);
+            requests->insert(i + 1, tail);
+            i += 2;
+        } else if (start < dev_offset) {
+            request.length = static_cast<uint32_t>(dev_offset - start);
+            i++;
+        } else {
+            request.vmo_offset += dev_end - start;
+            request.dev_offset = dev_end;
+            request.length = static_cast<uint32_t>(end - dev_end);
+            i++;
+        }
+    }
+}
+
+} // namespace
+
 void WriteTxn::Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset,
                        uint64_t nblocks) {
     validate_vmo_size(vmo, static_cast<blk_t>(vmo_offset));
@@ -60,31 +102,40 @@ void WriteTxn::Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset
     requests_.push_back(fbl::move(request));
 }
 
-zx_status_t WriteTxn::Flush(zx_handle_t vmo, vmoid_t vmoid) {
-    ZX_DEBUG_ASSERT(vmo != ZX_HANDLE_INVALID);
+void WriteTxn::TakeRequests(vmoid_t vmoid, fbl::Vector<block_fifo_request_t>* out) {
     ZX_DEBUG_ASSERT(vmoid != VMOID_INVALID);
 
     // Update all the outgoing transactions to be in "disk blocks",
     // not "Minfs blocks".
-    block_fifo_request_t blk_reqs[requests_.size()];
     const uint32_t kDiskBlocksPerMinfsBlock = kMinfsBlockSize / bc_->DeviceBlockSize();
     for (size_t i = 0; i < requests_.size(); i++) {
-        blk_reqs[i].group = bc_->BlockGroupID();
-        blk_reqs[i].vmoid = vmoid;
-        blk_reqs[i].opcode = BLOCKIO_WRITE;
-        blk_reqs[i].vmo_offset = requests_[i].vmo_offset * kDiskBlocksPerMinfsBlock;
-        blk_reqs[i].dev_offset = requests_[i].dev_offset * kDiskBlocksPerMinfsBlock;
-        // TODO(ZX-2253): Remove this assertion.
+        uint64_t vmo_offset = requests_[i].vmo_offset * kDiskBlocksPerMinfsBlock;
+        uint64_t dev_offset = requests_[i].dev_offset * kDiskBlocksPerMinfsBlock;
         uint64_t length = requests_[i].length * kDiskBlocksPerMinfsBlock;
+        DropOverwritten(dev_offset, length, out);
+        if (out->size() > 0) {
+            block_fifo_request_t& last = (*out)[out->size() - 1];
+            if (last.vmo_offset + last.length == vmo_offset &&
+                last.dev_offset + last.length == dev_offset &&
+                last.length + length < UINT32_MAX) {
+                last.length += static_cast<uint32_t>(length);
+                continue;
+            }
+        }
+
+        block_fifo_request_t request;
+        request.group = bc_->BlockGroupID();
+        request.vmoid = vmoid;
+        request.opcode = BLOCKIO_WRITE;
+        request.vmo_offset = vmo_offset;
+        request.dev_offset = dev_offset;
+        // TODO(ZX-2253): Remove this assertion.
         ZX_ASSERT_MSG(length < UINT32_MAX, "Too many blocks");
-        blk_reqs[i].length = static_cast<uint32_t>(length);
+        request.length = static_cast<uint32_t>(length);
+        out->push_back(request);
     }
 
-    // Actually send the operations to the underlying block device.
-    zx_status_t status = bc_->Transaction(blk_reqs, requests_.size());
-
     requests_.reset();
-    return status;
 }
 
 size_t WriteTxn::BlkCount() const {
@@ -114,16 +165,11 @@ void WritebackWork::Reset() {
 }
 
 #ifdef __Fuchsia__
-// Returns the number of blocks of the writeback buffer that have been
-// consumed
-size_t WritebackWork::Complete(zx_handle_t vmo, vmoid_t vmoid) {
-    size_t blk_count = BlkCount();
-    zx_status_t status = Flush(vmo, vmoid);
+void WritebackWork::Finish(zx_status_t status) {
     if (closure_) {
         closure_(status);
     }
     Reset();
-    return blk_count;
 }
 
 void WritebackWork::SetClosure(SyncCallback closure) {
@@ -310,29 +356,65 @@ void WritebackBuffer::Enqueue(fbl::unique_ptr<WritebackWork> work) {
     cnd_signal(&consumer_cvar_);
 }
 
+void WritebackBuffer::GetMetrics(uint64_t* out_requests, uint64_t* out_blocks) {
+    fbl::AutoLock lock(&writeback_lock_);
+    *out_requests = fifo_requests_;
+    *out_blocks = blocks_written_;
+}
+
+size_t WritebackBuffer::CompleteBatch(fbl::unique_ptr<WritebackWork>* batch, size_t count,
+                                      size_t* out_requests) {
+    TRACE_DURATION("minfs", "WritebackBuffer::CompleteBatch", "count", count);
+    size_t blks_consumed = 0;
+    fbl::Vector<block_fifo_request_t> requests;
+    for (size_t i = 0; i < count; i++) {
+        blks_consumed += batch[i]->BlkCount();
+        batch[i]->TakeRequests(buffer_vmoid_, &requests);
+    }
+
+    // Actually send the operations to the underlying block device.
+    zx_status_t status = bc_->Transaction(requests.get(), requests.size());
+    for (size_t i = 0; i < count; i++) {
+        batch[i]->Finish(status);
+        TRACE_FLOW_END("minfs", "writeback", reinterpret_cast<trace_flow_id_t>(batch[i].get()));
+        batch[i] = nullptr;
+    }
+    *out_requests = requests.size();
+    return blks_consumed;
+}
+
 int WritebackBuffer::WritebackThread(void* arg) {
     WritebackBuffer* b = reinterpret_cast<WritebackBuffer*>(arg);
 
     b->writeback_lock_.Acquire();
     while (true) {
         while (!b->work_queue_.is_empty()) {
-            auto work = b->work_queue_.pop();
             TRACE_DURATION("minfs", "WritebackBuffer::WritebackThread");
 
-            // Stay unlocked while processing a unit of work
+            // Gather the queued work to write back together. Requests within a
+            // single transaction may complete in any order, so CompleteBatch only
+            // writes the latest copy of blocks which the batch writes more than once.
+            fbl::unique_ptr<WritebackWork> batch[kMaxWritebackBatch];
+            size_t count = 0;
+            while (!b->work_queue_.is_empty() && count < kMaxWritebackBatch) {
+                batch[count++] = b->work_queue_.pop();
+            }
+
+            // Stay unlocked while processing the batch.
             b->writeback_lock_.Release();
 
             // TODO(smklein): We could add additional validation that the blocks
             // in "work" are contiguous and in the range of [start_, len_) (including
             // wraparound).
-            size_t blks_consumed = work->Complete(b->buffer_->GetVmo(), b->buffer_vmoid_);
-            TRACE_FLOW_END("minfs", "writeback", reinterpret_cast<trace_flow_id_t>(work.get()));
-            work = nullptr;
+            size_t requests;
+            size_t blks_consumed = b->CompleteBatch(batch, count, &requests);
 
             // Relock before checking the state of the queue
             b->writeback_lock_.Acquire();
             b->start_ = (b->start_ + blks_consumed) % b->cap_;
             b->len_ -= blks_consumed;
+            b->fifo_requests_ += requests;
+            b->blocks_written_ += blks_consumed;
             cnd_signal(&b->producer_cvar_);
         }
 
@@ -0,0 +1,21 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <lib/zx/pager.h>
+
+#include <zircon/syscalls.h>
+
+namespace zx {
+
+zx_status_t pager::create(uint32_t options, pager* result) {
+    return zx_pager_create(options, result->reset_and_get_address());
+}
+
+zx_status_t pager::create_vmo(const port& port, uint64_t key, uint64_t size, uint32_t options,
+                              vmo* result) const {
+    return zx_pager_create_vmo(get(), port.get(), key, size, options,
+                               result->reset_and_get_address());
+}
+
+} // namespace zx
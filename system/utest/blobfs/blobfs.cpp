@@ -16,6 +16,7 @@
 #include <blobfs/lz4.h>
 #include <digest/digest.h>
 #include <digest/merkle-tree.h>
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/atomic.h>
 #include <fbl/auto_call.h>
@@ -1845,6 +1846,60 @@ static bool TestHugeBlobCompressible(BlobfsTest* blobfsTest) {
     END_HELPER;
 }
 
+// Reads chunks of a chunk compressed blob out of order, through both read()
+// and a mapping, so that each is paged in and verified on its own.
+static bool TestCompressedBlobRandomAccess(BlobfsTest* blobfsTest) {
+    BEGIN_HELPER;
+    fbl::unique_ptr<blob_info_t> info;
+
+    // Compressible, but different in every chunk.
+    const size_t chunk_size = blobfs::kCompressionChunkSize;
+    ASSERT_TRUE(GenerateBlob([](char* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            data[i] = static_cast<char>((i / 4096) * 7 + (i % 13 == 0));
+        }
+    }, 4 * chunk_size + 1234, &info));
+
+    fbl::unique_fd fd;
+    ASSERT_TRUE(MakeBlob(info.get(), &fd));
+    ASSERT_EQ(close(fd.release()), 0);
+
+    // Remount so that nothing of the blob is resident.
+    ASSERT_TRUE(blobfsTest->Remount());
+    fd.reset(open(info->path, O_RDONLY));
+    ASSERT_TRUE(fd, "Failed to-reopen blob");
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<char[]> buf(new (&ac) char[chunk_size]);
+    ASSERT_TRUE(ac.check());
+    const size_t offsets[] = {
+        3 * chunk_size + 17, chunk_size - 100, 4 * chunk_size, 0, 2 * chunk_size + 4096,
+    };
+    for (size_t offset : offsets) {
+        size_t length = fbl::min(chunk_size, info->size_data - offset);
+        ASSERT_EQ(pread(fd.get(), buf.get(), length, offset), static_cast<ssize_t>(length));
+        ASSERT_EQ(memcmp(buf.get(), &info->data[offset], length), 0,
+                  "Read data, but it was bad");
+    }
+
+    ASSERT_TRUE(blobfsTest->Remount());
+    fd.reset(open(info->path, O_RDONLY));
+    ASSERT_TRUE(fd, "Failed to-reopen blob");
+    void* addr = mmap(nullptr, info->size_data, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    ASSERT_NE(addr, MAP_FAILED, "Could not mmap blob");
+    const char* mapped = static_cast<const char*>(addr);
+    for (size_t offset : offsets) {
+        size_t length = fbl::min(chunk_size, info->size_data - offset);
+        ASSERT_EQ(memcmp(&mapped[offset], &info->data[offset], length), 0,
+                  "Mapped data was bad");
+    }
+    ASSERT_EQ(munmap(addr, info->size_data), 0);
+    ASSERT_EQ(close(fd.release()), 0);
+
+    ASSERT_EQ(unlink(info->path), 0);
+    END_HELPER;
+}
+
 static bool CreateUmountRemountLarge(BlobfsTest* blobfsTest) {
     BEGIN_HELPER;
     blob_list_t bl;
@@ -2259,28 +2314,92 @@ static bool TestCompressorBufferTooSmall(void) {
     BEGIN_TEST;
     blobfs::Compressor c;
 
-    // Pretend we're going to compress only one byte of data.
-    const size_t buf_size = c.BufferMax(1);
+    // Leave room for the seek table and the worst case of only one of the
+    // blob's two chunks.
+    const size_t blob_size = 2 * blobfs::kCompressionChunkSize;
+    const size_t buf_size = blobfs::ChunkTableSize(blob_size) + c.ChunkBufferMax();
     fbl::AllocChecker ac;
     fbl::unique_ptr<char[]> buf(new (&ac) char[buf_size]);
     EXPECT_EQ(ac.check(), true);
-    ASSERT_EQ(c.Initialize(buf.get(), buf_size), ZX_OK);
+    ASSERT_EQ(c.Initialize(buf.get(), buf_size, blob_size), ZX_OK);
 
-    // Keep compressing data until Compressor returns an error.
+    // Keep compressing incompressible data until Compressor returns an error,
+    // which must come from running out of buffer rather than out of blob.
     unsigned int seed = 0;
     zx_status_t result = ZX_OK;
-    for (;;) {
+    size_t compressed = 0;
+    for (; compressed < blob_size; compressed++) {
         char data = static_cast<char>(rand_r(&seed));
         result = c.Update(&data, 1);
         if (result != ZX_OK) {
             break;
         }
     }
+    ASSERT_LT(compressed, blob_size);
     ASSERT_EQ(result, ZX_ERR_IO_DATA_INTEGRITY);
 
     END_TEST;
 }
 
+// Ensure each chunk of a chunk compressed blob can be decompressed on its own.
+static bool TestChunkedCompression(void) {
+    BEGIN_TEST;
+    const size_t blob_size = 3 * blobfs::kCompressionChunkSize + 1234;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+    unsigned int seed = 0;
+    for (size_t i = 0; i < blob_size; i++) {
+        data[i] = static_cast<uint8_t>(rand_r(&seed) % 4);
+    }
+
+    blobfs::Compressor c;
+    const size_t buf_size = c.BufferMax(blob_size);
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[buf_size]);
+    ASSERT_TRUE(ac.check());
+    ASSERT_EQ(c.Initialize(buf.get(), buf_size, blob_size), ZX_OK);
+    // Feed the data in pieces which straddle chunk boundaries.
+    const size_t piece = blobfs::kCompressionChunkSize / 3;
+    for (size_t off = 0; off < blob_size; off += piece) {
+        ASSERT_EQ(c.Update(&data[off], fbl::min(piece, blob_size - off)), ZX_OK);
+    }
+    ASSERT_EQ(c.End(), ZX_OK);
+    ASSERT_LT(c.Size(), blob_size);
+
+    // Decompress the whole blob.
+    fbl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+    size_t target_size = blob_size;
+    size_t src_size = c.Size();
+    ASSERT_EQ(blobfs::Decompressor::DecompressBlob(blobfs::kBlobFlagChunkCompressed, out.get(),
+                                                   &target_size, buf.get(), &src_size), ZX_OK);
+    ASSERT_EQ(target_size, blob_size);
+    ASSERT_EQ(src_size, c.Size());
+    ASSERT_EQ(memcmp(out.get(), data.get(), blob_size), 0);
+
+    // Decompress only the last chunk.
+    ASSERT_EQ(blobfs::Decompressor::ValidateChunkTable(buf.get(), c.Size(), c.Size(),
+                                                       blob_size), ZX_OK);
+    uint64_t start, end;
+    blobfs::Decompressor::ChunkBounds(buf.get(), 3, &start, &end);
+    ASSERT_EQ(end, c.Size());
+    memset(out.get(), 0, blob_size);
+    target_size = 1234;
+    src_size = end - start;
+    ASSERT_EQ(blobfs::Decompressor::Decompress(out.get(), &target_size, &buf[start], &src_size),
+              ZX_OK);
+    ASSERT_EQ(target_size, 1234);
+    ASSERT_EQ(memcmp(out.get(), &data[3 * blobfs::kCompressionChunkSize], 1234), 0);
+
+    // A damaged seek table is rejected.
+    buf[sizeof(blobfs::blobfs_chunk_table_t)] ^= 0xff;
+    target_size = blob_size;
+    src_size = c.Size();
+    ASSERT_NE(blobfs::Decompressor::DecompressBlob(blobfs::kBlobFlagChunkCompressed, out.get(),
+                                                   &target_size, buf.get(), &src_size), ZX_OK);
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(blobfs_tests)
 RUN_TESTS(MEDIUM, TestBasic)
 RUN_TESTS(MEDIUM, TestNullBlob)
@@ -2313,6 +2432,7 @@ RUN_TESTS(MEDIUM, TestPartialWriteSleepRamdisk)
 RUN_TESTS(MEDIUM, TestAlternateWrite)
 RUN_TESTS(LARGE, TestHugeBlobRandom)
 RUN_TESTS(LARGE, TestHugeBlobCompressible)
+RUN_TESTS(MEDIUM, TestCompressedBlobRandomAccess)
 RUN_TESTS(LARGE, CreateUmountRemountLarge)
 RUN_TESTS(LARGE, CreateUmountRemountLargeMultithreaded)
 RUN_TESTS(LARGE, NoSpace)
@@ -2322,6 +2442,7 @@ RUN_TEST_FVM(MEDIUM, ResizePartition)
 RUN_TEST_FVM(MEDIUM, CorruptAtMount)
 RUN_TESTS(LARGE, CreateWriteReopen)
 RUN_TEST(TestCompressorBufferTooSmall);
+RUN_TEST(TestChunkedCompression);
 END_TEST_CASE(blobfs_tests)
 
 static void print_test_help(FILE* f) {
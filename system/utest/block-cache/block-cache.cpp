@@ -0,0 +1,203 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <fs-management/ramdisk.h>
+#include <unittest/unittest.h>
+#include <zircon/device/block.h>
+#include <zircon/device/device.h>
+#include <zircon/device/ramdisk.h>
+#include <zircon/syscalls.h>
+
+namespace {
+
+constexpr char kCacheDriverLib[] = "/boot/driver/block-cache.so";
+constexpr size_t kBlockSize = 512;
+
+// Fills |buf| with data which identifies each block by its |offset| and a |seed|.
+void Fill(uint8_t* buf, size_t len, off_t offset, uint8_t seed) {
+    for (size_t i = 0; i < len; ++i) {
+        buf[i] = static_cast<uint8_t>(((offset + i) / kBlockSize) ^ seed);
+    }
+}
+
+// A ramdisk with the block cache bound on top of it.  The ramdisk is destroyed, along with the
+// cache, when this goes out of scope.
+class CacheTest {
+public:
+    ~CacheTest() {
+        cache_.reset();
+        raw_.reset();
+        if (ramdisk_path_[0]) {
+            destroy_ramdisk(ramdisk_path_);
+        }
+    }
+
+    bool Create(uint64_t blk_count) {
+        BEGIN_HELPER;
+        ASSERT_EQ(create_ramdisk(kBlockSize, blk_count, ramdisk_path_), 0);
+        raw_.reset(open(ramdisk_path_, O_RDWR));
+        ASSERT_TRUE(raw_);
+        ASSERT_GE(ioctl_device_bind(raw_.get(), kCacheDriverLib, sizeof(kCacheDriverLib)), 0);
+
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/block-cache/block", ramdisk_path_);
+        ASSERT_EQ(wait_for_device(path, ZX_SEC(3)), ZX_OK);
+        cache_.reset(open(path, O_RDWR));
+        ASSERT_TRUE(cache_);
+        END_HELPER;
+    }
+
+    bool GetStats(block_cache_stats_t* stats) {
+        BEGIN_HELPER;
+        ASSERT_EQ(ioctl_block_get_cache_stats(cache_.get(), stats),
+                  static_cast<ssize_t>(sizeof(*stats)));
+        END_HELPER;
+    }
+
+    int raw() const { return raw_.get(); }
+    int cache() const { return cache_.get(); }
+
+private:
+    char ramdisk_path_[PATH_MAX] = {};
+    fbl::unique_fd raw_;
+    fbl::unique_fd cache_;
+};
+
+bool TestReadAfterWrite() {
+    BEGIN_TEST;
+    CacheTest test;
+    ASSERT_TRUE(test.Create(4096));
+
+    // Write across several lines, starting and ending partway through them.
+    const size_t len = 64 * 1024;
+    const off_t offset = 3 * kBlockSize;
+    fbl::unique_ptr<uint8_t[]> buf(new uint8_t[len]);
+    fbl::unique_ptr<uint8_t[]> out(new uint8_t[len]);
+    Fill(buf.get(), len, offset, 0x5a);
+    ASSERT_EQ(pwrite(test.cache(), buf.get(), len, offset), static_cast<ssize_t>(len));
+
+    block_cache_stats_t before;
+    ASSERT_TRUE(test.GetStats(&before));
+    EXPECT_GT(before.write_misses, 0);
+    EXPECT_GT(before.dirty_count, 0);
+
+    // The data comes back from the cache, without reading the device.
+    ASSERT_EQ(pread(test.cache(), out.get(), len, offset), static_cast<ssize_t>(len));
+    EXPECT_EQ(memcmp(buf.get(), out.get(), len), 0);
+
+    block_cache_stats_t after;
+    ASSERT_TRUE(test.GetStats(&after));
+    EXPECT_GT(after.read_hits, before.read_hits);
+    EXPECT_EQ(after.read_misses, before.read_misses);
+    END_TEST;
+}
+
+bool TestSyncWritesBack() {
+    BEGIN_TEST;
+    CacheTest test;
+    ASSERT_TRUE(test.Create(4096));
+
+    const size_t len = 16 * 1024;
+    const off_t offset = 7 * kBlockSize;
+    uint8_t buf[len];
+    uint8_t out[len];
+    Fill(buf, len, offset, 0xa5);
+    ASSERT_EQ(pwrite(test.cache(), buf, len, offset), static_cast<ssize_t>(len));
+
+    // Once synced, the data is on the device itself.
+    ASSERT_EQ(ioctl_device_sync(test.cache()), ZX_OK);
+    ASSERT_EQ(pread(test.raw(), out, len, offset), static_cast<ssize_t>(len));
+    EXPECT_EQ(memcmp(buf, out, len), 0);
+
+    block_cache_stats_t stats;
+    ASSERT_TRUE(test.GetStats(&stats));
+    EXPECT_EQ(stats.dirty_count, 0);
+    EXPECT_GT(stats.writebacks, 0);
+    END_TEST;
+}
+
+bool TestReadHitsSlowDevice() {
+    BEGIN_TEST;
+    CacheTest test;
+    ASSERT_TRUE(test.Create(4096));
+
+    // Make the device slow, so that hits are worth having.
+    zx_duration_t latency = ZX_MSEC(5);
+    ASSERT_GE(ioctl_ramdisk_set_latency(test.raw(), &latency), 0);
+
+    const size_t len = 4096;
+    uint8_t out[len];
+    ASSERT_EQ(pread(test.cache(), out, len, 0), static_cast<ssize_t>(len));
+    block_cache_stats_t first;
+    ASSERT_TRUE(test.GetStats(&first));
+    EXPECT_EQ(first.read_misses, 1);
+
+    zx_time_t start = zx_clock_get_monotonic();
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(pread(test.cache(), out, len, 0), static_cast<ssize_t>(len));
+    }
+    zx_duration_t elapsed = zx_clock_get_monotonic() - start;
+
+    block_cache_stats_t stats;
+    ASSERT_TRUE(test.GetStats(&stats));
+    EXPECT_EQ(stats.read_misses, 1);
+    EXPECT_EQ(stats.read_hits, first.read_hits + 10);
+    EXPECT_LT(elapsed, 10 * latency);
+    END_TEST;
+}
+
+bool TestEviction() {
+    BEGIN_TEST;
+    // Use a device several times larger than the default cache size.
+    const size_t dev_size = 64 << 20;
+    CacheTest test;
+    ASSERT_TRUE(test.Create(dev_size / kBlockSize));
+    block_cache_stats_t stats;
+    ASSERT_TRUE(test.GetStats(&stats));
+    ASSERT_LT(stats.line_count * stats.line_size, dev_size, "cache is too large for this test");
+
+    // Fill the device through the cache, forcing dirty lines out as it goes.
+    const size_t chunk = 1 << 20;
+    fbl::unique_ptr<uint8_t[]> buf(new uint8_t[chunk]);
+    fbl::unique_ptr<uint8_t[]> out(new uint8_t[chunk]);
+    for (off_t off = 0; off < static_cast<off_t>(dev_size); off += chunk) {
+        Fill(buf.get(), chunk, off, 0x3c);
+        ASSERT_EQ(pwrite(test.cache(), buf.get(), chunk, off), static_cast<ssize_t>(chunk));
+    }
+    ASSERT_TRUE(test.GetStats(&stats));
+    EXPECT_GT(stats.writebacks, 0);
+    EXPECT_LE(stats.dirty_count, stats.line_count);
+
+    // Everything reads back through the cache, and from the device once synced.
+    for (off_t off = 0; off < static_cast<off_t>(dev_size); off += chunk) {
+        Fill(buf.get(), chunk, off, 0x3c);
+        ASSERT_EQ(pread(test.cache(), out.get(), chunk, off), static_cast<ssize_t>(chunk));
+        ASSERT_EQ(memcmp(buf.get(), out.get(), chunk), 0);
+    }
+    ASSERT_EQ(ioctl_device_sync(test.cache()), ZX_OK);
+    for (off_t off = 0; off < static_cast<off_t>(dev_size); off += chunk) {
+        Fill(buf.get(), chunk, off, 0x3c);
+        ASSERT_EQ(pread(test.raw(), out.get(), chunk, off), static_cast<ssize_t>(chunk));
+        ASSERT_EQ(memcmp(buf.get(), out.get(), chunk), 0);
+    }
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(BlockCacheTest)
+RUN_TEST(TestReadAfterWrite)
+RUN_TEST(TestSyncWritesBack)
+RUN_TEST(TestReadHitsSlowDevice)
+RUN_TEST_MEDIUM(TestEviction)
+END_TEST_CASE(BlockCacheTest)
@@ -73,6 +73,19 @@ bool task_stats_smoke() {
     END_TEST;
 }
 
+// Tests that ZX_INFO_TASK_VM_STATS seems to work.
+bool task_vm_stats_smoke() {
+    BEGIN_TEST;
+    zx_info_task_vm_stats_t info;
+    ASSERT_EQ(zx_object_get_info(zx_process_self(), ZX_INFO_TASK_VM_STATS,
+                                 &info, sizeof(info), nullptr, nullptr),
+              ZX_OK);
+
+    // A running process has at least its top level page table.
+    ASSERT_GT(info.mem_page_table_bytes, 0u);
+    END_TEST;
+}
+
 // Structs to keep track of VMARs/mappings in the test child process.
 typedef struct test_mapping {
     uintptr_t base;
@@ -960,6 +973,11 @@ RUN_SINGLE_ENTRY_TESTS(ZX_INFO_TASK_STATS, zx_info_task_stats_t, zx_process_self
 RUN_TEST((wrong_handle_type_fails<ZX_INFO_TASK_STATS, zx_info_task_stats_t, get_test_job>));
 RUN_TEST((wrong_handle_type_fails<ZX_INFO_TASK_STATS, zx_info_task_stats_t, zx_thread_self>));
 
+RUN_TEST(task_vm_stats_smoke);
+RUN_SINGLE_ENTRY_TESTS(ZX_INFO_TASK_VM_STATS, zx_info_task_vm_stats_t, zx_process_self);
+RUN_TEST((wrong_handle_type_fails<ZX_INFO_TASK_VM_STATS, zx_info_task_vm_stats_t, get_test_job>));
+RUN_TEST((wrong_handle_type_fails<ZX_INFO_TASK_VM_STATS, zx_info_task_vm_stats_t, zx_thread_self>));
+
 RUN_TEST(process_maps_smoke);
 RUN_MULTI_ENTRY_TESTS(ZX_INFO_PROCESS_MAPS, zx_info_maps_t, get_test_process);
 RUN_TEST((self_fails<ZX_INFO_PROCESS_MAPS, zx_info_maps_t>))
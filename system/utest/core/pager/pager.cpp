@@ -0,0 +1,237 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+#include <threads.h>
+
+#include <zircon/process.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/port.h>
+
+#include <unittest/unittest.h>
+
+namespace {
+
+constexpr uint64_t kKey = 0x1234;
+constexpr size_t kVmoSize = 4 * PAGE_SIZE;
+
+struct ReadArgs {
+    zx_handle_t vmo;
+    uint64_t offset;
+    uint8_t data;
+    zx_status_t status;
+};
+
+int read_thread(void* arg) {
+    auto args = static_cast<ReadArgs*>(arg);
+    args->status = zx_vmo_read(args->vmo, &args->data, args->offset, sizeof(args->data));
+    return 0;
+}
+
+// Waits for a page request for |vmo| and checks that it is for the page at |offset|.
+bool wait_for_request(zx_handle_t port, uint64_t offset) {
+    BEGIN_HELPER;
+    zx_port_packet_t packet;
+    ASSERT_EQ(zx_port_wait(port, zx_deadline_after(ZX_SEC(10)), &packet), ZX_OK, "");
+    EXPECT_EQ(packet.key, kKey, "");
+    EXPECT_EQ(packet.type, ZX_PKT_TYPE_PAGE_REQUEST, "");
+    EXPECT_EQ(packet.page_request.command, ZX_PAGER_VMO_READ, "");
+    EXPECT_EQ(packet.page_request.offset, offset, "");
+    EXPECT_EQ(packet.page_request.length, PAGE_SIZE, "");
+    END_HELPER;
+}
+
+// Supplies the page at |offset| of |vmo|, with every byte set to |val|.
+bool supply_page(zx_handle_t pager, zx_handle_t vmo, uint64_t offset, uint8_t val) {
+    BEGIN_HELPER;
+    zx_handle_t aux;
+    ASSERT_EQ(zx_vmo_create(PAGE_SIZE, 0, &aux), ZX_OK, "");
+    uint8_t data[PAGE_SIZE];
+    memset(data, val, sizeof(data));
+    ASSERT_EQ(zx_vmo_write(aux, data, 0, sizeof(data)), ZX_OK, "");
+    EXPECT_EQ(zx_pager_supply_pages(pager, vmo, offset, PAGE_SIZE, aux, 0), ZX_OK, "");
+    zx_handle_close(aux);
+    END_HELPER;
+}
+
+bool create_test() {
+    BEGIN_TEST;
+    zx_handle_t pager, port, vmo;
+    ASSERT_EQ(zx_pager_create(0, &pager), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK, "");
+
+    EXPECT_EQ(zx_pager_create(1, &pager), ZX_ERR_INVALID_ARGS, "");
+    EXPECT_EQ(zx_pager_create_vmo(pager, port, kKey, kVmoSize, 1, &vmo), ZX_ERR_INVALID_ARGS, "");
+    EXPECT_EQ(zx_pager_create_vmo(port, port, kKey, kVmoSize, 0, &vmo), ZX_ERR_WRONG_TYPE, "");
+
+    ASSERT_EQ(zx_pager_create_vmo(pager, port, kKey, kVmoSize, 0, &vmo), ZX_OK, "");
+    uint64_t size;
+    EXPECT_EQ(zx_vmo_get_size(vmo, &size), ZX_OK, "");
+    EXPECT_EQ(size, kVmoSize, "");
+    EXPECT_EQ(zx_vmo_set_size(vmo, 2 * kVmoSize), ZX_ERR_UNAVAILABLE, "");
+    EXPECT_EQ(zx_vmo_op_range(vmo, ZX_VMO_OP_COMMIT, 0, kVmoSize, nullptr, 0),
+              ZX_ERR_NOT_SUPPORTED, "");
+
+    zx_handle_close(vmo);
+    zx_handle_close(port);
+    zx_handle_close(pager);
+    END_TEST;
+}
+
+bool read_supply_test() {
+    BEGIN_TEST;
+    zx_handle_t pager, port, vmo;
+    ASSERT_EQ(zx_pager_create(0, &pager), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK, "");
+    ASSERT_EQ(zx_pager_create_vmo(pager, port, kKey, kVmoSize, 0, &vmo), ZX_OK, "");
+
+    ReadArgs args = {vmo, PAGE_SIZE + 3, 0, ZX_ERR_INTERNAL};
+    thrd_t thread;
+    ASSERT_EQ(thrd_create(&thread, read_thread, &args), thrd_success, "");
+
+    ASSERT_TRUE(wait_for_request(port, PAGE_SIZE), "");
+    ASSERT_TRUE(supply_page(pager, vmo, PAGE_SIZE, 0xab), "");
+    thrd_join(thread, nullptr);
+
+    EXPECT_EQ(args.status, ZX_OK, "");
+    EXPECT_EQ(args.data, 0xab, "");
+
+    // Supplied pages are read without another request.
+    uint8_t data = 0;
+    EXPECT_EQ(zx_vmo_read(vmo, &data, PAGE_SIZE, sizeof(data)), ZX_OK, "");
+    EXPECT_EQ(data, 0xab, "");
+    zx_port_packet_t packet;
+    EXPECT_EQ(zx_port_wait(port, 0, &packet), ZX_ERR_TIMED_OUT, "");
+
+    zx_handle_close(vmo);
+    zx_handle_close(port);
+    zx_handle_close(pager);
+    END_TEST;
+}
+
+bool map_fault_test() {
+    BEGIN_TEST;
+    zx_handle_t pager, port, vmo;
+    ASSERT_EQ(zx_pager_create(0, &pager), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK, "");
+    ASSERT_EQ(zx_pager_create_vmo(pager, port, kKey, kVmoSize, 0, &vmo), ZX_OK, "");
+
+    uintptr_t addr;
+    ASSERT_EQ(zx_vmar_map(zx_vmar_root_self(), 0, vmo, 0, kVmoSize, ZX_VM_PERM_READ, &addr),
+              ZX_OK, "");
+
+    // Fault on the mapping from another thread while we act as the pager.
+    auto fault_thread = [](void* arg) -> int {
+        return *static_cast<volatile uint8_t*>(arg);
+    };
+    thrd_t thread;
+    ASSERT_EQ(thrd_create(&thread, fault_thread, reinterpret_cast<void*>(addr + 2 * PAGE_SIZE)),
+              thrd_success, "");
+
+    ASSERT_TRUE(wait_for_request(port, 2 * PAGE_SIZE), "");
+    ASSERT_TRUE(supply_page(pager, vmo, 2 * PAGE_SIZE, 0x42), "");
+    int result;
+    thrd_join(thread, &result);
+    EXPECT_EQ(result, 0x42, "");
+
+    EXPECT_EQ(zx_vmar_unmap(zx_vmar_root_self(), addr, kVmoSize), ZX_OK, "");
+    zx_handle_close(vmo);
+    zx_handle_close(port);
+    zx_handle_close(pager);
+    END_TEST;
+}
+
+bool detach_test() {
+    BEGIN_TEST;
+    zx_handle_t pager, port, vmo;
+    ASSERT_EQ(zx_pager_create(0, &pager), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK, "");
+    ASSERT_EQ(zx_pager_create_vmo(pager, port, kKey, kVmoSize, 0, &vmo), ZX_OK, "");
+
+    ReadArgs args = {vmo, 0, 0, ZX_ERR_INTERNAL};
+    thrd_t thread;
+    ASSERT_EQ(thrd_create(&thread, read_thread, &args), thrd_success, "");
+
+    // Detaching fails the outstanding read, and any later ones.
+    ASSERT_TRUE(wait_for_request(port, 0), "");
+    EXPECT_EQ(zx_pager_detach_vmo(pager, vmo), ZX_OK, "");
+    thrd_join(thread, nullptr);
+    EXPECT_EQ(args.status, ZX_ERR_BAD_STATE, "");
+
+    uint8_t data;
+    EXPECT_EQ(zx_vmo_read(vmo, &data, PAGE_SIZE, sizeof(data)), ZX_ERR_BAD_STATE, "");
+    EXPECT_EQ(zx_pager_detach_vmo(pager, vmo), ZX_ERR_INVALID_ARGS, "");
+
+    zx_handle_close(vmo);
+    zx_handle_close(port);
+    zx_handle_close(pager);
+    END_TEST;
+}
+
+bool close_pager_test() {
+    BEGIN_TEST;
+    zx_handle_t pager, port, vmo;
+    ASSERT_EQ(zx_pager_create(0, &pager), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK, "");
+    ASSERT_EQ(zx_pager_create_vmo(pager, port, kKey, kVmoSize, 0, &vmo), ZX_OK, "");
+
+    // With the pager gone nothing can supply the pages.
+    zx_handle_close(pager);
+    uint8_t data;
+    EXPECT_EQ(zx_vmo_read(vmo, &data, 0, sizeof(data)), ZX_ERR_BAD_STATE, "");
+
+    zx_handle_close(vmo);
+    zx_handle_close(port);
+    END_TEST;
+}
+
+bool rights_test() {
+    BEGIN_TEST;
+    zx_handle_t pager, port, vmo;
+    ASSERT_EQ(zx_pager_create(0, &pager), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK, "");
+    ASSERT_EQ(zx_pager_create_vmo(pager, port, kKey, kVmoSize, 0, &vmo), ZX_OK, "");
+
+    zx_handle_t ro_pager, ro_vmo, aux, new_vmo;
+    ASSERT_EQ(zx_handle_duplicate(pager, ZX_RIGHTS_BASIC | ZX_RIGHT_READ, &ro_pager), ZX_OK, "");
+    ASSERT_EQ(zx_handle_duplicate(vmo, ZX_RIGHTS_BASIC | ZX_RIGHT_READ, &ro_vmo), ZX_OK, "");
+    ASSERT_EQ(zx_vmo_create(PAGE_SIZE, 0, &aux), ZX_OK, "");
+
+    // Only the holder of a writable pager handle may act as the pager, and
+    // only on vmos it could write itself.
+    EXPECT_EQ(zx_pager_create_vmo(ro_pager, port, kKey, kVmoSize, 0, &new_vmo),
+              ZX_ERR_ACCESS_DENIED, "");
+    EXPECT_EQ(zx_pager_supply_pages(ro_pager, vmo, 0, PAGE_SIZE, aux, 0),
+              ZX_ERR_ACCESS_DENIED, "");
+    EXPECT_EQ(zx_pager_supply_pages(pager, ro_vmo, 0, PAGE_SIZE, aux, 0),
+              ZX_ERR_ACCESS_DENIED, "");
+    EXPECT_EQ(zx_pager_detach_vmo(ro_pager, vmo), ZX_ERR_ACCESS_DENIED, "");
+    EXPECT_EQ(zx_pager_detach_vmo(pager, ro_vmo), ZX_ERR_ACCESS_DENIED, "");
+    EXPECT_EQ(zx_pager_detach_vmo(pager, vmo), ZX_OK, "");
+
+    zx_handle_close(aux);
+    zx_handle_close(ro_vmo);
+    zx_handle_close(ro_pager);
+    zx_handle_close(vmo);
+    zx_handle_close(port);
+    zx_handle_close(pager);
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(pager_tests)
+RUN_TEST(create_test)
+RUN_TEST(read_supply_test)
+RUN_TEST(map_fault_test)
+RUN_TEST(detach_test)
+RUN_TEST(close_pager_test)
+RUN_TEST(rights_test)
+END_TEST_CASE(pager_tests)
+
+#ifndef BUILD_COMBINED_TESTS
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
+#endif
@@ -8,6 +8,7 @@
 
 #include <crypto/bytes.h>
 #include <crypto/cipher.h>
+#include <fbl/algorithm.h>
 #include <unittest/unittest.h>
 #include <zircon/errors.h>
 #include <zircon/types.h>
@@ -348,6 +349,54 @@ bool TestDecryptRandomAccess(Cipher::Algorithm cipher) {
 }
 DEFINE_EACH(TestDecryptRandomAccess)
 
+// Checks that random access transforms of many sectors, including a partial last sector, match the
+// stream transform of each sector with its tweak computed by hand.  Stream mode passes the whole
+// buffer to BoringSSL's EVP cipher, while random access AES-XTS may use the AES-NI routines.
+bool TestRandomAccessMatchesStream(Cipher::Algorithm cipher) {
+    BEGIN_TEST;
+    const size_t kSectors = 8;
+    const size_t kTail = 64;
+    const uint64_t kFirst = 3;
+    Secret key;
+    Bytes iv;
+    ASSERT_OK(GenerateKeyMaterial(cipher, &key, &iv));
+    uint64_t iv0;
+    memcpy(&iv0, iv.get(), sizeof(iv0));
+
+    for (size_t sector = 512; sector <= PAGE_SIZE; sector *= 8) {
+        size_t len = sector * kSectors + kTail;
+        Bytes ptext, ctext, result;
+        ASSERT_OK(ptext.Randomize(len));
+        ASSERT_OK(ctext.Resize(len));
+        ASSERT_OK(result.Resize(len));
+
+        Cipher encrypt;
+        ASSERT_OK(encrypt.InitEncrypt(cipher, key, iv, sector));
+        EXPECT_OK(encrypt.Encrypt(ptext.get(), kFirst * sector, len, ctext.get()));
+
+        for (size_t off = 0; off < len; off += sector) {
+            size_t chunk = fbl::min(sector, len - off);
+            uint64_t tweak = iv0 + kFirst + off / sector;
+            Bytes sector_iv;
+            ASSERT_OK(sector_iv.Copy(iv));
+            memcpy(sector_iv.get(), &tweak, sizeof(tweak));
+
+            Cipher stream;
+            ASSERT_OK(stream.InitEncrypt(cipher, key, sector_iv));
+            ASSERT_OK(stream.Encrypt(ptext.get() + off, chunk, result.get() + off));
+            EXPECT_EQ(memcmp(ctext.get() + off, result.get() + off, chunk), 0);
+        }
+
+        Cipher decrypt;
+        ASSERT_OK(decrypt.InitDecrypt(cipher, key, iv, sector));
+        EXPECT_OK(decrypt.Decrypt(ctext.get(), kFirst * sector, len, result.get()));
+        EXPECT_EQ(memcmp(ptext.get(), result.get(), len), 0);
+    }
+
+    END_TEST;
+}
+DEFINE_EACH(TestRandomAccessMatchesStream)
+
 // The following tests are taken from NIST's SP 800-38E.  The non-byte aligned tests vectors are
 // omitted; as they are not supported.  Of those remaining, every tenth is selected up to number 200
 // as a representative sample.
@@ -632,6 +681,73 @@ bool TestSP800_38E_TC200(void) {
 }
 // clang-format on
 
+// The following tests are taken from IEEE 1619-2007, Annex B.  Unlike the vectors above, their data
+// units are a whole 512 byte sector, and the data unit sequence number is given as an offset to the
+// random access transform rather than as the IV.  Each vector is checked alone and as the middle
+// sector of a three sector transform.
+bool TestIEEE1619_DataUnit(uint64_t sequence, const char* xctext) {
+    BEGIN_TEST;
+    const size_t kSector = 512;
+    Secret key;
+    Bytes iv, ptext, ctext;
+    ASSERT_OK(HexToSecret(
+        "2718281828459045235360287471352662497757247093699959574966967627"
+        "3141592653589793238462643383279502884197169399375105820974944592", &key));
+    ASSERT_OK(iv.Resize(16));
+    ASSERT_OK(ptext.Resize(kSector * 3));
+    for (size_t i = 0; i < ptext.len(); ++i) {
+        ptext[i] = static_cast<uint8_t>(i);
+    }
+    ASSERT_OK(HexToBytes(xctext, &ctext));
+    ASSERT_EQ(ctext.len(), kSector);
+    uint8_t tmp[kSector * 3];
+
+    Cipher encrypt;
+    ASSERT_OK(encrypt.InitEncrypt(Cipher::kAES256_XTS, key, iv, kSector));
+    EXPECT_OK(encrypt.Encrypt(ptext.get(), sequence * kSector, kSector, tmp));
+    EXPECT_EQ(memcmp(tmp, ctext.get(), kSector), 0);
+    EXPECT_OK(encrypt.Encrypt(ptext.get(), (sequence - 1) * kSector, kSector * 3, tmp));
+    EXPECT_EQ(memcmp(tmp + kSector, ctext.get(), kSector), 0);
+
+    Cipher decrypt;
+    ASSERT_OK(decrypt.InitDecrypt(Cipher::kAES256_XTS, key, iv, kSector));
+    EXPECT_OK(decrypt.Decrypt(ctext.get(), sequence * kSector, kSector, tmp));
+    EXPECT_EQ(memcmp(tmp, ptext.get(), kSector), 0);
+    END_TEST;
+}
+
+// clang-format off
+bool TestIEEE1619_Vector10(void) {
+    return TestIEEE1619_DataUnit(0xff,
+        "1c3b3a102f770386e4836c99e370cf9bea00803f5e482357a4ae12d414a3e63b5d31e276f8fe4a8d66b317f9ac683f44"
+        "680a86ac35adfc3345befecb4bb188fd5776926c49a3095eb108fd1098baec70aaa66999a72a82f27d848b21d4a741b0"
+        "c5cd4d5fff9dac89aeba122961d03a757123e9870f8acf1000020887891429ca2a3e7a7d7df7b10355165c8b9a6d0a7d"
+        "e8b062c4500dc4cd120c0f7418dae3d0b5781c34803fa75421c790dfe1de1834f280d7667b327f6c8cd7557e12ac3a0f"
+        "93ec05c52e0493ef31a12d3d9260f79a289d6a379bc70c50841473d1a8cc81ec583e9645e07b8d9670655ba5bbcfecc6"
+        "dc3966380ad8fecb17b6ba02469a020a84e18e8f84252070c13e9f1f289be54fbc481457778f616015e1327a02b140f1"
+        "505eb309326d68378f8374595c849d84f4c333ec4423885143cb47bd71c5edae9be69a2ffeceb1bec9de244fbe15992b"
+        "11b77c040f12bd8f6a975a44a0f90c29a9abc3d4d893927284c58754cce294529f8614dcd2aba991925fedc4ae74ffac"
+        "6e333b93eb4aff0479da9a410e4450e0dd7ae4c6e2910900575da401fc07059f645e8b7e9bfdef33943054ff84011493"
+        "c27b3429eaedb4ed5376441a77ed43851ad77f16f541dfd269d50d6a5f14fb0aab1cbb4c1550be97f7ab4066193c4caa"
+        "773dad38014bd2092fa755c824bb5e54c4f36ffda9fcea70b9c6e693e148c151");
+}
+
+bool TestIEEE1619_Vector11(void) {
+    return TestIEEE1619_DataUnit(0xffff,
+        "77a31251618a15e6b92d1d66dffe7b50b50bad552305ba0217a610688eff7e11e1d0225438e093242d6db274fde801d4"
+        "cae06f2092c728b2478559df58e837c2469ee4a4fa794e4bbc7f39bc026e3cb72c33b0888f25b4acf56a2a9804f1ce6d"
+        "3d6e1dc6ca181d4b546179d55544aa7760c40d06741539c7e3cd9d2f6650b2013fd0eeb8c2b8e3d8d240ccae2d4c9832"
+        "0a7442e1c8d75a42d6e6cfa4c2eca1798d158c7aecdf82490f24bb9b38e108bcda12c3faf9a21141c3613b58367f922a"
+        "aa26cd22f23d708dae699ad7cb40a8ad0b6e2784973dcb605684c08b8d6998c69aac049921871ebb65301a4619ca80ec"
+        "b485a31d744223ce8ddc2394828d6a80470c092f5ba413c3378fa6054255c6f9df4495862bbb3287681f931b687c888a"
+        "bf844dfc8fc28331e579928cd12bd2390ae123cf03818d14dedde5c0c24c8ab018bfca75ca096f2d531f3d1619e785f1"
+        "ada437cab92e980558b3dce1474afb75bfedbf8ff54cb2618e0244c9ac0d3c66fb51598cd2db11f9be39791abe447c63"
+        "094f7c453b7ff87cb5bb36b7c79efb0872d17058b83b15ab0866ad8a58656c5a7e20dbdf308b2461d97c0ec0024a2715"
+        "055249cf3b478ddd4740de654f75ca686e0d7345c69ed50cdc2a8b332b1f8824108ac937eb050585608ee734097fc090"
+        "54fbff89eeaeea791f4a7ab1f9868294a4f9e27b42af8100cb9d59cef9645803");
+}
+// clang-format on
+
 BEGIN_TEST_CASE(CipherTest)
 RUN_TEST(TestGetLengths_Uninitialized)
 RUN_EACH(TestGetLengths)
@@ -643,6 +759,7 @@ RUN_EACH(TestEncryptStream)
 RUN_EACH(TestEncryptRandomAccess)
 RUN_EACH(TestDecryptStream)
 RUN_EACH(TestDecryptRandomAccess)
+RUN_EACH(TestRandomAccessMatchesStream)
 RUN_TEST(TestSP800_38A_F5)
 RUN_TEST(TestSP800_38E_TC010)
 RUN_TEST(TestSP800_38E_TC020)
@@ -664,6 +781,8 @@ RUN_TEST(TestSP800_38E_TC170)
 RUN_TEST(TestSP800_38E_TC180)
 RUN_TEST(TestSP800_38E_TC190)
 RUN_TEST(TestSP800_38E_TC200)
+RUN_TEST(TestIEEE1619_Vector10)
+RUN_TEST(TestIEEE1619_Vector11)
 END_TEST_CASE(CipherTest)
 
 } // namespace
@@ -5,8 +5,10 @@
 #include <digest/merkle-tree.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <digest/digest.h>
+#include <fbl/unique_ptr.h>
 #include <zircon/assert.h>
 #include <zircon/status.h>
 #include <unittest/unittest.h>
@@ -626,6 +628,63 @@ bool VerifyBadLeaves(void) {
     END_TEST;
 }
 
+bool VerifyRange(void) {
+    BEGIN_TEST_WITH_RC;
+    size_t tree_len = MerkleTree::GetTreeLength(kUnalignedLarge);
+    Digest digest;
+    ASSERT_OK(MerkleTree::Create(gData, kUnalignedLarge, gTree, tree_len, &digest));
+    // Only the range itself is passed in, at the start of its own buffer.
+    size_t offset = kLarge - kNodeSize;
+    size_t length = kUnalignedLarge - offset;
+    fbl::unique_ptr<uint8_t[]> range(new uint8_t[length]);
+    memcpy(range.get(), gData + offset, length);
+    ASSERT_OK(MerkleTree::VerifyRange(range.get(), kUnalignedLarge, gTree, tree_len,
+                                      offset, length, digest));
+    ASSERT_OK(MerkleTree::VerifyRange(range.get(), kUnalignedLarge, gTree, tree_len,
+                                      offset, kNodeSize, digest));
+    ASSERT_ERR(ZX_ERR_INVALID_ARGS,
+               MerkleTree::VerifyRange(range.get() + 1, kUnalignedLarge, gTree, tree_len,
+                                       offset + 1, kNodeSize, digest));
+    ASSERT_ERR(ZX_ERR_INVALID_ARGS,
+               MerkleTree::VerifyRange(range.get(), kUnalignedLarge, gTree, tree_len,
+                                       offset, kNodeSize + 1, digest));
+    ASSERT_ERR(ZX_ERR_OUT_OF_RANGE,
+               MerkleTree::VerifyRange(range.get(), kUnalignedLarge, gTree, tree_len,
+                                       offset, length + 1, digest));
+    range[length - 1] ^= 1;
+    ASSERT_ERR(ZX_ERR_IO_DATA_INTEGRITY,
+               MerkleTree::VerifyRange(range.get(), kUnalignedLarge, gTree, tree_len,
+                                       offset, length, digest));
+    END_TEST;
+}
+
+bool HashNodesMatchesCreate(void) {
+    BEGIN_TEST_WITH_RC;
+    // Large enough that the bottom level is hashed on several threads.
+    size_t tree_len = MerkleTree::GetTreeLength(kUnalignedLarge);
+    Digest digest;
+    ASSERT_OK(MerkleTree::Create(gData, kUnalignedLarge, gTree, tree_len, &digest));
+    size_t nodes = (kUnalignedLarge + kNodeSize - 1) / kNodeSize;
+    fbl::unique_ptr<uint8_t[]> digests(new uint8_t[nodes * Digest::kLength]);
+    ASSERT_OK(MerkleTree::HashNodes(gData, kUnalignedLarge, 0, 0, nodes, digests.get()));
+    ASSERT_EQ(memcmp(digests.get(), gTree, nodes * Digest::kLength), 0, "Mismatched digests");
+    // Any subrange of the level hashes to the same digests.
+    ASSERT_OK(MerkleTree::HashNodes(gData, kUnalignedLarge, 0, nodes - 3, 3, digests.get()));
+    ASSERT_EQ(memcmp(digests.get(), gTree + (nodes - 3) * Digest::kLength,
+                     3 * Digest::kLength), 0, "Mismatched digests");
+    END_TEST;
+}
+
+bool HashNodesOutOfBounds(void) {
+    BEGIN_TEST_WITH_RC;
+    uint8_t digests[2 * Digest::kLength];
+    ASSERT_ERR(ZX_ERR_OUT_OF_RANGE,
+               MerkleTree::HashNodes(gData, kSmall, 0, (kSmall / kNodeSize) - 1, 2, digests));
+    ASSERT_ERR(ZX_ERR_INVALID_ARGS,
+               MerkleTree::HashNodes(gData, kSmall, 0, 0, 1, nullptr));
+    END_TEST;
+}
+
 bool CreateAndVerifyHugePRNGData(void) {
     BEGIN_TEST_WITH_RC;
     Digest digest;
@@ -739,5 +798,8 @@ RUN_TEST(VerifyGoodPartOfBadTree)
 RUN_TEST(VerifyBadTree)
 RUN_TEST(VerifyGoodPartOfBadLeaves)
 RUN_TEST(VerifyBadLeaves)
+RUN_TEST(VerifyRange)
+RUN_TEST(HashNodesMatchesCreate)
+RUN_TEST(HashNodesOutOfBounds)
 RUN_TEST(CreateAndVerifyHugePRNGData)
 END_TEST_CASE(MerkleTreeTests)
@@ -2,10 +2,13 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <fbl/function.h>
 #include <fbl/string.h>
@@ -156,6 +159,149 @@ private:
     fbl::StringBuffer<fs_test_utils::kPathSize> path_;
 };
 
+fbl::String GetLargeDirPath(const Fixture& fixture) {
+    return fbl::StringPrintf("%s/largedir", fixture.fs_path().c_str());
+}
+
+// Fills a single directory with one empty file per iteration.
+bool CreateLargeDir(perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::String dir_path = GetLargeDirPath(*fixture);
+    ASSERT_EQ(mkdir(dir_path.c_str(), 0666), 0);
+    PathComponentGen component;
+    state->DeclareStep("create");
+
+    while (state->KeepRunning()) {
+        fbl::String path = fbl::StringPrintf("%s%s", dir_path.c_str(), component.current);
+        fbl::unique_fd fd(open(path.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0644));
+        ASSERT_TRUE(fd);
+        component.Next();
+    }
+    END_HELPER;
+}
+
+// Returns the next entry of |dir| other than "." and "..", or nullptr at the
+// end of the directory.
+struct dirent* NextFileEntry(DIR* dir) {
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            break;
+        }
+    }
+    return entry;
+}
+
+// Lists the directory filled by CreateLargeDir the way "ls -l" does: each
+// iteration reads the next entry and stats it, starting over at the end.
+bool ListLargeDir(perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    DIR* dir = opendir(GetLargeDirPath(*fixture).c_str());
+    ASSERT_NONNULL(dir);
+    state->DeclareStep("readdir");
+    state->DeclareStep("stat");
+
+    bool listed = true;
+    while (listed && state->KeepRunning()) {
+        struct dirent* entry = NextFileEntry(dir);
+        if (entry == nullptr) {
+            rewinddir(dir);
+            entry = NextFileEntry(dir);
+        }
+        state->NextStep();
+        struct stat buff;
+        listed = entry != nullptr && fstatat(dirfd(dir), entry->d_name, &buff, 0) == 0;
+    }
+    closedir(dir);
+    ASSERT_TRUE(listed);
+    END_HELPER;
+}
+
+// Looks up each file created by CreateLargeDir by name, in creation order.
+bool LookupLargeDir(perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::String dir_path = GetLargeDirPath(*fixture);
+    PathComponentGen component;
+    state->DeclareStep("stat");
+
+    while (state->KeepRunning()) {
+        fbl::String path = fbl::StringPrintf("%s%s", dir_path.c_str(), component.current);
+        struct stat buff;
+        ASSERT_EQ(stat(path.c_str(), &buff), 0);
+        component.Next();
+    }
+    END_HELPER;
+}
+
+// The hot file tests read a small file over and over, in blocks of
+// kHotFileBlockSize bytes.
+constexpr size_t kHotFileSize = 64 * 1024;
+constexpr size_t kHotFileBlockSize = 4 * 1024;
+constexpr size_t kHotFileBlocks = kHotFileSize / kHotFileBlockSize;
+
+fbl::String GetHotFilePath(const Fixture& fixture) {
+    return fbl::StringPrintf("%s/hotfile", fixture.fs_path().c_str());
+}
+
+// Writes one block of the hot file per iteration, filling each with its index.
+bool WriteHotFile(perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::unique_fd fd(open(GetHotFilePath(*fixture).c_str(), O_CREAT | O_WRONLY, 0644));
+    ASSERT_TRUE(fd);
+    state->DeclareStep("pwrite");
+    uint8_t data[kHotFileBlockSize];
+
+    size_t block = 0;
+    while (state->KeepRunning()) {
+        memset(data, static_cast<int>(block), sizeof(data));
+        ASSERT_EQ(pwrite(fd.get(), data, sizeof(data), block * kHotFileBlockSize),
+                  static_cast<ssize_t>(sizeof(data)));
+        block = (block + 1) % kHotFileBlocks;
+    }
+    END_HELPER;
+}
+
+// Reads one block of the hot file per iteration through a single descriptor,
+// which may be served from the file's VMO without a message to the server.
+bool ReadHotFile(perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::unique_fd fd(open(GetHotFilePath(*fixture).c_str(), O_RDONLY));
+    ASSERT_TRUE(fd);
+    state->DeclareStep("pread");
+    uint8_t data[kHotFileBlockSize];
+
+    size_t block = 0;
+    while (state->KeepRunning()) {
+        ASSERT_EQ(pread(fd.get(), data, sizeof(data), block * kHotFileBlockSize),
+                  static_cast<ssize_t>(sizeof(data)));
+        ASSERT_EQ(data[0], static_cast<uint8_t>(block));
+        block = (block + 1) % kHotFileBlocks;
+    }
+    END_HELPER;
+}
+
+// Reads one block of the hot file per iteration through a new descriptor,
+// which always sends its reads to the server.
+bool ReopenReadHotFile(perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::String path = GetHotFilePath(*fixture);
+    state->DeclareStep("open");
+    state->DeclareStep("pread");
+    uint8_t data[kHotFileBlockSize];
+
+    size_t block = 0;
+    while (state->KeepRunning()) {
+        fbl::unique_fd fd(open(path.c_str(), O_RDONLY));
+        ASSERT_TRUE(fd);
+        state->NextStep();
+        ASSERT_EQ(pread(fd.get(), data, sizeof(data), block * kHotFileBlockSize),
+                  static_cast<ssize_t>(sizeof(data)));
+        ASSERT_EQ(data[0], static_cast<uint8_t>(block));
+        block = (block + 1) % kHotFileBlocks;
+    }
+    END_HELPER;
+}
+
 } // namespace
 
 bool RunBenchmark(int argc, char** argv) {
@@ -238,6 +384,70 @@ bool RunBenchmark(int argc, char** argv) {
         testcases.push_back(fbl::move(testcase));
     }
 
+    // Large directory listing tests.
+    const int large_dir_sample_counts[] = {
+        1000,
+        5000,
+        10000,
+    };
+
+    for (int test_sample_count : large_dir_sample_counts) {
+        TestCaseInfo testcase;
+        testcase.name = fbl::StringPrintf("%s/LargeDir/%d-Entries",
+                                          disk_format_string_[f_opts.fs_type], test_sample_count);
+        testcase.sample_count = test_sample_count;
+        testcase.teardown = false;
+
+        TestInfo create_test;
+        create_test.name = fbl::StringPrintf("%s/Create", testcase.name.c_str());
+        create_test.test_fn = CreateLargeDir;
+        testcase.tests.push_back(fbl::move(create_test));
+
+        TestInfo list_test;
+        list_test.name = fbl::StringPrintf("%s/List", testcase.name.c_str());
+        list_test.test_fn = ListLargeDir;
+        testcase.tests.push_back(fbl::move(list_test));
+
+        TestInfo lookup_test;
+        lookup_test.name = fbl::StringPrintf("%s/Lookup", testcase.name.c_str());
+        lookup_test.test_fn = LookupLargeDir;
+        testcase.tests.push_back(fbl::move(lookup_test));
+        testcases.push_back(fbl::move(testcase));
+    }
+
+    // Hot file tests.
+    const int hot_file_sample_counts[] = {
+        1024,
+        16384,
+    };
+
+    for (int test_sample_count : hot_file_sample_counts) {
+        TestCaseInfo testcase;
+        testcase.name = fbl::StringPrintf("%s/HotFile/%d-Ops",
+                                          disk_format_string_[f_opts.fs_type], test_sample_count);
+        testcase.sample_count = test_sample_count;
+        testcase.teardown = false;
+
+        TestInfo write_test;
+        write_test.name = fbl::StringPrintf("%s/Write", testcase.name.c_str());
+        write_test.test_fn = WriteHotFile;
+        write_test.required_disk_space = kHotFileSize;
+        testcase.tests.push_back(fbl::move(write_test));
+
+        TestInfo read_test;
+        read_test.name = fbl::StringPrintf("%s/Read", testcase.name.c_str());
+        read_test.test_fn = ReadHotFile;
+        read_test.required_disk_space = kHotFileSize;
+        testcase.tests.push_back(fbl::move(read_test));
+
+        TestInfo reopen_test;
+        reopen_test.name = fbl::StringPrintf("%s/ReopenRead", testcase.name.c_str());
+        reopen_test.test_fn = ReopenReadHotFile;
+        reopen_test.required_disk_space = kHotFileSize;
+        testcase.tests.push_back(fbl::move(reopen_test));
+        testcases.push_back(fbl::move(testcase));
+    }
+
     return fs_test_utils::RunTestCases(f_opts, p_opts, testcases);
 }
 } // namespace fs_bench
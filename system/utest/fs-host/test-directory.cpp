@@ -5,6 +5,7 @@
 #include "util.h"
 
 #include <fbl/algorithm.h>
+#include <minfs/format.h>
 
 bool check_dir_contents(const char* dirname, expected_dirent_t* edirents, size_t len) {
     BEGIN_HELPER;
@@ -120,8 +121,93 @@ bool test_directory_readdir_large(void) {
     END_TEST;
 }
 
+// Large enough for the directory to be indexed.
+bool test_directory_indexed(void) {
+    BEGIN_TEST;
+
+    const int num_files = 2000;
+    ASSERT_EQ(emu_mkdir("::indexed", 0755), 0);
+    for (int i = 0; i < num_files; i++) {
+        char path[100];
+        snprintf(path, sizeof(path), "::indexed/file%05d", i);
+        int fd = emu_open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        ASSERT_GT(fd, 0);
+        ASSERT_EQ(emu_close(fd), 0);
+    }
+    ASSERT_EQ(run_fsck(), 0);
+
+    // Names are found, and may not be created twice.
+    struct stat s;
+    for (int i = 0; i < num_files; i += 97) {
+        char path[100];
+        snprintf(path, sizeof(path), "::indexed/file%05d", i);
+        ASSERT_EQ(emu_stat(path, &s), 0);
+        ASSERT_LT(emu_open(path, O_RDWR | O_CREAT | O_EXCL, 0644), 0);
+    }
+    ASSERT_NE(emu_stat("::indexed/file99999", &s), 0);
+
+    // Remove every other entry, then fill the holes with new names.
+    for (int i = 0; i < num_files; i += 2) {
+        char path[100];
+        snprintf(path, sizeof(path), "::indexed/file%05d", i);
+        ASSERT_EQ(emu_unlink(path), 0);
+        ASSERT_NE(emu_stat(path, &s), 0);
+    }
+    ASSERT_EQ(run_fsck(), 0);
+    for (int i = 0; i < num_files; i += 2) {
+        char path[100];
+        snprintf(path, sizeof(path), "::indexed/new%05d", i);
+        ASSERT_EQ(emu_mkdir(path, 0755), 0);
+    }
+    ASSERT_EQ(run_fsck(), 0);
+
+    for (int i = 0; i < num_files; i++) {
+        char path[100];
+        snprintf(path, sizeof(path), (i % 2) ? "::indexed/file%05d" : "::indexed/new%05d", i);
+        ASSERT_EQ(emu_stat(path, &s), 0);
+        ASSERT_EQ(emu_unlink(path), 0);
+    }
+    ASSERT_EQ(emu_unlink("::indexed"), 0);
+    ASSERT_EQ(run_fsck(), 0);
+    END_TEST;
+}
+
+// Entries unlinked through the index coalesce with the free space before them,
+// so emptying the directory in order shrinks it back down.
+bool test_directory_indexed_coalesce(void) {
+    BEGIN_TEST;
+
+    const int num_files = 1000;
+    ASSERT_EQ(emu_mkdir("::coalesce", 0755), 0);
+    for (int i = 0; i < num_files; i++) {
+        char path[100];
+        snprintf(path, sizeof(path), "::coalesce/file%05d", i);
+        int fd = emu_open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        ASSERT_GT(fd, 0);
+        ASSERT_EQ(emu_close(fd), 0);
+    }
+    struct stat s;
+    ASSERT_EQ(emu_stat("::coalesce", &s), 0);
+    ASSERT_GT(s.st_size, static_cast<off_t>(minfs::kMinfsBlockSize));
+
+    for (int i = 0; i < num_files; i++) {
+        char path[100];
+        snprintf(path, sizeof(path), "::coalesce/file%05d", i);
+        ASSERT_EQ(emu_unlink(path), 0);
+    }
+    ASSERT_EQ(run_fsck(), 0);
+    ASSERT_EQ(emu_stat("::coalesce", &s), 0);
+    ASSERT_LT(s.st_size, static_cast<off_t>(minfs::kMinfsBlockSize));
+
+    ASSERT_EQ(emu_unlink("::coalesce"), 0);
+    ASSERT_EQ(run_fsck(), 0);
+    END_TEST;
+}
+
 RUN_MINFS_TESTS(directory_tests,
     RUN_TEST_LARGE(test_directory_large)
     RUN_TEST_MEDIUM(test_directory_readdir)
     RUN_TEST_MEDIUM(test_directory_readdir_large)
+    RUN_TEST_LARGE(test_directory_indexed)
+    RUN_TEST_LARGE(test_directory_indexed_coalesce)
 )
@@ -0,0 +1,162 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/unique_ptr.h>
+#include <minfs/format.h>
+
+#include "util.h"
+
+namespace {
+
+constexpr size_t kBlockSize = minfs::kMinfsBlockSize;
+
+// Fills |buf| with a pattern identifying block |n| of the file |file|.
+void FillBlock(uint8_t* buf, uint32_t file, uint32_t n) {
+    for (size_t i = 0; i < kBlockSize; i++) {
+        buf[i] = static_cast<uint8_t>(file * 131 + n * 7 + i);
+    }
+}
+
+bool WriteBlock(int fd, uint32_t file, uint32_t n) {
+    BEGIN_HELPER;
+    uint8_t buf[kBlockSize];
+    FillBlock(buf, file, n);
+    ASSERT_EQ(emu_pwrite(fd, buf, kBlockSize, n * kBlockSize), kBlockSize);
+    END_HELPER;
+}
+
+// Verifies that blocks [0, count) of |filename| hold the pattern of |file|,
+// except for the blocks in |holes|, which must read back as zeroes.
+bool VerifyFile(const char* filename, uint32_t file, uint32_t count, uint32_t hole_stride) {
+    BEGIN_HELPER;
+    int fd = emu_open(filename, O_RDONLY, 0644);
+    ASSERT_GT(fd, 0);
+    uint8_t expected[kBlockSize];
+    uint8_t actual[kBlockSize];
+    for (uint32_t n = 0; n < count; n++) {
+        if (hole_stride != 0 && n % hole_stride != 0) {
+            memset(expected, 0, sizeof(expected));
+        } else {
+            FillBlock(expected, file, n);
+        }
+        ASSERT_EQ(emu_pread(fd, actual, kBlockSize, n * kBlockSize), kBlockSize);
+        ASSERT_EQ(memcmp(expected, actual, kBlockSize), 0);
+    }
+    ASSERT_EQ(emu_close(fd), 0);
+    END_HELPER;
+}
+
+bool test_extents_sequential(void) {
+    BEGIN_TEST;
+
+    constexpr uint32_t kBlocks = 512;
+    int fd = emu_open("::sequential", O_RDWR | O_CREAT, 0644);
+    ASSERT_GT(fd, 0);
+    for (uint32_t n = 0; n < kBlocks; n++) {
+        ASSERT_TRUE(WriteBlock(fd, 0, n));
+    }
+    ASSERT_EQ(emu_close(fd), 0);
+    ASSERT_TRUE(VerifyFile("::sequential", 0, kBlocks, 0));
+    ASSERT_EQ(run_fsck(), 0);
+
+    // Shrink into the middle of the extent, then grow the file again.
+    fd = emu_open("::sequential", O_RDWR, 0644);
+    ASSERT_GT(fd, 0);
+    ASSERT_EQ(emu_ftruncate(fd, kBlocks / 2 * kBlockSize + 1), 0);
+    for (uint32_t n = kBlocks / 2; n < kBlocks; n++) {
+        ASSERT_TRUE(WriteBlock(fd, 0, n));
+    }
+    ASSERT_EQ(emu_close(fd), 0);
+    ASSERT_TRUE(VerifyFile("::sequential", 0, kBlocks, 0));
+
+    ASSERT_EQ(emu_unlink("::sequential"), 0);
+    ASSERT_EQ(run_fsck(), 0);
+    END_TEST;
+}
+
+// Writes a sparse file backwards, so new blocks extend extents at their start,
+// then fills in the holes, joining neighbouring extents.
+bool test_extents_sparse(void) {
+    BEGIN_TEST;
+
+    constexpr uint32_t kBlocks = 64;
+    int fd = emu_open("::sparse", O_RDWR | O_CREAT, 0644);
+    ASSERT_GT(fd, 0);
+    for (uint32_t n = kBlocks; n-- > 0;) {
+        if (n % 8 == 0) {
+            ASSERT_TRUE(WriteBlock(fd, 1, n));
+        }
+    }
+    ASSERT_EQ(emu_ftruncate(fd, kBlocks * kBlockSize), 0);
+    ASSERT_EQ(emu_close(fd), 0);
+    ASSERT_TRUE(VerifyFile("::sparse", 1, kBlocks, 8));
+    ASSERT_EQ(run_fsck(), 0);
+
+    fd = emu_open("::sparse", O_RDWR, 0644);
+    ASSERT_GT(fd, 0);
+    for (uint32_t n = kBlocks; n-- > 0;) {
+        if (n % 8 != 0) {
+            ASSERT_TRUE(WriteBlock(fd, 1, n));
+        }
+    }
+    ASSERT_EQ(emu_close(fd), 0);
+    ASSERT_TRUE(VerifyFile("::sparse", 1, kBlocks, 0));
+    ASSERT_EQ(run_fsck(), 0);
+
+    ASSERT_EQ(emu_unlink("::sparse"), 0);
+    ASSERT_EQ(run_fsck(), 0);
+    END_TEST;
+}
+
+// Interleaves the writes of two files so that neither can be mapped by the
+// extents held in the inode, forcing both to fall back to block tables.
+template <uint32_t Blocks>
+bool test_extents_fragmented(void) {
+    BEGIN_TEST;
+
+    int fd_a = emu_open("::frag_a", O_RDWR | O_CREAT, 0644);
+    ASSERT_GT(fd_a, 0);
+    int fd_b = emu_open("::frag_b", O_RDWR | O_CREAT, 0644);
+    ASSERT_GT(fd_b, 0);
+    for (uint32_t n = 0; n < Blocks; n++) {
+        ASSERT_TRUE(WriteBlock(fd_a, 2, n));
+        ASSERT_TRUE(WriteBlock(fd_b, 3, n));
+    }
+    ASSERT_EQ(emu_close(fd_a), 0);
+    ASSERT_EQ(emu_close(fd_b), 0);
+    ASSERT_TRUE(VerifyFile("::frag_a", 2, Blocks, 0));
+    ASSERT_TRUE(VerifyFile("::frag_b", 3, Blocks, 0));
+    ASSERT_EQ(run_fsck(), 0);
+
+    fd_a = emu_open("::frag_a", O_RDWR, 0644);
+    ASSERT_GT(fd_a, 0);
+    ASSERT_EQ(emu_ftruncate(fd_a, Blocks / 2 * kBlockSize), 0);
+    ASSERT_EQ(emu_close(fd_a), 0);
+    ASSERT_TRUE(VerifyFile("::frag_a", 2, Blocks / 2, 0));
+    ASSERT_EQ(run_fsck(), 0);
+
+    ASSERT_EQ(emu_unlink("::frag_a"), 0);
+    ASSERT_EQ(emu_unlink("::frag_b"), 0);
+    ASSERT_EQ(run_fsck(), 0);
+    END_TEST;
+}
+
+minfs::Options ExtentOptions() {
+    minfs::Options options = {};
+    options.extents = true;
+    return options;
+}
+
+} // namespace
+
+RUN_MINFS_TESTS_OPTIONS(extent_tests, ExtentOptions(),
+    RUN_TEST_MEDIUM(test_extents_sequential)
+    RUN_TEST_MEDIUM(test_extents_sparse)
+    RUN_TEST_MEDIUM((test_extents_fragmented<minfs::kMinfsInodeExtents>))
+    RUN_TEST_MEDIUM((test_extents_fragmented<64>))
+    RUN_TEST_LARGE((test_extents_fragmented<2048>))
+)
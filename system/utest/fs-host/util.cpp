@@ -12,6 +12,10 @@
 #include <minfs/fsck.h>
 
 void setup_fs_test(size_t disk_size) {
+    setup_fs_test(disk_size, {});
+}
+
+void setup_fs_test(size_t disk_size, const minfs::Options& options) {
     int r = open(MOUNT_PATH, O_RDWR | O_CREAT | O_EXCL, 0755);
 
     if (r < 0) {
@@ -29,7 +33,7 @@ void setup_fs_test(size_t disk_size) {
         exit(-1);
     }
 
-    if (emu_mkfs(MOUNT_PATH) < 0) {
+    if (emu_mkfs(MOUNT_PATH, options) < 0) {
         fprintf(stderr, "Unable to run mkfs\n");
         exit(-1);
     }
@@ -17,6 +17,7 @@ typedef struct expected_dirent {
 } expected_dirent_t;
 
 void setup_fs_test(size_t disk_size);
+void setup_fs_test(size_t disk_size, const minfs::Options& options);
 void teardown_fs_test(void);
 int run_fsck(void);
 
@@ -36,5 +37,12 @@ int run_fsck(void);
     CASE_TESTS                                                 \
     END_FS_TEST_CASE(minfs_##case_name)
 
+// Runs |CASE_TESTS| on a filesystem created with |options|.
+#define RUN_MINFS_TESTS_OPTIONS(case_name, options, CASE_TESTS) \
+    BEGIN_TEST_CASE(minfs_##case_name)                         \
+    setup_fs_test(DEFAULT_DISK_SIZE, options);                 \
+    CASE_TESTS                                                 \
+    END_FS_TEST_CASE(minfs_##case_name)
+
 #define ASSERT_STREAM_ALL(op, fd, buf, len) \
     ASSERT_EQ(op(fd, (buf), (len)), (ssize_t)(len), "");
@@ -8,6 +8,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -327,6 +328,116 @@ bool TestFullOperations(void) {
     END_TEST;
 }
 
+namespace {
+
+// Fill |data| with a pattern unique to block |n| of a file, as of write |generation|.
+void StampBlock(uint32_t n, uint32_t generation, uint8_t* data) {
+    for (size_t i = 0; i < minfs::kMinfsBlockSize; i++) {
+        data[i] = static_cast<uint8_t>(n * 7 + generation * 13 + i);
+    }
+}
+
+// Verify that block |n| of the file at |fd| holds the pattern written by |generation|.
+bool VerifyBlock(int fd, uint32_t n, uint32_t generation) {
+    BEGIN_HELPER;
+    uint8_t expected[minfs::kMinfsBlockSize];
+    uint8_t actual[minfs::kMinfsBlockSize];
+    StampBlock(n, generation, expected);
+    off_t offset = static_cast<off_t>(n) * minfs::kMinfsBlockSize;
+    ASSERT_EQ(pread(fd, actual, sizeof(actual), offset), sizeof(actual));
+    ASSERT_EQ(memcmp(expected, actual, sizeof(actual)), 0, "Unexpected block contents");
+    END_HELPER;
+}
+
+}  // namespace
+
+// Small sequential writes only reserve their blocks, which are allocated and written
+// back together once the file is synced.
+bool TestDelayedAllocation(void) {
+    BEGIN_TEST;
+    constexpr uint32_t kBlocks = 96;
+    constexpr size_t kWriteSize = minfs::kMinfsBlockSize / 4;
+
+    uint32_t free_before;
+    ASSERT_TRUE(GetUsedBlocks(&free_before));
+
+    fbl::unique_fd fd(open("::delayed", O_CREAT | O_RDWR));
+    ASSERT_TRUE(fd);
+    uint8_t data[minfs::kMinfsBlockSize];
+    for (uint32_t n = 0; n < kBlocks; n++) {
+        StampBlock(n, 0, data);
+        for (size_t off = 0; off < sizeof(data); off += kWriteSize) {
+            ASSERT_EQ(write(fd.get(), data + off, kWriteSize), kWriteSize);
+        }
+    }
+
+    // The data is readable, and its blocks are unavailable to other writers, before
+    // any of them are allocated.
+    uint64_t file_blocks;
+    ASSERT_TRUE(GetFileBlocks(fd.get(), &file_blocks));
+    ASSERT_EQ(file_blocks, 0);
+    uint32_t free_delayed;
+    ASSERT_TRUE(GetUsedBlocks(&free_delayed));
+    ASSERT_LE(free_delayed + kBlocks, free_before);
+    for (uint32_t n = 0; n < kBlocks; n++) {
+        ASSERT_TRUE(VerifyBlock(fd.get(), n, 0));
+    }
+
+    // Syncing allocates the whole run, along with its indirect block, and releases
+    // whatever was reserved beyond that.
+    ASSERT_EQ(fsync(fd.get()), 0);
+    ASSERT_TRUE(GetFileBlocks(fd.get(), &file_blocks));
+    ASSERT_EQ(file_blocks, kBlocks + 1);
+    uint32_t free_after;
+    ASSERT_TRUE(GetUsedBlocks(&free_after));
+    ASSERT_EQ(free_after + kBlocks + 1, free_before);
+
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_TRUE(check_remount());
+    fd.reset(open("::delayed", O_RDWR));
+    ASSERT_TRUE(fd);
+    for (uint32_t n = 0; n < kBlocks; n++) {
+        ASSERT_TRUE(VerifyBlock(fd.get(), n, 0));
+    }
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_EQ(unlink("::delayed"), 0);
+    END_TEST;
+}
+
+// Rewrite the same blocks while earlier copies of them are still queued for
+// writeback, and check that only the latest copy reaches the disk.
+bool TestWritebackOverwrite(void) {
+    BEGIN_TEST;
+    constexpr uint32_t kGenerations = 64;
+    constexpr uint32_t kFarBlock = 32;
+
+    fbl::unique_fd fd(open("::overwrite", O_CREAT | O_RDWR));
+    ASSERT_TRUE(fd);
+    uint8_t data[minfs::kMinfsBlockSize];
+    for (uint32_t generation = 0; generation < kGenerations; generation++) {
+        // Alternating between distant blocks flushes the delayed write of the other
+        // one, so each generation of each block is queued as its own writeback work.
+        StampBlock(0, generation, data);
+        ASSERT_EQ(pwrite(fd.get(), data, sizeof(data), 0), sizeof(data));
+        StampBlock(kFarBlock, generation, data);
+        off_t offset = static_cast<off_t>(kFarBlock) * minfs::kMinfsBlockSize;
+        ASSERT_EQ(pwrite(fd.get(), data, sizeof(data), offset), sizeof(data));
+    }
+    ASSERT_EQ(fsync(fd.get()), 0);
+    ASSERT_TRUE(VerifyBlock(fd.get(), 0, kGenerations - 1));
+    ASSERT_TRUE(VerifyBlock(fd.get(), kFarBlock, kGenerations - 1));
+
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_TRUE(check_remount());
+    fd.reset(open("::overwrite", O_RDWR));
+    ASSERT_TRUE(fd);
+    ASSERT_TRUE(VerifyBlock(fd.get(), 0, kGenerations - 1));
+    ASSERT_TRUE(VerifyBlock(fd.get(), kFarBlock, kGenerations - 1));
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_EQ(unlink("::overwrite"), 0);
+    END_TEST;
+}
+
 #define RUN_MINFS_TESTS_NORMAL(name, CASE_TESTS) \
     FS_TEST_CASE(name, default_test_disk, CASE_TESTS, FS_TEST_NORMAL, minfs, 1)
 
@@ -335,6 +446,8 @@ bool TestFullOperations(void) {
 
 RUN_MINFS_TESTS_NORMAL(FsMinfsTests,
     RUN_TEST_LARGE(TestFullOperations)
+    RUN_TEST_MEDIUM(TestDelayedAllocation)
+    RUN_TEST_MEDIUM(TestWritebackOverwrite)
 )
 
 RUN_MINFS_TESTS_FVM(FsMinfsFvmTests,
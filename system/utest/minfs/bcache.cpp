@@ -0,0 +1,128 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Tests for the block cache which backs minfs::Bcache::Readblk.
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <fs-management/ramdisk.h>
+#include <minfs/bcache.h>
+#include <minfs/format.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+using minfs::Bcache;
+using minfs::kMinfsBlockSize;
+
+// Enough blocks that reading them all cycles through the cache several times.
+constexpr uint32_t kBlockCount = 4 * minfs::kMinfsBlockCacheSize;
+constexpr uint64_t kRamdiskBlockSize = 512;
+constexpr size_t kWords = kMinfsBlockSize / sizeof(uint32_t);
+
+// Fills |block| with contents unique to |bno| and |generation|.
+void StampBlock(uint32_t bno, uint32_t generation, uint32_t* block) {
+    for (size_t i = 0; i < kWords; i++) {
+        block[i] = (bno << 16) ^ (generation << 8) ^ static_cast<uint32_t>(i);
+    }
+}
+
+bool CheckBlock(Bcache* bc, uint32_t bno, uint32_t generation) {
+    BEGIN_HELPER;
+    uint32_t expected[kWords];
+    uint32_t actual[kWords];
+    StampBlock(bno, generation, expected);
+    ASSERT_EQ(bc->Readblk(bno, actual), ZX_OK);
+    ASSERT_EQ(memcmp(expected, actual, kMinfsBlockSize), 0, "Read another block's data");
+    END_HELPER;
+}
+
+// A ramdisk whose every block is stamped with its own number.
+class StampedDisk {
+public:
+    ~StampedDisk() {
+        if (path_[0] != '\0') {
+            destroy_ramdisk(path_);
+        }
+    }
+
+    bool Init(fbl::unique_ptr<Bcache>* out) {
+        BEGIN_HELPER;
+        ASSERT_EQ(create_ramdisk(kRamdiskBlockSize,
+                                 kBlockCount * kMinfsBlockSize / kRamdiskBlockSize, path_), 0);
+        fbl::unique_fd fd(open(path_, O_RDWR));
+        ASSERT_TRUE(fd);
+        uint32_t block[kWords];
+        for (uint32_t bno = 0; bno < kBlockCount; bno++) {
+            StampBlock(bno, 0, block);
+            ASSERT_EQ(pwrite(fd.get(), block, kMinfsBlockSize, bno * kMinfsBlockSize),
+                      static_cast<ssize_t>(kMinfsBlockSize));
+        }
+        ASSERT_EQ(Bcache::Create(out, fbl::move(fd), kBlockCount), ZX_OK);
+        END_HELPER;
+    }
+
+private:
+    char path_[PATH_MAX] = {};
+};
+
+// Each block of a readahead run must land in a slot of its own.
+bool SequentialReadTest() {
+    BEGIN_TEST;
+    StampedDisk disk;
+    fbl::unique_ptr<Bcache> bc;
+    ASSERT_TRUE(disk.Init(&bc));
+
+    // The readahead window grows to its maximum over the first few reads, and
+    // the cache is recycled several times over.
+    for (uint32_t bno = 0; bno < kBlockCount; bno++) {
+        ASSERT_TRUE(CheckBlock(bc.get(), bno, 0));
+    }
+    // The most recently read blocks are still cached, and still correct.
+    for (uint32_t bno = kBlockCount - 1; bno >= kBlockCount - minfs::kMinfsReadaheadMax; bno--) {
+        ASSERT_TRUE(CheckBlock(bc.get(), bno, 0));
+    }
+    END_TEST;
+}
+
+// A readahead run stops at a block which is already cached, and picks up
+// blocks written through the cache.
+bool ReadAroundWritesTest() {
+    BEGIN_TEST;
+    StampedDisk disk;
+    fbl::unique_ptr<Bcache> bc;
+    ASSERT_TRUE(disk.Init(&bc));
+
+    uint32_t block[kWords];
+    const uint32_t written = 3 * minfs::kMinfsReadaheadMax / 2;
+    StampBlock(written, 1, block);
+    ASSERT_EQ(bc->Writeblk(written, block), ZX_OK);
+
+    for (uint32_t bno = 0; bno < 2 * written; bno++) {
+        ASSERT_TRUE(CheckBlock(bc.get(), bno, bno == written ? 1 : 0));
+    }
+    // A random walk over the disk, to mix readahead runs with evictions.
+    uint32_t bno = 7;
+    for (uint32_t i = 0; i < 2 * kBlockCount; i++) {
+        bno = (bno * 1103515245u + 12345u) % kBlockCount;
+        ASSERT_TRUE(CheckBlock(bc.get(), bno, bno == written ? 1 : 0));
+        if (bno + 1 < kBlockCount) {
+            ASSERT_TRUE(CheckBlock(bc.get(), bno + 1, bno + 1 == written ? 1 : 0));
+        }
+    }
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(minfs_bcache_tests)
+RUN_TEST(SequentialReadTest)
+RUN_TEST(ReadAroundWritesTest)
+END_TEST_CASE(minfs_bcache_tests)
@@ -0,0 +1,54 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "block-device.h"
+
+#include <fcntl.h>
+
+#include <fs-management/ramdisk.h>
+#include <zircon/assert.h>
+
+namespace block_perftest {
+
+Ramdisk::Ramdisk(uint64_t block_size, uint64_t block_count) {
+    ZX_ASSERT(create_ramdisk(block_size, block_count, path_) == 0);
+}
+
+Ramdisk::~Ramdisk() {
+    ZX_ASSERT(destroy_ramdisk(path_) == 0);
+}
+
+fbl::unique_fd Ramdisk::Open() const {
+    fbl::unique_fd fd(open(path_, O_RDWR));
+    ZX_ASSERT(fd);
+    return fd;
+}
+
+BlockFifo::BlockFifo(int fd, size_t size) {
+    ZX_ASSERT(ioctl_block_get_info(fd, &info_) >= 0);
+    zx_handle_t fifo;
+    ZX_ASSERT(ioctl_block_get_fifos(fd, &fifo) >= 0);
+    ZX_ASSERT(block_fifo_create_client(fifo, &client_) == ZX_OK);
+
+    zx::vmo dup;
+    ZX_ASSERT(zx::vmo::create(size, 0, &vmo_) == ZX_OK);
+    ZX_ASSERT(vmo_.duplicate(ZX_RIGHT_SAME_RIGHTS, &dup) == ZX_OK);
+    zx_handle_t raw = dup.release();
+    ZX_ASSERT(ioctl_block_attach_vmo(fd, &raw, &vmoid_) >= 0);
+}
+
+BlockFifo::~BlockFifo() {
+    block_fifo_release_client(client_);
+}
+
+void BlockFifo::Transact(uint32_t opcode, uint64_t dev_offset, uint32_t length) {
+    block_fifo_request_t request = {};
+    request.opcode = opcode;
+    request.vmoid = vmoid_;
+    request.length = length;
+    request.dev_offset = dev_offset;
+    ZX_ASSERT(block_fifo_txn(client_, &request, 1) == ZX_OK);
+}
+
+}  // namespace block_perftest
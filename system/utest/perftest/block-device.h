@@ -0,0 +1,58 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <block-client/client.h>
+#include <fbl/macros.h>
+#include <fbl/unique_fd.h>
+#include <lib/zx/vmo.h>
+#include <zircon/device/block.h>
+
+// Fixtures shared by the tests which measure I/O through block devices.
+// Failures are fatal, as in the tests themselves.
+namespace block_perftest {
+
+// A ramdisk which exists for the lifetime of the object.
+class Ramdisk {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Ramdisk);
+    Ramdisk(uint64_t block_size, uint64_t block_count);
+    ~Ramdisk();
+
+    const char* path() const { return path_; }
+
+    // Returns a new read-write connection to the ramdisk.
+    fbl::unique_fd Open() const;
+
+private:
+    char path_[PATH_MAX];
+};
+
+// A block fifo client for a block device, with a VMO of |size| bytes attached
+// for every request to transfer through.
+class BlockFifo {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(BlockFifo);
+    BlockFifo(int fd, size_t size);
+    ~BlockFifo();
+
+    const block_info_t& info() const { return info_; }
+
+    // Issues a single request with |opcode|, transferring |length| device blocks
+    // at |dev_offset| from or to the start of the VMO, and waits for it to complete.
+    void Transact(uint32_t opcode, uint64_t dev_offset, uint32_t length);
+
+private:
+    block_info_t info_;
+    fifo_client_t* client_ = nullptr;
+    zx::vmo vmo_;
+    vmoid_t vmoid_;
+};
+
+}  // namespace block_perftest
@@ -0,0 +1,164 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <lib/fdio/watcher.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/device/dmctl.h>
+#include <zircon/device/test.h>
+#include <zircon/syscalls.h>
+
+namespace {
+
+// Test devices are named "<kPrefix><run>-<index>", so that each run can pick out its own.
+constexpr char kPrefix[] = "bindperf";
+
+uint32_t next_run = 0;
+
+struct WatchState {
+    const char* prefix;
+    uint32_t count;
+    bool* present;
+    bool idle;
+    bool want_present;
+};
+
+zx_status_t WatchCb(int dirfd, int event, const char* fn, void* cookie) {
+    auto state = static_cast<WatchState*>(cookie);
+    size_t len = strlen(state->prefix);
+    if (event == WATCH_EVENT_IDLE) {
+        state->idle = true;
+    } else if (!strncmp(fn, state->prefix, len)) {
+        uint32_t i = static_cast<uint32_t>(strtoul(fn + len, nullptr, 10));
+        if (i < state->count) {
+            state->present[i] = (event == WATCH_EVENT_ADD_FILE);
+        }
+    }
+    // The existing entries are reported before WATCH_EVENT_IDLE, and changes after it.
+    if (!state->idle) {
+        return ZX_OK;
+    }
+    for (uint32_t i = 0; i < state->count; ++i) {
+        if (state->present[i] != state->want_present) {
+            return ZX_OK;
+        }
+    }
+    return ZX_ERR_STOP;
+}
+
+// Waits until all of the |count| devices named with |prefix| have been added to the test bus,
+// or all have been removed from it.
+void Wait(const char* prefix, uint32_t count, bool present) {
+    fbl::unique_ptr<bool[]> devs(new bool[count]());
+    WatchState state = {prefix, count, devs.get(), false, present};
+    fbl::unique_fd dir(open(TEST_CONTROL_DEVICE, O_RDONLY | O_DIRECTORY));
+    ZX_ASSERT(dir);
+    ZX_ASSERT(fdio_watch_directory(dir.get(), WatchCb, zx_deadline_after(ZX_SEC(10)), &state) ==
+              ZX_ERR_STOP);
+}
+
+// Returns the number of devices which the device coordinator has matched against its drivers.
+uint32_t BindMatchCount() {
+    fbl::unique_fd dmctl(open("/dev/misc/dmctl", O_WRONLY));
+    ZX_ASSERT(dmctl);
+    dmctl_cmd_t cmd;
+    strcpy(cmd.name, "bindstats");
+    zx_handle_t socket;
+    ZX_ASSERT(zx_socket_create(0, &cmd.h, &socket) == ZX_OK);
+    ZX_ASSERT(ioctl_dmctl_command(dmctl.get(), &cmd) == ZX_OK);
+
+    // The coordinator closes its end once the command has been handled.
+    char buf[128];
+    size_t len = 0;
+    for (;;) {
+        size_t actual;
+        zx_status_t status = zx_socket_read(socket, 0, buf + len, sizeof(buf) - 1 - len, &actual);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            zx_object_wait_one(socket, ZX_SOCKET_READABLE | ZX_SOCKET_PEER_CLOSED,
+                               ZX_TIME_INFINITE, nullptr);
+            continue;
+        }
+        if (status != ZX_OK || actual == 0) {
+            break;
+        }
+        len += actual;
+    }
+    zx_handle_close(socket);
+    buf[len] = 0;
+
+    unsigned devices;
+    ZX_ASSERT(sscanf(buf, "devices=%u", &devices) == 1);
+    return devices;
+}
+
+// Waits until the device coordinator has matched at least |count| devices against its drivers.
+// It publishes each device before doing so, so seeing a device appear is not enough.
+void WaitMatched(uint32_t count) {
+    while (BindMatchCount() < count) {
+        zx_nanosleep(zx_deadline_after(ZX_USEC(100)));
+    }
+}
+
+// Test the time taken for the device coordinator to add |count| devices on the test bus and
+// match them against the drivers which might bind to them, and then to remove them.  Nothing
+// binds to test devices, so each one is checked against every driver indexed under its protocol
+// (see dc_bind_index_find()).
+bool AddRemoveTest(perftest::RepeatState* state, uint32_t count) {
+    state->DeclareStep("add");
+    state->DeclareStep("remove");
+
+    fbl::unique_fd ctl(open(TEST_CONTROL_DEVICE, O_RDWR));
+    ZX_ASSERT(ctl);
+    fbl::unique_ptr<fbl::unique_fd[]> devs(new fbl::unique_fd[count]);
+
+    uint32_t matched = BindMatchCount();
+    while (state->KeepRunning()) {
+        auto prefix = fbl::StringPrintf("%s%u-", kPrefix, next_run++);
+        for (uint32_t i = 0; i < count; ++i) {
+            auto name = fbl::StringPrintf("%s%u", prefix.c_str(), i);
+            char path[1024];
+            ZX_ASSERT(ioctl_test_create_device(ctl.get(), name.c_str(), name.length() + 1, path,
+                                               sizeof(path)) >= 0);
+        }
+        Wait(prefix.c_str(), count, true);
+        matched += count;
+        WaitMatched(matched);
+        state->NextStep();
+
+        for (uint32_t i = 0; i < count; ++i) {
+            auto path = fbl::StringPrintf("%s/%s%u", TEST_CONTROL_DEVICE, prefix.c_str(), i);
+            devs[i].reset(open(path.c_str(), O_RDWR));
+            ZX_ASSERT(devs[i]);
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            ZX_ASSERT(ioctl_test_destroy_device(devs[i].get()) >= 0);
+            devs[i].reset();
+        }
+        Wait(prefix.c_str(), count, false);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const uint32_t kCounts[] = {
+        1,
+        32,
+    };
+    for (auto count : kCounts) {
+        auto name = fbl::StringPrintf("Devmgr/TestDevice/AddRemove/%udevices", count);
+        perftest::RegisterTest(name.c_str(), AddRemoveTest, count);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
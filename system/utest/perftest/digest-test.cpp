@@ -0,0 +1,86 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <digest/digest.h>
+#include <digest/merkle-tree.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+using digest::Digest;
+using digest::MerkleTree;
+
+// Test performance of hashing a single buffer of the given size.
+bool DigestHashTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    memset(data.get(), 0xff, size);
+
+    Digest digest;
+    while (state->KeepRunning()) {
+        perftest::DoNotOptimize(digest.Hash(data.get(), size));
+    }
+    return true;
+}
+
+// Test performance of creating the Merkle tree of |size| bytes of data, as
+// blobfs does when a blob is written.
+bool MerkleTreeCreateTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    size_t tree_len = MerkleTree::GetTreeLength(size);
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    fbl::unique_ptr<uint8_t[]> tree(new uint8_t[tree_len]);
+    memset(data.get(), 0xff, size);
+
+    Digest digest;
+    while (state->KeepRunning()) {
+        ZX_ASSERT(MerkleTree::Create(data.get(), size, tree.get(), tree_len, &digest) == ZX_OK);
+    }
+    return true;
+}
+
+// Test performance of verifying all of |size| bytes of data, as blobfs does
+// when a blob is read.
+bool MerkleTreeVerifyTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    size_t tree_len = MerkleTree::GetTreeLength(size);
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    fbl::unique_ptr<uint8_t[]> tree(new uint8_t[tree_len]);
+    memset(data.get(), 0xff, size);
+
+    Digest digest;
+    ZX_ASSERT(MerkleTree::Create(data.get(), size, tree.get(), tree_len, &digest) == ZX_OK);
+    while (state->KeepRunning()) {
+        ZX_ASSERT(MerkleTree::Verify(data.get(), size, tree.get(), tree_len, 0, size,
+                                     digest) == ZX_OK);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    perftest::RegisterTest("Digest/Hash/8192bytes", DigestHashTest, MerkleTree::kNodeSize);
+
+    static const size_t kSizesBytes[] = {
+        65536,
+        1048576,
+        16777216,
+    };
+    for (auto size : kSizesBytes) {
+        auto name = fbl::StringPrintf("MerkleTree/Create/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), MerkleTreeCreateTest, size);
+        name = fbl::StringPrintf("MerkleTree/Verify/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), MerkleTreeVerifyTest, size);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
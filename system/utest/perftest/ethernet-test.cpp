@@ -0,0 +1,156 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <lib/fdio/watcher.h>
+#include <lib/zx/fifo.h>
+#include <lib/zx/socket.h>
+#include <lib/zx/vmo.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/device/ethernet.h>
+#include <zircon/device/ethertap.h>
+
+namespace {
+
+constexpr char kTapctl[] = "/dev/misc/tapctl";
+constexpr char kEthernetDir[] = "/dev/class/ethernet";
+constexpr uint32_t kMtu = 1500;
+constexpr uint16_t kBufSize = 2048;
+constexpr size_t kFrameSize = 64;
+constexpr size_t kMacSize = 6;
+
+// Each tap device gets its own MAC address, so that it can be told apart from any which are
+// still being torn down.
+uint8_t next_mac_suffix = 0;
+
+struct WatchState {
+    uint8_t mac[kMacSize];
+    int fd;
+};
+
+zx_status_t WatchCb(int dirfd, int event, const char* fn, void* cookie) {
+    if (event != WATCH_EVENT_ADD_FILE || !strcmp(fn, ".") || !strcmp(fn, "..")) {
+        return ZX_OK;
+    }
+    fbl::unique_fd fd(openat(dirfd, fn, O_RDWR));
+    eth_info_t info;
+    if (!fd || ioctl_ethernet_get_info(fd.get(), &info) < 0) {
+        return ZX_OK;
+    }
+    auto state = static_cast<WatchState*>(cookie);
+    if (memcmp(info.mac, state->mac, kMacSize) != 0) {
+        return ZX_OK;
+    }
+    state->fd = fd.release();
+    return ZX_ERR_STOP;
+}
+
+// Creates an ethertap device with |options|, and opens and starts an ethernet client of it with
+// every rx buffer queued.
+void OpenTap(uint32_t options, zx::socket* sock, fbl::unique_fd* out, zx::fifo* rx_fifo,
+             uint32_t* rx_depth) {
+    fbl::unique_fd ctl(open(kTapctl, O_RDONLY));
+    ZX_ASSERT(ctl);
+    ethertap_ioctl_config_t config = {};
+    strlcpy(config.name, "perftest", ETHERTAP_MAX_NAME_LEN);
+    config.options = options;
+    config.mtu = kMtu;
+    const uint8_t mac[kMacSize] = {0x12, 0x20, 0x30, 0x40, 0x51, next_mac_suffix++};
+    memcpy(config.mac, mac, sizeof(mac));
+    ZX_ASSERT(ioctl_ethertap_config(ctl.get(), &config, sock->reset_and_get_address()) >= 0);
+
+    WatchState state;
+    memcpy(state.mac, mac, sizeof(mac));
+    state.fd = -1;
+    fbl::unique_fd dir(open(kEthernetDir, O_RDONLY));
+    ZX_ASSERT(dir);
+    ZX_ASSERT(fdio_watch_directory(dir.get(), WatchCb, zx_deadline_after(ZX_SEC(3)), &state) ==
+              ZX_ERR_STOP);
+    out->reset(state.fd);
+
+    eth_fifos_t fifos;
+    ZX_ASSERT(ioctl_ethernet_get_fifos(out->get(), &fifos) >= 0);
+    zx_handle_close(fifos.tx_fifo);
+    rx_fifo->reset(fifos.rx_fifo);
+    *rx_depth = fifos.rx_depth;
+
+    zx::vmo vmo;
+    ZX_ASSERT(zx::vmo::create(fifos.rx_depth * kBufSize, ZX_VMO_NON_RESIZABLE, &vmo) == ZX_OK);
+    zx_handle_t raw = vmo.release();
+    ZX_ASSERT(ioctl_ethernet_set_iobuf(out->get(), &raw) >= 0);
+    ZX_ASSERT(ioctl_ethernet_start(out->get()) >= 0);
+
+    for (uint32_t i = 0; i < fifos.rx_depth; ++i) {
+        eth_fifo_entry_t entry = {};
+        entry.offset = i * kBufSize;
+        entry.length = kBufSize;
+        ZX_ASSERT(rx_fifo->write(sizeof(entry), &entry, 1, nullptr) == ZX_OK);
+    }
+}
+
+// Test performance of receiving bursts of |frames| small frames through an
+// ethertap device, from the write of the first into the tap's socket until the
+// last has been read from the client's rx fifo.  With ETHERTAP_OPT_RX_QUEUE,
+// the tap reads frames directly into the client's buffers.
+bool RecvTest(perftest::RepeatState* state, uint32_t frames, uint32_t options) {
+    state->SetBytesProcessedPerRun(frames * kFrameSize);
+
+    zx::socket sock;
+    fbl::unique_fd fd;
+    zx::fifo rx_fifo;
+    uint32_t rx_depth;
+    OpenTap(options, &sock, &fd, &rx_fifo, &rx_depth);
+    ZX_ASSERT(frames <= rx_depth);
+
+    uint8_t frame[kFrameSize];
+    memset(frame, 0xa5, sizeof(frame));
+    fbl::unique_ptr<eth_fifo_entry_t[]> entries(new eth_fifo_entry_t[frames]);
+    while (state->KeepRunning()) {
+        for (uint32_t i = 0; i < frames; ++i) {
+            ZX_ASSERT(sock.write(0, frame, sizeof(frame), nullptr) == ZX_OK);
+        }
+        uint32_t received = 0;
+        while (received < frames) {
+            ZX_ASSERT(rx_fifo.wait_one(ZX_FIFO_READABLE, zx::time::infinite(), nullptr) == ZX_OK);
+            size_t actual;
+            ZX_ASSERT(rx_fifo.read(sizeof(entries[0]), &entries[received], frames - received,
+                                   &actual) == ZX_OK);
+            received += static_cast<uint32_t>(actual);
+        }
+        for (uint32_t i = 0; i < frames; ++i) {
+            ZX_ASSERT(entries[i].flags & ETH_FIFO_RX_OK);
+            entries[i].length = kBufSize;
+            entries[i].flags = 0;
+        }
+        size_t actual;
+        ZX_ASSERT(rx_fifo.write(sizeof(entries[0]), entries.get(), frames, &actual) == ZX_OK);
+        ZX_ASSERT(actual == frames);
+    }
+
+    ZX_ASSERT(ioctl_ethernet_stop(fd.get()) >= 0);
+    return true;
+}
+
+void RegisterTests() {
+    static const uint32_t kFrames[] = {
+        1,
+        32,
+    };
+    for (auto frames : kFrames) {
+        auto name = fbl::StringPrintf("Ethernet/Recv/Copy/%uframes", frames);
+        perftest::RegisterTest(name.c_str(), RecvTest, frames, 0u);
+        name = fbl::StringPrintf("Ethernet/Recv/RxQueue/%uframes", frames);
+        perftest::RegisterTest(name.c_str(), RecvTest, frames, ETHERTAP_OPT_RX_QUEUE);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,93 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_fd.h>
+#include <fs-management/fvm.h>
+#include <fs-management/ramdisk.h>
+#include <lib/zx/time.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/device/block.h>
+#include <zircon/device/device.h>
+
+#include "block-device.h"
+
+namespace {
+
+constexpr char kFvmDriverLib[] = "/boot/driver/fvm.so";
+constexpr size_t kBlockSize = 4096;
+constexpr size_t kBlockCount = 16384;
+constexpr size_t kSliceSize = 1 << 20;
+constexpr size_t kPartitionSlices = 32;
+
+// Opens either |ramdisk| or a partition of an FVM created on it.
+fbl::unique_fd OpenDevice(const block_perftest::Ramdisk& ramdisk, bool fvm) {
+    fbl::unique_fd fd = ramdisk.Open();
+    if (!fvm) {
+        return fd;
+    }
+
+    ZX_ASSERT(fvm_init(fd.get(), kSliceSize) == ZX_OK);
+    ZX_ASSERT(ioctl_device_bind(fd.get(), kFvmDriverLib, sizeof(kFvmDriverLib)) >= 0);
+    char fvm_path[PATH_MAX];
+    snprintf(fvm_path, sizeof(fvm_path), "%s/fvm", ramdisk.path());
+    ZX_ASSERT(wait_for_device(fvm_path, ZX_SEC(3)) == ZX_OK);
+    fbl::unique_fd fvm_fd(open(fvm_path, O_RDWR));
+    ZX_ASSERT(fvm_fd);
+
+    alloc_req_t request;
+    memset(&request, 0, sizeof(request));
+    request.slice_count = kPartitionSlices;
+    memset(request.type, 0xaa, sizeof(request.type));
+    memset(request.guid, 0xbb, sizeof(request.guid));
+    strcpy(request.name, "perftest");
+    fbl::unique_fd partition(fvm_allocate_partition(fvm_fd.get(), &request));
+    ZX_ASSERT(partition);
+    return partition;
+}
+
+// Test performance of reading |size| bytes at a time from random offsets
+// through the block fifo, either of a ramdisk or of an FVM partition on one.
+// Comparing the two shows the cost of translating I/O through the FVM.
+bool RandomReadTest(perftest::RepeatState* state, size_t size, bool fvm) {
+    state->SetBytesProcessedPerRun(size);
+
+    block_perftest::Ramdisk ramdisk(kBlockSize, kBlockCount);
+    fbl::unique_fd fd = OpenDevice(ramdisk, fvm);
+    block_perftest::BlockFifo fifo(fd.get(), size);
+
+    // Only read the range the FVM partition would cover, so that both
+    // devices see the same access pattern.
+    const uint64_t length = size / fifo.info().block_size;
+    const uint64_t count = kPartitionSlices * kSliceSize / fifo.info().block_size / length;
+    unsigned int seed = 0;
+    while (state->KeepRunning()) {
+        uint64_t dev_offset = (rand_r(&seed) % count) * length;
+        fifo.Transact(BLOCKIO_READ, dev_offset, static_cast<uint32_t>(length));
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kSizesBytes[] = {
+        4096,
+        65536,
+    };
+    for (auto size : kSizesBytes) {
+        auto name = fbl::StringPrintf("Fvm/RandomRead/Raw/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), RandomReadTest, size, false);
+        name = fbl::StringPrintf("Fvm/RandomRead/Partition/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), RandomReadTest, size, true);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
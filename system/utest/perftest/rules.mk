@@ -9,7 +9,12 @@ MODULE := $(LOCAL_DIR)
 MODULE_TYPE := usertest
 
 MODULE_SRCS += \
+    $(LOCAL_DIR)/block-device.cpp \
     $(LOCAL_DIR)/clock-test.cpp \
+    $(LOCAL_DIR)/devmgr-test.cpp \
+    $(LOCAL_DIR)/digest-test.cpp \
+    $(LOCAL_DIR)/ethernet-test.cpp \
+    $(LOCAL_DIR)/fvm-test.cpp \
     $(LOCAL_DIR)/handle-creation-test.cpp \
     $(LOCAL_DIR)/malloc-test.cpp \
     $(LOCAL_DIR)/memcpy-test.cpp \
@@ -20,6 +25,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/runner-test.cpp \
     $(LOCAL_DIR)/sleep-test.cpp \
     $(LOCAL_DIR)/syscalls-test.cpp \
+    $(LOCAL_DIR)/zxcrypt-test.cpp \
 
 MODULE_NAME := perf-test
 
@@ -28,6 +34,8 @@ MODULE_STATIC_LIBS := \
     system/ulib/async-loop \
     system/ulib/async-loop.cpp \
     system/ulib/async.cpp \
+    system/ulib/block-client \
+    system/ulib/ddk \
     system/ulib/fbl \
     system/ulib/perftest \
     system/ulib/trace \
@@ -38,10 +46,14 @@ MODULE_STATIC_LIBS := \
 MODULE_LIBS := \
     system/ulib/async.default \
     system/ulib/c \
+    system/ulib/crypto \
+    system/ulib/digest \
     system/ulib/fdio \
+    system/ulib/fs-management \
     system/ulib/launchpad \
     system/ulib/trace-engine \
     system/ulib/unittest \
     system/ulib/zircon \
+    system/ulib/zxcrypt \
 
 include make/module.mk
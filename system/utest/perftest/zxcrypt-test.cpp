@@ -0,0 +1,101 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <crypto/bytes.h>
+#include <crypto/cipher.h>
+#include <crypto/secret.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <lib/zx/time.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/device/block.h>
+#include <zxcrypt/volume.h>
+
+#include "block-device.h"
+
+namespace {
+
+constexpr size_t kBlockSize = 4096;
+constexpr size_t kBlockCount = 16384;
+
+// Test performance of transforming |size| bytes with AES-XTS as zxcrypt does,
+// i.e. as a random access cipher with one tweak per block.
+bool CipherTest(perftest::RepeatState* state, size_t size, crypto::Cipher::Direction direction) {
+    state->SetBytesProcessedPerRun(size);
+
+    size_t key_len, iv_len;
+    ZX_ASSERT(crypto::Cipher::GetKeyLen(crypto::Cipher::kAES256_XTS, &key_len) == ZX_OK);
+    ZX_ASSERT(crypto::Cipher::GetIVLen(crypto::Cipher::kAES256_XTS, &iv_len) == ZX_OK);
+    crypto::Secret key;
+    crypto::Bytes iv;
+    ZX_ASSERT(key.Generate(key_len) == ZX_OK);
+    ZX_ASSERT(iv.Randomize(iv_len) == ZX_OK);
+
+    crypto::Cipher cipher;
+    ZX_ASSERT(cipher.Init(crypto::Cipher::kAES256_XTS, direction, key, iv, kBlockSize) == ZX_OK);
+
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+    memset(data.get(), 0xff, size);
+
+    zx_off_t offset = 0;
+    while (state->KeepRunning()) {
+        ZX_ASSERT(cipher.Transform(data.get(), offset, size, data.get(), direction) == ZX_OK);
+        offset += size;
+    }
+    return true;
+}
+
+// Test performance of reading or writing |size| bytes at a time, sequentially,
+// through the block fifo of a zxcrypt volume on a ramdisk.
+bool RamdiskTest(perftest::RepeatState* state, size_t size, uint32_t opcode) {
+    state->SetBytesProcessedPerRun(size);
+
+    // Format and bind a zxcrypt volume.
+    // TODO(aarongreen): ZX-1130 workaround.  Use null key of a fixed length until fixed.
+    block_perftest::Ramdisk ramdisk(kBlockSize, kBlockCount);
+    crypto::Secret key;
+    uint8_t* buf;
+    ZX_ASSERT(key.Allocate(zxcrypt::kZx1130KeyLen, &buf) == ZX_OK);
+    memset(buf, 0, key.len());
+    ZX_ASSERT(zxcrypt::Volume::Create(ramdisk.Open(), key) == ZX_OK);
+    fbl::unique_ptr<zxcrypt::Volume> volume;
+    ZX_ASSERT(zxcrypt::Volume::Unlock(ramdisk.Open(), key, 0, &volume) == ZX_OK);
+    fbl::unique_fd zxcrypt;
+    ZX_ASSERT(volume->Open(zx::sec(3), &zxcrypt) == ZX_OK);
+    block_perftest::BlockFifo fifo(zxcrypt.get(), size);
+
+    const uint64_t length = size / fifo.info().block_size;
+    const uint64_t limit = fifo.info().block_count - fifo.info().block_count % length;
+    uint64_t dev_offset = 0;
+    while (state->KeepRunning()) {
+        fifo.Transact(opcode, dev_offset, static_cast<uint32_t>(length));
+        dev_offset = (dev_offset + length) % limit;
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kSizesBytes[] = {
+        4096,
+        131072,
+        1048576,
+    };
+    for (auto size : kSizesBytes) {
+        auto name = fbl::StringPrintf("Zxcrypt/Cipher/Encrypt/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), CipherTest, size, crypto::Cipher::kEncrypt);
+        name = fbl::StringPrintf("Zxcrypt/Cipher/Decrypt/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), CipherTest, size, crypto::Cipher::kDecrypt);
+        name = fbl::StringPrintf("Zxcrypt/Ramdisk/Write/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), RamdiskTest, size, BLOCKIO_WRITE);
+        name = fbl::StringPrintf("Zxcrypt/Ramdisk/Read/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), RamdiskTest, size, BLOCKIO_READ);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -7,12 +7,14 @@
 #include <inttypes.h>
 #include <sys/types.h>
 #include <stdlib.h>
+#include <threads.h>
 #include <unistd.h>
 
 #include <zircon/compiler.h>
 #include <zircon/process.h>
 #include <zircon/syscalls.h>
 #include <fbl/algorithm.h>
+#include <fbl/atomic.h>
 
 #include "bench.h"
 
@@ -46,6 +48,98 @@ inline zx_time_t time_it(T func) {
     return ticks_to_ns(ticks);
 }
 
+namespace {
+
+constexpr size_t kMaxFaultThreads = 8;
+
+struct fault_bench_args {
+    zx_handle_t vmo;
+    uintptr_t ptr;
+    size_t size;
+    fbl::atomic<bool>* go;
+};
+
+struct mapper_bench_args {
+    fbl::atomic<bool>* exit;
+    size_t count;
+};
+
+// Write faults in every page of the thread's own mapping.
+int fault_bench_thread(void* arg) {
+    fault_bench_args* a = static_cast<fault_bench_args*>(arg);
+    while (!a->go->load())
+        ;
+    for (size_t i = 0; i < a->size; i += PAGE_SIZE) {
+        ((volatile char *)a->ptr)[i] = 99;
+    }
+    return 0;
+}
+
+// Keeps changing the address space while the fault threads run.
+int mapper_bench_thread(void* arg) {
+    mapper_bench_args* a = static_cast<mapper_bench_args*>(arg);
+    const size_t size = 16 * PAGE_SIZE;
+    zx_handle_t vmo;
+    zx_vmo_create(size, 0, &vmo);
+    while (!a->exit->load()) {
+        uintptr_t ptr;
+        zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, 0, vmo, 0, size, &ptr);
+        zx_vmar_protect(zx_vmar_root_self(), ZX_VM_PERM_READ, ptr, size);
+        zx_vmar_unmap(zx_vmar_root_self(), ptr, size);
+        a->count++;
+    }
+    zx_handle_close(vmo);
+    return 0;
+}
+
+// Times |num_threads| threads each write faulting in their own VMO of |size|
+// at the same time, optionally with another thread mapping and unmapping in
+// the same address space.
+zx_time_t time_parallel_faults(size_t num_threads, size_t size, bool with_mapper,
+                               size_t* map_ops) {
+    fbl::atomic<bool> go(false);
+    fbl::atomic<bool> exit(false);
+    fault_bench_args args[kMaxFaultThreads];
+    thrd_t threads[kMaxFaultThreads];
+
+    for (size_t i = 0; i < num_threads; i++) {
+        args[i].size = size;
+        args[i].go = &go;
+        zx_vmo_create(size, 0, &args[i].vmo);
+        zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, 0,
+                    args[i].vmo, 0, size, &args[i].ptr);
+        thrd_create(&threads[i], fault_bench_thread, &args[i]);
+    }
+
+    mapper_bench_args mapper_args = {&exit, 0};
+    thrd_t mapper;
+    if (with_mapper) {
+        thrd_create(&mapper, mapper_bench_thread, &mapper_args);
+    }
+
+    zx_time_t t = time_it([&](){
+        go.store(true);
+        for (size_t i = 0; i < num_threads; i++) {
+            thrd_join(threads[i], nullptr);
+        }
+    });
+
+    if (with_mapper) {
+        exit.store(true);
+        thrd_join(mapper, nullptr);
+    }
+    *map_ops = mapper_args.count;
+
+    for (size_t i = 0; i < num_threads; i++) {
+        zx_vmar_unmap(zx_vmar_root_self(), args[i].ptr, size);
+        zx_handle_close(args[i].vmo);
+    }
+
+    return t;
+}
+
+} // namespace
+
 int vmo_run_benchmark() {
     zx_time_t t;
     //zx_handle_t vmo;
@@ -179,6 +273,23 @@ int vmo_run_benchmark() {
 
     zx_handle_close(vmo);
 
+    // fault in separate vmos from several threads at once, with and without
+    // another thread changing the address space at the same time
+    const size_t per_thread_size = 8*1024*1024;
+    for (size_t num_threads = 1; num_threads <= kMaxFaultThreads; num_threads *= 2) {
+        for (bool with_mapper : {false, true}) {
+            size_t map_ops;
+            t = time_parallel_faults(num_threads, per_thread_size, with_mapper, &map_ops);
+            printf("\ttook %" PRIu64 " nsecs for %zu threads to each write fault in a vmo of size %zu"
+                   " (%" PRIu64 " MB/s)", t, num_threads, per_thread_size,
+                   num_threads * per_thread_size * ZX_SEC(1) / 1024 / 1024 / fbl::max<zx_time_t>(t, 1));
+            if (with_mapper) {
+                printf(", %zu concurrent map/protect/unmap ops", map_ops);
+            }
+            printf("\n");
+        }
+    }
+
     printf("done with benchmark\n");
 
     return 0;
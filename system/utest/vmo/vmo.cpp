@@ -1761,6 +1761,124 @@ bool vmo_unmap_coherency() {
     END_TEST;
 }
 
+bool vmo_concurrent_fault_map_test() {
+    BEGIN_TEST;
+
+    // Several threads repeatedly decommit and fault in their own mapped VMO,
+    // checking the contents as they go, while another thread keeps mapping,
+    // protecting and unmapping other VMOs in the same address space. Faults
+    // on different VMOs no longer hold the address space lock, so this checks
+    // that they stay correct while the region tree changes around them.
+    static constexpr size_t kNumFaulters = 4;
+    static constexpr size_t kFaulterSize = 4 * 1024 * 1024;
+    static constexpr size_t kMapperSize = 64 * 1024;
+    const zx_time_t duration = ZX_SEC(5);
+
+    struct shared_state {
+        fbl::atomic<bool> exit;
+        fbl::atomic<size_t> errors;
+        fbl::atomic<size_t> fault_passes;
+        fbl::atomic<size_t> map_passes;
+    } state = {};
+
+    struct faulter_args {
+        shared_state* state;
+        zx_handle_t vmo;
+        uintptr_t ptr;
+        uint32_t stamp;
+    } faulters[kNumFaulters] = {};
+
+    for (size_t i = 0; i < kNumFaulters; i++) {
+        faulter_args& f = faulters[i];
+        f.state = &state;
+        f.stamp = static_cast<uint32_t>(i + 1) << 24;
+        ASSERT_EQ(ZX_OK, zx_vmo_create(kFaulterSize, 0, &f.vmo), "vm_object_create");
+        ASSERT_EQ(ZX_OK, zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                                     0, f.vmo, 0, kFaulterSize, &f.ptr), "map");
+    }
+
+    auto faulter = [](void* _args) -> int {
+        faulter_args* f = (faulter_args*)_args;
+
+        while (!f->state->exit.load()) {
+            for (size_t off = 0; off < kFaulterSize; off += PAGE_SIZE) {
+                *(volatile uint32_t*)(f->ptr + off) = f->stamp + (uint32_t)(off / PAGE_SIZE);
+            }
+            for (size_t off = 0; off < kFaulterSize; off += PAGE_SIZE) {
+                if (*(volatile uint32_t*)(f->ptr + off) != f->stamp + (uint32_t)(off / PAGE_SIZE)) {
+                    f->state->errors.fetch_add(1);
+                }
+            }
+            if (zx_vmo_op_range(f->vmo, ZX_VMO_OP_DECOMMIT, 0, kFaulterSize,
+                                nullptr, 0) != ZX_OK) {
+                f->state->errors.fetch_add(1);
+            }
+            f->state->fault_passes.fetch_add(1);
+        }
+
+        return 0;
+    };
+
+    auto mapper = [](void* _args) -> int {
+        shared_state* state = (shared_state*)_args;
+
+        while (!state->exit.load()) {
+            zx_handle_t vmo;
+            uintptr_t ptr;
+            if (zx_vmo_create(kMapperSize, 0, &vmo) != ZX_OK) {
+                state->errors.fetch_add(1);
+                continue;
+            }
+            if (zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                            0, vmo, 0, kMapperSize, &ptr) == ZX_OK) {
+                for (size_t off = 0; off < kMapperSize; off += PAGE_SIZE) {
+                    *(volatile uint32_t*)(ptr + off) = 99;
+                }
+                if (zx_vmar_protect(zx_vmar_root_self(), ZX_VM_PERM_READ, ptr,
+                                    kMapperSize / 2) != ZX_OK ||
+                    zx_vmar_unmap(zx_vmar_root_self(), ptr, kMapperSize) != ZX_OK) {
+                    state->errors.fetch_add(1);
+                }
+            } else {
+                state->errors.fetch_add(1);
+            }
+            zx_handle_close(vmo);
+            state->map_passes.fetch_add(1);
+        }
+
+        return 0;
+    };
+
+    thrd_t faulter_threads[kNumFaulters];
+    for (size_t i = 0; i < kNumFaulters; i++) {
+        ASSERT_EQ(thrd_success, thrd_create(&faulter_threads[i], faulter, &faulters[i]),
+                  "thread create");
+    }
+    thrd_t mapper_thread;
+    ASSERT_EQ(thrd_success, thrd_create(&mapper_thread, mapper, &state), "thread create");
+
+    zx_nanosleep(zx_deadline_after(duration));
+
+    state.exit.store(true);
+    for (auto& t : faulter_threads) {
+        thrd_join(t, nullptr);
+    }
+    thrd_join(mapper_thread, nullptr);
+
+    unittest_printf("%zu fault passes, %zu map passes\n",
+                    state.fault_passes.load(), state.map_passes.load());
+    EXPECT_EQ(0u, state.errors.load(), "errors");
+    EXPECT_LT(0u, state.fault_passes.load(), "fault passes");
+    EXPECT_LT(0u, state.map_passes.load(), "map passes");
+
+    for (auto& f : faulters) {
+        EXPECT_EQ(ZX_OK, zx_vmar_unmap(zx_vmar_root_self(), f.ptr, kFaulterSize), "unmap");
+        EXPECT_EQ(ZX_OK, zx_handle_close(f.vmo), "handle_close");
+    }
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(vmo_tests)
 RUN_TEST(vmo_create_test);
 RUN_TEST(vmo_read_write_test);
@@ -1795,6 +1913,7 @@ RUN_TEST(vmo_clone_resize_clone_hazard);
 RUN_TEST(vmo_clone_resize_parent_ok);
 RUN_TEST(vmo_info_test);
 RUN_TEST_LARGE(vmo_unmap_coherency);
+RUN_TEST_LARGE(vmo_concurrent_fault_map_test);
 END_TEST_CASE(vmo_tests)
 
 int main(int argc, char** argv) {